@@ -52,6 +52,42 @@ static inline unsigned long addr_read(size_t addr, size_t width, size_t sign_ext
     return val;
 }
 
+// 由HPFAR_EL2与FAR_EL2得到触发第二阶段异常的客户机物理地址
+static inline vaddr_t aborts_fault_ipa(unsigned long far) {
+    uint64_t hpfar = sysreg_hpfar_el2_read();
+
+    return (bit64_extract(hpfar, HPFAR_FIPA_OFF, HPFAR_FIPA_LEN) * PAGE_SIZE) |
+           (far & (PAGE_SIZE - 1));
+}
+
+// 被换出的客户机页的缺页，处理后重新执行触发异常的指令
+static bool aborts_swap_fault(unsigned long iss, unsigned long far) {
+    unsigned long fsc;
+
+    if (!cpu()->vcpu->vm->swap.enabled) {
+        return false;
+    }
+
+    fsc = bit64_extract(iss, ESR_ISS_DA_DSFC_OFF, ESR_ISS_DA_DSFC_LEN) & ESR_ISS_DA_DSFC_CODE;
+    if (fsc != ESR_ISS_DA_DSFC_TRNSLT && fsc != ESR_ISS_DA_DSFC_ACCESS) {
+        return false;
+    }
+
+    return vm_swap_fault(cpu()->vcpu->vm, aborts_fault_ipa(far), fsc);
+}
+
+// 客户机写共享的镜像页，复制一份私有页后重新执行触发异常的指令
+static bool aborts_cow_fault(unsigned long iss, unsigned long far) {
+    unsigned long fsc;
+
+    fsc = bit64_extract(iss, ESR_ISS_DA_DSFC_OFF, ESR_ISS_DA_DSFC_LEN) & ESR_ISS_DA_DSFC_CODE;
+    if (fsc != ESR_ISS_DA_DSFC_PERMIS || !(iss & ESR_ISS_DA_WnR_BIT)) {
+        return false;
+    }
+
+    return vm_cow_break(cpu()->vcpu->vm, aborts_fault_ipa(far));
+}
+
 void aborts_data_lower(unsigned long iss, unsigned long far, unsigned long il, unsigned long ec) {
     unsigned long DSFC;
     size_t addr, width, write, reg, sign_ext;
@@ -60,6 +96,10 @@ void aborts_data_lower(unsigned long iss, unsigned long far, unsigned long il, u
     struct emul_access emul;
     emul_handler_t handler = NULL;
 
+    if (aborts_cow_fault(iss, far) || aborts_swap_fault(iss, far)) {
+        return;
+    }
+
     if (!(iss & ESR_ISS_DA_ISV_BIT) || (iss & ESR_ISS_DA_FnV_BIT)) {
         ERROR("no information to handle data abort (0x%x)", far);
     }
@@ -111,6 +151,10 @@ void aborts_sync_handler() {
 
     if (ec == ESR_EC_DALEL) {
         aborts_data_lower(iss, far, il, ec);
+    } else if (ec == ESR_EC_IALEL) {
+        if (!aborts_swap_fault(iss, far)) {
+            ERROR("instruction abort (0x%x) - cant deal with it", far);
+        }
     } else if (ec == ESR_EC_HVC64) {
         arg0 = vcpu_readreg(cpu()->vcpu, 0);
         arg1 = vcpu_readreg(cpu()->vcpu, 1);
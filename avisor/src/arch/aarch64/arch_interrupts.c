@@ -42,4 +42,17 @@ bool interrupts_arch_check(irqid_t int_id) {
 
 void interrupts_arch_vm_assign(struct vm *vm, irqid_t id)  {
     vgic_set_hw(vm, id);
-}
\ No newline at end of file
+}
+
+// 共享外设中断在所有CPU上关闭，私有中断由各vCPU退出时关闭其来源
+void interrupts_arch_vm_release(struct vm *vm, irqid_t id) {
+    if (id >= GIC_CPU_PRIV) {
+        interrupts_arch_clear(id);
+        gic_set_enable(id, false);
+    }
+}
+
+// 在没有运行客户机的CPU上处理一个挂起的中断（EL2下中断始终是屏蔽的）
+void interrupts_arch_handle() {
+    gic_handle();
+}
@@ -107,3 +107,19 @@ void vm_arch_init(struct vm* vm, const struct vm_config* config) {
 
     cpu_sync_and_clear_msgs(&vm->sync);
 }
+
+// 预先分配体系结构相关的状态，供虚拟机池使用
+void vm_arch_alloc(struct vm* vm) {
+    vgic_alloc(vm);
+}
+
+void vm_arch_free(struct vm* vm) {
+    vgic_free(vm);
+}
+
+// vCPU不再在本核上运行：关闭客户机的虚拟定时器并清空vGIC的列表寄存器
+void vcpu_arch_release(struct vcpu* vcpu) {
+    sysreg_cntv_ctl_el0_write(0);
+    ISB();
+    vgic_cpu_release(vcpu);
+}
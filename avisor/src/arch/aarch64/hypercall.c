@@ -2,6 +2,8 @@
 #include "util.h"
 #include "lcm.h"
 #include "rq.h"
+#include "shmem.h"
+#include "vmm.h"
 
 void print_message_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2)
 {
@@ -10,17 +12,25 @@ void print_message_handler(unsigned long iss, unsigned long arg0, unsigned long
     INFO("Hypercall message: %s", (char *)arg0);
 }
 
-hypercall_handler_t hypercall_handlers[8] = {
+hypercall_handler_t hypercall_handlers[HYPERCALL_ISS_MAX] = {
     [HYPERCALL_ISS_HALT] = guest_halt_handler,
     [HYPERCALL_ISS_CHECKPOINT_SNAPSHOT] = checkpoint_snapshot_handler,  // 创建快照
     [HYPERCALL_ISS_RESTORE_SNAPSHOT] = restore_snapshot_handler,        // 恢复快照
     [HYPERCALL_ISS_PRINT_MESSAGE] = print_message_handler,              // 注册自定义的 Handler
     [HYPERCALL_ISS_RESTART] = restart_vm_handler,                       // 重启虚拟机
+    [HYPERCALL_ISS_SHMEM_CREATE] = shmem_create_handler,                // 创建共享内存
+    [HYPERCALL_ISS_SHMEM_ATTACH] = shmem_attach_handler,                // 映射共享内存
+    [HYPERCALL_ISS_SHMEM_DETACH] = shmem_detach_handler,                // 解除映射
+    [HYPERCALL_ISS_VM_CREATE] = vmm_create_handler,                     // 从模板创建虚拟机
+    [HYPERCALL_ISS_VM_START] = vmm_start_handler,                       // 启动虚拟机
+    [HYPERCALL_ISS_VM_PAUSE] = vmm_pause_handler,                       // 暂停虚拟机
+    [HYPERCALL_ISS_VM_RESUME] = vmm_resume_handler,                     // 恢复虚拟机
+    [HYPERCALL_ISS_VM_DESTROY] = vmm_destroy_handler,                   // 销毁虚拟机
 };
 
 void hypercall_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2)
 {
-    if (iss < 8 && hypercall_handlers[iss]) {
+    if (iss < HYPERCALL_ISS_MAX && hypercall_handlers[iss]) {
         hypercall_handlers[iss](iss, arg0, arg1, arg2);
     } else {
         INFO("Unknown hypercall iss: %lu", iss);
@@ -3,9 +3,11 @@
 
 #include "util.h"
 #include "sysregs.h"
+#include "timer.h"
 
 struct cpu_arch {
     SREG64 mpidr;
+    struct timer_queue timers;
 };
 
 // 获取当前cpu的指针
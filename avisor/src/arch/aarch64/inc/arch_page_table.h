@@ -100,6 +100,9 @@
 #define PTE_RSW_OPEN (0x1LL << PTE_RSW_OFF)
 #define PTE_RSW_FULL (0x2LL << PTE_RSW_OFF)
 #define PTE_RSW_RSRV (0x3LL << PTE_RSW_OFF)
+#define PTE_RSW_SWAP (0x4LL << PTE_RSW_OFF)    // 页已被压缩换出，地址字段为存储块号
+#define PTE_RSW_ZERO (0x5LL << PTE_RSW_OFF)    // 全零页已被回收
+#define PTE_RSW_COW (0x6LL << PTE_RSW_OFF)     // 只读映射的共享镜像页，写时复制
 
 #define PT_ROOT_FLAGS_REC_IND_OFF (0)
 #define PT_ROOT_FLAGS_REC_IND_LEN (13)
@@ -118,9 +121,21 @@
     (PTE_MEMATTR_NRML_OWBC | PTE_MEMATTR_NRML_IWBC | PTE_SH_NS | PTE_S2AP_RW | \
      PTE_AF)
 
+#define PTE_VM_COW_FLAGS                                                       \
+    (PTE_MEMATTR_NRML_OWBC | PTE_MEMATTR_NRML_IWBC | PTE_SH_NS | PTE_S2AP_RO | \
+     PTE_AF | PTE_RSW_COW)
+
 #define PTE_VM_DEV_FLAGS \
     (PTE_MEMATTR_DEV_GRE | PTE_SH_NS | PTE_S2AP_RW | PTE_AF)
 
+#define PTE_VM_SHMEM_FLAGS                                                     \
+    (PTE_MEMATTR_NRML_OWBC | PTE_MEMATTR_NRML_IWBC | PTE_SH_IS | PTE_S2AP_RW | \
+     PTE_AF)
+
+#define PTE_VM_SHMEM_RO_FLAGS                                                  \
+    (PTE_MEMATTR_NRML_OWBC | PTE_MEMATTR_NRML_IWBC | PTE_SH_IS | PTE_S2AP_RO | \
+     PTE_AF)
+
 #ifndef __ASSEMBLER__
 
 typedef uint64_t pte_t;
@@ -5,6 +5,9 @@
 #include "fences.h"
 #include "sysregs.h"
 
+// 超过该页数时，逐页无效化的开销大于收益，直接无效化整个VMID（或EL2地址空间）
+#define TLB_INV_RANGE_MAX_PAGES     (512)
+
 static inline void tlb_hyp_inv_va(vaddr_t va)
 {
     DSB(ish);
@@ -21,46 +24,87 @@ static inline void tlb_hyp_inv_all()
     ISB();
 }
 
-static inline void tlb_vm_inv_va(asid_t vmid, vaddr_t va)
+static inline void tlb_hyp_inv_range(vaddr_t va, size_t size)
 {
-    uint64_t vttbr = 0;
-    vttbr = sysreg_vttbr_el2_read();
-    bool switch_vmid =
-        bit64_extract(vttbr, VTTBR_VMID_OFF, VTTBR_VMID_LEN) != vmid;
+    if (size / PAGE_SIZE > TLB_INV_RANGE_MAX_PAGES) {
+        tlb_hyp_inv_all();
+        return;
+    }
+
+    DSB(ish);
+    for (vaddr_t addr = va; addr < va + size; addr += PAGE_SIZE) {
+        arm_tlbi_vae2is(addr);
+    }
+    DSB(ish);
+    ISB();
+}
 
-    if (switch_vmid) {
+/**
+ * 二阶段TLBI作用于VTTBR_EL2中当前的VMID。仅在需要时切换到目标VMID，
+ * 并返回原值，以便在整个无效化序列结束后只恢复一次。
+ */
+static inline uint64_t tlb_vm_switch(asid_t vmid)
+{
+    uint64_t vttbr = sysreg_vttbr_el2_read();
+
+    if (bit64_extract(vttbr, VTTBR_VMID_OFF, VTTBR_VMID_LEN) != vmid) {
         sysreg_vttbr_el2_write((((uint64_t)vmid << VTTBR_VMID_OFF) & VTTBR_VMID_MSK));
-        DSB(ish);
         ISB();
     }
 
-    arm_tlbi_ipas2e1is(va);
+    return vttbr;
+}
 
-    if (switch_vmid) {
-        DSB(ish);
-        sysreg_vttbr_el2_write((((uint64_t)vmid << VTTBR_VMID_OFF) & VTTBR_VMID_MSK));
+static inline void tlb_vm_restore(asid_t vmid, uint64_t vttbr)
+{
+    if (bit64_extract(vttbr, VTTBR_VMID_OFF, VTTBR_VMID_LEN) != vmid) {
+        sysreg_vttbr_el2_write(vttbr);
+        ISB();
     }
 }
 
 static inline void tlb_vm_inv_all(asid_t vmid)
 {
-    uint64_t vttbr = 0;
-    vttbr = sysreg_vttbr_el2_read();
-    bool switch_vmid =
-        bit64_extract(vttbr, VTTBR_VMID_OFF, VTTBR_VMID_LEN) != vmid;
+    uint64_t vttbr = tlb_vm_switch(vmid);
 
-    if (switch_vmid) {
-        sysreg_vttbr_el2_write((((uint64_t)vmid << VTTBR_VMID_OFF) & VTTBR_VMID_MSK));
-        DSB(ish);
-        ISB();
+    DSB(ishst);
+    arm_tlbi_vmalls12e1is();
+    DSB(ish);
+
+    tlb_vm_restore(vmid, vttbr);
+}
+
+/**
+ * 无效化[va, va + size)的二阶段表项，只切换一次VTTBR、只等待一次完成屏障。
+ * 一、二阶段合并的表项无法按IPA无效化，因此最后对该VMID统一无效化一次。
+ */
+static inline void tlb_vm_inv_range(asid_t vmid, vaddr_t va, size_t size)
+{
+    uint64_t vttbr;
+
+    if (size / PAGE_SIZE > TLB_INV_RANGE_MAX_PAGES) {
+        tlb_vm_inv_all(vmid);
+        return;
     }
 
-    arm_tlbi_vmalls12e1is();
+    vttbr = tlb_vm_switch(vmid);
 
-    if (switch_vmid) {
-        DSB(ish);
-        sysreg_vttbr_el2_write((((uint64_t)vmid << VTTBR_VMID_OFF) & VTTBR_VMID_MSK));
+    DSB(ishst);
+    for (vaddr_t addr = va; addr < va + size; addr += PAGE_SIZE) {
+        arm_tlbi_ipas2e1is(addr);
     }
+    DSB(ish);
+    arm_tlbi_vmalle1is();
+    DSB(ish);
+    ISB();
+
+    tlb_vm_restore(vmid, vttbr);
+}
+
+// 单页同样需要丢弃该VMID的一、二阶段合并表项，与范围无效化使用同一序列
+static inline void tlb_vm_inv_va(asid_t vmid, vaddr_t va)
+{
+    tlb_vm_inv_range(vmid, va, PAGE_SIZE);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -10,6 +10,18 @@ typedef enum {
     HYPERCALL_ISS_PRINT_MESSAGE, // 自定义的Hypercall类型,3
     // Restart
     HYPERCALL_ISS_RESTART, // 自定义的Hypercall类型,4
+    // Shared memory
+    HYPERCALL_ISS_SHMEM_CREATE, // 5
+    HYPERCALL_ISS_SHMEM_ATTACH, // 6
+    HYPERCALL_ISS_SHMEM_DETACH, // 7
+    // VM lifecycle, management VM only
+    HYPERCALL_ISS_VM_CREATE, // 8
+    HYPERCALL_ISS_VM_START, // 9
+    HYPERCALL_ISS_VM_PAUSE, // 10
+    HYPERCALL_ISS_VM_RESUME, // 11
+    HYPERCALL_ISS_VM_DESTROY, // 12
+
+    HYPERCALL_ISS_MAX,
 } HYPERCALL_TYPE;
 
 typedef void (*hypercall_handler_t)(unsigned long, unsigned long, unsigned long, unsigned long);
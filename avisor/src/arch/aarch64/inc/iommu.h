@@ -23,5 +23,7 @@ struct iommu_vm_arch {
 bool iommu_arch_init();
 bool iommu_arch_vm_init(struct vm *vm, const struct vm_config *config);
 bool iommu_arch_vm_add_device(struct vm *vm, deviceid_t id);
+void iommu_arch_tlb_inv_range(asid_t vmid, vaddr_t ipa, size_t size);
+void iommu_arch_tlb_inv_all(asid_t vmid);
 
 #endif
@@ -205,6 +205,8 @@ struct smmu_glbl_rs0_hw {
 #define SMMUV2_CBAR_VMID(ID)            ((ID) & SMMUV2_CBAR_VMID_MASK)
 #define SMMUV2_CBAR_VA64                (0x1 << 0)
 
+#define SMMUV2_TLBGSTATUS_GSACTIVE      (0x1 << 0)
+
 #define SMMUV2_CB_TTBA_END     (48)
 #define SMMUV2_CB_TTBA(x)      BIT64_MASK(x, (SMMUV2_CB_TTBA_END - x))
 
@@ -378,6 +380,7 @@ size_t smmu_alloc_sme();
 void smmu_write_ctxbnk(size_t ctx_id, paddr_t root_pt, asid_t vm_id);
 void smmu_write_sme(size_t sme, streamid_t mask, streamid_t id, bool group);
 void smmu_write_s2c(size_t sme, size_t ctx_id);
+void smmu_tlb_inv_vmid(asid_t vm_id);
 size_t smmu_sme_get_ctx(size_t sme);
 streamid_t smmu_sme_get_id(size_t sme);
 streamid_t smmu_sme_get_mask(size_t sme);
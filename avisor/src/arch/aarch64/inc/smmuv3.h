@@ -2,8 +2,12 @@
 #define SMMUV3_H
 
 #include "util.h"
+#include "arch_vm.h"
 
 void arm_smmuv3_init();
 int arm_smmuv3_vm_dev_init(vmid_t vmid, streamid_t sid);
+int arm_smmuv3_vm_init(vmid_t vmid, const struct smmu_group *groups, size_t n);
+void arm_smmuv3_tlb_inv_vm(vmid_t vmid);
+void arm_smmuv3_tlb_inv_range(vmid_t vmid, paddr_t ipa, size_t size);
 
 #endif
\ No newline at end of file
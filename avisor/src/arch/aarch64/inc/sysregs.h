@@ -68,6 +68,7 @@ SYSREG_GEN_ACCESSORS(ctr_el0);
 SYSREG_GEN_ACCESSORS(mpidr_el1);
 SYSREG_GEN_ACCESSORS(vmpidr_el2);
 SYSREG_GEN_ACCESSORS(cntvoff_el2);
+SYSREG_GEN_ACCESSORS(cntv_ctl_el0);
 SYSREG_GEN_ACCESSORS(sctlr_el1);
 SYSREG_GEN_ACCESSORS(cntkctl_el1);
 SYSREG_GEN_ACCESSORS(cntfrq_el0);
@@ -84,6 +85,7 @@ SYSREG_GEN_ACCESSORS(hcr_el2);
 SYSREG_GEN_ACCESSORS(vtcr_el2);
 SYSREG_GEN_ACCESSORS(vttbr_el2);
 SYSREG_GEN_ACCESSORS(id_aa64mmfr0_el1);
+SYSREG_GEN_ACCESSORS(id_aa64isar0_el1);
 SYSREG_GEN_ACCESSORS(tpidr_el2);
 SYSREG_GEN_ACCESSORS(vsctlr_el2);
 SYSREG_GEN_ACCESSORS(spsr_el2);
@@ -145,6 +147,10 @@ static inline void arm_tlbi_vmalls12e1is() {
     asm volatile("tlbi vmalls12e1is");
 }
 
+static inline void arm_tlbi_vmalle1is() {
+    asm volatile("tlbi vmalle1is");
+}
+
 static inline void arm_tlbi_vae2is(size_t vaddr) {
     asm volatile("tlbi vae2is, %0" ::"r"(vaddr >> 12));
 }
@@ -541,6 +547,10 @@ static inline void arm_tlbi_ipas2e1is(size_t vaddr) {
 #define ESR_ISS_DA_DSFC_ACCESS (0x8)
 #define ESR_ISS_DA_DSFC_PERMIS (0xC)
 
+/* HPFAR_EL2, Hypervisor IPA Fault Address Register */
+#define HPFAR_FIPA_OFF (4)
+#define HPFAR_FIPA_LEN (40)
+
 #define ESR_ISS_SYSREG_ADDR ((0xfff << 10) | (0xf << 1))
 #define ESR_ISS_SYSREG_ADDR_32 (0xFFC1E)
 #define ESR_ISS_SYSREG_ADDR_64 (0xF001E)
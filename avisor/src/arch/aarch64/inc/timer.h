@@ -13,7 +13,46 @@
 // Secure EL2 Virtual Timer: 19
 #define IRQ_TIMER (26)
 
+#define TIMER_MAX_EVENTS (32)   // 每个CPU上同时排队的定时事件上限
+#define TIMER_EVENT_IDLE ((size_t)-1)
+
+struct timer_event;
+typedef void (*timer_event_handler_t)(struct timer_event* ev);
+
+/**
+ * 虚拟机监控器的定时事件。事件排在添加它的CPU上，并在该CPU的中断上下文中触发。
+ * 已排队的事件只能在所属CPU上重新设定或取消（违反时断言失败）；
+ * EL2运行时屏蔽中断，因此无需加锁。
+ */
+struct timer_event {
+    uint64_t deadline;      // 到期时间（计数器tick）
+    uint64_t period;        // 周期（tick），0表示单次事件
+    timer_event_handler_t handler;
+    void* data;
+    size_t idx;             // 在堆中的位置，未排队时为TIMER_EVENT_IDLE
+    cpuid_t cpu;            // 所属CPU，即事件所在队列的CPU
+};
+
+// 每个CPU一个按到期时间排序的最小堆，CNTHP只为堆顶事件编程
+struct timer_queue {
+    struct timer_event* heap[TIMER_MAX_EVENTS];
+    size_t nr;
+};
+
 void timer_init();
 void timer_handler();
 
+void timer_event_init(struct timer_event* ev, timer_event_handler_t handler, void* data);
+bool timer_event_add(struct timer_event* ev, uint64_t delay, uint64_t period);
+void timer_event_cancel(struct timer_event* ev);
+
+static inline bool timer_event_pending(struct timer_event* ev) {
+    return ev->idx != TIMER_EVENT_IDLE;
+}
+
+uint64_t timer_get_ticks();
+uint64_t timer_ms_to_ticks(uint64_t ms);
+uint64_t timer_ticks_to_ms(uint64_t ticks);
+uint64_t timer_ticks_to_us(uint64_t ticks);
+
 #endif
\ No newline at end of file
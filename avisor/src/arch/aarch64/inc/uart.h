@@ -10,6 +10,7 @@
 #define CR_UARTEN                   (1U	<< 0U)
 #define IMSC_RXIM		            (1U << 4U)
 #define FR_RXFE                     (1U	<< 4U)
+#define FR_TXFF                     (1U	<< 5U)
 #define RSRECR_ERR_MASK             (0xF)
 
 // Macros
@@ -46,6 +47,7 @@ struct __attribute__((packed)) PL011_REGS {
 // PL011 Device
 void uart_print_char(const char);
 void uart_print_string(const char *);
+void uart_write(const char *, size_t);
 void uart_print_hex(uint64_t);
 void uart_enable_interrupts(void);
 void uart_print_register_colon(const char *s,uint64_t n,const char *s1,uint64_t n1);
@@ -66,8 +66,18 @@ struct vgic_priv {
     struct vgic_int interrupts[GIC_CPU_PRIV];
 };
 
+/**
+ * The virtual interrupt state is sized for the architectural maximum rather
+ * than the VM configuration, so pooled VMs can allocate it up front (see
+ * vgic_alloc) and vgic_init just uses it.
+ */
+#define VGIC_INT_PAGES NUM_PAGES(GIC_MAX_INTERUPTS * sizeof(struct vgic_int))
+
 void vgic_init(struct vm *vm, const struct vgic_dscrp *vgic_dscrp);
 void vgic_cpu_init(struct vcpu *vcpu);
+void vgic_cpu_release(struct vcpu *vcpu);
+void vgic_alloc(struct vm *vm);
+void vgic_free(struct vm *vm);
 void vgic_set_hw(struct vm *vm, irqid_t id);
 void vgic_inject(struct vcpu *vcpu, irqid_t id, vcpuid_t source);
 void vgic_inject_hw(struct vcpu *vcpu, irqid_t id);
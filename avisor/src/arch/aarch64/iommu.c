@@ -90,6 +90,15 @@ bool iommu_arch_vm_init(struct vm *vm, const struct vm_config *config) {
     return true;
 }
 
+void iommu_arch_tlb_inv_range(asid_t vmid, vaddr_t ipa, size_t size) {
+    /* No global invalidation by IPA, drop the whole VMID. */
+    smmu_tlb_inv_vmid(vmid);
+}
+
+void iommu_arch_tlb_inv_all(asid_t vmid) {
+    smmu_tlb_inv_vmid(vmid);
+}
+
 #elif (SMMU_VERSION == SMMUV3)
 
 bool iommu_arch_init() {   
@@ -107,16 +116,17 @@ bool iommu_arch_vm_add_device(struct vm *vm, streamid_t id) {
 
 bool iommu_arch_vm_init(struct vm *vm, const struct vm_config *config) {
     /* This section relates only to arm's iommu so we parse it here. */
-    for (size_t i = 0; i < config->arch.smmu.group_num; i++) {
-        /* Register each group. */
-        const struct smmu_group *group =
-            &config->arch.smmu.groups[i];
-        if(arm_smmuv3_vm_dev_init(vm->id, group->id) != 0){
-            return false;
-        }
-    }
+    /* All groups are registered in one batch of stream table updates. */
+    return arm_smmuv3_vm_init(vm->id, config->arch.smmu.groups,
+                              config->arch.smmu.group_num) == 0;
+}
 
-    return true;
+void iommu_arch_tlb_inv_range(asid_t vmid, vaddr_t ipa, size_t size) {
+    arm_smmuv3_tlb_inv_range(vmid, ipa, size);
+}
+
+void iommu_arch_tlb_inv_all(asid_t vmid) {
+    arm_smmuv3_tlb_inv_vm(vmid);
 }
 
 #else
@@ -134,4 +144,10 @@ bool iommu_arch_vm_init(struct vm *vm, const struct vm_config *config) {
     return true;
 }
 
+void iommu_arch_tlb_inv_range(asid_t vmid, vaddr_t ipa, size_t size) {
+}
+
+void iommu_arch_tlb_inv_all(asid_t vmid) {
+}
+
 #endif
\ No newline at end of file
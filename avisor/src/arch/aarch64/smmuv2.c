@@ -34,6 +34,10 @@ struct smmu_priv {
     spinlock_t ctx_lock;
     size_t ctx_num;
     BITMAP_ALLOC(ctxbank_bitmap, CTX_MAX_NUM);
+
+    /* VMIDs with a context bank, only those can have SMMU TLB entries */
+    spinlock_t tlb_lock;
+    BITMAP_ALLOC(vmid_bitmap, MAX_VM_NUM);
 };
 
 struct smmu_priv smmu;
@@ -149,6 +153,9 @@ void smmu_init() {
     smmu.ctx_num = ctx_bank_num;
     bitmap_clear_consecutive(smmu.ctxbank_bitmap, 0, smmu.ctx_num);
 
+    smmu.tlb_lock = SPINLOCK_INITVAL;
+    bitmap_clear_consecutive(smmu.vmid_bitmap, 0, MAX_VM_NUM);
+
     smmu.sme_lock = SPINLOCK_INITVAL;
     smmu.sme_num = smmu.hw.glbl_rs0->IDR0 & SMMUV2_IDR0_MASK;
     bitmap_clear_consecutive(smmu.sme_bitmap, 0, smmu.sme_num);
@@ -236,10 +243,31 @@ void smmu_write_ctxbnk(size_t ctx_id, paddr_t root_pt, asid_t vm_id) {
         sctlr = SMMUV2_SCTLR_CLEAR(sctlr);
         sctlr |= SMMUV2_SCTLR_DEFAULT;
         smmu.hw.cntxt[ctx_id].SCTLR |= sctlr;
+
+        if (vm_id < MAX_VM_NUM) {
+            bitmap_set(smmu.vmid_bitmap, vm_id);
+        }
     }
     spin_unlock(&smmu.ctx_lock);
 }
 
+/**
+ * Invalidate all TLB entries of a VM. SMMUv2 has no global invalidation by
+ * IPA, so ranges are handled by the caller invalidating the whole VMID.
+ */
+void smmu_tlb_inv_vmid(asid_t vm_id) {
+    if (smmu.hw.glbl_rs0 == NULL || vm_id >= MAX_VM_NUM ||
+        !bitmap_get(smmu.vmid_bitmap, vm_id)) {
+        return;
+    }
+
+    spin_lock(&smmu.tlb_lock);
+    smmu.hw.glbl_rs0->TLBIVMID = SMMUV2_CBAR_VMID(vm_id);
+    smmu.hw.glbl_rs0->TLBGSYNC = 0;
+    while (smmu.hw.glbl_rs0->TLBGSTATUS & SMMUV2_TLBGSTATUS_GSACTIVE);
+    spin_unlock(&smmu.tlb_lock);
+}
+
 size_t smmu_alloc_sme() {
     spin_lock(&smmu.sme_lock);
     /* Find a free sme. */
@@ -36,6 +36,7 @@
 #include "vm.h"
 #include "smmuv3.h"
 #include "string.h"
+#include "arch_tlb.h"
 
 static inline void mmio_write32(void *address, u32 value) {
 	*(volatile u32 *)address = value;
@@ -299,6 +300,10 @@ static inline u64 mmio_read64(void *address) {
 #define CMDQ_OP_TLBI_NSNH_ALL	0x30
 #define CMDQ_OP_CMD_SYNC	0x46
 #define ARM_SMMU_FEAT_2_LVL_STRTAB	(1 << 0)
+#define ARM_SMMU_FEAT_MSI		(1 << 2)
+
+/* Commands gathered before a single producer index update */
+#define CMDQ_BATCH_ENTRIES		16
 
 /* High-level queue structures */
 struct arm_smmu_cmdq_ent {
@@ -352,6 +357,14 @@ struct arm_smmu_queue {
 struct arm_smmu_cmdq {
 	struct arm_smmu_queue		q;
 	spinlock_t			lock;
+	/* CMD_SYNC completion word, written by the SMMU through MSI */
+	volatile u32			sync_word __attribute__((aligned(8)));
+	u32				sync_count;
+};
+
+struct arm_smmu_cmdq_batch {
+	u64				cmds[CMDQ_BATCH_ENTRIES * CMDQ_ENT_DWORDS];
+	u32				num;
 };
 
 struct arm_smmu_evtq {
@@ -387,6 +400,9 @@ struct arm_smmu_device {
 
 struct arm_smmu_device smmu_device;
 
+/* VMIDs with streams attached, only those can have SMMU TLB entries */
+static BITMAP_ALLOC(arm_smmu_vmids, MAX_VM_NUM);
+
 /* Low-level queue manipulation functions */
 static bool queue_full(struct arm_smmu_queue *q) {
 	u32 shift = q->max_n_shift;
@@ -413,11 +429,25 @@ static bool queue_error(struct arm_smmu_device *smmu, struct arm_smmu_queue *q)
 	return (gerror ^ gerrorn) & q->gerr_mask;
 }
 
-static void queue_inc_prod(struct arm_smmu_queue *q) {
+static u32 queue_space(struct arm_smmu_queue *q) {
+	u32 shift = q->max_n_shift;
+	u32 prod = Q_IDX(q->prod, shift), cons = Q_IDX(q->cons, shift);
+
+	if (Q_WRP(q->prod, shift) == Q_WRP(q->cons, shift))
+		return (1 << shift) - (prod - cons);
+
+	return cons - prod;
+}
+
+/* Advance the shadow producer index; the SMMU sees it on queue_publish_prod */
+static void queue_inc_prod_n(struct arm_smmu_queue *q, u32 n) {
 	u32 shift = q->max_n_shift;
-	u32 prod = (Q_WRP(q->prod, shift) | Q_IDX(q->prod, shift)) + 1;
+	u32 prod = (Q_WRP(q->prod, shift) | Q_IDX(q->prod, shift)) + n;
 
 	q->prod = Q_OVF(q->prod) | Q_WRP(prod, shift) | Q_IDX(prod, shift);
+}
+
+static void queue_publish_prod(struct arm_smmu_queue *q) {
 	mmio_write32(q->prod_reg, q->prod);
 }
 
@@ -514,19 +544,70 @@ static void arm_smmu_cmdq_skip_err(struct arm_smmu_device *smmu) {
 	mmio_write32(smmu->base + ARM_SMMU_GERRORN, gerrorn);
 }
 
-static void arm_smmu_cmdq_insert_cmd(struct arm_smmu_device *smmu, u64 *cmd) {
+/*
+ * Write n commands, optionally followed by a CMD_SYNC, with one update of the
+ * producer index. When a sync is requested, wait for it to complete: poll the
+ * MSI completion word if the SMMU supports MSIs, otherwise wait for the queue
+ * to drain.
+ */
+static void arm_smmu_cmdq_issue_cmdlist(struct arm_smmu_device *smmu,
+					u64 *cmds, u32 n, bool sync) {
 	struct arm_smmu_queue *q = &smmu->cmdq.q;
+	struct arm_smmu_cmdq_ent ent = { .opcode = CMDQ_OP_CMD_SYNC };
+	u64 cmd[CMDQ_ENT_DWORDS];
+	u32 i, seq = 0;
+
+	spin_lock(&smmu->cmdq.lock);
+
+	for (i = 0; i < n; i++) {
+		if (queue_full(q)) {
+			/* Let the SMMU see what we have so far and wait for room */
+			queue_publish_prod(q);
+			while (queue_full(q))
+				queue_sync_cons(q);
+		}
+		queue_write(queue_entry(q, q->prod), &cmds[i * CMDQ_ENT_DWORDS],
+			    q->ent_dwords);
+		queue_inc_prod_n(q, 1);
+	}
 
-	while (queue_full(q))
-		queue_sync_cons(q);
+	if (sync) {
+		seq = ++smmu->cmdq.sync_count;
+		if (smmu->features & ARM_SMMU_FEAT_MSI) {
+			ent.sync.msidata = seq;
+			ent.sync.msiaddr = paging_hvirt2phys(&smmu->cmdq.sync_word);
+		}
+		arm_smmu_cmdq_build_cmd(cmd, &ent);
+
+		while (queue_space(q) == 0) {
+			queue_publish_prod(q);
+			queue_sync_cons(q);
+		}
+		queue_write(queue_entry(q, q->prod), cmd, q->ent_dwords);
+		queue_inc_prod_n(q, 1);
+	}
 
-	queue_write(queue_entry(q, q->prod), cmd, q->ent_dwords);
-	queue_inc_prod(q);
-	while (!queue_empty(q)) {
-		queue_sync_cons(q);
-		if (queue_error(smmu, q))
-			arm_smmu_cmdq_skip_err(smmu);
+	queue_publish_prod(q);
+
+	if (sync) {
+		if (smmu->features & ARM_SMMU_FEAT_MSI) {
+			while (smmu->cmdq.sync_word != seq) {
+				if (queue_error(smmu, q)) {
+					queue_sync_cons(q);
+					arm_smmu_cmdq_skip_err(smmu);
+				}
+			}
+			queue_sync_cons(q);
+		} else {
+			do {
+				queue_sync_cons(q);
+				if (queue_error(smmu, q))
+					arm_smmu_cmdq_skip_err(smmu);
+			} while (!queue_empty(q));
+		}
 	}
+
+	spin_unlock(&smmu->cmdq.lock);
 }
 
 static void arm_smmu_cmdq_issue_cmd(struct arm_smmu_device *smmu,
@@ -537,20 +618,36 @@ static void arm_smmu_cmdq_issue_cmd(struct arm_smmu_device *smmu,
 		/* Ignore any unknown command */
 		return;
 
-	spin_lock(&smmu->cmdq.lock);
-	arm_smmu_cmdq_insert_cmd(smmu, cmd);
-	spin_unlock(&smmu->cmdq.lock);
+	arm_smmu_cmdq_issue_cmdlist(smmu, cmd, 1, false);
 }
 
 static void arm_smmu_cmdq_issue_sync(struct arm_smmu_device *smmu) {
-	struct arm_smmu_cmdq_ent ent = { .opcode = CMDQ_OP_CMD_SYNC };
-	u64 cmd[CMDQ_ENT_DWORDS];
+	arm_smmu_cmdq_issue_cmdlist(smmu, NULL, 0, true);
+}
 
-	arm_smmu_cmdq_build_cmd(cmd, &ent);
+static void arm_smmu_cmdq_batch_init(struct arm_smmu_cmdq_batch *batch) {
+	batch->num = 0;
+}
 
-	spin_lock(&smmu->cmdq.lock);
-	arm_smmu_cmdq_insert_cmd(smmu, cmd);
-	spin_unlock(&smmu->cmdq.lock);
+static void arm_smmu_cmdq_batch_add(struct arm_smmu_device *smmu,
+				    struct arm_smmu_cmdq_batch *batch,
+				    struct arm_smmu_cmdq_ent *ent) {
+	if (batch->num == CMDQ_BATCH_ENTRIES) {
+		arm_smmu_cmdq_issue_cmdlist(smmu, batch->cmds, batch->num, false);
+		batch->num = 0;
+	}
+
+	if (arm_smmu_cmdq_build_cmd(&batch->cmds[batch->num * CMDQ_ENT_DWORDS], ent))
+		return;
+
+	batch->num++;
+}
+
+/* Submit the remaining commands and wait for all of them with one CMD_SYNC */
+static void arm_smmu_cmdq_batch_submit(struct arm_smmu_device *smmu,
+				       struct arm_smmu_cmdq_batch *batch) {
+	arm_smmu_cmdq_issue_cmdlist(smmu, batch->cmds, batch->num, true);
+	batch->num = 0;
 }
 
 /* Stream table manipulation functions */
@@ -567,6 +664,7 @@ arm_smmu_write_strtab_l1_desc(u64 *dst, struct arm_smmu_strtab_l1_desc *desc) {
 }
 
 static void arm_smmu_sync_ste_for_sid(struct arm_smmu_device *smmu, u32 sid) {
+	struct arm_smmu_cmdq_batch batch;
 	struct arm_smmu_cmdq_ent cmd = {
 		.opcode	= CMDQ_OP_CFGI_STE,
 		.cfgi	= {
@@ -575,14 +673,52 @@ static void arm_smmu_sync_ste_for_sid(struct arm_smmu_device *smmu, u32 sid) {
 		},
 	};
 
-	arm_smmu_cmdq_issue_cmd(smmu, &cmd);
-	arm_smmu_cmdq_issue_sync(smmu);
+	arm_smmu_cmdq_batch_init(&batch);
+	arm_smmu_cmdq_batch_add(smmu, &batch, &cmd);
+	arm_smmu_cmdq_batch_submit(smmu, &batch);
+}
+
+/* Queue a leaf STE invalidation; the caller syncs the whole batch */
+static void arm_smmu_batch_ste_for_sid(struct arm_smmu_device *smmu,
+				       struct arm_smmu_cmdq_batch *batch, u32 sid) {
+	struct arm_smmu_cmdq_ent cmd = {
+		.opcode	= CMDQ_OP_CFGI_STE,
+		.cfgi	= {
+			.sid	= sid,
+			.leaf	= true,
+		},
+	};
+
+	arm_smmu_cmdq_batch_add(smmu, batch, &cmd);
+}
+
+/* Stage 2 translation STE: everything but the valid/config dword */
+static void arm_smmu_write_strtab_ent_s2(u64 *dst, u32 vmid, paddr_t root_pt) {
+	u64 vttbr;
+
+	dst[2] = FIELD_PREP(STRTAB_STE_2_S2VMID, vmid) |
+		 FIELD_PREP(STRTAB_STE_2_VTCR, VTCR_CELL) |
+		 STRTAB_STE_2_S2PTW | STRTAB_STE_2_S2AA64 |
+		 STRTAB_STE_2_S2R;
+
+	vttbr = paging_hvirt2phys(root_pt);
+	dst[3] = vttbr & STRTAB_STE_3_S2TTB_MASK;
+}
+
+static void arm_smmu_write_strtab_ent_valid(u64 *dst) {
+	u64 val = 0;
+
+	val |= FIELD_PREP(STRTAB_STE_0_CFG, STRTAB_STE_0_CFG_S2_TRANS);
+	val |= STRTAB_STE_0_V;
+
+	dst[0] = val;
+	fence_ord_write();
 }
 
 static void arm_smmu_write_strtab_ent(struct arm_smmu_device *smmu, u32 sid,
 				      u64 *guest_ste, u64 *dst, bool bypass,
 				      u32 vmid, paddr_t root_pt) {
-	u64 val, vttbr;
+	u64 val;
 
 	val = 0;
 
@@ -600,20 +736,9 @@ static void arm_smmu_write_strtab_ent(struct arm_smmu_device *smmu, u32 sid,
 		return;
 	}
 
-	dst[2] = FIELD_PREP(STRTAB_STE_2_S2VMID, vmid) |
-		 FIELD_PREP(STRTAB_STE_2_VTCR, VTCR_CELL) |
-		 STRTAB_STE_2_S2PTW | STRTAB_STE_2_S2AA64 |
-		 STRTAB_STE_2_S2R;
-
-	vttbr = paging_hvirt2phys(root_pt);
-	dst[3] = vttbr & STRTAB_STE_3_S2TTB_MASK;
-
-	val |= FIELD_PREP(STRTAB_STE_0_CFG, STRTAB_STE_0_CFG_S2_TRANS);
-	val |= STRTAB_STE_0_V;
-
+	arm_smmu_write_strtab_ent_s2(dst, vmid, root_pt);
 	arm_smmu_sync_ste_for_sid(smmu, sid);
-	dst[0] = val;
-	fence_ord_write();
+	arm_smmu_write_strtab_ent_valid(dst);
 	arm_smmu_sync_ste_for_sid(smmu, sid);
 }
 
@@ -897,6 +1022,9 @@ static int arm_smmu_device_init_features(struct arm_smmu_device *smmu) {
 	if (FIELD_GET(IDR0_VMID16, reg))
 		smmu->features |= IDR0_VMID16;
 
+	if (reg & IDR0_MSI)
+		smmu->features |= ARM_SMMU_FEAT_MSI;
+
 	/* IDR1 */
 	reg = mmio_read32(smmu->base + ARM_SMMU_IDR1);
 	if (reg & (IDR1_TABLES_PRESET | IDR1_QUEUES_PRESET | IDR1_REL))
@@ -924,7 +1052,8 @@ static int arm_smmu_device_init_features(struct arm_smmu_device *smmu) {
 	return 0;
 }
 
-static int arm_smmu_init_l2_strtab(struct arm_smmu_device *smmu, u32 sid) {
+static int arm_smmu_init_l2_strtab(struct arm_smmu_device *smmu,
+				   struct arm_smmu_cmdq_batch *batch, u32 sid) {
 	struct arm_smmu_strtab_cfg *cfg = &smmu->strtab_cfg;
 	struct arm_smmu_strtab_l1_desc *desc;
 	struct arm_smmu_cmdq_ent cmd;
@@ -954,7 +1083,7 @@ static int arm_smmu_init_l2_strtab(struct arm_smmu_device *smmu, u32 sid) {
 	cmd.opcode = CMDQ_OP_CFGI_STE;
 	cmd.cfgi.sid = sid;
 	cmd.cfgi.leaf = false;
-	arm_smmu_cmdq_issue_cmd(smmu, &cmd);
+	arm_smmu_cmdq_batch_add(smmu, batch, &cmd);
 
 	return 0;
 }
@@ -1009,19 +1138,50 @@ static u64 *arm_smmu_get_step_for_sid(struct arm_smmu_device *smmu, u32 sid) {
 	return step;
 }
 
-static int arm_smmu_init_ste(struct arm_smmu_device *smmu, u32 sid, u32 vmid) {
-	int ret = 0;
-	u64 *step;
+/*
+ * Point the STEs of all the given stream IDs at the VM's stage 2 tables.
+ * Every step is batched across the stream IDs: one CMD_SYNC after writing
+ * the translation fields, and one after making the entries valid and
+ * invalidating the VM's TLB entries, however many streams the VM has.
+ */
+static int arm_smmu_init_stes(struct arm_smmu_device *smmu, u32 vmid,
+			      const struct smmu_group *groups, size_t n) {
+	struct arm_smmu_cmdq_batch batch;
+	struct arm_smmu_cmdq_ent cmd;
+	int ret;
+	size_t i;
+
+	arm_smmu_cmdq_batch_init(&batch);
+	for (i = 0; i < n; i++) {
+		if (smmu->features & ARM_SMMU_FEAT_2_LVL_STRTAB) {
+			ret = arm_smmu_init_l2_strtab(smmu, &batch, groups[i].id);
+			if (ret) {
+				/*
+				 * The STEs written so far are still invalid; sync
+				 * what was queued for them before bailing out.
+				 */
+				arm_smmu_cmdq_batch_submit(smmu, &batch);
+				return ret;
+			}
+		}
+
+		arm_smmu_write_strtab_ent_s2(arm_smmu_get_step_for_sid(smmu, groups[i].id),
+					     vmid, (paddr_t) CURRENT_VM->as.pt.root);
+		arm_smmu_batch_ste_for_sid(smmu, &batch, groups[i].id);
+	}
+	arm_smmu_cmdq_batch_submit(smmu, &batch);
 
-	if (smmu->features & ARM_SMMU_FEAT_2_LVL_STRTAB) {
-		ret = arm_smmu_init_l2_strtab(smmu, sid);
-		if (ret)
-			return ret;
+	for (i = 0; i < n; i++) {
+		arm_smmu_write_strtab_ent_valid(arm_smmu_get_step_for_sid(smmu, groups[i].id));
+		arm_smmu_batch_ste_for_sid(smmu, &batch, groups[i].id);
 	}
+	cmd.opcode = CMDQ_OP_TLBI_S12_VMALL;
+	cmd.tlbi.vmid = vmid;
+	arm_smmu_cmdq_batch_add(smmu, &batch, &cmd);
+	arm_smmu_cmdq_batch_submit(smmu, &batch);
 
-	step = arm_smmu_get_step_for_sid(smmu, sid);
-	arm_smmu_write_strtab_ent(smmu, sid, NULL, step, false, vmid, 
-							(paddr_t) CURRENT_VM->as.pt.root);
+	if (vmid < MAX_VM_NUM)
+		bitmap_set(arm_smmu_vmids, vmid);
 
 	return 0;
 }
@@ -1037,19 +1197,68 @@ static int arm_smmu_init_ste(struct arm_smmu_device *smmu, u32 sid, u32 vmid) {
 // }
 
 int arm_smmuv3_vm_dev_init(vmid_t vmid, streamid_t sid) {
+	struct smmu_group group = { .id = sid };
+
+	return arm_smmu_init_stes(&smmu_device, vmid, &group, 1);
+}
+
+int arm_smmuv3_vm_init(vmid_t vmid, const struct smmu_group *groups, size_t n) {
+	if (n == 0)
+		return 0;
+
+	return arm_smmu_init_stes(&smmu_device, vmid, groups, n);
+}
+
+static bool arm_smmu_vmid_attached(struct arm_smmu_device *smmu, vmid_t vmid) {
+	return smmu->base && vmid < MAX_VM_NUM && bitmap_get(arm_smmu_vmids, vmid);
+}
+
+/* Drop all TLB entries of the VM with a single CMD_SYNC */
+void arm_smmuv3_tlb_inv_vm(vmid_t vmid) {
 	struct arm_smmu_device *smmu = &smmu_device;
-	struct arm_smmu_cmdq_ent cmd;
-	int ret;
-	
-	ret = arm_smmu_init_ste(smmu, sid, vmid);
-	if (ret)
-		return ret;
-	
-	cmd.opcode= CMDQ_OP_TLBI_S12_VMALL;
-	cmd.tlbi.vmid = vmid;
-	arm_smmu_cmdq_issue_cmd(smmu, &cmd);
+	struct arm_smmu_cmdq_batch batch;
+	struct arm_smmu_cmdq_ent cmd = {
+		.opcode = CMDQ_OP_TLBI_S12_VMALL,
+		.tlbi.vmid = vmid,
+	};
 
-	return 0;
+	if (!arm_smmu_vmid_attached(smmu, vmid))
+		return;
+
+	arm_smmu_cmdq_batch_init(&batch);
+	arm_smmu_cmdq_batch_add(smmu, &batch, &cmd);
+	arm_smmu_cmdq_batch_submit(smmu, &batch);
+}
+
+/*
+ * Invalidate the stage 2 TLB entries of [ipa, ipa + size) of the VM. All
+ * TLBI commands share one CMD_SYNC; like for the CPU TLBs, large ranges
+ * invalidate the whole VMID instead.
+ */
+void arm_smmuv3_tlb_inv_range(vmid_t vmid, paddr_t ipa, size_t size) {
+	struct arm_smmu_device *smmu = &smmu_device;
+	struct arm_smmu_cmdq_batch batch;
+	struct arm_smmu_cmdq_ent cmd = {
+		.opcode = CMDQ_OP_TLBI_S2_IPA,
+		.tlbi.vmid = vmid,
+		.tlbi.leaf = false,
+	};
+	paddr_t addr;
+
+	if (!arm_smmu_vmid_attached(smmu, vmid))
+		return;
+
+	if (size / PAGE_SIZE > TLB_INV_RANGE_MAX_PAGES) {
+		arm_smmuv3_tlb_inv_vm(vmid);
+		return;
+	}
+
+	arm_smmu_cmdq_batch_init(&batch);
+	for (addr = ipa; addr < ipa + size; addr += PAGE_SIZE) {
+		cmd.tlbi.addr = addr;
+		arm_smmu_cmdq_batch_add(smmu, &batch, &cmd);
+	}
+	arm_smmu_cmdq_batch_submit(smmu, &batch);
 }
 
 // static void arm_smmuv3_cell_exit() {
@@ -2,12 +2,12 @@
 #include "timer.h"
 #include "sysregs.h"
 #include "interrupts.h"
+#include "cpu.h"
 
 #define CNTV_CTL_ENABLE         (1 << 0)    /* Enables the timer */
 #define CNTV_CTL_IMASK          (1 << 1)    /* Timer interrupt mask bit */
 #define CNTV_CTL_ISTATUS        (1 << 2)    /* The status of the timer interrupt. This bit is read-only */
 
-static uint64_t TIMER_WAIT = 2000;
 static uint64_t cntfrq = 0;
 
 static inline void disable_cnthp(void) {
@@ -26,46 +26,174 @@ static inline void enable_cnthp(void) {
 	sysreg_cnthp_ctl_el2_write(cntv_ctl);
 }
 
-void set_el2_timer_sec(uint64_t _sec) {
-	TIMER_WAIT = _sec * 1000;
+uint64_t timer_get_ticks(void) {
+	return sysreg_cntpct_el0_read();
 }
 
-void set_el2_timer_microsec(uint64_t _ms) {
-	TIMER_WAIT = _ms;
+uint64_t timer_ms_to_ticks(uint64_t ms) {
+	return ms * cntfrq / 1000;
 }
 
-void timer_handler(void) {
-	static int cnt = 0;
-	uint64_t ticks, current_cnt;
-	// uint32_t val;
+uint64_t timer_ticks_to_ms(uint64_t ticks) {
+	return ticks * 1000 / cntfrq;
+}
+
+uint64_t timer_ticks_to_us(uint64_t ticks) {
+	return ticks * 1000000 / cntfrq;
+}
+
+static inline struct timer_queue* timer_queue(void) {
+	return &cpu()->arch.timers;
+}
+
+static inline void timer_heap_swap(struct timer_queue* q, size_t i, size_t j) {
+	struct timer_event* ev = q->heap[i];
+
+	q->heap[i] = q->heap[j];
+	q->heap[j] = ev;
+	q->heap[i]->idx = i;
+	q->heap[j]->idx = j;
+}
+
+static void timer_heap_up(struct timer_queue* q, size_t i) {
+	size_t parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (q->heap[parent]->deadline <= q->heap[i]->deadline)
+			break;
+		timer_heap_swap(q, i, parent);
+		i = parent;
+	}
+}
+
+static void timer_heap_down(struct timer_queue* q, size_t i) {
+	size_t l, r, min;
+
+	while (true) {
+		l = 2 * i + 1;
+		r = l + 1;
+		min = i;
+		if (l < q->nr && q->heap[l]->deadline < q->heap[min]->deadline)
+			min = l;
+		if (r < q->nr && q->heap[r]->deadline < q->heap[min]->deadline)
+			min = r;
+		if (min == i)
+			break;
+		timer_heap_swap(q, i, min);
+		i = min;
+	}
+}
+
+static bool timer_heap_insert(struct timer_queue* q, struct timer_event* ev) {
+	if (q->nr == TIMER_MAX_EVENTS)
+		return false;
+
+	ev->idx = q->nr;
+	q->heap[q->nr++] = ev;
+	timer_heap_up(q, ev->idx);
+	return true;
+}
 
-	// Disable the timer
+static void timer_heap_remove(struct timer_queue* q, struct timer_event* ev) {
+	size_t i = ev->idx;
+
+	ev->idx = TIMER_EVENT_IDLE;
+	if (i != --q->nr) {
+		q->heap[i] = q->heap[q->nr];
+		q->heap[i]->idx = i;
+		timer_heap_up(q, i);
+		timer_heap_down(q, q->heap[i]->idx);
+	}
+}
+
+// 只为最早的事件编程CNTHP，没有事件时关闭定时器，空闲的CPU不会被唤醒
+static void timer_program(struct timer_queue* q) {
 	disable_cnthp();
-	// val = sysreg_cnthp_ctl_el2_read();
+	if (q->nr > 0) {
+		sysreg_cnthp_cval_el2_write(q->heap[0]->deadline);
+		enable_cnthp();
+	}
+}
 
-	ticks = TIMER_WAIT * cntfrq / 1000;
-	
-	current_cnt = sysreg_cntpct_el0_read();
-    sysreg_cnthp_cval_el2_write(current_cnt + ticks);
+void timer_event_init(struct timer_event* ev, timer_event_handler_t handler, void* data) {
+	ev->deadline = 0;
+	ev->period = 0;
+	ev->handler = handler;
+	ev->data = data;
+	ev->idx = TIMER_EVENT_IDLE;
+	ev->cpu = cpu()->id;
+}
+
+/**
+ * 在delay个tick后触发ev，period非0时此后每period个tick触发一次。
+ * 对已排队的事件调用相当于重新设定其到期时间。
+ */
+bool timer_event_add(struct timer_event* ev, uint64_t delay, uint64_t period) {
+	struct timer_queue* q = timer_queue();
+
+	if (timer_event_pending(ev)) {
+		ASSERT(ev->cpu == cpu()->id);
+		timer_heap_remove(q, ev);
+	}
+
+	ev->cpu = cpu()->id;
+	ev->deadline = timer_get_ticks() + delay;
+	ev->period = period;
+	if (!timer_heap_insert(q, ev)) {
+		WARNING("cpu%d timer queue full", cpu()->id);
+		return false;
+	}
+
+	timer_program(q);
+	return true;
+}
+
+void timer_event_cancel(struct timer_event* ev) {
+	struct timer_queue* q = timer_queue();
 
-	// INFO("do irq_timer next timestamp: %d", current_cnt + ticks);
-	INFO("TIME IRQ %d", ++cnt);
+	if (!timer_event_pending(ev))
+		return;
 
-	// Enable the timer
-	enable_cnthp();
+	ASSERT(ev->cpu == cpu()->id);
+	timer_heap_remove(q, ev);
+	timer_program(q);
 }
 
+/**
+ * 处理所有已到期的事件。周期事件在调用处理函数之前重新排队，
+ * 这样处理函数可以取消或重新设定它；若已落后多个周期则不再补发。
+ */
+void timer_handler(void) {
+	struct timer_queue* q = timer_queue();
+	struct timer_event* ev;
+	uint64_t now;
 
-void timer_init(void) {
-	// uint64_t current_cnt;
+	disable_cnthp();
+
+	now = timer_get_ticks();
+	while (q->nr > 0 && q->heap[0]->deadline <= now) {
+		ev = q->heap[0];
+		timer_heap_remove(q, ev);
+		if (ev->period != 0) {
+			ev->deadline += ev->period;
+			if (ev->deadline <= now)
+				ev->deadline = now + ev->period;
+			if (!timer_heap_insert(q, ev))
+				WARNING("cpu%d timer queue full, periodic event dropped",
+					cpu()->id);
+		}
+		ev->handler(ev);
+		now = timer_get_ticks();
+	}
+
+	timer_program(q);
+}
 
-	// Disable the timer
+void timer_init(void) {
 	disable_cnthp();
 
-    set_el2_timer_sec(2);
 	cntfrq = sysreg_cntfrq_el0_read();
+	timer_queue()->nr = 0;
 	INFO("EL2 timer frq = %d", cntfrq);
-	// current_cnt = sysreg_cntpct_el0_read();
-
-	enable_cnthp();
-}
\ No newline at end of file
+}
@@ -14,6 +14,14 @@ void uart_print_string(const char *s)  {
 	} while (s[i] != '\0');
 }
 
+// Write a whole buffer, waiting only while the transmit FIFO is full
+void uart_write(const char *buf, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		while (UART_DEVICE->FR & FR_TXFF);
+		UART_DEVICE->DR = (unsigned char)buf[i];
+	}
+}
+
 void uart_print_hex(uint64_t n) {
 	const char *hexdigits = "0123456789ABCDEF";
 
@@ -928,6 +928,11 @@ void vgic_ipi_handler(uint32_t event, uint64_t data) {
     irqid_t int_id = VGIC_MSG_INTID(data);
     uint64_t val = VGIC_MSG_VAL(data);
 
+    if (cpu()->vcpu == NULL) {
+        // The target VM was destroyed after the message was sent
+        return;
+    }
+
     if (vm_id != cpu()->vcpu->vm->id) {
         ERROR("received vgic3 msg target to another vcpu");
         // TODO: need to fetch vcpu from other vm if the taget vm for this
@@ -1163,4 +1168,33 @@ void vgic_set_hw(struct vm *vm, irqid_t id) {
             WARNING("trying to link non-existent virtual irq to physical irq")
         }
     }
-}
\ No newline at end of file
+}
+
+void vgic_alloc(struct vm *vm) {
+    if (vm->arch.vgicd.interrupts != NULL) {
+        return;
+    }
+
+    vm->arch.vgicd.interrupts = mem_alloc_page(VGIC_INT_PAGES, false);
+    if (vm->arch.vgicd.interrupts == NULL) {
+        ERROR("failed to alloc vgic");
+    }
+}
+
+void vgic_free(struct vm *vm) {
+    if (vm->arch.vgicd.interrupts != NULL) {
+        mem_free_page(vm->arch.vgicd.interrupts, VGIC_INT_PAGES);
+        vm->arch.vgicd.interrupts = NULL;
+    }
+}
+
+/**
+ * Clear the list registers when a vCPU leaves this core, so interrupts of a
+ * destroyed VM never show up in the VM that runs here next.
+ */
+void vgic_cpu_release(struct vcpu *vcpu) {
+    for (size_t i = 0; i < NUM_LRS; i++) {
+        gich_write_lr(i, 0);
+    }
+    INIT_LIST_HEAD(&vcpu->arch.vgic_spilled);
+}
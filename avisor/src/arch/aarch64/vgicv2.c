@@ -126,7 +126,6 @@ void vgic_inject_sgi(struct vcpu *vcpu, struct vgic_int *interrupt, vcpuid_t sou
 void vgic_init(struct vm *vm, const struct vgic_dscrp *vgic_dscrp) {
     size_t n;
     size_t vtyper_itln;
-    size_t vgic_int_size;
 
     vm->arch.vgicd.CTLR = 0;
     vtyper_itln = vgic_get_itln(vgic_dscrp);
@@ -141,12 +140,7 @@ void vgic_init(struct vm *vm, const struct vgic_dscrp *vgic_dscrp) {
     mem_alloc_map_dev(&vm->as, (vaddr_t)vgic_dscrp->gicc_addr, 
         (vaddr_t)platform.arch.gic.gicv_addr, n);
 
-    vgic_int_size = vm->arch.vgicd.int_num * sizeof(struct vgic_int);
-    vm->arch.vgicd.interrupts =
-        mem_alloc_page(NUM_PAGES(vgic_int_size), false);
-    if (vm->arch.vgicd.interrupts == NULL) {
-        ERROR("failed to alloc vgic");
-    }
+    vgic_alloc(vm);
 
     for (size_t i = 0; i < vm->arch.vgicd.int_num; i++) {
         vm->arch.vgicd.interrupts[i].owner = NULL;
@@ -294,7 +294,6 @@ bool vgic_icc_sre_handler(struct emul_access *acc) {
 }
 
 void vgic_init(struct vm *vm, const struct vgic_dscrp *vgic_dscrp) {
-    size_t vgic_int_size;
     struct vcpu* vcpu = NULL;
     uint64_t typer;
 
@@ -308,12 +307,7 @@ void vgic_init(struct vm *vm, const struct vgic_dscrp *vgic_dscrp) {
         (((10 - 1) << GICD_TYPER_IDBITS_OFF) & GICD_TYPER_IDBITS_MSK);
     vm->arch.vgicd.IIDR = gicd->IIDR;
 
-    vgic_int_size = vm->arch.vgicd.int_num * sizeof(struct vgic_int);
-    vm->arch.vgicd.interrupts =
-        mem_alloc_page(NUM_PAGES(vgic_int_size), false);
-    if (vm->arch.vgicd.interrupts == NULL) {
-        ERROR("failed to alloc vgic");
-    }
+    vgic_alloc(vm);
 
     for (size_t i = 0; i < vm->arch.vgicd.int_num; i++) {
         vm->arch.vgicd.interrupts[i].owner = NULL;
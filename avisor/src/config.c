@@ -16,6 +16,8 @@ VM_IMAGE(vm1, "./image/4.restart.bin");
 #elif TEST_SCENE == 5
 VM_IMAGE(vm1, "./image/5.1.mem-reader.bin");
 VM_IMAGE(vm2, "./image/5.2.mem-writer.bin");
+#elif TEST_SCENE == 6
+VM_IMAGE(vm1, "./image/app-helloworld_kvm-arm64"); // 周期快照
 #elif TEST_SCENE == -1
 VM_IMAGE(vm1, "./image/output.bin"); // 调试用
 #endif
@@ -40,7 +42,7 @@ struct config config = {
             .base_addr = 0x40100000, 
             .load_addr = VM_IMAGE_OFFSET(vm1),
             .size = VM_IMAGE_SIZE(vm1),
-#if TEST_SCENE == 0
+#if TEST_SCENE == 0 || TEST_SCENE == 6
             .entry = 0x0000000040101b20,
 #else
             .entry = ENTRY_POINT, // 0x0000000040101b20,
@@ -67,6 +69,19 @@ struct config config = {
                 .rq_size = (1024 * 1024),
                 .vbase = 0x10000000,
             },
+#ifdef VIRTIO_CONSOLE
+            .vcons = {
+                .base = 0x0a000000,     // QEMU virt 的第一个 virtio-mmio 槽位
+                .irq = 48,
+            },
+#endif
+#if TEST_SCENE == 6
+            .ckpt = {
+                .interval_ms = 4000,
+                .retention = 2,
+                .max_overhead = 5,      // 快照耗时不超过客户机运行时间的5%
+            },
+#endif
             .arch.gic = {
                 .gicd_addr = 0x08000000,
                 .gicc_addr = 0x08010000,
@@ -86,6 +101,12 @@ struct config config = {
                 .rq_size = (1024 * 1024),
                 .vbase = 0x10000000,
             },
+#ifdef VM_SWAP
+            .swap = {
+                .mem_limit = 0x4000000,     // 常驻64MB，其余压缩换出
+                .store_size = 0x2000000,
+            },
+#endif
             .arch.gic = {
                 .gicd_addr = 0x08000000,
                 .gicc_addr = 0x08010000,
@@ -94,6 +115,38 @@ struct config config = {
         }
 #endif
     },
+    // 管理虚拟机通过VM_CREATE在空闲CPU上创建的虚拟机
+    .nr_templates = 1,
+    .templates = (struct vm_config[]) {
+        {
+            .base_addr = 0x40100000,
+            .load_addr = VM_IMAGE_OFFSET(vm1),
+            .size = VM_IMAGE_SIZE(vm1),
+#if TEST_SCENE == 0 || TEST_SCENE == 6
+            .entry = 0x0000000040101b20,
+#else
+            .entry = ENTRY_POINT,
+#endif
+            .dmem_size = 0x4000000, // 64MB
+            .nr_cpus = 1,
+            .nr_devs = 1,
+            .devs = (struct vm_dev_region[]) {
+                {
+                    .interrupt_num = 1,
+                    .interrupts = (irqid_t[]) {27}
+                }
+            },
+            .rq_vm = {
+                .rq_size = (1024 * 1024),
+                .vbase = 0x10000000,
+            },
+            .arch.gic = {
+                .gicd_addr = 0x08000000,
+                .gicc_addr = 0x08010000,
+                .gicr_addr = 0x080A0000,
+            }
+        },
+    },
     .dtb = {
         .base_addr = 0x40000000,
         .load_addr = DTB_IMAGE_OFFSET(dtb1),
@@ -0,0 +1,46 @@
+#include "boot.h"
+#include "cpu.h"
+#include "timer.h"
+#include "spinlock.h"
+
+static struct boot_mark boot_marks[BOOT_MAX_MARKS];
+static size_t nr_boot_marks = 0;
+static spinlock_t boot_lock = SPINLOCK_INITVAL;
+
+// 记录一个启动阶段结束的时间，超出容量的记录被丢弃
+void boot_mark(const char* stage) {
+    uint64_t ticks = timer_get_ticks();
+
+    spin_lock(&boot_lock);
+    if (nr_boot_marks < BOOT_MAX_MARKS) {
+        boot_marks[nr_boot_marks++] = (struct boot_mark){stage, ticks, cpu()->id};
+    }
+    spin_unlock(&boot_lock);
+}
+
+// 输出本CPU的启动时间线，第一条记录之前的时间即固件与早期启动的耗时
+void boot_timeline_dump() {
+    uint64_t first, prev;
+    struct boot_mark* mark;
+
+    spin_lock(&boot_lock);
+    if (nr_boot_marks == 0) {
+        spin_unlock(&boot_lock);
+        return;
+    }
+
+    first = boot_marks[0].ticks;
+    prev = 0;
+    INFO("cpu%d boot timeline (first mark at %dus):", cpu()->id, timer_ticks_to_us(first));
+    for (size_t i = 0; i < nr_boot_marks; i++) {
+        mark = &boot_marks[i];
+        if (mark->cpu != cpu()->id) {
+            continue;
+        }
+        INFO("  %s: +%dus (at %dus)", mark->stage,
+            prev ? timer_ticks_to_us(mark->ticks - prev) : 0,
+            timer_ticks_to_us(mark->ticks - first));
+        prev = mark->ticks;
+    }
+    spin_unlock(&boot_lock);
+}
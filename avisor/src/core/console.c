@@ -4,6 +4,14 @@
  
 spinlock_t lock = SPINLOCK_INITVAL;
 
+#define CONSOLE_LINE_SIZE (128)
+
+// 每个虚拟机的行缓冲，输出按行加上虚拟机标签，避免不同虚拟机的输出交错
+static struct {
+    char buf[CONSOLE_LINE_SIZE];
+    size_t len;
+} vm_lines[MAX_VM_NUM];
+
 void console_init() {
 
 }
@@ -12,4 +20,32 @@ void console_write(char const* const str) {
     spin_lock(&lock);
     uart_print_string(str);
     spin_unlock(&lock);
-}
\ No newline at end of file
+}
+
+// 需持有lock
+static void console_flush_vm(vmid_t vm_id) {
+    char tag[] = "[vm0] ";
+
+    tag[3] = '0' + vm_id;
+    uart_write(tag, sizeof(tag) - 1);
+    uart_write(vm_lines[vm_id].buf, vm_lines[vm_id].len);
+    vm_lines[vm_id].len = 0;
+}
+
+void console_write_vm(vmid_t vm_id, const char* buf, size_t len) {
+    char c;
+
+    if (vm_id >= MAX_VM_NUM) {
+        return;
+    }
+
+    spin_lock(&lock);
+    for (size_t i = 0; i < len; i++) {
+        c = buf[i];
+        vm_lines[vm_id].buf[vm_lines[vm_id].len++] = c;
+        if (c == '\n' || vm_lines[vm_id].len == CONSOLE_LINE_SIZE) {
+            console_flush_vm(vm_id);
+        }
+    }
+    spin_unlock(&lock);
+}
@@ -27,8 +27,6 @@ extern cpu_msg_handler_t ipi_cpumsg_handlers[];
 extern size_t _ipi_cpumsg_handlers_id_start[];
 size_t ipi_cpumsg_handler_num;
 
-// 暂时
-#define PLAT_CPU_NUM  2
 struct cpuif cpu_interfaces[PLAT_CPU_NUM];
 
 void cpu_init(cpuid_t cpu_id) {
@@ -0,0 +1,22 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include "util.h"
+
+#define BOOT_MAX_MARKS (64)
+
+/**
+ * 启动时间线。启动的每个阶段记录一个cntpct_el0时间戳；每个CPU在进入其虚拟机
+ * （或进入空闲）前打印自己的各阶段，包括每阶段的耗时以及相对所有CPU中
+ * 第一个时间戳的偏移。
+ */
+struct boot_mark {
+    const char* stage;
+    uint64_t ticks;
+    cpuid_t cpu;
+};
+
+void boot_mark(const char* stage);
+void boot_timeline_dump();
+
+#endif /* BOOT_H */
@@ -0,0 +1,52 @@
+#ifndef CKPT_H
+#define CKPT_H
+
+#include "util.h"
+#include "timer.h"
+
+struct vm;
+struct vm_config;
+struct snapshot;
+
+#define CKPT_MAX_BACKOFF (16)       // 自适应间隔最多放宽到配置间隔的倍数
+#define CKPT_IDLE_DIRTY_SHIFT (6)   // 脏页少于1/64视为空闲，放宽间隔
+#define CKPT_BUSY_DIRTY_SHIFT (2)   // 脏页多于1/4视为繁忙，回到配置间隔
+#define CKPT_RETRY_MS (10)          // 其他快照操作进行中时的重试间隔
+
+struct ckpt_config_vm {
+    size_t interval_ms;     // 自动快照的目标间隔，0表示不启用
+    size_t retention;       // 保留的自动快照个数
+    size_t max_overhead;    // 快照开销占客户机运行时间的上限（百分比）
+};
+
+/**
+ * 由虚拟机监控器周期性创建、无需客户机参与的自动快照。
+ * 间隔从配置值开始，每次快照后调整：客户机脏页很少时逐步放宽，
+ * 重新变忙时回到配置值；并且间隔不会小于使实测快照开销不超过
+ * 客户机运行时间max_overhead百分比的值。
+ * 自动快照保存在每个虚拟机的retention个槽位组成的环中，与快照hypercall
+ * 使用的快照池相互独立。
+ */
+struct vm_ckpt {
+    bool enabled;
+
+    uint64_t base_interval;     // 以下时间均为计数器tick
+    uint64_t interval;
+    uint64_t last;              // 上一次快照结束的时间
+    struct timer_event timer;   // 在主CPU上到期
+    uint64_t cost;              // 快照耗时的滑动平均
+    size_t max_overhead;
+
+    struct snapshot* slots;
+    size_t slot_size;
+    size_t nr_slots;
+    size_t cur_slot;
+
+    size_t nr_taken;
+    size_t nr_skipped;          // 因其他快照操作进行中而推迟的次数
+};
+
+void vm_ckpt_init(struct vm* vm, const struct vm_config* config);
+void vm_ckpt_release(struct vm* vm);
+
+#endif /* CKPT_H */
@@ -5,11 +5,15 @@
 #include "vm.h"
 #include "platform.h"
 #include "rq.h"
+#include "swap.h"
+#include "virtio_console.h"
+#include "ckpt.h"
 
 #define VM_IMAGE(img_name, img_path)                                         \
     extern uint8_t _##img_name##_vm_size;                                    \
     extern uint8_t _##img_name##_vm_beg;                                     \
     asm(".pushsection .vm_image_" XSTR(img_name) ", \"a\"\n\t"               \
+        ".balign 0x1000\n\t"                                                 \
         ".global _" XSTR(img_name) "_vm_beg\n\t"                             \
         "_" XSTR(img_name) "_vm_beg:\n\t"                                    \
         ".incbin " XSTR(img_path) "\n\t"                                     \
@@ -26,6 +30,7 @@
     extern uint8_t _##dtb_name##_dtb_size;                                    \
     extern uint8_t _##dtb_name##_dtb_beg;                                     \
     asm(".pushsection .dtb_image_" XSTR(dtb_name) ", \"a\"\n\t"               \
+        ".balign 0x1000\n\t"                                                  \
         ".global _" XSTR(dtb_name) "_dtb_beg\n\t"                             \
         "_" XSTR(dtb_name) "_dtb_beg:\n\t"                                    \
         ".incbin " XSTR(dtb_path) "\n\t"                                     \
@@ -40,6 +45,9 @@
 
 struct hyp_config {
     size_t nr_cpus;
+    bool has_mgmt_vm;       // 是否启用管理虚拟机，默认不启用
+    vmid_t mgmt_vm;         // 可以在运行时创建与销毁虚拟机的管理虚拟机
+    size_t vm_pool_size;    // 预先分配的虚拟机个数，见vmm_pool
 };
 
 struct dtb_config {
@@ -60,6 +68,9 @@ struct vm_config {
     struct vm_dev_region* devs; 
 
     struct rq_config_vm rq_vm;
+    struct swap_config_vm swap;
+    struct virtio_console_config_vm vcons;
+    struct ckpt_config_vm ckpt;
 
     struct arch_vm_platform arch;
 };
@@ -68,6 +79,8 @@ extern struct config {
     struct hyp_config hyp;
     size_t nr_vms;
     struct vm_config* vm;
+    size_t nr_templates;            // 运行时创建虚拟机可用的模板
+    struct vm_config* templates;
     struct dtb_config dtb;
 } config;
 
@@ -1,7 +1,10 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
+#include "util.h"
+
 void console_init();
 void console_write(char const* const str);
+void console_write_vm(vmid_t vm_id, const char* buf, size_t len);
 
 #endif /* CONSOLE_H */
\ No newline at end of file
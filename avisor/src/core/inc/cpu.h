@@ -10,6 +10,9 @@
 
 #define CPU_MASTER 0
 
+// 暂时
+#define PLAT_CPU_NUM  2
+
 struct cpuif {
     struct list_head event_list;
     spinlock_t event_list_lock;
@@ -24,6 +27,9 @@ struct cpu {
     struct vcpu* vcpu;
     struct cpu_arch arch;
     struct cpuif* interface;
+#ifdef SCHEDULE
+    struct timer_event sched_tick;
+#endif
     uint8_t stack[STACK_SIZE] __attribute__((aligned(PAGE_SIZE)));
 } __attribute__((aligned(PAGE_SIZE)));
 
@@ -21,6 +21,7 @@ enum irq_res { HANDLED_BY_HYP, FORWARD_TO_VM };
 enum irq_res interrupts_handle(irqid_t int_id);
 
 void interrupts_vm_assign(struct vm *vm, irqid_t id);
+void interrupts_vm_release(struct vm *vm);
 
 // ARCH
 void interrupts_arch_init();
@@ -30,5 +31,7 @@ void interrupts_arch_clear(irqid_t int_id);
 bool interrupts_arch_check(irqid_t int_id);
 bool interrupts_arch_conflict(bitmap_t* interrupt_bitmap, irqid_t id);
 void interrupts_arch_vm_assign(struct vm *vm, irqid_t id);
+void interrupts_arch_vm_release(struct vm *vm, irqid_t id);
+void interrupts_arch_handle();
 
 #endif
\ No newline at end of file
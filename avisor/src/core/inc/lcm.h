@@ -26,10 +26,27 @@ struct snapshot {
     ssid_t ss_id;
     size_t size;
     uint32_t vm_id;
-    struct vcpu vcpu;
-    char mem[0];
+    uint32_t csum;          // page_csum数组自身的CRC32C
+    size_t nr_pages;        // 客户机内存页数
+    size_t nr_unchanged;    // 与上一个快照相比内容未变化的页数
+    size_t nr_vcpus;
+    struct vcpu vcpus[MAX_VCPU_PER_VM];
+    uint32_t page_csum[0];  // 每页内存的CRC32C，之后是按字对齐的内存数据
 };
 
+// 快照头（含每页校验和）的大小，内存数据紧随其后
+static inline size_t ss_hdr_size(size_t nr_pages) {
+    return ALIGN(sizeof(struct snapshot) + nr_pages * sizeof(uint32_t), sizeof(uint64_t));
+}
+
+static inline size_t ss_total_size(size_t mem_size) {
+    return ss_hdr_size(NUM_PAGES(mem_size)) + mem_size;
+}
+
+static inline char* ss_mem(struct snapshot* ss) {
+    return (char*)ss + ss_hdr_size(ss->nr_pages);
+}
+
 void checkpoint_snapshot_handler(unsigned long iss, unsigned long far, unsigned long il, unsigned long ec);
 void restore_snapshot_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
 void guest_halt_handler(unsigned long iss, unsigned long far, unsigned long il, unsigned long ec);
@@ -38,6 +55,6 @@ void restart_vm_handler(unsigned long iss, unsigned long arg0, unsigned long arg
 extern struct list_head ss_pool_list;
 
 static struct snapshot_pool* alloc_ss_pool();
-void restore_snapshot_handler_by_ss(struct snapshot* ss);
+bool restore_snapshot_handler_by_ss(struct snapshot* ss);
 
 #endif
\ No newline at end of file
@@ -7,12 +7,6 @@
 #include "spinlock.h"
 #include "bitmap.h"
 
-struct shared_memory_device {
-    vaddr_t va;     // 虚拟地址
-    paddr_t pa;     // 物理地址
-    size_t size;    // 大小
-};
-
 struct ppages {
     paddr_t base;
     size_t nr_pages;
@@ -33,6 +27,27 @@ struct mem_region {
     struct page_pool page_pool;
 };
 
+/**
+ * 对同一地址空间的一批页表更新。批量中的映射/解映射只记录TLB表项失效的范围，
+ * 提交时按范围或对整个VMID统一无效化一次TLB。
+ */
+struct mem_batch {
+    struct addr_space* as;
+    vaddr_t inv_start;
+    vaddr_t inv_end;
+};
+
+// 记录需要无效化TLB的地址范围，在提交批次时统一处理
+static inline void mem_batch_inv(struct mem_batch* batch, vaddr_t va, size_t size) {
+    if (batch->inv_start == batch->inv_end) {
+        batch->inv_start = va;
+        batch->inv_end = va + size;
+    } else {
+        batch->inv_start = MIN(batch->inv_start, va);
+        batch->inv_end = MAX(batch->inv_end, va + size);
+    }
+}
+
 static inline struct ppages mem_ppages_get(paddr_t base, size_t nr_pages) {
     return (struct ppages){.base = base, .nr_pages = nr_pages};
 }
@@ -49,9 +64,20 @@ bool mem_map(struct addr_space *as, vaddr_t va, struct ppages *ppages,
             size_t nr_pages, mem_flags_t flags);                 
 vaddr_t mem_alloc_map_dev(struct addr_space* as, 
                              vaddr_t at, paddr_t pa, size_t nr_pages);  
+bool mem_map_huge(struct addr_space* as, vaddr_t va, struct ppages* ppages,
+                  mem_flags_t flags);
 void mem_unmap(struct addr_space* as, vaddr_t at, size_t num_pages,
                     bool free_ppages);     
 bool mem_free_page(void *page, size_t nr_pages);
+bool mem_walk(struct addr_space* as, vaddr_t va, paddr_t* pa);
+pte_t* mem_leaf_pte(struct addr_space* as, vaddr_t va, size_t* lvl);
+
+void mem_batch_begin(struct mem_batch* batch, struct addr_space* as);
+bool mem_batch_map(struct mem_batch* batch, vaddr_t va, struct ppages* ppages,
+                   size_t nr_pages, mem_flags_t flags);
+void mem_batch_unmap(struct mem_batch* batch, vaddr_t at, size_t num_pages,
+                     bool free_ppages);
+void mem_batch_commit(struct mem_batch* batch);
 /* Functions implemented in architecture dependent files */
 
 void as_arch_init(struct addr_space* as);
@@ -59,6 +85,9 @@ bool mem_translate(struct addr_space* as, vaddr_t va, paddr_t* pa);
 
 extern struct page_pool* root_page_pool;
 size_t mem_get_free_pages();
-extern struct shared_memory_device* shared_mem;
+
+#ifdef MEM_BENCH
+void mem_bench();
+#endif
 
 #endif /* MEM_H */
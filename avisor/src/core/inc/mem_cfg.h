@@ -13,7 +13,7 @@
 #define VM_SIZE         0x78000000      // size: 1.5GB, 不能超过2GB，否则会造成地址空间不足
 #define RQ_REGION_SIZE  0x10000000      // size: 256MB
 #define SHARED_MEM_SIZE 0x1000000       // size: 16MB
-#define SHARED_MEM_BASE 0x70000000      // 共享内存的基地址(虚拟地址)
+#define SHARED_MEM_BASE 0x70000000      // 兼容旧客户机的共享内存，映射到每个虚拟机的该IPA
 
 #define CPU_STACK_OFF   PAGE_SIZE
 #define CPU_STACK_SIZE  PAGE_SIZE
@@ -20,6 +20,8 @@ typedef pte_t mem_flags_t;
 
 void as_init(struct addr_space* as, enum type type, asid_t asid,
             pte_t* root_pt);
+pte_t* as_alloc_root(enum type type);
+void as_destroy(struct addr_space* as);
 vaddr_t mem_alloc_vpage(struct addr_space* as, vaddr_t at, size_t n);
 
 #endif
\ No newline at end of file
@@ -3,29 +3,74 @@
 
 #include "spinlock.h"
 #include "bitmap.h"
+#include "cpu.h"
+
+#define OBJPOOL_MAG_SIZE (16)       // 每个CPU缓存的空闲对象个数上限
+#define OBJPOOL_MAG_ALIGN (64)      // 按缓存行对齐，避免不同CPU的弹匣伪共享
+
+typedef void (*objpool_ctor_t)(void* obj);
+
+/**
+ * 每个CPU的空闲对象弹匣。只有所属CPU访问它，且EL2运行时屏蔽中断，
+ * 因此从弹匣分配和释放无需加锁。弹匣与共享池之间成批补充和归还。
+ */
+struct objpool_mag {
+    size_t nr;
+    void* objs[OBJPOOL_MAG_SIZE];
+    size_t nr_alloc;
+    size_t nr_free;
+} __attribute__((aligned(OBJPOOL_MAG_ALIGN)));
+
+struct objpool_stats {
+    size_t nr_alloc;
+    size_t nr_free;
+    size_t nr_refill;       // 从共享池批量取出的次数
+    size_t nr_flush;        // 批量归还共享池的次数
+    size_t nr_fail;
+    size_t nr_cached;       // 当前缓存在各CPU弹匣中的对象
+    size_t nr_inuse;
+};
 
 struct objpool {
+    const char* name;
     void* pool;
     bitmap_t* bitmap;
     size_t objsize;
     size_t num;
-    size_t count;
+    size_t count;           // 共享池之外（弹匣中或使用中）的对象个数
     spinlock_t lock;
+
+    objpool_ctor_t ctor;    // 对象第一次离开共享池之前调用一次，释放时须恢复构造后的状态
+    bool ready;
+    size_t hint;            // 下一次在位图中查找的起点
+    size_t mag_size;        // 按池大小限制，避免对象滞留在其他CPU的弹匣中
+    size_t batch;
+    size_t nr_refill;
+    size_t nr_flush;
+    size_t nr_fail;
+
+    struct objpool_mag mags[PLAT_CPU_NUM];
 };
 
-#define OBJPOOL_ALLOC(NAME, TYPE, N) \
+#define OBJPOOL_ALLOC_CTOR(NAME, TYPE, N, CTOR) \
     TYPE _##NAME##_array[N];\
     BITMAP_ALLOC(_##NAME##_array_bitmap, N);\
     struct objpool NAME = {\
+        .name = #NAME,\
         .pool = _##NAME##_array,\
         .bitmap = _##NAME##_array_bitmap,\
         .objsize = sizeof(TYPE),\
         .num = N,\
         .lock = SPINLOCK_INITVAL,\
+        .ctor = CTOR,\
     }
 
+#define OBJPOOL_ALLOC(NAME, TYPE, N) OBJPOOL_ALLOC_CTOR(NAME, TYPE, N, NULL)
+
 void objpool_init(struct objpool *objpool);
 void* objpool_alloc(struct objpool *objpool);
 void objpool_free(struct objpool *objpool, void* obj);
+void objpool_get_stats(struct objpool *objpool, struct objpool_stats *stats);
+void objpool_print_stats(struct objpool *objpool);
 
-#endif
\ No newline at end of file
+#endif
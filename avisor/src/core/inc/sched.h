@@ -4,6 +4,7 @@
 #include "vm.h"
 
 #define DEFAULT_COUNTER 2
+#define SCHED_TICK_MS 2000
 #define BMQ_LEVELS 8
 #define DEFAULT_LEVEL 4
 
@@ -0,0 +1,49 @@
+#ifndef SHMEM_H
+#define SHMEM_H
+
+#include "util.h"
+#include "mem.h"
+
+#define SHMEM_MAX_REGIONS (16)
+#define SHMEM_BLOCK_SIZE (0x200000)     // 共享内存以2MB块分配与映射
+
+/**
+ * 每个虚拟机对一个共享内存区域的权限，创建时由arg2按虚拟机ID给出，
+ * 每个虚拟机占2位。创建者总是拥有读写权限。
+ */
+#define SHMEM_PERM_NONE (0x0)
+#define SHMEM_PERM_RO (0x1)
+#define SHMEM_PERM_RW (0x3)
+#define SHMEM_PERM_BITS (2)
+#define SHMEM_PERM(vmid, perm) ((uint64_t)(perm) << ((vmid) * SHMEM_PERM_BITS))
+
+#define SHMEM_SUCCESS (0)
+#define SHMEM_ERROR ((unsigned long)-1)
+
+/**
+ * 由虚拟机监控器分配、带名字的共享内存区域，虚拟机可将其挂载到自选的IPA。
+ * 名字最多8个ASCII字符，打包在一个寄存器中传递，hypercall无需读取客户机内存。
+ */
+struct shmem_region {
+    bool used;
+    uint64_t name;
+    struct ppages ppages;
+    vmid_t owner;
+    uint64_t perms;
+    vaddr_t ipa[MAX_VM_NUM];    // 各虚拟机的映射地址，未映射为INVALID_VA
+    size_t refs;
+    bool pinned;                // 由虚拟机监控器创建，没有使用者时也不释放
+};
+
+struct vm;
+
+void shmem_init();
+void shmem_vm_init(struct vm* vm);
+void shmem_vm_release(struct vm* vm);
+
+// Hypercall Handler
+void shmem_create_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void shmem_attach_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void shmem_detach_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+
+#endif /* SHMEM_H */
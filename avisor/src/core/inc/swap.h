@@ -0,0 +1,58 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "util.h"
+#include "spinlock.h"
+#include "bitmap.h"
+#include "page_table.h"
+#include "timer.h"
+
+struct vm;
+struct vm_config;
+
+#define SWAP_CHUNK_SIZE (64)        // 压缩存储的分配粒度（字节）
+#define SWAP_SCAN_PAGES (4096)      // 每次时钟扫描检查的页数
+#define SWAP_RECLAIM_PAGES (256)    // 每次最多回收的页数
+#define SWAP_MAX_CSIZE (PAGE_SIZE * 3 / 4)  // 压缩后超过该大小的页不换出
+#define SWAP_SCAN_PERIOD_MS (2000)  // 时钟扫描的周期
+
+struct swap_config_vm {
+    size_t mem_limit;   // 驻留内存上限（字节），0表示不启用超分
+    size_t store_size;  // 压缩存储区大小（字节）
+};
+
+/**
+ * 客户机内存超分。超出mem_limit的客户机页由基于二阶段访问标志的时钟扫描回收：
+ * 冷页被压缩到每个虚拟机的存储区，全零页直接丢弃，二阶段表项替换为
+ * 带PTE_RSW_SWAP/PTE_RSW_ZERO标记的无效描述符。
+ * 之后客户机访问该页时触发转换错误，再将页换入。
+ */
+struct vm_swap {
+    spinlock_t lock;
+    bool enabled;
+
+    vaddr_t base;           // 可回收的客户机内存范围
+    size_t nr_pages;
+    size_t nr_limit;        // 驻留页上限
+    size_t nr_resident;     // 当前驻留页数
+    size_t cursor;          // 时钟扫描位置
+    struct timer_event scan_timer;
+
+    uint8_t* store;         // 压缩存储区
+    bitmap_t* store_bitmap;
+    size_t nr_chunks;
+    uint8_t* scratch;       // 压缩时使用的临时页
+    pte_t** victims;        // 本轮扫描选出的换出页
+
+    size_t nr_swapped;      // 当前被压缩换出的页数
+    size_t nr_zero;         // 当前被回收的全零页数
+    size_t nr_swap_in;
+    size_t nr_swap_out;
+};
+
+void vm_swap_init(struct vm* vm, const struct vm_config* config);
+void vm_swap_release(struct vm* vm);
+bool vm_swap_fault(struct vm* vm, vaddr_t ipa, unsigned long fsc);
+paddr_t vm_swap_page_pa(struct vm* vm, vaddr_t ipa);
+
+#endif /* SWAP_H */
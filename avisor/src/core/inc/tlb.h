@@ -3,6 +3,7 @@
 
 #include "arch_tlb.h"
 #include "mmu.h"
+#include "iommu.h"
 
 static inline void tlb_inv_va(struct addr_space *as, vaddr_t va)
 {
@@ -10,7 +11,7 @@ static inline void tlb_inv_va(struct addr_space *as, vaddr_t va)
         tlb_hyp_inv_va(va);
     } else if (as->type == AS_VM) {
         tlb_vm_inv_va(as->asid, va);
-        // TODO: inval iommu tlbs
+        iommu_arch_tlb_inv_range(as->asid, va, PAGE_SIZE);
     }
 }
 
@@ -20,7 +21,17 @@ static inline void tlb_inv_all(struct addr_space *as)
         tlb_hyp_inv_all();
     } else if (as->type == AS_VM) {
         tlb_vm_inv_all(as->asid);
-        // TODO: inval iommu tlbs
+        iommu_arch_tlb_inv_all(as->asid);
+    }
+}
+
+static inline void tlb_inv_range(struct addr_space *as, vaddr_t va, size_t size)
+{
+    if (as->type == AS_HYP) {
+        tlb_hyp_inv_range(va, size);
+    } else if (as->type == AS_VM) {
+        tlb_vm_inv_range(as->asid, va, size);
+        iommu_arch_tlb_inv_range(as->asid, va, size);
     }
 }
 
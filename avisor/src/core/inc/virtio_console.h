@@ -0,0 +1,106 @@
+#ifndef VIRTIO_CONSOLE_H
+#define VIRTIO_CONSOLE_H
+
+#include "util.h"
+#include "spinlock.h"
+#include "emul.h"
+
+struct vm;
+struct vm_config;
+
+/* virtio-mmio 寄存器（virtio 1.x，version 2） */
+#define VIRTIO_MMIO_MAGIC_VALUE         0x000
+#define VIRTIO_MMIO_VERSION             0x004
+#define VIRTIO_MMIO_DEVICE_ID           0x008
+#define VIRTIO_MMIO_VENDOR_ID           0x00c
+#define VIRTIO_MMIO_DEVICE_FEATURES     0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL 0x014
+#define VIRTIO_MMIO_DRIVER_FEATURES     0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL 0x024
+#define VIRTIO_MMIO_QUEUE_SEL           0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX       0x034
+#define VIRTIO_MMIO_QUEUE_NUM           0x038
+#define VIRTIO_MMIO_QUEUE_READY         0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY        0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS    0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK       0x064
+#define VIRTIO_MMIO_STATUS              0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW      0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH     0x084
+#define VIRTIO_MMIO_QUEUE_AVAIL_LOW     0x090
+#define VIRTIO_MMIO_QUEUE_AVAIL_HIGH    0x094
+#define VIRTIO_MMIO_QUEUE_USED_LOW      0x0a0
+#define VIRTIO_MMIO_QUEUE_USED_HIGH     0x0a4
+#define VIRTIO_MMIO_CONFIG_GENERATION   0x0fc
+#define VIRTIO_MMIO_CONFIG              0x100
+#define VIRTIO_MMIO_SIZE                0x200
+
+#define VIRTIO_MMIO_MAGIC               0x74726976  // "virt"
+#define VIRTIO_MMIO_VENDOR              0x52535641  // "AVSR"
+#define VIRTIO_ID_CONSOLE               3
+#define VIRTIO_F_VERSION_1              32
+#define VIRTIO_MMIO_INT_VRING           (1 << 0)
+
+#define VIRTQ_DESC_F_NEXT               1
+#define VIRTQ_DESC_F_WRITE              2
+#define VIRTQ_AVAIL_F_NO_INTERRUPT      1
+
+/* virtio console 的配置空间偏移 */
+#define VIRTIO_CONSOLE_EMERG_WR         0x8
+
+#define VIRTIO_CONSOLE_RX_QUEUE         0
+#define VIRTIO_CONSOLE_TX_QUEUE         1
+#define VIRTIO_CONSOLE_NR_QUEUES        2
+#define VIRTIO_CONSOLE_QUEUE_MAX        256
+
+struct virtio_console_config_vm {
+    vaddr_t base;   // virtio-mmio 寄存器的客户机物理地址，0表示不提供该设备
+    irqid_t irq;
+};
+
+struct virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed));
+
+struct virtq_used_elem {
+    uint32_t id;
+    uint32_t len;
+} __attribute__((packed));
+
+struct virtio_queue {
+    uint32_t num;
+    uint32_t ready;
+    vaddr_t desc;
+    vaddr_t avail;
+    vaddr_t used;
+    uint16_t last_avail;
+    uint16_t used_idx;
+};
+
+/**
+ * 模拟的virtio-mmio控制台。客户机在发送队列上一次交出整块缓冲区并只通知一次；
+ * 虚拟机监控器将其拷出，加上虚拟机ID前缀后写入物理UART。
+ */
+struct virtio_console {
+    bool enabled;
+    spinlock_t lock;
+    vaddr_t base;
+    irqid_t irq;
+
+    uint32_t status;
+    uint32_t int_status;
+    uint32_t dev_features_sel;
+    uint32_t drv_features_sel;
+    uint64_t drv_features;
+    uint32_t queue_sel;
+    struct virtio_queue queues[VIRTIO_CONSOLE_NR_QUEUES];
+
+    struct emul_mem emul;
+};
+
+void virtio_console_init(struct vm* vm, const struct vm_config* config);
+
+#endif /* VIRTIO_CONSOLE_H */
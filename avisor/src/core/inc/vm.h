@@ -11,6 +11,9 @@
 #include "emul.h"
 #include "config.h"
 #include "rq.h"
+#include "swap.h"
+#include "virtio_console.h"
+#include "ckpt.h"
 
 struct vm_mem_region {
     paddr_t base;
@@ -67,6 +70,9 @@ struct vm {
     struct list_head list;  //vm list 
 
     struct rq_vm rq;
+    struct vm_swap swap;
+    struct virtio_console vcons;
+    struct vm_ckpt ckpt;
 
     struct vm_io io;
 
@@ -78,6 +84,7 @@ struct vm_allocation {
     size_t size;
     struct vm *vm;
     struct vcpu *vcpus;
+    pte_t *root_pt;     // 预先分配的第二阶段页表根，NULL表示由as_init分配
 };
 
 struct vm_list {
@@ -98,6 +105,13 @@ void vm_emul_add_mem(struct vm* vm, struct emul_mem* emu);
 void vm_emul_add_reg(struct vm* vm, struct emul_reg* emu);
 emul_handler_t vm_emul_get_mem(struct vm* vm, vaddr_t addr);
 emul_handler_t vm_emul_get_reg(struct vm* vm, vaddr_t addr);
+bool vm_ipa_to_pa(struct vm* vm, vaddr_t ipa, paddr_t* pa);
+bool vm_copy_from_guest(struct vm* vm, void* dst, vaddr_t ipa, size_t len);
+bool vm_copy_to_guest(struct vm* vm, vaddr_t ipa, const void* src, size_t len);
+bool vm_cow_break(struct vm* vm, vaddr_t ipa);
+void vm_clear_mem(struct vm* vm);
+void vm_reset_images(struct vm* vm);
+void vm_destroy(struct vm* vm);
 
 static inline struct vcpu* vm_get_vcpu(struct vm* vm, vcpuid_t vcpuid) {
     if (vcpuid < vm->nr_cpus) {
@@ -138,11 +152,13 @@ static inline void vcpu_inject_irq(struct vcpu *vcpu, irqid_t id) {
 }
 
 struct vm* get_vm_by_id(vmid_t id);
-void map_shared_memory_to_vm(struct vm* vm);
 
 void vm_arch_init(struct vm* vm, const struct vm_config* config);
+void vm_arch_alloc(struct vm* vm);
+void vm_arch_free(struct vm* vm);
 void vcpu_arch_init(struct vcpu* vcpu, struct vm* vm);
 void vcpu_arch_reset(struct vcpu* vcpu, vaddr_t entry);
+void vcpu_arch_release(struct vcpu* vcpu);
 
 void vcpu_writepc(struct vcpu* vcpu, size_t pc);
 SREG64 vcpu_readpc(struct vcpu* vcpu);
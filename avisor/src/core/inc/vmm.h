@@ -2,8 +2,35 @@
 #define VMM_H
 
 #include "arch_vmm.h"
+#include "util.h"
+
+#define VMM_POOL_MAX (MAX_VM_NUM)      // 虚拟机池的容量上限
+#define VMM_SUCCESS (0)
+#define VMM_ERROR ((unsigned long)-1)
+
+/**
+ * 虚拟机的生命周期。启动时由配置创建的虚拟机直接处于RUNNING；
+ * 运行时由管理虚拟机从模板创建的虚拟机先处于CREATED，
+ * 其vCPU完成初始化后等待VM_START才进入客户机。
+ */
+enum vm_state {
+    VM_STATE_FREE = 0,
+    VM_STATE_CREATED,
+    VM_STATE_RUNNING,
+    VM_STATE_PAUSED,
+    VM_STATE_DYING,
+};
 
 void vmm_init();
 void vmm_io_init();
+void vmm_idle();
+void vmm_check_vcpu_state();
+
+// Hypercall Handler
+void vmm_create_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void vmm_start_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void vmm_pause_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void vmm_resume_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
+void vmm_destroy_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2);
 
-#endif
\ No newline at end of file
+#endif
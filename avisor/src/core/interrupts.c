@@ -43,7 +43,7 @@ void interrupts_reserve(irqid_t int_id, irq_handler_t handler) {
 enum irq_res interrupts_handle(irqid_t int_id) {
     // INFO("Enter %s id = %d", __func__, int_id);
 
-    if (vm_has_interrupt(cpu()->vcpu->vm, int_id)) {
+    if (cpu()->vcpu != NULL && vm_has_interrupt(cpu()->vcpu->vm, int_id)) {
         // INFO("Forward %d to vm", int_id);
         vcpu_inject_hw_irq((cpu()->vcpu), int_id);
 
@@ -54,6 +54,10 @@ enum irq_res interrupts_handle(irqid_t int_id) {
         interrupt_handlers[int_id](int_id);
         return HANDLED_BY_HYP;
 
+    } else if (cpu()->vcpu == NULL) {
+        // 空闲CPU上收到已销毁虚拟机的中断，直接丢弃
+        return HANDLED_BY_HYP;
+
     } else {
         ERROR("received unknown interrupt id = %d", int_id);
     }
@@ -70,12 +74,27 @@ void interrupts_vm_assign(struct vm *vm, irqid_t id) {
     bitmap_set(global_interrupt_bitmap, id);
 }
 
+// 虚拟机销毁时归还其中断，之后可以分配给新的虚拟机
+void interrupts_vm_release(struct vm *vm) {
+    for (irqid_t id = 0; id < MAX_INTERRUPTS; id++) {
+        if (!vm_has_interrupt(vm, id) || interrupt_is_reserved(id)) {
+            continue;
+        }
+        interrupts_arch_vm_release(vm, id);
+        bitmap_clear(vm->interrupt_bitmap, id);
+        bitmap_clear(global_interrupt_bitmap, id);
+    }
+}
+
 static void timer_interrupt_handler() {
     timer_handler();
+}
+
 #ifdef SCHEDULE
+static void sched_tick_handler(struct timer_event* ev) {
     update_task_times();
-#endif
 }
+#endif
 
 static inline void physicl_timer_init() {
     // enable intid = 26 physical timer
@@ -90,6 +109,12 @@ static inline void physicl_timer_init() {
     gic_set_prio(IRQ_TIMER, 0);
     gic_set_pend(IRQ_TIMER, false);
     gic_set_enable(IRQ_TIMER, true);
+
+#ifdef SCHEDULE
+    timer_event_init(&cpu()->sched_tick, sched_tick_handler, NULL);
+    timer_event_add(&cpu()->sched_tick, timer_ms_to_ticks(SCHED_TICK_MS),
+                    timer_ms_to_ticks(SCHED_TICK_MS));
+#endif
 }
 
 // 初始化中断
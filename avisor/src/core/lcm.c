@@ -1,19 +1,23 @@
 #include "lcm.h"
 #include "string.h"
+#include "crc32c.h"
+#include "timer.h"
 
 struct snapshot* latest_ss;
 ssid_t latest_ss_id = 0;
 struct list_head ss_pool_list;
+static bool ss_pool_ready = false;
 size_t current_restore_cnt = 0;
 
 
 // 获取一个新的快照结构体指针
 static inline struct snapshot* get_new_ss() {
     struct snapshot_pool* ss_pool = list_last_entry(&ss_pool_list, struct snapshot_pool, list);
-    size_t pool_size = (config.vm->dmem_size + sizeof(struct snapshot)) * NUM_MAX_SNAPSHOT_PER_POOL;
+    size_t ss_size = ss_total_size(config.vm->dmem_size);
+    size_t pool_size = ss_size * NUM_MAX_SNAPSHOT_PER_POOL;
 
     // 快照池已满, 分配一个新的快照池
-    if (ss_pool->last + sizeof(struct snapshot) > ss_pool->base + ss_pool->size) { 
+    if (ss_pool->last + ss_size > ss_pool->base + ss_pool->size) { 
         // 检查是否有足够的内存分配新的快照池，保守起见，至少空余两倍的快照池大小
         if (pool_size * 2 > mem_get_free_pages() * PAGE_SIZE) {
             // 若没有足够的内存，则释放最早的快照池
@@ -45,7 +49,7 @@ static inline void update_ss_pool_last(size_t size) {
 // 分配一个新的快照池
 static struct snapshot_pool* alloc_ss_pool() {
     struct snapshot_pool* ss_pool;
-    size_t pool_size = (config.vm->dmem_size + sizeof(struct snapshot)) * NUM_MAX_SNAPSHOT_PER_POOL;
+    size_t pool_size = ss_total_size(config.vm->dmem_size) * NUM_MAX_SNAPSHOT_PER_POOL;
 
     INFO("new snapshot pool size: %dMB", pool_size / 1024 / 1024);
     ss_pool = (struct snapshot_pool*) mem_alloc_page(NUM_PAGES(pool_size), false);
@@ -64,9 +68,11 @@ static struct snapshot_pool* alloc_ss_pool() {
 
 // 初始化快照池
 void ss_pool_init() {
+    crc32c_init();
     INIT_LIST_HEAD(&ss_pool_list);
     struct snapshot_pool* ss_pool = alloc_ss_pool();
     list_add_tail(&ss_pool->list, &ss_pool_list);
+    ss_pool_ready = true;
 }
 
 // 获取新的快照ID
@@ -83,6 +89,19 @@ static inline struct snapshot* get_latest_ss() {
 static inline struct snapshot* get_ss_by_id(ssid_t id) {
     paddr_t ss;
     struct snapshot_pool* ss_pool;
+    struct vm_ckpt* ckpt = &CURRENT_VM->ckpt;
+
+    // 自动快照的环形槽位
+    for (size_t i = 0; ckpt->enabled && i < ckpt->nr_slots; i++) {
+        ss = (paddr_t)ckpt->slots + i * ckpt->slot_size;
+        if (((struct snapshot*)ss)->size > 0 && ((struct snapshot*)ss)->ss_id == id) {
+            return (struct snapshot*) ss;
+        }
+    }
+
+    if (!ss_pool_ready) {
+        ERROR("invalid snapshot id");
+    }
 
     list_for_each_entry(ss_pool, &ss_pool_list, list) {
         ss = ss_pool->base;
@@ -124,16 +143,12 @@ void guest_halt_handler(unsigned long iss, unsigned long arg0, unsigned long arg
 
 // 重启虚拟机
 void restart_vm() {
-    const struct vm_config* config = CURRENT_VM->vm_config;
-    vaddr_t va = config->base_addr;
-    paddr_t pa = 0;
-    if (!mem_translate(&CURRENT_VM->as, va, &pa)) {
-        ERROR("Memory translation failed.");
-        return;
-    }
+    struct vm* vm = CURRENT_VM;
+    const struct vm_config* config = vm->vm_config;
 
-    // 恢复内存状态
-    memcpy((void*)pa, (void*)config->load_addr, config->dmem_size);
+    // 先清零全部内存，再恢复镜像：私有副本被释放，重新与avisor中的镜像共享，无需拷贝
+    vm_clear_mem(vm);
+    vm_reset_images(vm);
     // 重置vCPU
     vcpu_arch_reset(CURRENT_VM->vcpus, config->entry);
 
@@ -166,17 +181,190 @@ void restore_snapshot_handler(unsigned long iss, unsigned long arg0, unsigned lo
         return;
     }
 
-    restore_snapshot_handler_by_ss(ss);
-    INFO("Restore snapshot: ID=%lu, size=%lu", ss->ss_id, ss->size);
+    if (restore_snapshot_handler_by_ss(ss)) {
+        INFO("Restore snapshot: ID=%lu, size=%lu", ss->ss_id, ss->size);
+    }
+}
+
+/**
+ * 快照的创建与恢复由发起hypercall的vCPU协调，通过IPI通知同一虚拟机的其他vCPU
+ * 暂停并参与：每个vCPU保存/恢复自己的状态，并负责拷贝内存中属于自己的一段，
+ * 最后在vm->sync上同步。单vCPU的虚拟机退化为在本核上完成全部工作。
+ */
+enum LCM_EVENTS { LCM_CHECKPOINT, LCM_RESTORE };
+extern volatile const size_t LCM_IPI_ID;
+
+void lcm_ipi_handler(uint32_t event, uint64_t data);
+CPU_MSG_HANDLER(lcm_ipi_handler, LCM_IPI_ID);
+
+struct ss_job {
+    struct snapshot* ss;
+    struct snapshot* prev;
+    atomic_t nr_unchanged;
+    atomic_t nr_corrupted;
+    atomic_t busy;          // 同一虚拟机同时只能有一个快照操作
+} ss_jobs[MAX_VM_NUM];
+
+/**
+ * 客户机第i页的物理地址。镜像页与其他虚拟机共享、其余页可能被换出，
+ * 客户机内存在物理上并不连续，因此逐页查找；写入前先解除共享，必要时换入。
+ */
+static inline paddr_t ss_page_pa(size_t i, bool write) {
+    struct vm* vm = cpu()->vcpu->vm;
+    vaddr_t ipa = vm->vm_config->base_addr + i * PAGE_SIZE;
+    paddr_t pa;
+
+    if (write) {
+        vm_cow_break(vm, ipa);
+    }
+    if (!vm_ipa_to_pa(vm, ipa, &pa)) {
+        ERROR("vm%d page 0x%lx is not mapped", vm->id, ipa);
+    }
+    return pa;
+}
+
+// 当前vCPU负责拷贝的页范围 [first, last)
+static inline void ss_vcpu_pages(struct snapshot* ss, size_t* first, size_t* last) {
+    struct vcpu* vcpu = cpu()->vcpu;
+    size_t nr_cpus = vcpu->vm->nr_cpus;
+
+    *first = ss->nr_pages * vcpu->id / nr_cpus;
+    *last = ss->nr_pages * (vcpu->id + 1) / nr_cpus;
+}
+
+/**
+ * 保存客户机内存到快照，拷贝的同时计算每页的CRC32C。
+ * 若上一个快照属于同一虚拟机，则比较校验和统计未变化的页。
+ */
+static void ss_save_mem(struct ss_job* job) {
+    struct snapshot* ss = job->ss;
+    struct snapshot* prev = job->prev;
+    char* mem = ss_mem(ss);
+    size_t first, last, nr_unchanged = 0;
+
+    uint32_t old;
+
+    // 自动快照的槽位只有一个时prev即为ss本身，因此先取出旧的校验和
+    ss_vcpu_pages(ss, &first, &last);
+    for (size_t i = first; i < last; i++) {
+        old = prev != NULL ? prev->page_csum[i] : 0;
+        ss->page_csum[i] = crc32c_copy(mem + i * PAGE_SIZE, (void*)ss_page_pa(i, false),
+                                       PAGE_SIZE, CRC32C_INIT);
+        if (prev != NULL && old == ss->page_csum[i]) {
+            nr_unchanged++;
+        }
+    }
+    atomic_add(nr_unchanged, &job->nr_unchanged);
+}
+
+/**
+ * 校验快照中当前vCPU负责的页的CRC32C。恢复前由所有vCPU并行完成，
+ * 任何一页损坏都不会写入客户机内存。
+ */
+static void ss_verify_mem(struct ss_job* job) {
+    struct snapshot* ss = job->ss;
+    char* mem = ss_mem(ss);
+    size_t first, last, nr_corrupted = 0;
+    uint32_t csum;
+
+    ss_vcpu_pages(ss, &first, &last);
+    for (size_t i = first; i < last; i++) {
+        csum = crc32c(CRC32C_INIT, mem + i * PAGE_SIZE, PAGE_SIZE);
+        if (csum != ss->page_csum[i]) {
+            WARNING("Snapshot %lu page %lu corrupted (0x%x != 0x%x)",
+                ss->ss_id, i, csum, ss->page_csum[i]);
+            nr_corrupted++;
+        }
+    }
+    atomic_add(nr_corrupted, &job->nr_corrupted);
 }
 
-unsigned int __hash_object(const void* obj, size_t size) {
-    unsigned int hash = 0;
-    const unsigned char* p = (const unsigned char*) obj;
-    for (size_t i = 0; i < size; i++) {
-        hash = 31 * hash + p[i];
+// 从快照恢复客户机内存，快照已通过校验
+static void ss_restore_mem(struct ss_job* job) {
+    struct snapshot* ss = job->ss;
+    char* mem = ss_mem(ss);
+    size_t first, last;
+
+    ss_vcpu_pages(ss, &first, &last);
+    for (size_t i = first; i < last; i++) {
+        memcpy((void*)ss_page_pa(i, true), mem + i * PAGE_SIZE, PAGE_SIZE);
     }
-    return hash;
+}
+
+/**
+ * 每个vCPU在快照创建时执行的部分。
+ * 拷贝内存前需等待所有vCPU都已进入EL2并保存了自己的状态，
+ * 否则尚未收到IPI的vCPU仍在修改已拷贝的内存，快照前后不一致。
+ */
+static void ss_checkpoint_vcpu(struct ss_job* job) {
+    struct vcpu* vcpu = cpu()->vcpu;
+
+    memcpy(&job->ss->vcpus[vcpu->id], vcpu, sizeof(struct vcpu));
+    cpu_sync_barrier(&vcpu->vm->sync);
+    ss_save_mem(job);
+    cpu_sync_barrier(&vcpu->vm->sync);
+}
+
+/**
+ * 每个vCPU在快照恢复时执行的部分。
+ * 同样需等待所有vCPU都停下后再恢复内存，否则仍在运行的vCPU会覆盖已恢复的内存。
+ * 所有vCPU先校验各自的页，只有整个快照完好时才恢复，否则客户机保持原状继续运行。
+ * vcpu结构体在内存恢复之后再载入，恢复内存时仍使用当前的vcpu->vm。
+ */
+static void ss_restore_vcpu(struct ss_job* job) {
+    struct vcpu* vcpu = cpu()->vcpu;
+
+    cpu_sync_barrier(&vcpu->vm->sync);
+    ss_verify_mem(job);
+    cpu_sync_barrier(&vcpu->vm->sync);
+    if (atomic_read(&job->nr_corrupted) == 0) {
+        ss_restore_mem(job);
+        memcpy(vcpu, &job->ss->vcpus[vcpu->id], sizeof(struct vcpu));
+    }
+    cpu_sync_barrier(&vcpu->vm->sync);
+}
+
+void lcm_ipi_handler(uint32_t event, uint64_t data) {
+    struct ss_job* job = &ss_jobs[data];
+
+    switch (event) {
+        case LCM_CHECKPOINT:
+            ss_checkpoint_vcpu(job);
+            break;
+        case LCM_RESTORE:
+            ss_restore_vcpu(job);
+            break;
+        default:
+            WARNING("Unknown lcm event: %u", event);
+            break;
+    }
+}
+
+// 通知同一虚拟机的其他vCPU参与快照操作
+static void ss_job_broadcast(struct vm* vm, enum LCM_EVENTS event) {
+    struct cpu_msg msg = {LCM_IPI_ID, event, vm->id};
+
+    fence_ord_write();
+    vm_msg_broadcast(vm, &msg);
+}
+
+static inline bool ss_job_trylock(struct ss_job* job) {
+    return atomic_cmpxchg(&job->busy, 0, 1) == 0;
+}
+
+/**
+ * 另一个vCPU可能正在发起快照操作并等待本vCPU参与，
+ * 因此在等待期间处理发给本核的消息，否则双方会互相等待。
+ */
+static void ss_job_lock(struct ss_job* job) {
+    while (!ss_job_trylock(job)) {
+        cpu_msg_handler();
+    }
+}
+
+static inline void ss_job_unlock(struct ss_job* job) {
+    fence_ord_write();
+    atomic_set(&job->busy, 0);
 }
 
 void __print_regs(struct vcpu vcpu ) {
@@ -185,62 +373,84 @@ void __print_regs(struct vcpu vcpu ) {
     }
 }
 
+/**
+ * 在ss处为当前虚拟机创建快照，由发起的vCPU调用，调用者需持有job锁。
+ * 若上一个快照属于同一虚拟机，则与之比较统计未变化的页。
+ */
+static bool ss_checkpoint(struct vm* vm, struct snapshot* ss) {
+    struct ss_job* job = &ss_jobs[vm->id];
+    const struct vm_config* config = vm->vm_config;
+
+    ss->ss_id = get_new_ss_id();
+    ss->size = ss_total_size(config->dmem_size);
+    ss->vm_id = vm->id;
+    ss->nr_pages = NUM_PAGES(config->dmem_size);
+    ss->nr_vcpus = vm->nr_cpus;
+    INFO("Create snapshot: ID=%lu", ss->ss_id);
+
+    // 与上一个快照比较以统计未变化的页
+    job->ss = ss;
+    job->prev = get_latest_ss();
+    if (job->prev != NULL &&
+        (job->prev->vm_id != ss->vm_id || job->prev->nr_pages != ss->nr_pages)) {
+        job->prev = NULL;
+    }
+    atomic_set(&job->nr_unchanged, 0);
+
+    // 暂停所有vCPU，各自保存vcpu状态并并行拷贝内存
+    ss_job_broadcast(vm, LCM_CHECKPOINT);
+    ss_checkpoint_vcpu(job);
+    INFO("Save %lu vcpu state, pc=0x%lx", ss->nr_vcpus, vcpu_readpc(cpu()->vcpu));
+
+    ss->nr_unchanged = atomic_read(&job->nr_unchanged);
+    ss->csum = crc32c(CRC32C_INIT, ss->page_csum, ss->nr_pages * sizeof(uint32_t));
+    INFO("[checkpoint] Ckpt csum: %x, unchanged pages: %lu/%lu",
+        ss->csum, ss->nr_unchanged, ss->nr_pages);
+
+    return true;
+}
+
 // 创建快照的hypercall
 void checkpoint_snapshot_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
-    static bool init = false;
     struct snapshot* ss;
-    paddr_t pa;
-    const struct vm_config* config = CURRENT_VM->vm_config;
+    struct vm* vm = CURRENT_VM;
+    struct ss_job* job = &ss_jobs[vm->id];
 
-    if (!init) {
+    ss_job_lock(job);
+    if (!ss_pool_ready) {
         ss_pool_init();
-        init = true;
         INFO("Snapshot pool initialized.");
     }
 
-    // 要实现创建快照的功能，需要完成以下几个步骤：
     // 1. 为快照分配内存空间
     ss = get_new_ss();
     if (ss == NULL) {
         ERROR("Failed to allocate memory for snapshot.");
         return;
     }
-    
-    ss->ss_id = get_new_ss_id();
-    ss->size = sizeof(struct snapshot) + config->dmem_size;
-    ss->vm_id = CURRENT_VM->id;
-    INFO("Create snapshot: ID=%lu", ss->ss_id);
 
-    // 2. 保存vcpu的状态
-    memcpy(&ss->vcpu, cpu()->vcpu, sizeof(struct vcpu));
-    INFO("Save vcpu state, pc=0x%lx", vcpu_readpc(cpu()->vcpu));
-    // __print_regs(ss->vcpu);
-
-    // 3. 保存内存状态
-    vaddr_t va = config->base_addr;
-    pa = 0;
-    mem_translate(&CURRENT_VM->as, va, &pa);
-    if (pa == 0) {
-        ERROR("Memory translation failed.");
-        return;
+    // 2. 保存vCPU状态与客户机内存
+    if (ss_checkpoint(vm, ss)) {
+        // 3. 更新快照池的最后指针位置
+        update_ss_pool_last(ss->size);
+        INFO("Checkpoint snapshot created: ID=%lu, size=%lu", ss->ss_id, ss->size);
     }
-
-    memcpy(ss->mem, (void*)pa, config->dmem_size);
-    
-    INFO("[checkpoint] Ckpt hash: %x", __hash_object(ss, ss->size));
-    // 4. 更新快照池的最后指针位置
-    update_ss_pool_last(ss->size);
-
-    INFO("Checkpoint snapshot created: ID=%lu, size=%lu", ss->ss_id, ss->size);
+    ss_job_unlock(job);
 }
 
 /**
- * 恢复为给定快照
+ * 恢复为给定快照。快照与虚拟机不匹配或校验失败时不修改客户机，
+ * 只有本次恢复失败。
  * 
  * @param ss 要恢复的快照
+ * @return 是否已恢复
  */
-void restore_snapshot_handler_by_ss(struct snapshot* ss) {
-    INFO("[restore] Ckpt hash: %x", __hash_object(ss, ss->size));
+bool restore_snapshot_handler_by_ss(struct snapshot* ss) {
+    struct vm* vm = CURRENT_VM;
+    struct ss_job* job = &ss_jobs[vm->id];
+    bool ok;
+
+    INFO("[restore] Ckpt csum: %x", ss->csum);
 
     // 理论上来说，恢复快照时，cpu的pc应当是快照创建时的pc，
     // 但是为了能够在恢复快照后继续运行，我们将pc设置为发起恢复时的pc
@@ -248,19 +458,145 @@ void restore_snapshot_handler_by_ss(struct snapshot* ss) {
 
 
     // 恢复内存状态
-    const struct vm_config* config = CURRENT_VM->vm_config;
-    vaddr_t va = config->base_addr;
-    paddr_t pa = 0;
-    if (!mem_translate(&CURRENT_VM->as, va, &pa)) {
-        ERROR("Memory translation failed.");
-        return;
+    const struct vm_config* config = vm->vm_config;
+    if (ss->vm_id != vm->id || ss->nr_vcpus != vm->nr_cpus ||
+        ss->nr_pages != NUM_PAGES(config->dmem_size)) {
+        WARNING("Snapshot %lu does not match vm%d.", ss->ss_id, vm->id);
+        return false;
+    }
+    if (crc32c(CRC32C_INIT, ss->page_csum, ss->nr_pages * sizeof(uint32_t)) != ss->csum) {
+        WARNING("Snapshot %lu checksum table corrupted.", ss->ss_id);
+        return false;
     }
-    memcpy((void*)pa, ss->mem, config->dmem_size);
 
-    // 恢复vcpu的状态
-    memcpy(cpu()->vcpu, &ss->vcpu, sizeof(struct vcpu));
+    ss_job_lock(job);
+    job->ss = ss;
+    atomic_set(&job->nr_corrupted, 0);
+
+    // 暂停所有vCPU，并行校验快照，通过后再拷贝内存并恢复各自的vcpu状态
+    ss_job_broadcast(vm, LCM_RESTORE);
+    ss_restore_vcpu(job);
+    ok = atomic_read(&job->nr_corrupted) == 0;
+    ss_job_unlock(job);
+    if (!ok) {
+        WARNING("Snapshot %lu failed integrity check, vm%d not restored.",
+            ss->ss_id, vm->id);
+        return false;
+    }
     // vcpu_writepc(cpu()->vcpu, pc); // 恢复pc,实际不太合理
     // __print_regs(*(cpu()->vcpu));
 
     INFO("Restore vcpu state, pc=0x%lx", vcpu_readpc(cpu()->vcpu));
+    return true;
+}
+
+/**
+ * 根据本次快照的耗时与两次快照间的脏页数调整下一次的间隔：
+ * 客户机几乎不写内存时逐步放宽，写得多时回到配置间隔；
+ * 同时保证 耗时/间隔 不超过max_overhead。
+ */
+static void vm_ckpt_adapt(struct vm_ckpt* ckpt, struct snapshot* ss, uint64_t cost) {
+    size_t nr_dirty = ss->nr_pages - ss->nr_unchanged;
+    uint64_t floor;
+
+    ckpt->cost = ckpt->cost ? (3 * ckpt->cost + cost) / 4 : cost;
+
+    if (nr_dirty < (ss->nr_pages >> CKPT_IDLE_DIRTY_SHIFT)) {
+        ckpt->interval = MIN(ckpt->interval * 2, ckpt->base_interval * CKPT_MAX_BACKOFF);
+    } else if (nr_dirty > (ss->nr_pages >> CKPT_BUSY_DIRTY_SHIFT)) {
+        ckpt->interval = ckpt->base_interval;
+    } else {
+        ckpt->interval = MAX(ckpt->interval / 2, ckpt->base_interval);
+    }
+
+    floor = ckpt->cost * 100 / ckpt->max_overhead;
+    ckpt->interval = MAX(ckpt->interval, floor);
+}
+
+
+// 主CPU上的定时事件，由虚拟机的主vCPU发起一次快照并设定下一次的时间
+static void vm_ckpt_timer_handler(struct timer_event* ev) {
+    struct vm* vm = ev->data;
+    struct vm_ckpt* ckpt = &vm->ckpt;
+    struct ss_job* job = &ss_jobs[vm->id];
+    struct snapshot* ss;
+    uint64_t start, end;
+
+    if (cpu()->vcpu == NULL || cpu()->vcpu->vm != vm || !ss_job_trylock(job)) {
+        ckpt->nr_skipped++;
+        timer_event_add(&ckpt->timer, timer_ms_to_ticks(CKPT_RETRY_MS), 0);
+        return;
+    }
+
+    start = timer_get_ticks();
+    ss = (struct snapshot*)((paddr_t)ckpt->slots + ckpt->cur_slot * ckpt->slot_size);
+    if (ss_checkpoint(vm, ss)) {
+        latest_ss = ss;
+        ckpt->cur_slot = (ckpt->cur_slot + 1) % ckpt->nr_slots;
+        ckpt->nr_taken++;
+
+        end = timer_get_ticks();
+        vm_ckpt_adapt(ckpt, ss, end - start);
+        ckpt->last = end;
+        INFO("VM[%d] automatic snapshot %d took %dms, next in %dms",
+            vm->id, ss->ss_id, timer_ticks_to_ms(end - start),
+            timer_ticks_to_ms(ckpt->interval));
+    }
+    ss_job_unlock(job);
+
+    timer_event_add(&ckpt->timer, ckpt->interval, 0);
+}
+
+void vm_ckpt_init(struct vm* vm, const struct vm_config* config) {
+    struct vm_ckpt* ckpt = &vm->ckpt;
+
+    memset(ckpt, 0, sizeof(struct vm_ckpt));
+    if (config->ckpt.interval_ms == 0 || config->ckpt.retention == 0) {
+        return;
+    }
+
+    crc32c_init();
+    ckpt->slot_size = ss_total_size(config->dmem_size);
+    ckpt->nr_slots = config->ckpt.retention;
+    ckpt->slots = mem_alloc_page(NUM_PAGES(ckpt->slot_size * ckpt->nr_slots), false);
+    if (ckpt->slots == NULL) {
+        WARNING("VM[%d] no memory for %d automatic snapshots, disabled",
+            vm->id, ckpt->nr_slots);
+        return;
+    }
+    for (size_t i = 0; i < ckpt->nr_slots; i++) {
+        ((struct snapshot*)((paddr_t)ckpt->slots + i * ckpt->slot_size))->size = 0;
+    }
+
+    ckpt->base_interval = timer_ms_to_ticks(config->ckpt.interval_ms);
+    ckpt->interval = ckpt->base_interval;
+    ckpt->max_overhead = config->ckpt.max_overhead ? config->ckpt.max_overhead : 100;
+    ckpt->last = timer_get_ticks();
+    ckpt->enabled = true;
+
+    // 由主CPU初始化，快照也就由主CPU发起
+    timer_event_init(&ckpt->timer, vm_ckpt_timer_handler, vm);
+    timer_event_add(&ckpt->timer, ckpt->interval, 0);
+
+    INFO("VM[%d] automatic checkpoint every %dms, keep %d, overhead <= %d%%",
+        vm->id, config->ckpt.interval_ms, ckpt->nr_slots, ckpt->max_overhead);
+}
+
+// 虚拟机销毁时由主CPU调用：取消定时事件并释放快照环
+void vm_ckpt_release(struct vm* vm) {
+    struct vm_ckpt* ckpt = &vm->ckpt;
+    struct ss_job* job = &ss_jobs[vm->id];
+
+    if (!ckpt->enabled) {
+        return;
+    }
+
+    timer_event_cancel(&ckpt->timer);
+    if (latest_ss != NULL && in_range((paddr_t)latest_ss, (paddr_t)ckpt->slots,
+                                      ckpt->slot_size * ckpt->nr_slots)) {
+        latest_ss = NULL;
+    }
+    mem_free_page(ckpt->slots, NUM_PAGES(ckpt->slot_size * ckpt->nr_slots));
+    ckpt->enabled = false;
+    memset(job, 0, sizeof(struct ss_job));
 }
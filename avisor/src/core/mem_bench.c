@@ -0,0 +1,72 @@
+#include "util.h"
+#include "mem.h"
+#include "tlb.h"
+
+#ifdef MEM_BENCH
+
+#define MEM_BENCH_PAGES     (4096)          // 16MB
+#define MEM_BENCH_VA        (0x80000000)
+#define MEM_BENCH_VMID      (MAX_VM_NUM)    // 不与任何虚拟机冲突的VMID
+
+static inline uint64_t ticks_to_us(uint64_t ticks) {
+    return ticks * 1000000 / read_cntfrq_el0();
+}
+
+static void mem_bench_report(const char* name, uint64_t ticks) {
+    uint64_t us = ticks_to_us(ticks);
+
+    INFO("[mem_bench] %s: %lu pages in %lu us (%lu pages/ms)",
+        name, MEM_BENCH_PAGES, us, us ? MEM_BENCH_PAGES * 1000 / us : 0);
+}
+
+/**
+ * 比较逐页与批量两种方式映射/解除映射MEM_BENCH_PAGES个页面的吞吐量。
+ * 逐页方式每次调用都会遍历页表并（在解除映射时）单独无效化TLB，
+ * 批量方式只遍历一次页表并在提交时统一无效化。
+ */
+void mem_bench() {
+    static struct addr_space as;
+    struct mem_batch batch;
+    struct ppages pages, page;
+    uint64_t start;
+
+    as_init(&as, AS_VM, MEM_BENCH_VMID, NULL);
+    pages = mem_alloc_ppages(MEM_BENCH_PAGES, false);
+    if (pages.nr_pages != MEM_BENCH_PAGES) {
+        WARNING("[mem_bench] not enough memory");
+        return;
+    }
+
+    // 预先建立中间级页表，使两种方式的测量不包含页表分配
+    mem_map(&as, MEM_BENCH_VA, &pages, MEM_BENCH_PAGES, PTE_VM_FLAGS);
+    mem_unmap(&as, MEM_BENCH_VA, MEM_BENCH_PAGES, false);
+
+    start = read_cntpct_el0();
+    for (size_t i = 0; i < MEM_BENCH_PAGES; i++) {
+        page = mem_ppages_get(pages.base + i * PAGE_SIZE, 1);
+        mem_map(&as, MEM_BENCH_VA + i * PAGE_SIZE, &page, 1, PTE_VM_FLAGS);
+    }
+    mem_bench_report("map, per page", read_cntpct_el0() - start);
+
+    start = read_cntpct_el0();
+    for (size_t i = 0; i < MEM_BENCH_PAGES; i++) {
+        mem_unmap(&as, MEM_BENCH_VA + i * PAGE_SIZE, 1, false);
+    }
+    mem_bench_report("unmap, per page", read_cntpct_el0() - start);
+
+    start = read_cntpct_el0();
+    mem_batch_begin(&batch, &as);
+    mem_batch_map(&batch, MEM_BENCH_VA, &pages, MEM_BENCH_PAGES, PTE_VM_FLAGS);
+    mem_batch_commit(&batch);
+    mem_bench_report("map, batched", read_cntpct_el0() - start);
+
+    start = read_cntpct_el0();
+    mem_batch_begin(&batch, &as);
+    mem_batch_unmap(&batch, MEM_BENCH_VA, MEM_BENCH_PAGES, false);
+    mem_batch_commit(&batch);
+    mem_bench_report("unmap, batched", read_cntpct_el0() - start);
+
+    mem_free_page((void*)pages.base, pages.nr_pages);
+}
+
+#endif
@@ -62,8 +62,9 @@ static void mem_free_ppages(struct ppages *ppages) {
     if (in_range(ppages->base, pool->base, pool->nr_pages * PAGE_SIZE)) {
         index = (ppages->base - pool->base) / PAGE_SIZE;
         bitmap_clear_consecutive(pool->bitmap, index, ppages->nr_pages);
+        pool->free += ppages->nr_pages;
     }
-    spin_lock(&pool->lock);
+    spin_unlock(&pool->lock);
 }
 
 static inline pte_type_t pt_page_type(struct page_table* pt, size_t lvl) {
@@ -161,26 +162,64 @@ static void mem_inflate_pt(struct addr_space *as, vaddr_t va, size_t length) {
 }
 
 
+static inline struct page_table_dscr* as_pt_dscr(enum type type) {
+    return type == AS_HYP || type == AS_HYP_CPY ? hyp_pt_dscr : vm_pt_dscr;
+}
+
+// Allocate a zeroed root table, possibly before the address space exists
+pte_t* as_alloc_root(enum type type) {
+    struct page_table pt = { .dscr = as_pt_dscr(type) };
+    size_t n = NUM_PAGES(pt_size(&pt, 0));
+    pte_t* root_pt = (pte_t*) mem_alloc_page(n, true);
+
+    if (root_pt != NULL) {
+        memset((void*)root_pt, 0, n * PAGE_SIZE);
+    }
+    return root_pt;
+}
+
 void as_init(struct addr_space *as, enum type type, asid_t asid, 
             pte_t *root_pt) {
-    size_t n;
-
     as->type = type;
-    as->pt.dscr =
-        type == AS_HYP || type == AS_HYP_CPY ? hyp_pt_dscr : vm_pt_dscr;
+    as->pt.dscr = as_pt_dscr(type);
     as->lock = SPINLOCK_INITVAL;
     as->asid = asid;
 
     if (root_pt == NULL) {
-        n = NUM_PAGES(pt_size(&as->pt, 0));
-        root_pt = (pte_t*) mem_alloc_page(n, true);
-        memset((void*)root_pt, 0, n * PAGE_SIZE);
+        root_pt = as_alloc_root(type);
     }
     as->pt.root = root_pt;
 
     as_arch_init(as);
 }
 
+static void as_free_table(struct page_table *pt, pte_t *table, size_t lvl) {
+    pte_t *child;
+
+    for (size_t i = 0; i < pt_nentries(pt, lvl); i++) {
+        if (!pte_valid(&table[i]) || !pte_table(pt, &table[i], lvl)) {
+            continue;
+        }
+        child = (pte_t*)pte_addr(&table[i]);
+        as_free_table(pt, child, lvl + 1);
+        mem_free_page(child, NUM_PAGES(pt_size(pt, lvl + 1)));
+    }
+}
+
+/**
+ * Free all page tables of the address space, including the root. Pages that
+ * leaf entries point to are not freed here; the caller releases the pages it
+ * owns first (shared image pages, devices and shared memory are not owned by
+ * the address space).
+ */
+void as_destroy(struct addr_space *as) {
+    spin_lock(&as->lock);
+    as_free_table(&as->pt, as->pt.root, 0);
+    mem_free_page(as->pt.root, NUM_PAGES(pt_size(&as->pt, 0)));
+    as->pt.root = NULL;
+    spin_unlock(&as->lock);
+}
+
 vaddr_t mem_alloc_vpage(struct addr_space *as, vaddr_t at, size_t n) {
     size_t lvl = 0;
     size_t entry = 0;
@@ -275,10 +314,28 @@ vaddr_t mem_alloc_vpage(struct addr_space *as, vaddr_t at, size_t n) {
     return vpage;
 }
 
-bool mem_map(struct addr_space *as, vaddr_t va, struct ppages *ppages,
-            size_t nr_pages, mem_flags_t flags) {
+void mem_batch_begin(struct mem_batch *batch, struct addr_space *as) {
+    batch->as = as;
+    batch->inv_start = 0;
+    batch->inv_end = 0;
+}
+
+void mem_batch_commit(struct mem_batch *batch) {
+    if (batch->inv_start != batch->inv_end) {
+        tlb_inv_range(batch->as, batch->inv_start, batch->inv_end - batch->inv_start);
+    }
+    batch->inv_start = 0;
+    batch->inv_end = 0;
+}
+
+bool mem_batch_map(struct mem_batch *batch, vaddr_t va, struct ppages *ppages,
+                   size_t nr_pages, mem_flags_t flags) {
+    struct addr_space *as = batch->as;
+    size_t lvl = as->pt.dscr->lvls - 1;
+    size_t entry, nentries;
     pte_t *pte = NULL;
     vaddr_t vaddr = va & ~(PAGE_SIZE - 1);
+    paddr_t paddr;
 
     spin_lock(&as->lock);
 
@@ -297,11 +354,26 @@ bool mem_map(struct addr_space *as, vaddr_t va, struct ppages *ppages,
     }
 
     mem_inflate_pt(as, vaddr, nr_pages * PAGE_SIZE);
-    for (size_t i = 0; i < ppages->nr_pages; i++) {
-        pte = pt_get_pte(&as->pt, as->pt.dscr->lvls - 1, vaddr);
-        paddr_t paddr = ppages->base + (i * PAGE_SIZE);
-        pte_set(pte, paddr, PTE_PAGE, flags);
-        vaddr += PAGE_SIZE;
+
+    /**
+     * Walk the page table once per last level table instead of once per
+     * page. Only entries that were already valid need a TLB invalidation.
+     */
+    paddr = ppages->base;
+    for (size_t i = 0; i < ppages->nr_pages;) {
+        pte = pt_get_pte(&as->pt, lvl, vaddr);
+        entry = pt_getpteindex(&as->pt, pte, lvl);
+        nentries = pt_nentries(&as->pt, lvl);
+
+        for (; entry < nentries && i < ppages->nr_pages; entry++, i++) {
+            if (pte_valid(pte)) {
+                mem_batch_inv(batch, vaddr, PAGE_SIZE);
+            }
+            pte_set(pte, paddr, PTE_PAGE, flags);
+            pte++;
+            vaddr += PAGE_SIZE;
+            paddr += PAGE_SIZE;
+        }
     }
 
     fence_sync();
@@ -310,6 +382,79 @@ bool mem_map(struct addr_space *as, vaddr_t va, struct ppages *ppages,
     return true;
 }
 
+bool mem_map(struct addr_space *as, vaddr_t va, struct ppages *ppages,
+            size_t nr_pages, mem_flags_t flags) {
+    struct mem_batch batch;
+    bool res;
+
+    mem_batch_begin(&batch, as);
+    res = mem_batch_map(&batch, va, ppages, nr_pages, flags);
+    mem_batch_commit(&batch);
+
+    return res;
+}
+
+/**
+ * Map physically contiguous pages using the largest block descriptors that
+ * the alignment of va and pa allows, instead of inflating the range down to
+ * 4K pages. Fails, undoing what was mapped, if part of the range is in use.
+ */
+bool mem_map_huge(struct addr_space *as, vaddr_t va, struct ppages *ppages,
+                  mem_flags_t flags) {
+    struct page_table *pt = &as->pt;
+    vaddr_t vaddr = va;
+    paddr_t paddr = ppages->base;
+    size_t left = ppages->nr_pages * PAGE_SIZE;
+    size_t lvl, lvlsz;
+    pte_t *pte;
+    bool ok = true;
+
+    spin_lock(&as->lock);
+
+    while (left > 0 && ok) {
+        // Pick the largest block the alignment allows
+        for (lvl = 0; lvl < pt->dscr->lvls - 1; lvl++) {
+            lvlsz = pt_lvlsize(pt, lvl);
+            if (pt_lvl_terminal(pt, lvl) && lvlsz <= left &&
+                (vaddr % lvlsz) == 0 && (paddr % lvlsz) == 0) {
+                break;
+            }
+        }
+        lvlsz = pt_lvlsize(pt, lvl);
+
+        for (size_t i = 0; i < lvl && ok; i++) {
+            pte = pt_get_pte(pt, i, vaddr);
+            if (!pte_valid(pte)) {
+                if (mem_alloc_pt(as, pte, i, vaddr) == NULL) {
+                    ERROR("Failed to alloc page table.\n");
+                }
+            } else if (!pte_table(pt, pte, i)) {
+                ok = false;
+            }
+        }
+
+        pte = pt_get_pte(pt, lvl, vaddr);
+        if (!ok || pte_valid(pte)) {
+            ok = false;
+            break;
+        }
+        pte_set(pte, paddr, pt_page_type(pt, lvl), flags);
+
+        vaddr += lvlsz;
+        paddr += lvlsz;
+        left -= lvlsz;
+    }
+
+    fence_sync();
+    spin_unlock(&as->lock);
+
+    if (!ok && vaddr > va) {
+        mem_unmap(as, va, (vaddr - va) / PAGE_SIZE, false);
+    }
+
+    return ok;
+}
+
 vaddr_t mem_alloc_map(struct addr_space* as, struct ppages *page, 
                         vaddr_t at, size_t nr_pages, mem_flags_t flags) {
     vaddr_t address = mem_alloc_vpage(as, at, nr_pages);
@@ -335,7 +480,9 @@ vaddr_t mem_alloc_map_dev(struct addr_space* as,
     return address;
 }
 
-void mem_unmap(struct addr_space* as, vaddr_t at, size_t num_pages, bool free_ppages) {
+void mem_batch_unmap(struct mem_batch *batch, vaddr_t at, size_t num_pages,
+                     bool free_ppages) {
+    struct addr_space *as = batch->as;
     vaddr_t vaddr = at;
     vaddr_t top = at + (num_pages * PAGE_SIZE);
     size_t lvl = 0;
@@ -378,7 +525,7 @@ void mem_unmap(struct addr_space* as, vaddr_t at, size_t num_pages, bool free_pp
                     }
 
                     *pte = 0;
-                    tlb_inv_va(&cpu()->vcpu->vm->as, vaddr);
+                    mem_batch_inv(batch, vaddr, lvlsz);
 
                 } else {
                     break;
@@ -400,4 +547,44 @@ void mem_unmap(struct addr_space* as, vaddr_t at, size_t num_pages, bool free_pp
     }
 
     spin_unlock(&as->lock);
-}
\ No newline at end of file
+}
+
+// Walk the page table in software, independently of the loaded translation
+// registers. Returns the leaf entry (page or block) mapping va, or NULL.
+pte_t* mem_leaf_pte(struct addr_space *as, vaddr_t va, size_t *lvl) {
+    struct page_table *pt = &as->pt;
+    pte_t *pte;
+
+    for (size_t l = 0; l < pt->dscr->lvls; l++) {
+        pte = pt_get_pte(pt, l, va);
+        if (!pte_valid(pte)) {
+            break;
+        }
+        if (!pte_table(pt, pte, l)) {
+            *lvl = l;
+            return pte;
+        }
+    }
+
+    return NULL;
+}
+
+bool mem_walk(struct addr_space *as, vaddr_t va, paddr_t *pa) {
+    size_t lvl, lvlsz;
+    pte_t *pte = mem_leaf_pte(as, va, &lvl);
+
+    if (pte == NULL) {
+        return false;
+    }
+    lvlsz = pt_lvlsize(&as->pt, lvl);
+    *pa = (pte_addr(pte) & ~(lvlsz - 1)) | (va & (lvlsz - 1));
+    return true;
+}
+
+void mem_unmap(struct addr_space* as, vaddr_t at, size_t num_pages, bool free_ppages) {
+    struct mem_batch batch;
+
+    mem_batch_begin(&batch, as);
+    mem_batch_unmap(&batch, at, num_pages, free_ppages);
+    mem_batch_commit(&batch);
+}
@@ -2,40 +2,157 @@
 #include "string.h"
 #include "util.h"
 
-void objpool_init(struct objpool *objpool) {
+// 需持有objpool->lock
+static void objpool_setup(struct objpool *objpool) {
     memset(objpool->pool, 0, objpool->objsize*objpool->num);
-    memset(objpool->bitmap, 0, BITMAP_SIZE(objpool->num));
+    memset(objpool->bitmap, 0, BITMAP_SIZE(objpool->num) * sizeof(bitmap_t));
+
+    if (objpool->ctor != NULL) {
+        for (size_t i = 0; i < objpool->num; i++) {
+            objpool->ctor(objpool->pool + (objpool->objsize * i));
+        }
+    }
+
+    // 每个CPU最多缓存池的1/(2*CPU数)，保证其余CPU总能从共享池取到对象
+    objpool->mag_size = MIN(OBJPOOL_MAG_SIZE, objpool->num / (2 * PLAT_CPU_NUM));
+    objpool->batch = (objpool->mag_size + 1) / 2;
+    objpool->hint = 0;
+    objpool->count = 0;
+    objpool->ready = true;
 }
 
-void* objpool_alloc(struct objpool *objpool) {
-    void *obj = NULL;
-    ssize_t n;
-    
+void objpool_init(struct objpool *objpool) {
     spin_lock(&objpool->lock);
-    n = bitmap_find_nth(objpool->bitmap, objpool->num, 1, 0, false);
-    if (n >= 0) {
+    objpool_setup(objpool);
+    memset(objpool->mags, 0, sizeof(objpool->mags));
+    spin_unlock(&objpool->lock);
+}
+
+static inline void* objpool_obj(struct objpool *objpool, size_t n) {
+    return objpool->pool + (objpool->objsize * n);
+}
+
+/**
+ * 从共享池取出至多nr个对象。从上一次停下的位置继续查找，
+ * 已分配的对象不会在每次分配时被重新扫描。需持有objpool->lock。
+ */
+static size_t objpool_take(struct objpool *objpool, void** objs, size_t nr) {
+    size_t taken = 0;
+    ssize_t n;
+
+    while (taken < nr && objpool->count < objpool->num) {
+        n = bitmap_find_nth(objpool->bitmap, objpool->num, 1, objpool->hint, false);
+        if (n < 0) {
+            n = bitmap_find_nth(objpool->bitmap, objpool->hint, 1, 0, false);
+            if (n < 0) {
+                break;
+            }
+        }
         bitmap_set(objpool->bitmap, n);
-        obj = objpool->pool + (objpool->objsize * n);
+        objpool->hint = (n + 1) % objpool->num;
+        objpool->count++;
+        objs[taken++] = objpool_obj(objpool, n);
+    }
+
+    return taken;
+}
+
+// 将对象归还共享池，需持有objpool->lock
+static void objpool_put(struct objpool *objpool, void** objs, size_t nr) {
+    size_t n;
+
+    for (size_t i = 0; i < nr; i++) {
+        n = ((vaddr_t)objs[i] - (vaddr_t)objpool->pool) / objpool->objsize;
+        bitmap_clear(objpool->bitmap, n);
+        objpool->count--;
+    }
+}
+
+void* objpool_alloc(struct objpool *objpool) {
+    struct objpool_mag *mag = &objpool->mags[cpu()->id];
+    void *obj = NULL;
+
+    if (mag->nr == 0) {
+        spin_lock(&objpool->lock);
+        if (!objpool->ready) {
+            objpool_setup(objpool);
+        }
+        if (objpool->mag_size == 0) {
+            // 池太小，不使用弹匣
+            objpool_take(objpool, &obj, 1);
+        } else {
+            mag->nr = objpool_take(objpool, mag->objs, objpool->batch);
+            objpool->nr_refill++;
+        }
+        if (obj == NULL && mag->nr == 0) {
+            objpool->nr_fail++;
+        }
+        spin_unlock(&objpool->lock);
+    }
+
+    if (obj == NULL && mag->nr > 0) {
+        obj = mag->objs[--mag->nr];
+    }
+    if (obj != NULL) {
+        mag->nr_alloc++;
     }
-    spin_unlock(&objpool->lock);
     return obj;
 }
 
 void objpool_free(struct objpool *objpool, void* obj) {
-    size_t n;
+    struct objpool_mag *mag = &objpool->mags[cpu()->id];
     vaddr_t obj_addr = (vaddr_t)obj;
     vaddr_t pool_addr = (vaddr_t)objpool->pool;
 
-    bool in_pool = 
+    bool in_pool =
         in_range(obj_addr, pool_addr, objpool->objsize * objpool->num);
     bool aligned = IS_ALIGNED(obj_addr-pool_addr, objpool->objsize);
 
-    if (in_pool && aligned) {
-        n = (obj_addr-pool_addr)/objpool->objsize;
-        spin_lock(&objpool->lock);
-        bitmap_clear(objpool->bitmap, n);
-        spin_unlock(&objpool->lock);
-    } else {
-	    WARNING("leaked while trying to free stray object");
+    if (!in_pool || !aligned) {
+        WARNING("leaked while trying to free stray object");
+        return;
     }
-}
\ No newline at end of file
+
+    mag->nr_free++;
+    if (mag->nr < objpool->mag_size) {
+        mag->objs[mag->nr++] = obj;
+        return;
+    }
+
+    // 弹匣已满（或不使用弹匣）：连同本对象一批归还共享池
+    spin_lock(&objpool->lock);
+    objpool_put(objpool, &obj, 1);
+    if (mag->nr > 0) {
+        mag->nr -= objpool->batch;
+        objpool_put(objpool, &mag->objs[mag->nr], objpool->batch);
+        objpool->nr_flush++;
+    }
+    spin_unlock(&objpool->lock);
+}
+
+// 统计各CPU的计数时不加锁，结果只是近似值
+void objpool_get_stats(struct objpool *objpool, struct objpool_stats *stats) {
+    memset(stats, 0, sizeof(struct objpool_stats));
+
+    for (size_t i = 0; i < PLAT_CPU_NUM; i++) {
+        stats->nr_alloc += objpool->mags[i].nr_alloc;
+        stats->nr_free += objpool->mags[i].nr_free;
+        stats->nr_cached += objpool->mags[i].nr;
+    }
+
+    spin_lock(&objpool->lock);
+    stats->nr_refill = objpool->nr_refill;
+    stats->nr_flush = objpool->nr_flush;
+    stats->nr_fail = objpool->nr_fail;
+    stats->nr_inuse = objpool->count - stats->nr_cached;
+    spin_unlock(&objpool->lock);
+}
+
+void objpool_print_stats(struct objpool *objpool) {
+    struct objpool_stats stats;
+
+    objpool_get_stats(objpool, &stats);
+    INFO("objpool %s: %d/%d in use, %d cached, alloc %d, free %d, refill %d, flush %d, fail %d",
+        objpool->name, stats.nr_inuse, objpool->num, stats.nr_cached, stats.nr_alloc,
+        stats.nr_free, stats.nr_refill, stats.nr_flush, stats.nr_fail);
+}
@@ -0,0 +1,238 @@
+#include "shmem.h"
+#include "vm.h"
+#include "mem.h"
+#include "string.h"
+
+static struct shmem_region shmem_regions[SHMEM_MAX_REGIONS];
+static spinlock_t shmem_lock = SPINLOCK_INITVAL;
+
+// 将打包在寄存器中的名字转为字符串，仅用于日志
+static inline char* shmem_name_str(uint64_t name, char buf[9]) {
+    memcpy(buf, &name, sizeof(name));
+    buf[8] = '\0';
+    return buf;
+}
+
+// 需持有shmem_lock
+static struct shmem_region* shmem_find(uint64_t name) {
+    for (size_t i = 0; i < SHMEM_MAX_REGIONS; i++) {
+        if (shmem_regions[i].used && shmem_regions[i].name == name) {
+            return &shmem_regions[i];
+        }
+    }
+    return NULL;
+}
+
+// 固定映射在SHARED_MEM_BASE的共享内存，供直接访问该地址的旧客户机使用
+static struct shmem_region* shmem_legacy;
+
+static inline unsigned long shmem_perm(struct shmem_region* shm, vmid_t vm_id) {
+    if (vm_id == shm->owner) {
+        return SHMEM_PERM_RW;
+    }
+    return (shm->perms >> (vm_id * SHMEM_PERM_BITS)) & SHMEM_PERM_RW;
+}
+
+static void shmem_free(struct shmem_region* shm) {
+    mem_free_page((void*)shm->ppages.base, shm->ppages.nr_pages);
+    shm->used = false;
+}
+
+/**
+ * 创建固定的共享内存区域。旧的客户机（如场景5的读写者与app-helloworld）
+ * 不使用SHMEM hypercall，而是直接访问SHARED_MEM_BASE，因此每个虚拟机
+ * 启动时都映射该区域。它对所有虚拟机可读写，且永不释放。
+ */
+void shmem_init() {
+    struct shmem_region* shm = &shmem_regions[0];
+
+    if (!pp_alloc(root_page_pool, NUM_PAGES(SHARED_MEM_SIZE), true, &shm->ppages)) {
+        ERROR("Failed to allocate shared memory.");
+    }
+    memset((void*)shm->ppages.base, 0, SHARED_MEM_SIZE);
+    // 测试用
+    memcpy((char*)shm->ppages.base, "Ciallo!\0", 8);
+
+    shm->used = true;
+    shm->pinned = true;
+    memcpy(&shm->name, "shared\0\0", sizeof(shm->name));
+    shm->owner = MAX_VM_NUM;     // 不属于任何虚拟机
+    shm->perms = ~0ULL;
+    shm->refs = 0;
+    for (size_t i = 0; i < MAX_VM_NUM; i++) {
+        shm->ipa[i] = INVALID_VA;
+    }
+    shmem_legacy = shm;
+
+    INFO("Shared memory initialized: ipa=0x%x, pa=0x%x, size=0x%x",
+        SHARED_MEM_BASE, shm->ppages.base, SHARED_MEM_SIZE);
+}
+
+// 虚拟机初始化时映射固定的共享内存区域
+void shmem_vm_init(struct vm* vm) {
+    struct shmem_region* shm = shmem_legacy;
+
+    spin_lock(&shmem_lock);
+    if (shm != NULL && shm->ipa[vm->id] == INVALID_VA) {
+        if (!mem_map_huge(&vm->as, SHARED_MEM_BASE, &shm->ppages, PTE_VM_SHMEM_FLAGS)) {
+            ERROR("vm%d failed to map shared memory", vm->id);
+        }
+        shm->ipa[vm->id] = SHARED_MEM_BASE;
+        shm->refs++;
+    }
+    spin_unlock(&shmem_lock);
+}
+
+void shmem_create_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    // arg0: 名字（至多8个字符）
+    // arg1: 大小，向上对齐到2MB
+    // arg2: 其他虚拟机的权限，见SHMEM_PERM
+    // 返回 x0: SHMEM_SUCCESS/SHMEM_ERROR
+    uint64_t name = arg0;
+    size_t nr_pages = NUM_PAGES(ALIGN(arg1, SHMEM_BLOCK_SIZE));
+    struct shmem_region* shm = NULL;
+    unsigned long ret = SHMEM_ERROR;
+    char buf[9];
+
+    spin_lock(&shmem_lock);
+    if (name == 0 || nr_pages == 0 || shmem_find(name) != NULL) {
+        WARNING("shmem: cannot create '%s'", shmem_name_str(name, buf));
+        goto out;
+    }
+
+    for (size_t i = 0; i < SHMEM_MAX_REGIONS; i++) {
+        if (!shmem_regions[i].used) {
+            shm = &shmem_regions[i];
+            break;
+        }
+    }
+    if (shm == NULL) {
+        WARNING("shmem: no free region for '%s'", shmem_name_str(name, buf));
+        goto out;
+    }
+
+    // 按大小对齐分配，保证物理地址2MB对齐，从而可以使用块映射
+    if (!pp_alloc(root_page_pool, nr_pages, true, &shm->ppages)) {
+        WARNING("shmem: not enough memory for '%s'", shmem_name_str(name, buf));
+        goto out;
+    }
+    memset((void*)shm->ppages.base, 0, nr_pages * PAGE_SIZE);
+
+    shm->used = true;
+    shm->name = name;
+    shm->owner = CURRENT_VM->id;
+    shm->perms = arg2;
+    shm->refs = 0;
+    shm->pinned = false;
+    for (size_t i = 0; i < MAX_VM_NUM; i++) {
+        shm->ipa[i] = INVALID_VA;
+    }
+    ret = SHMEM_SUCCESS;
+
+    INFO("shmem: vm%d created '%s', pa=0x%x, size=0x%x",
+        shm->owner, shmem_name_str(name, buf), shm->ppages.base, nr_pages * PAGE_SIZE);
+out:
+    spin_unlock(&shmem_lock);
+    vcpu_writereg(cpu()->vcpu, 0, ret);
+}
+
+void shmem_attach_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    // arg0: 名字
+    // arg1: 映射到的客户机物理地址，须2MB对齐
+    // arg2: 请求的权限，SHMEM_PERM_RO/SHMEM_PERM_RW
+    // 返回 x0: SHMEM_SUCCESS/SHMEM_ERROR, x1: 区域大小
+    struct vm* vm = CURRENT_VM;
+    vaddr_t ipa = arg1;
+    unsigned long perm = arg2 & SHMEM_PERM_RW;
+    struct shmem_region* shm;
+    unsigned long ret = SHMEM_ERROR;
+    size_t size = 0;
+    char buf[9];
+
+    spin_lock(&shmem_lock);
+    shm = shmem_find(arg0);
+    if (shm == NULL || perm == SHMEM_PERM_NONE || !IS_ALIGNED(ipa, SHMEM_BLOCK_SIZE) ||
+        shm->ipa[vm->id] != INVALID_VA) {
+        WARNING("shmem: vm%d cannot attach '%s'", vm->id, shmem_name_str(arg0, buf));
+        goto out;
+    }
+    if ((shmem_perm(shm, vm->id) & perm) != perm) {
+        WARNING("shmem: vm%d has no permission for '%s'", vm->id, shmem_name_str(arg0, buf));
+        goto out;
+    }
+
+    if (!mem_map_huge(&vm->as, ipa, &shm->ppages,
+                      perm == SHMEM_PERM_RW ? PTE_VM_SHMEM_FLAGS : PTE_VM_SHMEM_RO_FLAGS)) {
+        WARNING("shmem: vm%d ipa 0x%x already in use", vm->id, ipa);
+        goto out;
+    }
+
+    shm->ipa[vm->id] = ipa;
+    shm->refs++;
+    size = shm->ppages.nr_pages * PAGE_SIZE;
+    ret = SHMEM_SUCCESS;
+
+    INFO("shmem: vm%d attached '%s' at 0x%x (%s)", vm->id, shmem_name_str(arg0, buf),
+        ipa, perm == SHMEM_PERM_RW ? "rw" : "ro");
+out:
+    spin_unlock(&shmem_lock);
+    vcpu_writereg(cpu()->vcpu, 0, ret);
+    vcpu_writereg(cpu()->vcpu, 1, size);
+}
+
+void shmem_detach_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    // arg0: 名字
+    // 返回 x0: SHMEM_SUCCESS/SHMEM_ERROR
+    // 最后一个虚拟机解除映射时释放该区域
+    struct vm* vm = CURRENT_VM;
+    struct shmem_region* shm;
+    unsigned long ret = SHMEM_ERROR;
+    char buf[9];
+
+    spin_lock(&shmem_lock);
+    shm = shmem_find(arg0);
+    if (shm == NULL || shm->ipa[vm->id] == INVALID_VA) {
+        WARNING("shmem: vm%d cannot detach '%s'", vm->id, shmem_name_str(arg0, buf));
+        goto out;
+    }
+
+    mem_unmap(&vm->as, shm->ipa[vm->id], shm->ppages.nr_pages, false);
+    shm->ipa[vm->id] = INVALID_VA;
+    if (--shm->refs == 0 && !shm->pinned) {
+        INFO("shmem: '%s' released", shmem_name_str(arg0, buf));
+        shmem_free(shm);
+    }
+    ret = SHMEM_SUCCESS;
+out:
+    spin_unlock(&shmem_lock);
+    vcpu_writereg(cpu()->vcpu, 0, ret);
+}
+
+/**
+ * 虚拟机销毁时解除它映射的所有共享内存。最后一个使用者离开时释放区域，
+ * 它创建了但没有任何虚拟机映射的区域也一并释放。
+ */
+void shmem_vm_release(struct vm* vm) {
+    struct shmem_region* shm;
+    bool attached;
+    char buf[9];
+
+    spin_lock(&shmem_lock);
+    for (size_t i = 0; i < SHMEM_MAX_REGIONS; i++) {
+        shm = &shmem_regions[i];
+        if (!shm->used) {
+            continue;
+        }
+        attached = shm->ipa[vm->id] != INVALID_VA;
+        if (attached) {
+            mem_unmap(&vm->as, shm->ipa[vm->id], shm->ppages.nr_pages, false);
+            shm->ipa[vm->id] = INVALID_VA;
+            shm->refs--;
+        }
+        if (shm->refs == 0 && !shm->pinned && (attached || shm->owner == vm->id)) {
+            INFO("shmem: '%s' released", shmem_name_str(shm->name, buf));
+            shmem_free(shm);
+        }
+    }
+    spin_unlock(&shmem_lock);
+}
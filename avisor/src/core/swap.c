@@ -0,0 +1,349 @@
+#include "swap.h"
+#include "vm.h"
+#include "mem.h"
+#include "string.h"
+#include "fences.h"
+#include "sysregs.h"
+
+/**
+ * 页压缩格式：以64位字为单位的游程编码。每段以一个标记字开头，
+ * 最高位为1表示一段重复字（后跟1个值），为0表示一段原样字（后跟count个字）。
+ * 客户机内存中大量的零页与填充数据用它已足够，且解压只需一次顺序扫描。
+ */
+#define SWAP_TOKEN_RUN (1ULL << 63)
+#define SWAP_PAGE_WORDS (PAGE_SIZE / sizeof(uint64_t))
+
+struct swap_blob {
+    uint64_t csize;
+    uint64_t data[0];
+};
+
+// 压缩一页到dst，返回压缩后字节数；超过limit时返回0
+static size_t swap_compress(uint64_t* dst, const uint64_t* src, size_t limit) {
+    size_t i = 0, out = 0, run, lit;
+    size_t max = limit / sizeof(uint64_t);
+
+    while (i < SWAP_PAGE_WORDS) {
+        run = 1;
+        while (i + run < SWAP_PAGE_WORDS && src[i + run] == src[i]) {
+            run++;
+        }
+
+        if (run > 2) {
+            if (out + 2 > max) {
+                return 0;
+            }
+            dst[out++] = SWAP_TOKEN_RUN | run;
+            dst[out++] = src[i];
+            i += run;
+            continue;
+        }
+
+        // 收集原样字，直到遇到长度大于2的重复段
+        lit = 0;
+        while (i + lit < SWAP_PAGE_WORDS) {
+            if (i + lit + 2 < SWAP_PAGE_WORDS && src[i + lit] == src[i + lit + 1] &&
+                src[i + lit] == src[i + lit + 2]) {
+                break;
+            }
+            lit++;
+        }
+        if (out + 1 + lit > max) {
+            return 0;
+        }
+        dst[out++] = lit;
+        memcpy(&dst[out], &src[i], lit * sizeof(uint64_t));
+        out += lit;
+        i += lit;
+    }
+
+    return out * sizeof(uint64_t);
+}
+
+static void swap_decompress(uint64_t* dst, const uint64_t* src) {
+    size_t i = 0, n;
+    uint64_t token;
+
+    while (i < SWAP_PAGE_WORDS) {
+        token = *src++;
+        n = token & ~SWAP_TOKEN_RUN;
+        if (token & SWAP_TOKEN_RUN) {
+            for (size_t j = 0; j < n; j++) {
+                dst[i + j] = *src;
+            }
+            src++;
+        } else {
+            memcpy(&dst[i], src, n * sizeof(uint64_t));
+            src += n;
+        }
+        i += n;
+    }
+}
+
+static inline pte_t* swap_pte(struct vm* vm, vaddr_t ipa) {
+    return pt_get_pte(&vm->as.pt, vm->as.pt.dscr->lvls - 1, ipa);
+}
+
+static inline struct swap_blob* swap_blob_get(struct vm_swap* swap, size_t chunk) {
+    return (struct swap_blob*)(swap->store + chunk * SWAP_CHUNK_SIZE);
+}
+
+static inline size_t swap_blob_chunks(size_t csize) {
+    return ALIGN(sizeof(struct swap_blob) + csize, SWAP_CHUNK_SIZE) / SWAP_CHUNK_SIZE;
+}
+
+/**
+ * 压缩一个已从第二阶段页表中移除的页。成功时写入换出标记并释放物理页，
+ * 失败时（不可压缩或存储区已满）重新映射该页。
+ */
+static bool swap_out_page(struct vm_swap* swap, pte_t* pte) {
+    paddr_t pa = pte_addr(pte);
+    uint64_t* page = (uint64_t*)pa;
+    size_t csize, nr_chunks, chunk;
+    struct swap_blob* blob;
+
+    csize = swap_compress((uint64_t*)swap->scratch, page, SWAP_MAX_CSIZE);
+    if (csize == 0) {
+        pte_set(pte, pa, PTE_PAGE, PTE_VM_FLAGS);
+        return false;
+    }
+
+    if (((uint64_t*)swap->scratch)[0] == (SWAP_TOKEN_RUN | SWAP_PAGE_WORDS) &&
+        ((uint64_t*)swap->scratch)[1] == 0) {
+        *pte = PTE_RSW_ZERO;
+        swap->nr_zero++;
+    } else {
+        nr_chunks = swap_blob_chunks(csize);
+        chunk = bitmap_find_consec(swap->store_bitmap, swap->nr_chunks, 0, nr_chunks, false);
+        if ((ssize_t)chunk < 0) {
+            pte_set(pte, pa, PTE_PAGE, PTE_VM_FLAGS);
+            return false;
+        }
+        bitmap_set_consecutive(swap->store_bitmap, chunk, nr_chunks);
+
+        blob = swap_blob_get(swap, chunk);
+        blob->csize = csize;
+        memcpy(blob->data, swap->scratch, csize);
+        *pte = PTE_RSW_SWAP | ((chunk * PAGE_SIZE) & PTE_ADDR_MSK);
+        swap->nr_swapped++;
+    }
+
+    mem_free_page((void*)pa, 1);
+    swap->nr_resident--;
+    swap->nr_swap_out++;
+
+    return true;
+}
+
+/**
+ * 时钟扫描：访问标志被置位的页清除标志并给予第二次机会，
+ * 未被置位的页作为换出候选。清除访问标志与移除映射产生的TLB无效化
+ * 合并为一次范围无效化，之后再逐页压缩。需持有swap->lock。
+ */
+static size_t swap_reclaim(struct vm* vm, size_t want) {
+    struct vm_swap* swap = &vm->swap;
+    struct mem_batch batch;
+    size_t nr_victims = 0, reclaimed = 0;
+    vaddr_t ipa;
+    pte_t* pte;
+
+    want = MIN(want, SWAP_RECLAIM_PAGES);
+
+    mem_batch_begin(&batch, &vm->as);
+    for (size_t i = 0; i < SWAP_SCAN_PAGES && i < swap->nr_pages; i++) {
+        ipa = swap->base + swap->cursor * PAGE_SIZE;
+        swap->cursor = (swap->cursor + 1) % swap->nr_pages;
+
+        pte = swap_pte(vm, ipa);
+        if (!pte_valid(pte)) {
+            continue;
+        }
+
+        if (*pte & PTE_AF) {
+            *pte &= ~PTE_AF;
+            mem_batch_inv(&batch, ipa, PAGE_SIZE);
+        } else if (nr_victims < want) {
+            // 保留物理地址，仅清除有效位，压缩完成前的访问会在swap->lock上等待
+            swap->victims[nr_victims++] = pte;
+            *pte &= ~PTE_VALID;
+            mem_batch_inv(&batch, ipa, PAGE_SIZE);
+        }
+    }
+    mem_batch_commit(&batch);
+
+    for (size_t i = 0; i < nr_victims; i++) {
+        if (swap_out_page(swap, swap->victims[i])) {
+            reclaimed++;
+        }
+    }
+
+    return reclaimed;
+}
+
+// 将换出的页重新载入，需持有swap->lock
+static paddr_t swap_in_page(struct vm* vm, pte_t* pte) {
+    struct vm_swap* swap = &vm->swap;
+    struct swap_blob* blob;
+    struct ppages ppages;
+    size_t chunk;
+
+    if (!pp_alloc(root_page_pool, 1, false, &ppages)) {
+        swap_reclaim(vm, 1);
+        if (!pp_alloc(root_page_pool, 1, false, &ppages)) {
+            ERROR("vm%d swap: out of memory", vm->id);
+        }
+    }
+
+    if (pte_check_rsw(pte, PTE_RSW_ZERO)) {
+        memset((void*)ppages.base, 0, PAGE_SIZE);
+        swap->nr_zero--;
+    } else {
+        chunk = pte_addr(pte) / PAGE_SIZE;
+        blob = swap_blob_get(swap, chunk);
+        swap_decompress((uint64_t*)ppages.base, blob->data);
+        bitmap_clear_consecutive(swap->store_bitmap, chunk, swap_blob_chunks(blob->csize));
+        swap->nr_swapped--;
+    }
+
+    pte_set(pte, ppages.base, PTE_PAGE, PTE_VM_FLAGS);
+    swap->nr_resident++;
+    swap->nr_swap_in++;
+
+    return ppages.base;
+}
+
+static inline bool swap_pte_swapped(pte_t* pte) {
+    return !pte_valid(pte) &&
+           (pte_check_rsw(pte, PTE_RSW_SWAP) || pte_check_rsw(pte, PTE_RSW_ZERO));
+}
+
+static inline bool swap_in_range(struct vm_swap* swap, vaddr_t ipa) {
+    return in_range(ipa, swap->base, swap->nr_pages * PAGE_SIZE);
+}
+
+// 主CPU上的周期定时事件
+static void vm_swap_scan(struct timer_event* ev) {
+    struct vm* vm = ev->data;
+    struct vm_swap* swap = &vm->swap;
+    size_t reclaimed;
+
+    spin_lock(&swap->lock);
+    reclaimed = swap_reclaim(vm, swap->nr_resident > swap->nr_limit
+                                     ? swap->nr_resident - swap->nr_limit
+                                     : 0);
+    if (reclaimed > 0) {
+        INFO("VM[%d] swap: reclaimed %d, resident %d, swapped %d, zero %d",
+            vm->id, reclaimed, swap->nr_resident, swap->nr_swapped, swap->nr_zero);
+    }
+    spin_unlock(&swap->lock);
+}
+
+void vm_swap_init(struct vm* vm, const struct vm_config* config) {
+    struct vm_swap* swap = &vm->swap;
+    size_t bitmap_size;
+
+    memset(swap, 0, sizeof(struct vm_swap));
+    if (config->swap.mem_limit == 0) {
+        return;
+    }
+
+    // 镜像页与其他虚拟机共享（见vm_map_image），只回收镜像之后的内存
+    swap->base = config->base_addr + ALIGN(config->size, PAGE_SIZE);
+    swap->nr_pages = NUM_PAGES(config->dmem_size);
+    swap->nr_limit = NUM_PAGES(config->swap.mem_limit);
+    swap->nr_resident = swap->nr_pages;
+
+    swap->nr_chunks = config->swap.store_size / SWAP_CHUNK_SIZE;
+    bitmap_size = BITMAP_SIZE(swap->nr_chunks) * sizeof(bitmap_t);
+    swap->store = mem_alloc_page(NUM_PAGES(config->swap.store_size), false);
+    swap->store_bitmap = mem_alloc_page(NUM_PAGES(bitmap_size), false);
+    swap->scratch = mem_alloc_page(1, false);
+    swap->victims = mem_alloc_page(NUM_PAGES(SWAP_RECLAIM_PAGES * sizeof(pte_t*)), false);
+    memset(swap->store_bitmap, 0, bitmap_size);
+
+    swap->lock = SPINLOCK_INITVAL;
+    swap->enabled = true;
+
+    // 由主CPU初始化，扫描定时器也就在主CPU上触发
+    timer_event_init(&swap->scan_timer, vm_swap_scan, vm);
+    timer_event_add(&swap->scan_timer, timer_ms_to_ticks(SWAP_SCAN_PERIOD_MS),
+                    timer_ms_to_ticks(SWAP_SCAN_PERIOD_MS));
+
+    INFO("VM[%d] swap: limit %d pages of %d, store 0x%x",
+        vm->id, swap->nr_limit, swap->nr_pages, config->swap.store_size);
+}
+
+// 虚拟机销毁时由主CPU调用：停止时钟扫描并释放压缩存储区
+void vm_swap_release(struct vm* vm) {
+    struct vm_swap* swap = &vm->swap;
+    size_t bitmap_size = BITMAP_SIZE(swap->nr_chunks) * sizeof(bitmap_t);
+
+    if (!swap->enabled) {
+        return;
+    }
+
+    timer_event_cancel(&swap->scan_timer);
+    mem_free_page(swap->store, NUM_PAGES(vm->vm_config->swap.store_size));
+    mem_free_page(swap->store_bitmap, NUM_PAGES(bitmap_size));
+    mem_free_page(swap->scratch, 1);
+    mem_free_page(swap->victims, NUM_PAGES(SWAP_RECLAIM_PAGES * sizeof(pte_t*)));
+    swap->enabled = false;
+}
+
+/**
+ * 处理第二阶段的缺页。返回true表示该异常已由换入处理，
+ * 客户机应重新执行触发异常的指令。
+ */
+bool vm_swap_fault(struct vm* vm, vaddr_t ipa, unsigned long fsc) {
+    struct vm_swap* swap = &vm->swap;
+    bool handled = false;
+    pte_t* pte;
+
+    if (!swap->enabled || !swap_in_range(swap, ipa)) {
+        return false;
+    }
+
+    spin_lock(&swap->lock);
+    pte = swap_pte(vm, ipa);
+    if (fsc == ESR_ISS_DA_DSFC_ACCESS && pte_valid(pte)) {
+        *pte |= PTE_AF;
+        handled = true;
+    } else if (fsc == ESR_ISS_DA_DSFC_TRNSLT && swap_pte_swapped(pte)) {
+        if (swap->nr_resident >= swap->nr_limit) {
+            swap_reclaim(vm, 1);
+        }
+        swap_in_page(vm, pte);
+        handled = true;
+    } else if (pte_valid(pte)) {
+        // 其他vCPU已处理了同一页的缺页
+        handled = true;
+    }
+    fence_sync();
+    spin_unlock(&swap->lock);
+
+    return handled;
+}
+
+/**
+ * 返回客户机页当前的物理地址，必要时将其换入。供需要直接访问客户机内存
+ * 的路径（快照、重启）使用；此处不做直接回收，以免回收掉其他vCPU正在
+ * 拷贝的页（物理内存耗尽时除外），驻留页数的超出由下一次扫描收回。
+ */
+paddr_t vm_swap_page_pa(struct vm* vm, vaddr_t ipa) {
+    struct vm_swap* swap = &vm->swap;
+    paddr_t pa;
+    pte_t* pte;
+
+    spin_lock(&swap->lock);
+    pte = swap_pte(vm, ipa);
+    if (pte_valid(pte)) {
+        pa = pte_addr(pte);
+    } else if (swap_pte_swapped(pte)) {
+        pa = swap_in_page(vm, pte);
+    } else {
+        ERROR("vm%d swap: 0x%lx is not mapped", vm->id, ipa);
+    }
+    spin_unlock(&swap->lock);
+
+    return pa;
+}
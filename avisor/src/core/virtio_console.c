@@ -0,0 +1,248 @@
+#include "virtio_console.h"
+#include "vm.h"
+#include "config.h"
+#include "console.h"
+#include "fences.h"
+#include "string.h"
+
+#define VIRTIO_CONSOLE_CHUNK (128)  // 每次从客户机拷贝的字节数，受限于hypervisor栈大小
+
+static void virtio_console_reset(struct virtio_console* vc) {
+    vc->status = 0;
+    vc->int_status = 0;
+    vc->dev_features_sel = 0;
+    vc->drv_features_sel = 0;
+    vc->drv_features = 0;
+    vc->queue_sel = 0;
+    memset(vc->queues, 0, sizeof(vc->queues));
+}
+
+static inline struct virtio_queue* virtio_console_queue(struct virtio_console* vc) {
+    if (vc->queue_sel < VIRTIO_CONSOLE_NR_QUEUES) {
+        return &vc->queues[vc->queue_sel];
+    }
+    return NULL;
+}
+
+// 输出一个描述符指向的缓冲区
+static bool virtio_console_tx_buf(struct vm* vm, vaddr_t addr, size_t len) {
+    char buf[VIRTIO_CONSOLE_CHUNK];
+    size_t n;
+
+    while (len > 0) {
+        n = MIN(len, VIRTIO_CONSOLE_CHUNK);
+        if (!vm_copy_from_guest(vm, buf, addr, n)) {
+            return false;
+        }
+        console_write_vm(vm->id, buf, n);
+        addr += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * 处理发送队列中所有新的缓冲区。整条描述符链在一次通知中处理完，
+ * 最后统一更新used->idx并至多注入一次中断。
+ */
+static void virtio_console_tx(struct vm* vm, struct virtio_console* vc) {
+    struct virtio_queue* vq = &vc->queues[VIRTIO_CONSOLE_TX_QUEUE];
+    struct virtq_used_elem used;
+    struct virtq_desc desc;
+    uint16_t avail_flags, avail_idx, head, idx;
+    bool ok = true;
+
+    if (!vq->ready || vq->num == 0) {
+        return;
+    }
+
+    ok &= vm_copy_from_guest(vm, &avail_idx, vq->avail + 2, sizeof(avail_idx));
+    fence_ord_read();
+
+    while (ok && vq->last_avail != avail_idx) {
+        ok &= vm_copy_from_guest(vm, &head,
+                                 vq->avail + 4 + (vq->last_avail % vq->num) * sizeof(uint16_t),
+                                 sizeof(head));
+        idx = head;
+        for (size_t i = 0; ok && i < vq->num; i++) {
+            ok &= vm_copy_from_guest(vm, &desc, vq->desc + idx * sizeof(desc), sizeof(desc));
+            if (ok && !(desc.flags & VIRTQ_DESC_F_WRITE)) {
+                ok &= virtio_console_tx_buf(vm, desc.addr, desc.len);
+            }
+            if (!(desc.flags & VIRTQ_DESC_F_NEXT)) {
+                break;
+            }
+            idx = desc.next % vq->num;
+        }
+
+        used.id = head;
+        used.len = 0;
+        ok &= vm_copy_to_guest(vm, vq->used + 4 + (vq->used_idx % vq->num) * sizeof(used),
+                               &used, sizeof(used));
+        vq->used_idx++;
+        vq->last_avail++;
+    }
+
+    if (!ok) {
+        WARNING("vm%d virtio-console: invalid guest address in transmit queue", vm->id);
+        return;
+    }
+
+    fence_ord_write();
+    vm_copy_to_guest(vm, vq->used + 2, &vq->used_idx, sizeof(vq->used_idx));
+    fence_ord();
+
+    vm_copy_from_guest(vm, &avail_flags, vq->avail, sizeof(avail_flags));
+    if (!(avail_flags & VIRTQ_AVAIL_F_NO_INTERRUPT)) {
+        vc->int_status |= VIRTIO_MMIO_INT_VRING;
+        vcpu_arch_inject_irq(cpu()->vcpu, vc->irq);
+    }
+}
+
+static uint32_t virtio_console_read(struct virtio_console* vc, size_t off) {
+    struct virtio_queue* vq = virtio_console_queue(vc);
+
+    switch (off) {
+        case VIRTIO_MMIO_MAGIC_VALUE:
+            return VIRTIO_MMIO_MAGIC;
+        case VIRTIO_MMIO_VERSION:
+            return 2;
+        case VIRTIO_MMIO_DEVICE_ID:
+            return VIRTIO_ID_CONSOLE;
+        case VIRTIO_MMIO_VENDOR_ID:
+            return VIRTIO_MMIO_VENDOR;
+        case VIRTIO_MMIO_DEVICE_FEATURES:
+            return vc->dev_features_sel == 1 ? (1U << (VIRTIO_F_VERSION_1 - 32)) : 0;
+        case VIRTIO_MMIO_QUEUE_NUM_MAX:
+            return vq != NULL ? VIRTIO_CONSOLE_QUEUE_MAX : 0;
+        case VIRTIO_MMIO_QUEUE_READY:
+            return vq != NULL ? vq->ready : 0;
+        case VIRTIO_MMIO_INTERRUPT_STATUS:
+            return vc->int_status;
+        case VIRTIO_MMIO_STATUS:
+            return vc->status;
+        case VIRTIO_MMIO_CONFIG_GENERATION:
+            return 0;
+        default:
+            // 配置空间 cols/rows/max_nr_ports 均为0
+            return 0;
+    }
+}
+
+static void virtio_console_write(struct vm* vm, struct virtio_console* vc, size_t off, uint32_t val) {
+    struct virtio_queue* vq = virtio_console_queue(vc);
+    char c;
+
+    switch (off) {
+        case VIRTIO_MMIO_DEVICE_FEATURES_SEL:
+            vc->dev_features_sel = val;
+            break;
+        case VIRTIO_MMIO_DRIVER_FEATURES_SEL:
+            vc->drv_features_sel = val;
+            break;
+        case VIRTIO_MMIO_DRIVER_FEATURES:
+            if (vc->drv_features_sel < 2) {
+                vc->drv_features |= (uint64_t)val << (32 * vc->drv_features_sel);
+            }
+            break;
+        case VIRTIO_MMIO_QUEUE_SEL:
+            vc->queue_sel = val;
+            break;
+        case VIRTIO_MMIO_QUEUE_NUM:
+            if (vq != NULL && val <= VIRTIO_CONSOLE_QUEUE_MAX) {
+                vq->num = val;
+            }
+            break;
+        case VIRTIO_MMIO_QUEUE_READY:
+            if (vq != NULL) {
+                vq->ready = val & 1;
+            }
+            break;
+        case VIRTIO_MMIO_QUEUE_NOTIFY:
+            if (val == VIRTIO_CONSOLE_TX_QUEUE) {
+                virtio_console_tx(vm, vc);
+            }
+            break;
+        case VIRTIO_MMIO_INTERRUPT_ACK:
+            vc->int_status &= ~val;
+            break;
+        case VIRTIO_MMIO_STATUS:
+            if (val == 0) {
+                virtio_console_reset(vc);
+            } else {
+                vc->status = val;
+            }
+            break;
+        case VIRTIO_MMIO_QUEUE_DESC_LOW:
+        case VIRTIO_MMIO_QUEUE_DESC_HIGH:
+        case VIRTIO_MMIO_QUEUE_AVAIL_LOW:
+        case VIRTIO_MMIO_QUEUE_AVAIL_HIGH:
+        case VIRTIO_MMIO_QUEUE_USED_LOW:
+        case VIRTIO_MMIO_QUEUE_USED_HIGH: {
+            vaddr_t* addr;
+
+            if (vq == NULL) {
+                break;
+            }
+            addr = off < VIRTIO_MMIO_QUEUE_AVAIL_LOW ? &vq->desc
+                 : off < VIRTIO_MMIO_QUEUE_USED_LOW ? &vq->avail : &vq->used;
+            if (off & 0x4) {
+                *addr = (*addr & 0xffffffffUL) | ((vaddr_t)val << 32);
+            } else {
+                *addr = (*addr & ~0xffffffffUL) | val;
+            }
+            break;
+        }
+        case VIRTIO_MMIO_CONFIG + VIRTIO_CONSOLE_EMERG_WR:
+            c = (char)val;
+            console_write_vm(vm->id, &c, 1);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool virtio_console_emul_handler(struct emul_access* acc) {
+    struct vm* vm = cpu()->vcpu->vm;
+    struct virtio_console* vc = &vm->vcons;
+    size_t off = acc->addr - vc->base;
+
+    // 通用寄存器只允许32位访问，配置空间允许任意宽度
+    if (off < VIRTIO_MMIO_CONFIG && acc->width != 4) {
+        return false;
+    }
+
+    spin_lock(&vc->lock);
+    if (acc->write) {
+        virtio_console_write(vm, vc, off, vcpu_readreg(cpu()->vcpu, acc->reg));
+    } else {
+        vcpu_writereg(cpu()->vcpu, acc->reg, virtio_console_read(vc, off));
+    }
+    spin_unlock(&vc->lock);
+
+    return true;
+}
+
+void virtio_console_init(struct vm* vm, const struct vm_config* config) {
+    struct virtio_console* vc = &vm->vcons;
+
+    vc->enabled = config->vcons.base != 0;
+    if (!vc->enabled) {
+        return;
+    }
+
+    vc->lock = SPINLOCK_INITVAL;
+    vc->base = config->vcons.base;
+    vc->irq = config->vcons.irq;
+    virtio_console_reset(vc);
+
+    vc->emul = (struct emul_mem) {
+        .va_base = vc->base,
+        .size = VIRTIO_MMIO_SIZE,
+        .handler = virtio_console_emul_handler
+    };
+    INIT_LIST_HEAD(&vc->emul.list);
+    vm_emul_add_mem(vm, &vc->emul);
+
+    INFO("VM[%d] virtio-console at 0x%x, irq %d", vm->id, vc->base, vc->irq);
+}
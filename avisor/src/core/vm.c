@@ -8,32 +8,73 @@
 #include "cpu.h"
 #include "list.h"
 #include "sched.h"
+#include "boot.h"
+#include "tlb.h"
+#include "shmem.h"
 // #include "rq.h"
 
 struct vm_list vm_list;
 
+// 镜像末尾不满一页的部分拷贝到私有页，页内其余部分清零，不暴露镜像之后的数据
+static void vm_copy_image_tail(struct vm* vm, vaddr_t ipa, paddr_t src, size_t size) {
+    paddr_t pa;
+
+    mem_translate(&vm->as, ipa, &pa);
+    memcpy((void*)pa, (void*)src, size);
+    memset((void*)(pa + size), 0, PAGE_SIZE - size);
+}
+
+/**
+ * 将嵌入在avisor中的镜像直接映射给虚拟机：整页以只读方式共享，
+ * 客户机写入时才复制（见vm_cow_break）。多个虚拟机使用同一镜像、
+ * 或虚拟机重启时都不再需要拷贝镜像。返回映射的页数。
+ */
+static size_t vm_map_image(struct vm* vm, vaddr_t ipa, paddr_t src, size_t size) {
+    size_t nr_shared = size / PAGE_SIZE;
+    size_t tail = size % PAGE_SIZE;
+    struct ppages ppages = mem_ppages_get(src, nr_shared);
+
+    if (!IS_ALIGNED(src, PAGE_SIZE)) {
+        // 镜像未按页对齐，只能拷贝
+        if (mem_alloc_map(&vm->as, NULL, ipa, NUM_PAGES(size), PTE_VM_FLAGS) != ipa) {
+            ERROR("vm%d cannot map image at 0x%x", vm->id, ipa);
+        }
+        vm_copy_to_guest(vm, ipa, (void*)src, size);
+        return NUM_PAGES(size);
+    }
+
+    if (nr_shared > 0 &&
+        mem_alloc_map(&vm->as, &ppages, ipa, nr_shared, PTE_VM_COW_FLAGS) != ipa) {
+        ERROR("vm%d cannot map image at 0x%x", vm->id, ipa);
+    }
+    if (tail > 0) {
+        if (mem_alloc_map(&vm->as, NULL, ipa + nr_shared * PAGE_SIZE, 1, PTE_VM_FLAGS) == INVALID_VA) {
+            ERROR("vm%d cannot map image at 0x%x", vm->id, ipa);
+        }
+        vm_copy_image_tail(vm, ipa + nr_shared * PAGE_SIZE, src + nr_shared * PAGE_SIZE, tail);
+    }
+
+    return NUM_PAGES(size);
+}
+
 // 初始化虚拟机的地址空间
 static void vm_init_mem_regions(struct vm* vm, const struct vm_config* vm_config) { 
+    size_t nr_image;
     vaddr_t va;
-    paddr_t pa;
+
+    nr_image = vm_map_image(vm, vm_config->base_addr, vm_config->load_addr, vm_config->size);
+    INFO("Map vm%d image 0x%x at 0x%x, size = 0x%x", vm->id,
+        vm_config->load_addr, vm_config->base_addr, vm_config->size);
 
     // 分配虚拟机的内存空间
-    va = mem_alloc_map(&vm->as, NULL, vm_config->base_addr, NUM_PAGES(vm_config->size + vm_config->dmem_size), PTE_VM_FLAGS);
-    if (va != vm_config->base_addr) {
+    va = vm_config->base_addr + nr_image * PAGE_SIZE;
+    if (mem_alloc_map(&vm->as, NULL, va, NUM_PAGES(vm_config->dmem_size), PTE_VM_FLAGS) != va) {
         ERROR("va != vm's base_addr");
     }
-    mem_translate(&vm->as, va, &pa); // 将虚拟地址转换为物理地址
-    memcpy((void*)pa, (void*)vm_config->load_addr, vm_config->size);
-    INFO("Copy vm%d to 0x%x, size = 0x%x", vm->id, pa, vm_config->size);
-        
-    va = mem_alloc_map(&vm->as, NULL,
-                (vaddr_t)config.dtb.base_addr, NUM_PAGES(config.dtb.size), PTE_VM_FLAGS);
-    if (va != config.dtb.base_addr) {
-        ERROR("va != config->vm.base_addr");
-    }
-    mem_translate(&vm->as, va, &pa);
-    memcpy((void*)pa, (void*)config.dtb.load_addr, config.dtb.size);
-    INFO("Copy dtb to 0x%x, size = 0x%x", pa, config.dtb.size);
+
+    vm_map_image(vm, config.dtb.base_addr, config.dtb.load_addr, config.dtb.size);
+    INFO("Map dtb 0x%x at 0x%x, size = 0x%x", config.dtb.load_addr,
+        config.dtb.base_addr, config.dtb.size);
 }
 
 // 初始化虚拟机对象
@@ -72,7 +113,8 @@ void vm_vcpu_init(struct vm* vm, const struct vm_config* vm_config) {
     vcpu_arch_reset(vcpu, vm_config->entry); // 将VCPUs的PC设置为虚拟机的入口地址
 }
 
-static void vm_master_init(struct vm* vm, const struct vm_config* vm_config, vmid_t vm_id) {
+static void vm_master_init(struct vm* vm, struct vm_allocation* vm_alloc,
+                           const struct vm_config* vm_config, vmid_t vm_id) {
     vm->master = cpu()->id;
     vm->nr_cpus = vm_config->nr_cpus;
     vm->id = vm_id;
@@ -80,7 +122,7 @@ static void vm_master_init(struct vm* vm, const struct vm_config* vm_config, vmi
 
     cpu_sync_init(&vm->sync, vm->nr_cpus);
 
-    as_init(&vm->as, AS_VM, vm_id, NULL);
+    as_init(&vm->as, AS_VM, vm_id, vm_alloc->root_pt);
 
     INIT_LIST_HEAD(&vm->emul_mem_list);
     INIT_LIST_HEAD(&vm->emul_reg_list);
@@ -114,11 +156,7 @@ static void vm_init_dev(struct vm* vm, const struct vm_config* config) {
     }
 
     // 初始化共享内存设备
-    if (shared_mem != NULL) {
-        mem_alloc_map_dev(&vm->as, (vaddr_t)shared_mem->va, shared_mem->pa, NUM_PAGES(shared_mem->size));
-    } else {
-        WARNING("No shared memory device");
-    }      
+    shmem_vm_init(vm);
 }
 
 void __print_vm_config(const struct vm_config* config) {
@@ -137,7 +175,7 @@ struct vm* vm_init(struct vm_allocation* vm_alloc, const struct vm_config* vm_co
     struct vm *vm = vm_allocation_init(vm_alloc);
     
     if (master) {
-        vm_master_init(vm, vm_config, vm_id); // 初始化虚拟机的主CPU
+        vm_master_init(vm, vm_alloc, vm_config, vm_id); // 初始化虚拟机的主CPU
     }
 
     vm_cpu_init(vm);
@@ -145,14 +183,21 @@ struct vm* vm_init(struct vm_allocation* vm_alloc, const struct vm_config* vm_co
     vm_vcpu_init(vm, vm_config);
     cpu_sync_barrier(&vm->sync);
     vm_arch_init(vm, vm_config);
+    boot_mark("vm_init: vcpus");
 
     if (master) {
         // __print_vm_config(vm_config);
         vm_init_mem_regions(vm, vm_config);
         INFO("VM[%d] MEM INIT", vm_id);
+        boot_mark("vm_init: memory");
+        vm_swap_init(vm, vm_config);
         vm_init_dev(vm, vm_config);
+        boot_mark("vm_init: devices");
+        virtio_console_init(vm, vm_config);
+        vm_ckpt_init(vm, vm_config);
         // init address space first
         vm_rq_init(vm, vm_config);
+        boot_mark("vm_init: services");
     }
 
 #ifdef SCHEDULE
@@ -210,6 +255,57 @@ __attribute__((weak)) cpumap_t vm_translate_to_vcpu_mask(struct vm* vm,
     return pmask;
 }
 
+// 客户机物理地址转换为宿主物理地址，被换出的页会先换入
+bool vm_ipa_to_pa(struct vm* vm, vaddr_t ipa, paddr_t* pa) {
+    if (mem_walk(&vm->as, ipa, pa)) {
+        return true;
+    }
+    if (vm->swap.enabled && in_range(ipa, vm->swap.base, vm->swap.nr_pages * PAGE_SIZE)) {
+        *pa = vm_swap_page_pa(vm, ipa & ~(PAGE_SIZE - 1)) | (ipa & (PAGE_SIZE - 1));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * 在宿主与客户机内存之间拷贝，按页逐段转换地址，
+ * 因此缓冲区可以跨越物理上不连续的客户机页。
+ */
+bool vm_copy_from_guest(struct vm* vm, void* dst, vaddr_t ipa, size_t len) {
+    size_t n;
+    paddr_t pa;
+
+    while (len > 0) {
+        n = MIN(len, PAGE_SIZE - (ipa & (PAGE_SIZE - 1)));
+        if (!vm_ipa_to_pa(vm, ipa, &pa)) {
+            return false;
+        }
+        memcpy(dst, (void*)pa, n);
+        dst = (char*)dst + n;
+        ipa += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool vm_copy_to_guest(struct vm* vm, vaddr_t ipa, const void* src, size_t len) {
+    size_t n;
+    paddr_t pa;
+
+    while (len > 0) {
+        n = MIN(len, PAGE_SIZE - (ipa & (PAGE_SIZE - 1)));
+        vm_cow_break(vm, ipa);
+        if (!vm_ipa_to_pa(vm, ipa, &pa)) {
+            return false;
+        }
+        memcpy((void*)pa, src, n);
+        src = (const char*)src + n;
+        ipa += n;
+        len -= n;
+    }
+    return true;
+}
+
 void vm_emul_add_mem(struct vm* vm, struct emul_mem* emu) {
     list_add_tail(&emu->list, &vm->emul_mem_list);
 }
@@ -260,4 +356,157 @@ struct vm* get_vm_by_id(vmid_t id) {
         }
     }
     return NULL;
-}
\ No newline at end of file
+}
+
+/**
+ * 若ipa所在页是共享的镜像页，为虚拟机复制一份私有的可写页。
+ * 返回true表示该页现在可写：刚刚完成复制，或已被其他vCPU复制过。
+ */
+bool vm_cow_break(struct vm* vm, vaddr_t ipa) {
+    struct addr_space* as = &vm->as;
+    bool ret = false;
+    size_t lvl;
+    pte_t* pte;
+    void* page;
+
+    spin_lock(&as->lock);
+    pte = mem_leaf_pte(as, ipa, &lvl);
+    if (pte == NULL || lvl != as->pt.dscr->lvls - 1) {
+        goto out;
+    }
+    if (!pte_check_rsw(pte, PTE_RSW_COW)) {
+        ret = (*pte & PTE_AP_MSK) == PTE_S2AP_RW;
+        goto out;
+    }
+
+    page = mem_alloc_page(1, false);
+    if (page == NULL) {
+        ERROR("vm%d out of memory for copy-on-write at 0x%lx", vm->id, ipa);
+    }
+    memcpy(page, (void*)pte_addr(pte), PAGE_SIZE);
+    pte_set(pte, (paddr_t)page, PTE_PAGE, PTE_VM_FLAGS);
+    fence_sync();
+    tlb_inv_va(as, ipa & ~(PAGE_SIZE - 1));
+    ret = true;
+out:
+    spin_unlock(&as->lock);
+    return ret;
+}
+
+// 将ipa处的镜像恢复为与src共享的只读页，释放客户机写入时复制的私有页
+static void vm_reset_image(struct vm* vm, vaddr_t ipa, paddr_t src, size_t size) {
+    struct addr_space* as = &vm->as;
+    size_t nr_shared = size / PAGE_SIZE;
+    size_t lvl;
+    pte_t* pte;
+
+    if (!IS_ALIGNED(src, PAGE_SIZE)) {
+        vm_copy_to_guest(vm, ipa, (void*)src, size);
+        return;
+    }
+
+    spin_lock(&as->lock);
+    for (size_t i = 0; i < nr_shared; i++) {
+        pte = mem_leaf_pte(as, ipa + i * PAGE_SIZE, &lvl);
+        if (pte == NULL || pte_check_rsw(pte, PTE_RSW_COW)) {
+            continue;
+        }
+        mem_free_page((void*)pte_addr(pte), 1);
+        pte_set(pte, src + i * PAGE_SIZE, PTE_PAGE, PTE_VM_COW_FLAGS);
+    }
+    fence_sync();
+    tlb_inv_range(as, ipa, nr_shared * PAGE_SIZE);
+    spin_unlock(&as->lock);
+
+    if (size % PAGE_SIZE) {
+        vm_copy_image_tail(vm, ipa + nr_shared * PAGE_SIZE, src + nr_shared * PAGE_SIZE,
+                           size % PAGE_SIZE);
+    }
+}
+
+// 判断ipa处是否为与avisor中镜像共享的只读页
+static bool vm_page_shared(struct vm* vm, vaddr_t ipa) {
+    struct addr_space* as = &vm->as;
+    bool shared;
+    size_t lvl;
+    pte_t* pte;
+
+    spin_lock(&as->lock);
+    pte = mem_leaf_pte(as, ipa, &lvl);
+    shared = pte != NULL && pte_check_rsw(pte, PTE_RSW_COW);
+    spin_unlock(&as->lock);
+    return shared;
+}
+
+/**
+ * 虚拟机重启时清零镜像与其后的全部内存，以免上次运行的数据残留。
+ * 共享的镜像页属于avisor，跳过；被换出的页换入后再清零。
+ */
+void vm_clear_mem(struct vm* vm) {
+    const struct vm_config* vm_config = vm->vm_config;
+    size_t nr_pages = NUM_PAGES(vm_config->size) + NUM_PAGES(vm_config->dmem_size);
+    vaddr_t ipa;
+    paddr_t pa;
+
+    for (size_t i = 0; i < nr_pages; i++) {
+        ipa = vm_config->base_addr + i * PAGE_SIZE;
+        if (vm_page_shared(vm, ipa)) {
+            continue;
+        }
+        if (!vm_ipa_to_pa(vm, ipa, &pa)) {
+            ERROR("vm%d cannot clear memory at 0x%lx", vm->id, ipa);
+        }
+        memset((void*)pa, 0, PAGE_SIZE);
+    }
+}
+
+// 虚拟机重启时恢复其镜像与设备树
+void vm_reset_images(struct vm* vm) {
+    const struct vm_config* vm_config = vm->vm_config;
+
+    vm_reset_image(vm, vm_config->base_addr, vm_config->load_addr, vm_config->size);
+    vm_reset_image(vm, config.dtb.base_addr, config.dtb.load_addr, config.dtb.size);
+}
+
+// 释放ipa起nr_pages页中虚拟机私有的页，与镜像共享的只读页属于avisor，保持不动
+static void vm_free_pages(struct vm* vm, vaddr_t ipa, size_t nr_pages) {
+    struct addr_space* as = &vm->as;
+    size_t lvl;
+    pte_t* pte;
+
+    for (size_t i = 0; i < nr_pages; i++) {
+        pte = mem_leaf_pte(as, ipa + i * PAGE_SIZE, &lvl);
+        if (pte == NULL || lvl != as->pt.dscr->lvls - 1 || pte_check_rsw(pte, PTE_RSW_COW)) {
+            continue;
+        }
+        mem_free_page((void*)pte_addr(pte), 1);
+    }
+}
+
+/**
+ * 由虚拟机的主CPU在所有vCPU都停止之后调用，回收虚拟机占用的内存、中断与
+ * 定时事件。虚拟机结构本身（vm_allocation）由调用者释放或放回池中。
+ */
+void vm_destroy(struct vm* vm) {
+    const struct vm_config* vm_config = vm->vm_config;
+
+    vm_ckpt_release(vm);
+    vm_swap_release(vm);
+    shmem_vm_release(vm);
+    interrupts_vm_release(vm);
+
+    spin_lock(&vm_list.lock);
+    list_del(&vm->list);
+    spin_unlock(&vm_list.lock);
+
+    vm_free_pages(vm, vm_config->base_addr,
+                  NUM_PAGES(vm_config->size) + NUM_PAGES(vm_config->dmem_size));
+    vm_free_pages(vm, config.dtb.base_addr, NUM_PAGES(config.dtb.size));
+    if (vm->rq.pbase != 0) {
+        vm_free_pages(vm, vm->rq.vbase, NUM_PAGES(vm->rq.rq_size));
+    }
+
+    as_destroy(&vm->as);
+    tlb_inv_all(&vm->as);
+    vm_arch_free(vm);
+}
@@ -8,6 +8,8 @@
 #include "cpu.h"
 #include "io.h"
 #include "interrupts.h"
+#include "boot.h"
+#include "timer.h"
 // #include "rq.h"
 
 static struct vm_assignment {
@@ -16,8 +18,41 @@ static struct vm_assignment {
     size_t ncpus;
     cpumap_t cpus;
     struct vm_allocation vm_alloc;
+    const struct vm_config* vm_config;
+    volatile enum vm_state state;
+    cpumap_t joined;        // 已开始初始化该虚拟机的CPU
+    atomic_t nr_exited;     // 销毁时已经离开的非主vCPU个数
 } vm_assign[MAX_VM_NUM];
 
+/**
+ * 预先分配好的虚拟机：按MAX_VCPU_PER_VM分配的结构体、清零的页表根与vGIC状态。
+ * 运行时创建虚拟机直接取用，被取用后在创建者所在的CPU上通过定时事件补充，
+ * 分配内存不在创建虚拟机的路径上。
+ */
+static struct vmm_pool {
+    spinlock_t lock;
+    size_t nr;
+    struct vm_allocation allocs[VMM_POOL_MAX];
+    struct timer_event refill;
+    atomic_t refill_armed;
+} vmm_pool = { .lock = SPINLOCK_INITVAL };
+
+static spinlock_t vmm_lock = SPINLOCK_INITVAL;  // 保护vmm_idle_cpus与运行时虚拟机ID的分配
+static cpumap_t vmm_idle_cpus;                  // 没有运行虚拟机、可以承载新虚拟机的CPU
+
+enum VMM_EVENTS { VMM_KICK };
+extern volatile const size_t VMM_IPI_ID;
+
+void vmm_ipi_handler(uint32_t event, uint64_t data);
+CPU_MSG_HANDLER(vmm_ipi_handler, VMM_IPI_ID);
+
+// 只用于把目标CPU从客户机或wfi中唤醒，状态变化在vmm_check_vcpu_state中处理
+void vmm_ipi_handler(uint32_t event, uint64_t data) {
+    if (event != VMM_KICK) {
+        WARNING("Unknown vmm event: %u", event);
+    }
+}
+
 static bool vmm_assign_vcpu(bool *master, vmid_t *vm_id) {
     bool assigned = false;
     *master = false;
@@ -27,6 +62,8 @@ static bool vmm_assign_vcpu(bool *master, vmid_t *vm_id) {
         if (vm_assign[i].ncpus < config.vm[i].nr_cpus) {
             if (!vm_assign[i].master) {
                 vm_assign[i].master = true;
+                vm_assign[i].vm_config = &config.vm[i];
+                vm_assign[i].state = VM_STATE_RUNNING;
                 vm_assign[i].ncpus++;
                 *master = true;
                 assigned = true;
@@ -45,7 +82,7 @@ static bool vmm_assign_vcpu(bool *master, vmid_t *vm_id) {
     return assigned;
 }
 
-static bool vmm_alloc_vm(struct vm_allocation* vm_alloc, struct vm_config *config) {
+static bool vmm_alloc_vm(struct vm_allocation* vm_alloc, size_t nr_cpus) {
 
     /**
      * We know that we will allocate a block aligned to the PAGE_SIZE, which
@@ -62,12 +99,12 @@ static bool vmm_alloc_vm(struct vm_allocation* vm_alloc, struct vm_config *confi
 
     size_t total_size = sizeof(struct vm);
     size_t vcpus_offset = ALIGN(total_size, _Alignof(struct vcpu));
-    total_size = vcpus_offset + (config->nr_cpus * sizeof(struct vcpu));
+    total_size = vcpus_offset + (nr_cpus * sizeof(struct vcpu));
     total_size = ALIGN(total_size, PAGE_SIZE);
 
     void* allocation = mem_alloc_page(NUM_PAGES(total_size), false);
     if (allocation == NULL) {
-        ERROR("Failed to allocate memory for VM.");
+        WARNING("Failed to allocate memory for VM.");
         return false;
     }
     memset((void*)allocation, 0, total_size);
@@ -76,6 +113,7 @@ static bool vmm_alloc_vm(struct vm_allocation* vm_alloc, struct vm_config *confi
     vm_alloc->size = total_size;
     vm_alloc->vm = (struct vm*) vm_alloc->base;
     vm_alloc->vcpus = (struct vcpu*) (vm_alloc->base + vcpus_offset);
+    vm_alloc->root_pt = NULL;
 
     INFO("VM memory allocated at %x with size 0x%x", allocation, total_size);
     return true;
@@ -87,7 +125,7 @@ static struct vm_allocation* vmm_alloc_install_vm(vmid_t vm_id, bool master) {
     struct vm_config *vm_config = &config.vm[vm_id];
 
     if (master) {
-        if (!vmm_alloc_vm(vm_alloc, vm_config)) {
+        if (!vmm_alloc_vm(vm_alloc, vm_config->nr_cpus)) {
             ERROR("Failed to allocate vm internal structures");
         }
         fence_ord_write();
@@ -96,6 +134,70 @@ static struct vm_allocation* vmm_alloc_install_vm(vmid_t vm_id, bool master) {
     return vm_alloc;
 }
 
+static void vmm_free_vm(struct vm_allocation* vm_alloc) {
+    mem_free_page((void*)vm_alloc->base, NUM_PAGES(vm_alloc->size));
+    memset(vm_alloc, 0, sizeof(struct vm_allocation));
+}
+
+// 预先分配一个可以容纳任意模板的虚拟机
+static bool vmm_pool_alloc(struct vm_allocation* vm_alloc) {
+    if (!vmm_alloc_vm(vm_alloc, MAX_VCPU_PER_VM)) {
+        return false;
+    }
+
+    vm_alloc->root_pt = as_alloc_root(AS_VM);
+    if (vm_alloc->root_pt == NULL) {
+        vmm_free_vm(vm_alloc);
+        return false;
+    }
+    vm_arch_alloc(vm_alloc->vm);
+
+    return true;
+}
+
+// 补充到配置的大小。同一时刻只有一个CPU在补充，而取用只会减少池中的个数
+static void vmm_pool_fill() {
+    size_t target = MIN(config.hyp.vm_pool_size, VMM_POOL_MAX);
+    struct vm_allocation vm_alloc;
+
+    while (vmm_pool.nr < target && vmm_pool_alloc(&vm_alloc)) {
+        spin_lock(&vmm_pool.lock);
+        vmm_pool.allocs[vmm_pool.nr++] = vm_alloc;
+        spin_unlock(&vmm_pool.lock);
+    }
+}
+
+static bool vmm_pool_get(struct vm_allocation* vm_alloc) {
+    bool found = false;
+
+    spin_lock(&vmm_pool.lock);
+    if (vmm_pool.nr > 0) {
+        *vm_alloc = vmm_pool.allocs[--vmm_pool.nr];
+        found = true;
+    }
+    spin_unlock(&vmm_pool.lock);
+
+    return found;
+}
+
+static void vmm_pool_refill(struct timer_event* ev) {
+    vmm_pool_fill();
+    fence_ord_write();
+    atomic_set(&vmm_pool.refill_armed, 0);
+}
+
+// 在本核上尽快补充虚拟机池，但不在当前的hypercall中进行
+static void vmm_pool_schedule_refill() {
+    if (atomic_cmpxchg(&vmm_pool.refill_armed, 0, 1) != 0) {
+        return;
+    }
+
+    timer_event_init(&vmm_pool.refill, vmm_pool_refill, NULL);
+    if (!timer_event_add(&vmm_pool.refill, 0, 0)) {
+        atomic_set(&vmm_pool.refill_armed, 0);
+    }
+}
+
 void vmm_io_init() {
     io_init();
 }
@@ -107,8 +209,14 @@ void vm_list_init() {
 void vmm_init() { 
     vmm_arch_init(); // 初始化虚拟机管理器的体系结构相关的部分    
     vmm_io_init(); // 初始化虚拟机管理器的IO部分    
+    boot_mark("vmm_arch_init");
+    if (cpu()->id == CPU_MASTER) {
+        vmm_pool_fill(); // 预先分配运行时创建虚拟机所需的结构
+        boot_mark("vm_pool");
+    }
     // ipc_init() // 如果有IPC初始化，需要确保它正确完成
     cpu_sync_barrier(&cpu_glb_sync); // 等待所有CPU都到达这里    
+    boot_mark("vmm_sync");
     vm_list_init(); // 初始化虚拟机列表
     bool master = false; // 是否是主CPU
     vmid_t vm_id = -1;
@@ -117,6 +225,7 @@ void vmm_init() {
         
         struct vm_allocation *vm_alloc = vmm_alloc_install_vm(vm_id, master);
         INFO("vmm_alloc_install_vm completed.");
+        boot_mark("vm_alloc");
         
         struct vm_config *vm_config = &config.vm[vm_id];
         struct vm *vm = vm_init(vm_alloc, vm_config, master, vm_id); // 初始化虚拟机（这个虚拟机是被Avisor管理的）
@@ -124,13 +233,349 @@ void vmm_init() {
         
         cpu_sync_barrier(&vm->sync);
         INFO("VM sync barrier passed for VMID:%d", vm_id);
+        boot_mark("vm_sync");
+        boot_timeline_dump();
 
         vcpu_run(cpu()->vcpu); // 运行虚拟机
         INFO("vcpu_run started for VMID:%d", vm_id);
     } else {
         INFO("No VM assigned to this CPU, entering idle state.");
-        // 如果这个CPU没有分配到虚拟机，那么就让这个CPU空闲
-        cpu_idle();
+        boot_timeline_dump();
+        // 如果这个CPU没有分配到虚拟机，那么就让这个CPU空闲，等待运行时创建的虚拟机
+        vmm_idle();
     }
     INFO("VMM initialization completed.");
 }
+
+#define VM_STATE_BIT(state) (1UL << (state))
+
+static void vmm_kick(cpumap_t cpus) {
+    struct cpu_msg msg = {VMM_IPI_ID, VMM_KICK, 0};
+
+    for (cpuid_t i = 0; i < config.hyp.nr_cpus; i++) {
+        if ((cpus & (1UL << i)) && i != cpu()->id) {
+            cpu_send_msg(i, &msg);
+        }
+    }
+}
+
+// 在没有客户机可运行时等待并处理一个中断（EL2下中断始终是屏蔽的，wfi仍会被唤醒）
+static void vmm_wait_event() {
+    cpu_idle();
+    interrupts_arch_handle();
+}
+
+// 查找分配给本CPU、但本CPU还没有加入的虚拟机
+static bool vmm_find_assigned(vmid_t* vm_id) {
+    cpumap_t me = 1UL << cpu()->id;
+    bool found = false;
+
+    for (vmid_t i = 0; i < MAX_VM_NUM && !found; i++) {
+        spin_lock(&vm_assign[i].lock);
+        if (vm_assign[i].state != VM_STATE_FREE && (vm_assign[i].cpus & me) &&
+            !(vm_assign[i].joined & me)) {
+            *vm_id = i;
+            found = true;
+        }
+        spin_unlock(&vm_assign[i].lock);
+    }
+
+    return found;
+}
+
+// 在空闲CPU上初始化运行时创建的虚拟机，等待VM_START后进入客户机
+static void vmm_boot_vm(vmid_t vm_id) {
+    struct vm_assignment* assign = &vm_assign[vm_id];
+    struct vm* vm;
+    bool master;
+
+    spin_lock(&assign->lock);
+    master = !assign->master;
+    assign->master = true;
+    assign->joined |= (1UL << cpu()->id);
+    spin_unlock(&assign->lock);
+
+    vm = vm_init(&assign->vm_alloc, assign->vm_config, master, vm_id);
+    cpu_sync_barrier(&vm->sync);
+    if (master) {
+        INFO("VM[%d] initialized, waiting for start", vm_id);
+    }
+
+    while (assign->state == VM_STATE_CREATED) {
+        vmm_wait_event();
+    }
+    vmm_check_vcpu_state();
+
+    vcpu_run(cpu()->vcpu);
+}
+
+/**
+ * 没有虚拟机的CPU在这里等待。管理虚拟机创建虚拟机时选中本CPU并发送IPI，
+ * 本CPU随即加入该虚拟机的初始化。不会返回。
+ */
+void vmm_idle() {
+    vmid_t vm_id;
+
+    spin_lock(&vmm_lock);
+    vmm_idle_cpus |= (1UL << cpu()->id);
+    spin_unlock(&vmm_lock);
+
+    while (!vmm_find_assigned(&vm_id)) {
+        vmm_wait_event();
+    }
+
+    vmm_boot_vm(vm_id);
+}
+
+// 由虚拟机的主CPU在所有vCPU离开后调用
+static void vmm_release_vm(vmid_t vm_id) {
+    struct vm_assignment* assign = &vm_assign[vm_id];
+
+    vm_destroy(assign->vm_alloc.vm);
+    vmm_free_vm(&assign->vm_alloc);
+
+    spin_lock(&assign->lock);
+    assign->master = false;
+    assign->ncpus = 0;
+    assign->cpus = 0;
+    assign->joined = 0;
+    assign->vm_config = NULL;
+    atomic_set(&assign->nr_exited, 0);
+    assign->state = VM_STATE_FREE;
+    spin_unlock(&assign->lock);
+
+    INFO("VM[%d] destroyed", vm_id);
+}
+
+/**
+ * vCPU离开正在销毁的虚拟机。非主vCPU离开后不再访问虚拟机，
+ * 主vCPU等它们全部离开后回收虚拟机，之后所有CPU都回到空闲状态。不会返回。
+ */
+static void vmm_vcpu_exit(struct vm* vm) {
+    struct vm_assignment* assign = &vm_assign[vm->id];
+    vmid_t vm_id = vm->id;
+    size_t nr_cpus = vm->nr_cpus;
+    bool master = vm->master == cpu()->id;
+
+    vcpu_arch_release(cpu()->vcpu);
+    cpu()->vcpu = NULL;
+
+    if (!master) {
+        fence_ord_write();
+        atomic_add(1, &assign->nr_exited);
+        vmm_idle();
+    }
+
+    while (atomic_read(&assign->nr_exited) < (int)(nr_cpus - 1));
+    vmm_release_vm(vm_id);
+    vmm_idle();
+}
+
+/**
+ * 每次从客户机退出、返回客户机之前调用（见exception.S）。
+ * 虚拟机被暂停时在此等待，被销毁时不再返回。
+ */
+void vmm_check_vcpu_state() {
+    struct vm* vm = cpu()->vcpu->vm;
+    struct vm_assignment* assign = &vm_assign[vm->id];
+
+    if (assign->state == VM_STATE_RUNNING) {
+        return;
+    }
+
+    while (assign->state == VM_STATE_PAUSED) {
+        vmm_wait_event();
+    }
+    if (assign->state == VM_STATE_DYING) {
+        vmm_vcpu_exit(vm);
+    }
+}
+
+// 生命周期hypercall只允许管理虚拟机调用
+static bool vmm_caller_is_mgmt() {
+    if (!config.hyp.has_mgmt_vm || CURRENT_VM->id != config.hyp.mgmt_vm) {
+        WARNING("vm%d is not the management VM", CURRENT_VM->id);
+        return false;
+    }
+    return true;
+}
+
+static bool vmm_template_valid(unsigned long idx) {
+    const struct vm_config* vm_config;
+
+    if (idx >= config.nr_templates) {
+        WARNING("vmm: no template %d", idx);
+        return false;
+    }
+
+    vm_config = &config.templates[idx];
+    if (vm_config->nr_cpus == 0 || vm_config->nr_cpus > MAX_VCPU_PER_VM) {
+        WARNING("vmm: template %d has %d vcpus", idx, vm_config->nr_cpus);
+        return false;
+    }
+    for (size_t i = 0; i < vm_config->nr_devs; i++) {
+        // 设备加入IOMMU后无法在运行时解除，不允许运行时创建的虚拟机直通设备
+        if (vm_config->devs[i].id != 0) {
+            WARNING("vmm: template %d passes through device %d", idx, vm_config->devs[i].id);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 为新虚拟机预留ID与空闲CPU，预留的CPU在分配好虚拟机结构之后才会加入
+static bool vmm_reserve(size_t nr_cpus, vmid_t* vm_id, cpumap_t* cpus) {
+    bool ok = false;
+    vmid_t id;
+
+    *cpus = 0;
+    spin_lock(&vmm_lock);
+    if (bit_count(vmm_idle_cpus) < nr_cpus) {
+        goto out;
+    }
+
+    for (id = config.nr_vms; id < MAX_VM_NUM; id++) {
+        if (vm_assign[id].state == VM_STATE_FREE) {
+            break;
+        }
+    }
+    if (id >= MAX_VM_NUM) {
+        goto out;
+    }
+
+    for (cpuid_t i = 0; bit_count(*cpus) < nr_cpus; i++) {
+        if (vmm_idle_cpus & (1UL << i)) {
+            *cpus |= (1UL << i);
+        }
+    }
+    vmm_idle_cpus &= ~*cpus;
+
+    spin_lock(&vm_assign[id].lock);
+    vm_assign[id].cpus = 0;
+    vm_assign[id].state = VM_STATE_CREATED;
+    spin_unlock(&vm_assign[id].lock);
+
+    *vm_id = id;
+    ok = true;
+out:
+    spin_unlock(&vmm_lock);
+    return ok;
+}
+
+static void vmm_unreserve(vmid_t vm_id, cpumap_t cpus) {
+    spin_lock(&vmm_lock);
+    vmm_idle_cpus |= cpus;
+    spin_lock(&vm_assign[vm_id].lock);
+    vm_assign[vm_id].state = VM_STATE_FREE;
+    spin_unlock(&vm_assign[vm_id].lock);
+    spin_unlock(&vmm_lock);
+}
+
+void vmm_create_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    // arg0: 模板编号，见config.templates
+    // 返回 x0: 新虚拟机的ID/VMM_ERROR，新虚拟机需要VM_START才开始运行
+    const struct vm_config* vm_config;
+    struct vm_assignment* assign;
+    struct vm_allocation vm_alloc;
+    unsigned long ret = VMM_ERROR;
+    cpumap_t cpus;
+    vmid_t vm_id;
+    bool pooled;
+
+    if (!vmm_caller_is_mgmt() || !vmm_template_valid(arg0)) {
+        goto out;
+    }
+    vm_config = &config.templates[arg0];
+
+    if (!vmm_reserve(vm_config->nr_cpus, &vm_id, &cpus)) {
+        WARNING("vmm: no idle cpus or free vm id for template %d", arg0);
+        goto out;
+    }
+    assign = &vm_assign[vm_id];
+
+    pooled = vmm_pool_get(&vm_alloc);
+    if (!pooled && !vmm_alloc_vm(&vm_alloc, vm_config->nr_cpus)) {
+        vmm_unreserve(vm_id, cpus);
+        goto out;
+    }
+
+    spin_lock(&assign->lock);
+    assign->vm_alloc = vm_alloc;
+    assign->vm_config = vm_config;
+    assign->master = false;
+    assign->ncpus = vm_config->nr_cpus;
+    assign->joined = 0;
+    atomic_set(&assign->nr_exited, 0);
+    assign->cpus = cpus;
+    spin_unlock(&assign->lock);
+
+    vmm_kick(cpus);
+    if (pooled) {
+        vmm_pool_schedule_refill();
+    }
+
+    INFO("VM[%d] created from template %d on cpus 0x%x (%s)", vm_id, arg0, cpus,
+        pooled ? "pooled" : "allocated");
+    ret = vm_id;
+out:
+    vcpu_writereg(cpu()->vcpu, 0, ret);
+}
+
+// 将虚拟机从from中的某个状态切换到to，并唤醒其CPU，使其在退出路径上看到新状态
+static void vmm_set_state(vmid_t vm_id, unsigned long from, enum vm_state to) {
+    struct vm_assignment* assign;
+    unsigned long ret = VMM_ERROR;
+    cpumap_t cpus = 0;
+
+    if (!vmm_caller_is_mgmt()) {
+        goto out;
+    }
+    if (vm_id >= MAX_VM_NUM || vm_id == CURRENT_VM->id) {
+        WARNING("vmm: invalid target vm%d", vm_id);
+        goto out;
+    }
+
+    assign = &vm_assign[vm_id];
+    spin_lock(&assign->lock);
+    // 静态虚拟机的CPU在启动时由vmm_assign_vcpu记录，运行时创建的在vmm_create_handler中记录；
+    // CPU尚未全部记录时无法唤醒它们，拒绝切换
+    if (assign->vm_config == NULL || assign->cpus == 0 ||
+        bit_count(assign->cpus) < assign->vm_config->nr_cpus) {
+        spin_unlock(&assign->lock);
+        WARNING("vmm: vm%d has no cpus assigned", vm_id);
+        goto out;
+    }
+    if (from & VM_STATE_BIT(assign->state)) {
+        assign->state = to;
+        cpus = assign->cpus;
+        ret = VMM_SUCCESS;
+    }
+    spin_unlock(&assign->lock);
+
+    if (ret != VMM_SUCCESS) {
+        WARNING("vmm: vm%d cannot change from state %d to %d", vm_id, assign->state, to);
+        goto out;
+    }
+    vmm_kick(cpus);
+    INFO("vmm: vm%d state -> %d", vm_id, to);
+out:
+    vcpu_writereg(cpu()->vcpu, 0, ret);
+}
+
+// 以下hypercall的 arg0: 虚拟机ID，返回 x0: VMM_SUCCESS/VMM_ERROR
+void vmm_start_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    vmm_set_state(arg0, VM_STATE_BIT(VM_STATE_CREATED), VM_STATE_RUNNING);
+}
+
+void vmm_pause_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    vmm_set_state(arg0, VM_STATE_BIT(VM_STATE_RUNNING), VM_STATE_PAUSED);
+}
+
+void vmm_resume_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    vmm_set_state(arg0, VM_STATE_BIT(VM_STATE_PAUSED), VM_STATE_RUNNING);
+}
+
+void vmm_destroy_handler(unsigned long iss, unsigned long arg0, unsigned long arg1, unsigned long arg2) {
+    vmm_set_state(arg0, VM_STATE_BIT(VM_STATE_CREATED) | VM_STATE_BIT(VM_STATE_RUNNING) |
+                  VM_STATE_BIT(VM_STATE_PAUSED), VM_STATE_DYING);
+}
@@ -0,0 +1,115 @@
+#include "crc32c.h"
+#include "sysregs.h"
+#include "spinlock.h"
+
+#define CRC32C_POLY     (0x82F63B78U)   // Castagnoli多项式（反射形式）
+
+#define ID_AA64ISAR0_CRC32_OFF  16
+#define ID_AA64ISAR0_CRC32_LEN  4
+
+static bool crc32c_hw = false;
+static bool crc32c_ready = false;
+static spinlock_t crc32c_lock = SPINLOCK_INITVAL;
+
+/**
+ * CRC32指令在Armv8.0中是可选的（Armv8.1起为必选），因此在初始化时
+ * 读取ID_AA64ISAR0_EL1检测一次，不支持时退回逐位计算的软件实现。
+ * 快照池和每个启用自动快照的虚拟机都会调用，只有第一次调用生效。
+ */
+void crc32c_init() {
+    spin_lock(&crc32c_lock);
+    if (!crc32c_ready) {
+        crc32c_hw = bit64_extract(sysreg_id_aa64isar0_el1_read(),
+                        ID_AA64ISAR0_CRC32_OFF, ID_AA64ISAR0_CRC32_LEN) != 0;
+        crc32c_ready = true;
+        INFO("CRC32C: %s", crc32c_hw ? "hardware" : "software");
+    }
+    spin_unlock(&crc32c_lock);
+}
+
+static inline uint32_t crc32c_u8_hw(uint32_t crc, uint8_t val) {
+    asm volatile("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(val));
+    return crc;
+}
+
+static inline uint32_t crc32c_u64_hw(uint32_t crc, uint64_t val) {
+    asm volatile("crc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(val));
+    return crc;
+}
+
+static inline uint32_t crc32c_u8_sw(uint32_t crc, uint8_t val) {
+    crc ^= val;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+    }
+    return crc;
+}
+
+static inline uint32_t crc32c_u64_sw(uint32_t crc, uint64_t val) {
+    for (int i = 0; i < 8; i++) {
+        crc = crc32c_u8_sw(crc, (uint8_t)(val >> (i * 8)));
+    }
+    return crc;
+}
+
+/**
+ * 校验循环按硬件/软件实现各生成一份，每次调用只判断一次crc32c_hw，
+ * 而不是在每个字上判断。
+ */
+#define CRC32C_DEFINE(impl)                                                     \
+static uint32_t crc32c_buf_##impl(uint32_t crc, const void* buf, size_t len) {  \
+    const uint8_t* p = buf;                                                     \
+                                                                                \
+    while (len > 0 && ((uintptr_t)p & (sizeof(uint64_t) - 1))) {                \
+        crc = crc32c_u8_##impl(crc, *p++);                                      \
+        len--;                                                                  \
+    }                                                                           \
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {                  \
+        crc = crc32c_u64_##impl(crc, *(const uint64_t*)p);                      \
+        p += sizeof(uint64_t);                                                  \
+    }                                                                           \
+    while (len--) {                                                             \
+        crc = crc32c_u8_##impl(crc, *p++);                                      \
+    }                                                                           \
+                                                                                \
+    return crc;                                                                 \
+}                                                                               \
+                                                                                \
+static uint32_t crc32c_copy_##impl(void* dst, const void* src, size_t len,      \
+                                   uint32_t crc) {                              \
+    uint8_t* d = dst;                                                           \
+    const uint8_t* s = src;                                                     \
+    uint64_t val;                                                               \
+                                                                                \
+    if (!(((uintptr_t)d | (uintptr_t)s) & (sizeof(uint64_t) - 1))) {            \
+        for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {              \
+            val = *(const uint64_t*)s;                                          \
+            *(uint64_t*)d = val;                                                \
+            crc = crc32c_u64_##impl(crc, val);                                  \
+            d += sizeof(uint64_t);                                              \
+            s += sizeof(uint64_t);                                              \
+        }                                                                       \
+    }                                                                           \
+    while (len--) {                                                             \
+        *d = *s++;                                                              \
+        crc = crc32c_u8_##impl(crc, *d++);                                      \
+    }                                                                           \
+                                                                                \
+    return crc;                                                                 \
+}
+
+CRC32C_DEFINE(hw)
+CRC32C_DEFINE(sw)
+
+uint32_t crc32c(uint32_t crc, const void* buf, size_t len) {
+    return crc32c_hw ? crc32c_buf_hw(crc, buf, len) : crc32c_buf_sw(crc, buf, len);
+}
+
+/**
+ * 从src拷贝len字节到dst，并在同一趟中返回数据的CRC32C，
+ * 数据只经过一次内存，计算一页的校验和无需额外的内存访问。
+ */
+uint32_t crc32c_copy(void* dst, const void* src, size_t len, uint32_t crc) {
+    return crc32c_hw ? crc32c_copy_hw(dst, src, len, crc) :
+                       crc32c_copy_sw(dst, src, len, crc);
+}
@@ -0,0 +1,12 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include "util.h"
+
+#define CRC32C_INIT     (0xFFFFFFFFU)
+
+void crc32c_init();
+uint32_t crc32c(uint32_t crc, const void* buf, size_t len);
+uint32_t crc32c_copy(void* dst, const void* src, size_t len, uint32_t crc);
+
+#endif
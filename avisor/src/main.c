@@ -3,18 +3,25 @@
 #include "vm.h"
 #include "cpu.h"
 #include "interrupts.h"
+#include "boot.h"
 
 int main(cpuid_t id)
 {
     cpu_init(id);
+    boot_mark("cpu_init");
     if (id == CPU_MASTER) {
         INFO("------------avisor started------------");
         INFO("Exception level: %d", sysreg_CurrentEL_read() >> 2);
         mem_init();
+        boot_mark("mem_init");
+#ifdef MEM_BENCH
+        mem_bench();
+#endif
     }
 
     cpu_sync_barrier(&cpu_glb_sync);
     interrupts_init();
+    boot_mark("interrupts_init");
     vmm_init(); // 这一步才是正式加载虚拟机
     
     INFO("VMM initialized");
@@ -0,0 +1,329 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/* Packet generator that measures the transmit rate of the first network
+ * device with uk_netdev_tx_burst() for burst sizes from 1 to 64.
+ * With CONFIG_APPPKTGEN_TSO, it sends TCP segments of up to 64 KiB that the
+ * device splits into MSS-sized frames (TSO) and reports the TCP payload
+ * throughput instead.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <uk/alloc.h>
+#include <uk/netdev.h>
+#include <uk/netbuf.h>
+#include <uk/plat/time.h>
+
+#define PKTGEN_BURST_MAX	64
+#define PKTGEN_ETHERTYPE	0x88b5 /* local experimental */
+#define PKTGEN_BUF_LEN		2048
+#define PKTGEN_POOL_LEN		2048 /* netbufs, covers both rings */
+
+#if CONFIG_APPPKTGEN_TSO
+#define PKTGEN_ETHERTYPE_IPV4	0x0800
+#define PKTGEN_IPV4_HDR_LEN	20
+#define PKTGEN_TCP_HDR_LEN	20
+#define PKTGEN_HDRS_LEN		(UK_ETH_HDR_UNTAGGED_LEN		\
+				 + PKTGEN_IPV4_HDR_LEN + PKTGEN_TCP_HDR_LEN)
+/* As many full segments as fit into the 16-bit IP length */
+#define PKTGEN_TSO_SEGS		((__U16_MAX - PKTGEN_IPV4_HDR_LEN	\
+				  - PKTGEN_TCP_HDR_LEN)			\
+				 / CONFIG_APPPKTGEN_TSO_MSS)
+#define PKTGEN_TSO_PAYLOAD_LEN	(PKTGEN_TSO_SEGS * CONFIG_APPPKTGEN_TSO_MSS)
+
+/* The payload is shared by all packets, only the headers are per packet */
+static __u8 tso_payload[PKTGEN_TSO_PAYLOAD_LEN] __align(__PAGE_SIZE);
+static __u32 tso_seq;
+#endif /* CONFIG_APPPKTGEN_TSO */
+
+static struct uk_alloc *a;
+static struct uk_netdev_info info;
+static struct uk_hwaddr src_addr;
+/* Receive buffers and frames are taken from a single pool cache */
+static struct uk_netbuf_cache *cache;
+
+static struct uk_netbuf *pktgen_alloc(size_t len)
+{
+	struct uk_netbuf *nb;
+
+	nb = uk_netbuf_cache_take(cache);
+	if (!nb)
+		return NULL;
+	nb->len = len;
+	return nb;
+}
+
+#if CONFIG_APPPKTGEN_TSO
+static inline void pktgen_put16(__u8 *p, __u16 v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+static inline void pktgen_put32(__u8 *p, __u32 v)
+{
+	pktgen_put16(p, v >> 16);
+	pktgen_put16(p + 2, v & 0xffff);
+}
+
+static __u32 pktgen_csum_add(__u32 sum, const __u8 *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += ((__u32) p[i] << 8) | p[i + 1];
+	if (len & 1)
+		sum += (__u32) p[len - 1] << 8;
+	return sum;
+}
+
+static __u16 pktgen_csum_fold(__u32 sum)
+{
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return sum;
+}
+
+/* TCP/IPv4 segment from 192.0.2.2:5001 to the discard port of 192.0.2.1 */
+static struct uk_netbuf *pktgen_frame(void)
+{
+	static const __u8 saddr[4] = { 192, 0, 2, 2 };
+	static const __u8 daddr[4] = { 192, 0, 2, 1 };
+	const __u16 tcp_len = PKTGEN_TCP_HDR_LEN + PKTGEN_TSO_PAYLOAD_LEN;
+	struct uk_netbuf *nb, *payload;
+	__u8 *frame, *ip, *tcp;
+	__u32 sum;
+
+	nb = pktgen_alloc(PKTGEN_HDRS_LEN);
+	if (!nb)
+		return NULL;
+	payload = uk_netbuf_alloc_indir(a, tso_payload, sizeof(tso_payload),
+					0, 0, NULL);
+	if (!payload) {
+		uk_netbuf_free(nb);
+		return NULL;
+	}
+	payload->len = sizeof(tso_payload);
+
+	frame = nb->data;
+	memset(frame, 0xff, UK_ETH_ADDR_LEN);
+	memcpy(frame + UK_ETH_ADDR_LEN, src_addr.addr_bytes, UK_ETH_ADDR_LEN);
+	pktgen_put16(frame + 2 * UK_ETH_ADDR_LEN, PKTGEN_ETHERTYPE_IPV4);
+
+	ip = frame + UK_ETH_HDR_UNTAGGED_LEN;
+	memset(ip, 0, PKTGEN_IPV4_HDR_LEN);
+	ip[0] = 0x45;
+	pktgen_put16(ip + 2, PKTGEN_IPV4_HDR_LEN + tcp_len);
+	pktgen_put16(ip + 6, 0x4000); /* don't fragment */
+	ip[8] = 64;
+	ip[9] = 6; /* TCP */
+	memcpy(ip + 12, saddr, sizeof(saddr));
+	memcpy(ip + 16, daddr, sizeof(daddr));
+	pktgen_put16(ip + 10, ~pktgen_csum_fold(
+			     pktgen_csum_add(0, ip, PKTGEN_IPV4_HDR_LEN)));
+
+	tcp = ip + PKTGEN_IPV4_HDR_LEN;
+	memset(tcp, 0, PKTGEN_TCP_HDR_LEN);
+	pktgen_put16(tcp, 5001);
+	pktgen_put16(tcp + 2, 9);
+	pktgen_put32(tcp + 4, tso_seq);
+	tcp[12] = (PKTGEN_TCP_HDR_LEN / 4) << 4;
+	tcp[13] = 0x18; /* PSH, ACK */
+	pktgen_put16(tcp + 14, 0xffff);
+	tso_seq += PKTGEN_TSO_PAYLOAD_LEN;
+
+	/* The device completes the checksum from the pseudo header on */
+	sum = pktgen_csum_add(0, ip + 12, 8);
+	sum += 6 + tcp_len;
+	pktgen_put16(tcp + 16, pktgen_csum_fold(sum));
+	nb->flags = UK_NETBUF_F_PARTIAL_CSUM | UK_NETBUF_F_GSO;
+	nb->csum_start = UK_ETH_HDR_UNTAGGED_LEN + PKTGEN_IPV4_HDR_LEN;
+	nb->csum_offset = 16;
+	nb->gso_type = UK_NETBUF_GSO_TCPV4;
+	nb->gso_size = CONFIG_APPPKTGEN_TSO_MSS;
+
+	uk_netbuf_append(nb, payload);
+	return nb;
+}
+#else /* !CONFIG_APPPKTGEN_TSO */
+
+static struct uk_netbuf *pktgen_frame(void)
+{
+	struct uk_netbuf *nb;
+	__u8 *frame;
+
+	nb = pktgen_alloc(CONFIG_APPPKTGEN_PKT_SIZE);
+	if (!nb)
+		return NULL;
+
+	frame = nb->data;
+	memset(frame, 0xff, UK_ETH_ADDR_LEN);
+	memcpy(frame + UK_ETH_ADDR_LEN, src_addr.addr_bytes, UK_ETH_ADDR_LEN);
+	frame[2 * UK_ETH_ADDR_LEN]     = PKTGEN_ETHERTYPE >> 8;
+	frame[2 * UK_ETH_ADDR_LEN + 1] = PKTGEN_ETHERTYPE & 0xff;
+	memset(frame + UK_ETH_HDR_UNTAGGED_LEN, 0,
+	       CONFIG_APPPKTGEN_PKT_SIZE - UK_ETH_HDR_UNTAGGED_LEN);
+	return nb;
+}
+#endif /* !CONFIG_APPPKTGEN_TSO */
+
+static void pktgen_drain_rx(struct uk_netdev *dev)
+{
+	struct uk_netbuf *pkts[PKTGEN_BURST_MAX];
+	uint16_t cnt, i;
+	int rc;
+
+	do {
+		cnt = PKTGEN_BURST_MAX;
+		rc = uk_netdev_rx_burst(dev, 0, pkts, &cnt);
+		for (i = 0; i < cnt; i++)
+			uk_netbuf_free(pkts[i]);
+	} while (uk_netdev_status_more(rc));
+}
+
+static int pktgen_run(struct uk_netdev *dev, uint16_t burst)
+{
+	struct uk_netbuf *pkts[PKTGEN_BURST_MAX];
+	__nsec start, duration, now;
+	__u64 sent = 0, us;
+	uint16_t nb, cnt, i;
+	int rc;
+
+	duration = ukarch_time_msec_to_nsec(CONFIG_APPPKTGEN_DURATION_MS);
+	start = ukplat_monotonic_clock();
+	do {
+		for (nb = 0; nb < burst; nb++) {
+			pkts[nb] = pktgen_frame();
+			if (!pkts[nb])
+				break;
+		}
+
+		cnt = nb;
+		rc = uk_netdev_tx_burst(dev, 0, pkts, &cnt);
+		if (rc < 0) {
+			fprintf(stderr, "Failed to send: %d\n", rc);
+			for (i = 0; i < nb; i++)
+				uk_netbuf_free(pkts[i]);
+			return rc;
+		}
+		sent += cnt;
+
+		/* Packets that did not fit on the queue are dropped */
+		for (i = cnt; i < nb; i++)
+			uk_netbuf_free(pkts[i]);
+
+		pktgen_drain_rx(dev);
+		now = ukplat_monotonic_clock();
+	} while (now - start < duration);
+
+	us = (now - start) / 1000;
+#if CONFIG_APPPKTGEN_TSO
+	printf("burst %2u: %10llu segs in %6llu us: %llu Mbit/s TCP payload\n",
+	       burst, (unsigned long long) sent, (unsigned long long) us,
+	       (unsigned long long) (sent * PKTGEN_TSO_PAYLOAD_LEN * 8 / us));
+#else /* !CONFIG_APPPKTGEN_TSO */
+	printf("burst %2u: %10llu pkts in %6llu us: %llu.%03llu Mpps\n",
+	       burst, (unsigned long long) sent, (unsigned long long) us,
+	       (unsigned long long) (sent / us),
+	       (unsigned long long) ((sent * 1000 / us) % 1000));
+#endif /* !CONFIG_APPPKTGEN_TSO */
+	return 0;
+}
+
+static int pktgen_setup(struct uk_netdev *dev)
+{
+	struct uk_netdev_conf conf = {
+		.nb_rx_queues = 1,
+		.nb_tx_queues = 1,
+	};
+	struct uk_netdev_rxqueue_conf rxq_conf = {
+		.a = a,
+		.alloc_rxpkts = uk_netbuf_cache_alloc_rxpkts,
+	};
+	struct uk_netdev_txqueue_conf txq_conf = {
+		.a = a,
+	};
+	const struct uk_hwaddr *hwaddr;
+	struct uk_netbuf_pool *pool;
+	int rc;
+
+	rc = uk_netdev_probe(dev);
+	if (rc < 0)
+		return rc;
+
+	uk_netdev_info_get(dev, &info);
+#if CONFIG_APPPKTGEN_TSO
+	if (!uk_netdev_tso4_supported(info.features)) {
+		fprintf(stderr, "Device does not support TSO\n");
+		return -ENOTSUP;
+	}
+#endif /* CONFIG_APPPKTGEN_TSO */
+	pool = uk_netbuf_pool_alloc(a, PKTGEN_POOL_LEN, PKTGEN_BUF_LEN,
+				    info.ioalign,
+				    MAX(info.nb_encap_rx, info.nb_encap_tx),
+				    0, 1, NULL);
+	if (!pool)
+		return -ENOMEM;
+	cache = uk_netbuf_pool_cache_get(pool, 0);
+	rxq_conf.alloc_rxpkts_argp = cache;
+
+	rc = uk_netdev_configure(dev, &conf);
+	if (rc < 0)
+		return rc;
+	rc = uk_netdev_rxq_configure(dev, 0, 0, &rxq_conf);
+	if (rc < 0)
+		return rc;
+	rc = uk_netdev_txq_configure(dev, 0, 0, &txq_conf);
+	if (rc < 0)
+		return rc;
+	rc = uk_netdev_start(dev);
+	if (rc < 0)
+		return rc;
+
+	hwaddr = uk_netdev_hwaddr_get(dev);
+	if (hwaddr)
+		src_addr = *hwaddr;
+	return 0;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	struct uk_netdev *dev;
+	uint16_t burst;
+	int rc;
+
+	a = uk_alloc_get_default();
+	dev = uk_netdev_get(0);
+	if (!dev) {
+		fprintf(stderr, "No network device found\n");
+		return -ENODEV;
+	}
+
+	rc = pktgen_setup(dev);
+	if (rc < 0) {
+		fprintf(stderr, "Failed to set up netdev%u: %d\n",
+			uk_netdev_id_get(dev), rc);
+		return rc;
+	}
+
+#if CONFIG_APPPKTGEN_TSO
+	printf("Sending %d byte TCP segments with MSS %d on netdev%u (%s)\n",
+	       PKTGEN_TSO_PAYLOAD_LEN, CONFIG_APPPKTGEN_TSO_MSS,
+	       uk_netdev_id_get(dev), uk_netdev_drv_name_get(dev));
+#else /* !CONFIG_APPPKTGEN_TSO */
+	printf("Sending %d byte frames on netdev%u (%s)\n",
+	       CONFIG_APPPKTGEN_PKT_SIZE, uk_netdev_id_get(dev),
+	       uk_netdev_drv_name_get(dev));
+#endif /* !CONFIG_APPPKTGEN_TSO */
+	for (burst = 1; burst <= PKTGEN_BURST_MAX; burst *= 2) {
+		rc = pktgen_run(dev, burst);
+		if (rc < 0)
+			return rc;
+	}
+	return 0;
+}
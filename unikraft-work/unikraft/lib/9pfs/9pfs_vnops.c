@@ -43,6 +43,7 @@
 #include <vfscore/vnode.h>
 #include <vfscore/file.h>
 #include <vfscore/fs.h>
+#include <vfscore/pagecache.h>
 
 #include "9pfs.h"
 
@@ -970,7 +971,11 @@ static int uk_9pfs_symlink(struct vnode *dvp, char *op, char *np)
 
 #define uk_9pfs_seek		((vnop_seek_t)vfscore_vop_nullop)
 #define uk_9pfs_ioctl		((vnop_ioctl_t)vfscore_vop_einval)
+#ifdef CONFIG_LIB9PFS_PAGECACHE
+#define uk_9pfs_cache		vfscore_pagecache_vop
+#else /* !CONFIG_LIB9PFS_PAGECACHE */
 #define uk_9pfs_cache		((vnop_cache_t)NULL)
+#endif /* !CONFIG_LIB9PFS_PAGECACHE */
 #define uk_9pfs_fallocate	((vnop_fallocate_t)vfscore_vop_nullop)
 #define uk_9pfs_poll		((vnop_poll_t)vfscore_vop_einval)
 
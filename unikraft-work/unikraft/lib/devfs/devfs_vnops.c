@@ -279,6 +279,7 @@ struct vnops devfs_vnops = {
 	devfs_readlink,		/* read link */
 	devfs_symlink,		/* symbolic link */
 	devfs_poll,		/* poll */
+	(vnop_aread_t) NULL,	/* asynchronous read */
 };
 
 /*
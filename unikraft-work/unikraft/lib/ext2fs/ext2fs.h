@@ -0,0 +1,325 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UK_EXT2FS__
+#define __UK_EXT2FS__
+
+#include <uk/arch/types.h>
+#include <uk/blkdev.h>
+#include <uk/essentials.h>
+#include <uk/list.h>
+#include <uk/mutex.h>
+#include <uk/semaphore.h>
+
+#include <vfscore/prex.h>
+#include <vfscore/vnode.h>
+
+/*
+ * On-disk format. All fields are little-endian, which matches every
+ * architecture Unikraft currently supports, so they are used as-is.
+ */
+#define EXT2_SUPER_OFFSET	1024
+#define EXT2_SUPER_MAGIC	0xEF53
+#define EXT2_ROOT_INO		2
+#define EXT2_GOOD_OLD_REV	0
+#define EXT2_GOOD_OLD_INODE_SIZE 128
+#define EXT2_MIN_BLOCK_LOG_SIZE	10
+#define EXT2_MAX_BLOCK_LOG_SIZE	16
+#define EXT2_DESC_SIZE		32
+#define EXT2_NDIR_BLOCKS	12
+#define EXT2_IND_BLOCK		12
+#define EXT2_DIND_BLOCK		13
+#define EXT2_TIND_BLOCK		14
+#define EXT2_N_BLOCKS		15
+
+#define EXT2_FEATURE_INCOMPAT_FILETYPE		0x0002
+#define EXT3_FEATURE_INCOMPAT_RECOVER		0x0004
+#define EXT4_FEATURE_INCOMPAT_EXTENTS		0x0040
+#define EXT4_FEATURE_INCOMPAT_64BIT		0x0080
+#define EXT4_FEATURE_INCOMPAT_MMP		0x0100
+#define EXT4_FEATURE_INCOMPAT_FLEX_BG		0x0200
+#define EXT4_FEATURE_INCOMPAT_EA_INODE		0x0400
+#define EXT4_FEATURE_INCOMPAT_CSUM_SEED		0x2000
+#define EXT4_FEATURE_INCOMPAT_LARGEDIR		0x4000
+
+/* Incompatible features this driver can read */
+#define EXT2FS_FEATURE_INCOMPAT_SUPP		\
+	(EXT2_FEATURE_INCOMPAT_FILETYPE		\
+	 | EXT4_FEATURE_INCOMPAT_EXTENTS	\
+	 | EXT4_FEATURE_INCOMPAT_64BIT		\
+	 | EXT4_FEATURE_INCOMPAT_MMP		\
+	 | EXT4_FEATURE_INCOMPAT_FLEX_BG	\
+	 | EXT4_FEATURE_INCOMPAT_EA_INODE	\
+	 | EXT4_FEATURE_INCOMPAT_CSUM_SEED	\
+	 | EXT4_FEATURE_INCOMPAT_LARGEDIR)
+
+#define EXT4_HUGE_FILE_FL	0x00040000
+#define EXT4_EXTENTS_FL		0x00080000
+#define EXT4_INLINE_DATA_FL	0x10000000
+
+struct ext2_super_block {
+	__u32	s_inodes_count;
+	__u32	s_blocks_count_lo;
+	__u32	s_r_blocks_count_lo;
+	__u32	s_free_blocks_count_lo;
+	__u32	s_free_inodes_count;
+	__u32	s_first_data_block;
+	__u32	s_log_block_size;
+	__u32	s_log_cluster_size;
+	__u32	s_blocks_per_group;
+	__u32	s_clusters_per_group;
+	__u32	s_inodes_per_group;
+	__u32	s_mtime;
+	__u32	s_wtime;
+	__u16	s_mnt_count;
+	__s16	s_max_mnt_count;
+	__u16	s_magic;
+	__u16	s_state;
+	__u16	s_errors;
+	__u16	s_minor_rev_level;
+	__u32	s_lastcheck;
+	__u32	s_checkinterval;
+	__u32	s_creator_os;
+	__u32	s_rev_level;
+	__u16	s_def_resuid;
+	__u16	s_def_resgid;
+	/* EXT2_DYNAMIC_REV */
+	__u32	s_first_ino;
+	__u16	s_inode_size;
+	__u16	s_block_group_nr;
+	__u32	s_feature_compat;
+	__u32	s_feature_incompat;
+	__u32	s_feature_ro_compat;
+	__u8	s_uuid[16];
+	char	s_volume_name[16];
+	char	s_last_mounted[64];
+	__u32	s_algorithm_usage_bitmap;
+	__u8	s_prealloc_blocks;
+	__u8	s_prealloc_dir_blocks;
+	__u16	s_reserved_gdt_blocks;
+	__u8	s_journal_uuid[16];
+	__u32	s_journal_inum;
+	__u32	s_journal_dev;
+	__u32	s_last_orphan;
+	__u32	s_hash_seed[4];
+	__u8	s_def_hash_version;
+	__u8	s_jnl_backup_type;
+	__u16	s_desc_size;
+	__u32	s_default_mount_opts;
+	__u32	s_first_meta_bg;
+	__u32	s_mkfs_time;
+	__u32	s_jnl_blocks[17];
+	/* EXT4_FEATURE_INCOMPAT_64BIT */
+	__u32	s_blocks_count_hi;
+	__u32	s_r_blocks_count_hi;
+	__u32	s_free_blocks_count_hi;
+} __packed;
+
+struct ext2_group_desc {
+	__u32	bg_block_bitmap_lo;
+	__u32	bg_inode_bitmap_lo;
+	__u32	bg_inode_table_lo;
+	__u16	bg_free_blocks_count_lo;
+	__u16	bg_free_inodes_count_lo;
+	__u16	bg_used_dirs_count_lo;
+	__u16	bg_flags;
+	__u32	bg_exclude_bitmap_lo;
+	__u16	bg_block_bitmap_csum_lo;
+	__u16	bg_inode_bitmap_csum_lo;
+	__u16	bg_itable_unused_lo;
+	__u16	bg_checksum;
+	/* EXT4_FEATURE_INCOMPAT_64BIT, if s_desc_size >= 64 */
+	__u32	bg_block_bitmap_hi;
+	__u32	bg_inode_bitmap_hi;
+	__u32	bg_inode_table_hi;
+} __packed;
+
+struct ext2_inode {
+	__u16	i_mode;
+	__u16	i_uid;
+	__u32	i_size_lo;
+	__u32	i_atime;
+	__u32	i_ctime;
+	__u32	i_mtime;
+	__u32	i_dtime;
+	__u16	i_gid;
+	__u16	i_links_count;
+	__u32	i_blocks_lo;
+	__u32	i_flags;
+	__u32	i_osd1;
+	__u32	i_block[EXT2_N_BLOCKS];
+	__u32	i_generation;
+	__u32	i_file_acl_lo;
+	__u32	i_size_high;
+	__u32	i_faddr;
+	__u16	i_blocks_high;
+	__u16	i_file_acl_high;
+	__u16	i_uid_high;
+	__u16	i_gid_high;
+	__u16	i_checksum_lo;
+	__u16	i_reserved;
+} __packed;
+
+struct ext2_dir_entry {
+	__u32	inode;
+	__u16	rec_len;
+	__u8	name_len;
+	__u8	file_type;	/* name_len high byte without FILETYPE */
+	char	name[];
+} __packed;
+
+#define EXT2_DIR_ENTRY_HDR	8
+
+#define EXT2_FT_UNKNOWN		0
+#define EXT2_FT_REG_FILE	1
+#define EXT2_FT_DIR		2
+#define EXT2_FT_CHRDEV		3
+#define EXT2_FT_BLKDEV		4
+#define EXT2_FT_FIFO		5
+#define EXT2_FT_SOCK		6
+#define EXT2_FT_SYMLINK		7
+
+#define EXT4_EXT_MAGIC		0xF30A
+/* Extents longer than this are preallocated, but unwritten */
+#define EXT4_EXT_INIT_MAX_LEN	32768
+
+struct ext4_extent_header {
+	__u16	eh_magic;
+	__u16	eh_entries;
+	__u16	eh_max;
+	__u16	eh_depth;
+	__u32	eh_generation;
+} __packed;
+
+struct ext4_extent_idx {
+	__u32	ei_block;
+	__u32	ei_leaf_lo;
+	__u16	ei_leaf_hi;
+	__u16	ei_unused;
+} __packed;
+
+struct ext4_extent {
+	__u32	ee_block;
+	__u16	ee_len;
+	__u16	ee_start_hi;
+	__u32	ee_start_lo;
+} __packed;
+
+/*
+ * Block cache. Buffers hold one file system block each and are recycled
+ * in LRU order. A buffer returned by ext2fs_bread() stays valid until the
+ * next call to ext2fs_bread() on the same mount.
+ */
+struct ext2fs_buf {
+	struct uk_hlist_node	hash_link;
+	struct uk_list_head	lru_link;
+	__u64			blk;
+	void			*data;
+};
+
+/*
+ * Asynchronous file read, see ext2fs_aread(). `pending` counts the
+ * requests in flight plus one held by the submitter, so that the read
+ * completes only after all its requests were submitted.
+ */
+#define EXT2FS_AIO_REQS		16
+
+struct ext2fs_aio {
+	struct ext2fs_aio	*next;
+	struct ext2fs_mount_data *md;
+	struct vfscore_aio	*aio;
+	long			bytes;
+	int			error;
+	unsigned int		pending;
+	unsigned int		nb_reqs;
+	struct uk_blkreq	reqs[EXT2FS_AIO_REQS];
+};
+
+struct ext2fs_mount_data {
+	struct uk_blkdev	*dev;
+	/* Serializes all I/O and block cache accesses of the mount. */
+	struct uk_mutex		lock;
+
+	/* Device geometry */
+	size_t			ssize;
+	__sector		max_sectors;
+	size_t			ioalign;
+	/* Queue interrupts unsupported: completions are polled */
+	int			polling;
+
+	/* Batched requests: `nb_reqs` were submitted since the last wait,
+	 * `nb_done` of them have been reaped from `done`.
+	 */
+	struct uk_blkreq	*reqs;
+	unsigned int		nb_reqs;
+	unsigned int		nb_done;
+	int			error;
+	struct uk_semaphore	done;
+
+	/* Unused asynchronous reads. Completions put them back from
+	 * interrupt context, so the list is protected by disabling
+	 * interrupts.
+	 */
+	struct ext2fs_aio	*aio_free;
+
+	/* Block cache */
+	struct ext2fs_buf	*bufs;
+	struct uk_hlist_head	*buf_hash;
+	struct uk_list_head	buf_lru;
+
+	/* File system geometry */
+	struct ext2_super_block	sb;
+	size_t			bsize;
+	unsigned int		bshift;
+	unsigned int		sec_per_blk;
+	__u64			blocks_count;
+	__u32			ngroups;
+	size_t			inode_size;
+	size_t			desc_size;
+	void			*gdt;
+	__u32			incompat;
+};
+
+struct ext2fs_node {
+	__u32			ino;
+	struct ext2_inode	inode;
+	/* Last extent found, to skip tree walks for sequential access */
+	__u64			ext_lblk;
+	__u64			ext_pblk;
+	__u32			ext_len;
+};
+
+#define EXT2FS_MD(mount) ((struct ext2fs_mount_data *) (mount)->m_data)
+#define EXT2FS_NODE(vnode) ((struct ext2fs_node *) (vnode)->v_data)
+
+static inline __u64 ext2fs_inode_size(const struct ext2_inode *inode)
+{
+	return (__u64)inode->i_size_high << 32 | inode->i_size_lo;
+}
+
+/* ext2fs_blk.c */
+int ext2fs_dev_open(struct ext2fs_mount_data *md, unsigned int id);
+void ext2fs_dev_close(struct ext2fs_mount_data *md);
+int ext2fs_io_read(struct ext2fs_mount_data *md, __sector sector,
+		   __sector nb_sectors, void *buf);
+int ext2fs_io_wait(struct ext2fs_mount_data *md);
+struct ext2fs_aio *ext2fs_aio_get(struct ext2fs_mount_data *md);
+void ext2fs_aio_put(struct ext2fs_aio *eaio);
+int ext2fs_aio_read(struct ext2fs_aio *eaio, __sector sector,
+		    __sector nb_sectors, void *buf);
+void ext2fs_aio_submit(struct ext2fs_aio *eaio);
+int ext2fs_bcache_init(struct ext2fs_mount_data *md);
+void ext2fs_bcache_free(struct ext2fs_mount_data *md);
+int ext2fs_bread(struct ext2fs_mount_data *md, __u64 blk, void **data);
+
+/* ext2fs_vfsops.c */
+int ext2fs_read_inode(struct ext2fs_mount_data *md, __u32 ino,
+		      struct ext2_inode *inode);
+
+/* ext2fs_vnops.c */
+int ext2fs_node_init(struct vnode *vp, __u32 ino);
+
+#endif /* __UK_EXT2FS__ */
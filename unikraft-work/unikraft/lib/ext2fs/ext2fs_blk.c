@@ -0,0 +1,426 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <uk/alloc.h>
+#include <uk/assert.h>
+#include <uk/plat/lcpu.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+
+#include "ext2fs.h"
+
+#define EXT2FS_BUF_BUCKETS	256
+#define EXT2FS_BLK_NONE		((__u64)-1)
+
+/*
+ * Requests are submitted without waiting for each other, up to
+ * CONFIG_LIBEXT2FS_MAXREQS at a time. Every completion ups `done`, so that
+ * ext2fs_io_wait() only needs to reap as many completions as requests were
+ * submitted. Completions arrive through the queue interrupt or, if the
+ * driver does not support it, by polling the queue while waiting.
+ */
+static void ext2fs_req_done(struct uk_blkreq *req, void *cookie)
+{
+	struct ext2fs_mount_data *md = (struct ext2fs_mount_data *)cookie;
+
+	if (unlikely(req->result < 0))
+		md->error = EIO;
+	uk_semaphore_up(&md->done);
+}
+
+static void ext2fs_queue_event(struct uk_blkdev *dev, uint16_t queue_id,
+			       void *argp __unused)
+{
+	/* Runs the request callbacks and re-enables the queue interrupt */
+	uk_blkdev_queue_finish_reqs(dev, queue_id);
+}
+
+static void ext2fs_io_reap(struct ext2fs_mount_data *md)
+{
+	if (!md->polling) {
+		uk_semaphore_down(&md->done);
+	} else {
+		while (!uk_semaphore_down_try(&md->done)) {
+			uk_blkdev_queue_finish_reqs(md->dev, 0);
+			if (uk_semaphore_down_try(&md->done))
+				break;
+			uk_sched_yield();
+		}
+	}
+	md->nb_done++;
+}
+
+int ext2fs_io_wait(struct ext2fs_mount_data *md)
+{
+	int rc;
+
+	while (md->nb_done < md->nb_reqs)
+		ext2fs_io_reap(md);
+
+	rc = md->error;
+	md->nb_reqs = 0;
+	md->nb_done = 0;
+	md->error = 0;
+	return rc;
+}
+
+static int ext2fs_io_submit(struct ext2fs_mount_data *md,
+			    struct uk_blkreq *req)
+{
+	int rc;
+
+	for (;;) {
+		rc = uk_blkdev_queue_submit_one(md->dev, 0, req);
+		if (uk_blkdev_status_successful(rc))
+			return 0;
+		if (unlikely(rc < 0)) {
+			uk_pr_err("Failed to submit read request: %d\n", rc);
+			return EIO;
+		}
+
+		/* The queue is full: wait for one of our requests, or for
+		 * asynchronous reads to make room
+		 */
+		if (md->nb_done < md->nb_reqs) {
+			ext2fs_io_reap(md);
+		} else {
+			if (md->polling)
+				uk_blkdev_queue_finish_reqs(md->dev, 0);
+			uk_sched_yield();
+		}
+	}
+}
+
+/*
+ * Queues a read of `nb_sectors` sectors into `buf`, which must be aligned
+ * to the device's I/O alignment. The read is only complete after the next
+ * ext2fs_io_wait(), which callers must issue even if this fails.
+ */
+int ext2fs_io_read(struct ext2fs_mount_data *md, __sector sector,
+		   __sector nb_sectors, void *buf)
+{
+	struct uk_blkreq *req;
+	__sector n;
+	int rc;
+
+	UK_ASSERT(((uintptr_t)buf & (md->ioalign - 1)) == 0);
+
+	while (nb_sectors) {
+		if (md->nb_reqs == CONFIG_LIBEXT2FS_MAXREQS) {
+			rc = ext2fs_io_wait(md);
+			if (unlikely(rc))
+				return rc;
+		}
+
+		n = MIN(nb_sectors, md->max_sectors);
+		req = &md->reqs[md->nb_reqs];
+		uk_blkreq_init(req, UK_BLKREQ_READ, sector, n, buf,
+			       ext2fs_req_done, md);
+		rc = ext2fs_io_submit(md, req);
+		if (unlikely(rc))
+			return rc;
+		md->nb_reqs++;
+
+		sector += n;
+		nb_sectors -= n;
+		buf = (char *)buf + n * md->ssize;
+	}
+	return 0;
+}
+
+/*
+ * Asynchronous reads own their requests and do not wait for them: the
+ * last completion posts the result to the caller. Until all requests are
+ * submitted, the submitter holds an extra reference in `pending`.
+ */
+static void ext2fs_aio_release(struct ext2fs_aio *eaio, unsigned int n)
+{
+	struct vfscore_aio *aio = eaio->aio;
+
+	if (__atomic_sub_fetch(&eaio->pending, n, __ATOMIC_ACQ_REL))
+		return;
+
+	aio->aio_res = eaio->error ? -eaio->error : eaio->bytes;
+	ext2fs_aio_put(eaio);
+	aio->aio_done(aio);
+}
+
+static void ext2fs_aio_req_done(struct uk_blkreq *req, void *cookie)
+{
+	struct ext2fs_aio *eaio = (struct ext2fs_aio *)cookie;
+
+	if (unlikely(req->result < 0))
+		eaio->error = EIO;
+	ext2fs_aio_release(eaio, 1);
+}
+
+struct ext2fs_aio *ext2fs_aio_get(struct ext2fs_mount_data *md)
+{
+	struct ext2fs_aio *eaio;
+	unsigned long flags;
+
+	flags = ukplat_lcpu_save_irqf();
+	eaio = md->aio_free;
+	if (eaio)
+		md->aio_free = eaio->next;
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (!eaio) {
+		eaio = malloc(sizeof(*eaio));
+		if (unlikely(!eaio))
+			return NULL;
+		eaio->md = md;
+	}
+	eaio->aio = NULL;
+	eaio->bytes = 0;
+	eaio->error = 0;
+	eaio->nb_reqs = 0;
+	return eaio;
+}
+
+/* May be called from interrupt context */
+void ext2fs_aio_put(struct ext2fs_aio *eaio)
+{
+	struct ext2fs_mount_data *md = eaio->md;
+	unsigned long flags;
+
+	flags = ukplat_lcpu_save_irqf();
+	eaio->next = md->aio_free;
+	md->aio_free = eaio;
+	ukplat_lcpu_restore_irqf(flags);
+}
+
+/*
+ * Adds a read of `nb_sectors` sectors into `buf` to `eaio`. Returns
+ * ENOTSUP if the read would need more than EXT2FS_AIO_REQS requests.
+ */
+int ext2fs_aio_read(struct ext2fs_aio *eaio, __sector sector,
+		    __sector nb_sectors, void *buf)
+{
+	struct ext2fs_mount_data *md = eaio->md;
+	__sector n;
+
+	UK_ASSERT(((uintptr_t)buf & (md->ioalign - 1)) == 0);
+
+	while (nb_sectors) {
+		if (eaio->nb_reqs == EXT2FS_AIO_REQS)
+			return ENOTSUP;
+
+		n = MIN(nb_sectors, md->max_sectors);
+		uk_blkreq_init(&eaio->reqs[eaio->nb_reqs++], UK_BLKREQ_READ,
+			       sector, n, buf, ext2fs_aio_req_done, eaio);
+
+		sector += n;
+		nb_sectors -= n;
+		buf = (char *)buf + n * md->ssize;
+	}
+	return 0;
+}
+
+/*
+ * Submits the requests added with ext2fs_aio_read(). The read may complete
+ * before this returns, after which `eaio` must not be used anymore.
+ */
+void ext2fs_aio_submit(struct ext2fs_aio *eaio)
+{
+	unsigned int i, nb_reqs = eaio->nb_reqs;
+
+	eaio->pending = nb_reqs + 1;
+	for (i = 0; i < nb_reqs; i++) {
+		if (unlikely(ext2fs_io_submit(eaio->md, &eaio->reqs[i]))) {
+			eaio->error = EIO;
+			break;
+		}
+	}
+	ext2fs_aio_release(eaio, nb_reqs - i + 1);
+}
+
+int ext2fs_dev_open(struct ext2fs_mount_data *md, unsigned int id)
+{
+	struct uk_blkdev_info dev_info;
+	struct uk_blkdev_conf dev_conf;
+	struct uk_blkdev_queue_info q_info;
+	struct uk_blkdev_queue_conf q_conf;
+	struct uk_blkdev *dev;
+	int rc;
+
+	dev = uk_blkdev_get(id);
+	if (!dev)
+		return ENODEV;
+
+	if (uk_blkdev_state_get(dev) != UK_BLKDEV_UNCONFIGURED) {
+		uk_pr_err("blkdev%u: Device is in use\n", id);
+		return EBUSY;
+	}
+
+	rc = uk_blkdev_get_info(dev, &dev_info);
+	if (unlikely(rc))
+		return -rc;
+
+	dev_conf.nb_queues = 1;
+	rc = uk_blkdev_configure(dev, &dev_conf);
+	if (unlikely(rc))
+		return -rc;
+
+	rc = uk_blkdev_queue_get_info(dev, 0, &q_info);
+	if (unlikely(rc))
+		goto err_unconfigure;
+
+	q_conf.a = uk_alloc_get_default();
+	q_conf.callback = ext2fs_queue_event;
+	q_conf.callback_cookie = md;
+#if CONFIG_LIBUKBLKDEV_DISPATCHERTHREADS
+	q_conf.s = uk_sched_current();
+#endif
+	rc = uk_blkdev_queue_configure(dev, 0, q_info.nb_max, &q_conf);
+	if (unlikely(rc))
+		goto err_unconfigure;
+
+	rc = uk_blkdev_start(dev);
+	if (unlikely(rc))
+		goto err_unconfigure_queue;
+
+	md->dev = dev;
+	md->ssize = uk_blkdev_ssize(dev);
+	md->max_sectors = uk_blkdev_max_sec_per_req(dev);
+	md->ioalign = MAX(uk_blkdev_ioalign(dev), sizeof(void *));
+	if (unlikely(!md->max_sectors || md->ioalign & (md->ioalign - 1))) {
+		uk_pr_err("blkdev%u: Unsupported device capabilities\n", id);
+		rc = -ENOTSUP;
+		goto err_stop;
+	}
+
+	md->reqs = calloc(CONFIG_LIBEXT2FS_MAXREQS, sizeof(*md->reqs));
+	if (unlikely(!md->reqs)) {
+		rc = -ENOMEM;
+		goto err_stop;
+	}
+	md->nb_reqs = 0;
+	md->nb_done = 0;
+	md->error = 0;
+	uk_semaphore_init(&md->done, 0);
+	md->aio_free = NULL;
+
+	md->polling = (uk_blkdev_queue_intr_enable(dev, 0) < 0);
+	if (md->polling)
+		uk_pr_info("blkdev%u: Polling for completions\n", id);
+	return 0;
+
+err_stop:
+	uk_blkdev_stop(dev);
+err_unconfigure_queue:
+	uk_blkdev_queue_unconfigure(dev, 0);
+err_unconfigure:
+	uk_blkdev_unconfigure(dev);
+	return -rc;
+}
+
+void ext2fs_dev_close(struct ext2fs_mount_data *md)
+{
+	struct ext2fs_aio *eaio;
+
+	UK_ASSERT(md->nb_reqs == 0);
+
+	if (!md->polling)
+		uk_blkdev_queue_intr_disable(md->dev, 0);
+	uk_blkdev_stop(md->dev);
+	uk_blkdev_queue_unconfigure(md->dev, 0);
+	uk_blkdev_unconfigure(md->dev);
+	free(md->reqs);
+
+	while ((eaio = md->aio_free)) {
+		md->aio_free = eaio->next;
+		free(eaio);
+	}
+}
+
+int ext2fs_bcache_init(struct ext2fs_mount_data *md)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct ext2fs_buf *buf;
+	unsigned int i;
+
+	md->bufs = calloc(CONFIG_LIBEXT2FS_BCACHE, sizeof(*md->bufs));
+	md->buf_hash = calloc(EXT2FS_BUF_BUCKETS, sizeof(*md->buf_hash));
+	if (unlikely(!md->bufs || !md->buf_hash))
+		goto err_free;
+
+	UK_INIT_LIST_HEAD(&md->buf_lru);
+	for (i = 0; i < CONFIG_LIBEXT2FS_BCACHE; i++) {
+		buf = &md->bufs[i];
+		buf->data = uk_memalign(a, md->ioalign, md->bsize);
+		if (unlikely(!buf->data))
+			goto err_free;
+		buf->blk = EXT2FS_BLK_NONE;
+		uk_list_add_tail(&buf->lru_link, &md->buf_lru);
+	}
+	return 0;
+
+err_free:
+	ext2fs_bcache_free(md);
+	return ENOMEM;
+}
+
+void ext2fs_bcache_free(struct ext2fs_mount_data *md)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	unsigned int i;
+
+	if (md->bufs) {
+		for (i = 0; i < CONFIG_LIBEXT2FS_BCACHE; i++)
+			if (md->bufs[i].data)
+				uk_free(a, md->bufs[i].data);
+	}
+	free(md->bufs);
+	free(md->buf_hash);
+	md->bufs = NULL;
+	md->buf_hash = NULL;
+}
+
+/*
+ * Returns the cached contents of block `blk`, reading it on a miss. Waits
+ * for all requests queued before.
+ */
+int ext2fs_bread(struct ext2fs_mount_data *md, __u64 blk, void **data)
+{
+	struct uk_hlist_head *head;
+	struct ext2fs_buf *buf;
+	int rc;
+
+	if (unlikely(blk >= md->blocks_count)) {
+		uk_pr_err("Block %"PRIu64" beyond end of file system\n", blk);
+		return EIO;
+	}
+
+	head = &md->buf_hash[blk & (EXT2FS_BUF_BUCKETS - 1)];
+	uk_hlist_for_each_entry(buf, head, hash_link) {
+		if (buf->blk == blk)
+			goto out;
+	}
+
+	/* Recycle the least recently used buffer */
+	buf = uk_list_first_entry(&md->buf_lru, struct ext2fs_buf, lru_link);
+	if (buf->blk != EXT2FS_BLK_NONE) {
+		uk_hlist_del(&buf->hash_link);
+		buf->blk = EXT2FS_BLK_NONE;
+	}
+
+	rc = ext2fs_io_read(md, blk * md->sec_per_blk, md->sec_per_blk,
+			    buf->data);
+	rc = ext2fs_io_wait(md) ?: rc;
+	if (unlikely(rc))
+		return rc;
+
+	buf->blk = blk;
+	uk_hlist_add_head(&buf->hash_link, head);
+out:
+	uk_list_move_tail(&buf->lru_link, &md->buf_lru);
+	*data = buf->data;
+	return 0;
+}
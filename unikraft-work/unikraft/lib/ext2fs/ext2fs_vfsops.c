@@ -0,0 +1,328 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/config.h>
+#include <uk/print.h>
+#include <vfscore/mount.h>
+#include <vfscore/dentry.h>
+
+#include "ext2fs.h"
+
+UK_CTASSERT(__offsetof(struct ext2_super_block, s_magic) == 0x38);
+UK_CTASSERT(__offsetof(struct ext2_super_block, s_desc_size) == 0xFE);
+UK_CTASSERT(__offsetof(struct ext2_super_block, s_blocks_count_hi) == 0x150);
+UK_CTASSERT(sizeof(struct ext2_group_desc) == 0x2C);
+UK_CTASSERT(sizeof(struct ext2_inode) == EXT2_GOOD_OLD_INODE_SIZE);
+
+extern struct vnops ext2fs_vnops;
+
+static int ext2fs_mount(struct mount *mp, const char *dev, int flags,
+			const void *data);
+
+static int ext2fs_unmount(struct mount *mp, int flags);
+
+static int ext2fs_statfs(struct mount *mp, struct statfs *statp);
+
+#define ext2fs_sync		((vfsop_sync_t)vfscore_nullop)
+#define ext2fs_vget		((vfsop_vget_t)vfscore_nullop)
+
+struct vfsops ext2fs_vfsops = {
+	.vfs_mount	= ext2fs_mount,
+	.vfs_unmount	= ext2fs_unmount,
+	.vfs_sync	= ext2fs_sync,
+	.vfs_vget	= ext2fs_vget,
+	.vfs_statfs	= ext2fs_statfs,
+	.vfs_vnops	= &ext2fs_vnops
+};
+
+static struct vfscore_fs_type ext2fs_fs = {
+	.vs_name	= "ext2fs",
+	.vs_init	= NULL,
+	.vs_op		= &ext2fs_vfsops
+};
+
+UK_FS_REGISTER(ext2fs_fs);
+
+/* Accepts "blkdev<id>" or just "<id>" */
+static int ext2fs_parse_dev(const char *dev, unsigned int *id)
+{
+	unsigned long val;
+	char *end;
+
+	if (!dev)
+		return EINVAL;
+	if (strncmp(dev, "blkdev", 6) == 0)
+		dev += 6;
+	if (*dev < '0' || *dev > '9')
+		return EINVAL;
+
+	val = strtoul(dev, &end, 10);
+	if (*end != '\0' || val > UINT_MAX)
+		return EINVAL;
+
+	*id = (unsigned int)val;
+	return 0;
+}
+
+static int ext2fs_read_super(struct ext2fs_mount_data *md)
+{
+	struct ext2_super_block *sb = &md->sb;
+	struct uk_alloc *a = uk_alloc_get_default();
+	size_t len;
+	void *buf;
+	int rc;
+
+	/* The superblock is at byte 1024, whatever the sector size */
+	len = ALIGN_UP(EXT2_SUPER_OFFSET + 1024, md->ssize);
+	buf = uk_memalign(a, md->ioalign, len);
+	if (unlikely(!buf))
+		return ENOMEM;
+
+	rc = ext2fs_io_read(md, 0, len / md->ssize, buf);
+	rc = ext2fs_io_wait(md) ?: rc;
+	if (!rc)
+		memcpy(sb, (char *)buf + EXT2_SUPER_OFFSET, sizeof(*sb));
+	uk_free(a, buf);
+	if (unlikely(rc))
+		return rc;
+
+	if (sb->s_magic != EXT2_SUPER_MAGIC) {
+		uk_pr_err("No ext2/3/4 file system found\n");
+		return EINVAL;
+	}
+
+	if (sb->s_rev_level == EXT2_GOOD_OLD_REV) {
+		md->inode_size = EXT2_GOOD_OLD_INODE_SIZE;
+		md->incompat = 0;
+	} else {
+		md->inode_size = sb->s_inode_size;
+		md->incompat = sb->s_feature_incompat;
+	}
+
+	if (md->incompat & EXT3_FEATURE_INCOMPAT_RECOVER) {
+		uk_pr_err("File system needs journal recovery, run e2fsck\n");
+		return EINVAL;
+	}
+	if (md->incompat & ~EXT2FS_FEATURE_INCOMPAT_SUPP) {
+		uk_pr_err("Unsupported file system features: 0x%"PRIx32"\n",
+			  md->incompat & ~EXT2FS_FEATURE_INCOMPAT_SUPP);
+		return EINVAL;
+	}
+
+	if (sb->s_log_block_size >
+	    EXT2_MAX_BLOCK_LOG_SIZE - EXT2_MIN_BLOCK_LOG_SIZE) {
+		uk_pr_err("Invalid block size\n");
+		return EINVAL;
+	}
+	md->bshift = EXT2_MIN_BLOCK_LOG_SIZE + sb->s_log_block_size;
+	md->bsize = 1UL << md->bshift;
+	if (md->bsize < md->ssize || md->bsize % md->ssize) {
+		uk_pr_err("Block size %"__PRIsz" not supported with %"__PRIsz"-byte sectors\n",
+			  md->bsize, md->ssize);
+		return EINVAL;
+	}
+	md->sec_per_blk = md->bsize / md->ssize;
+
+	if (md->inode_size < EXT2_GOOD_OLD_INODE_SIZE
+	    || md->inode_size > md->bsize
+	    || md->inode_size & (md->inode_size - 1)) {
+		uk_pr_err("Invalid inode size %"__PRIsz"\n", md->inode_size);
+		return EINVAL;
+	}
+
+	md->blocks_count = sb->s_blocks_count_lo;
+	md->desc_size = EXT2_DESC_SIZE;
+	if (md->incompat & EXT4_FEATURE_INCOMPAT_64BIT) {
+		md->blocks_count |= (__u64)sb->s_blocks_count_hi << 32;
+		md->desc_size = sb->s_desc_size;
+		if (md->desc_size < EXT2_DESC_SIZE || md->desc_size > md->bsize
+		    || md->desc_size & (md->desc_size - 1)) {
+			uk_pr_err("Invalid group descriptor size %"__PRIsz"\n",
+				  md->desc_size);
+			return EINVAL;
+		}
+	}
+
+	if (md->blocks_count * md->sec_per_blk > uk_blkdev_sectors(md->dev)) {
+		uk_pr_err("File system larger than the device\n");
+		return EINVAL;
+	}
+
+	if (!sb->s_blocks_per_group || !sb->s_inodes_per_group
+	    || sb->s_first_data_block >= md->blocks_count) {
+		uk_pr_err("Invalid block group layout\n");
+		return EINVAL;
+	}
+	md->ngroups = DIV_ROUND_UP(md->blocks_count - sb->s_first_data_block,
+				   sb->s_blocks_per_group);
+	if ((__u64)md->ngroups * sb->s_inodes_per_group < sb->s_inodes_count) {
+		uk_pr_err("Invalid inode count\n");
+		return EINVAL;
+	}
+
+	return 0;
+}
+
+/* Loads the group descriptor table, which follows the superblock */
+static int ext2fs_read_gdt(struct ext2fs_mount_data *md)
+{
+	size_t len = (size_t)md->ngroups * md->desc_size;
+	__u64 blk = md->sb.s_first_data_block + 1;
+	size_t off, n;
+	void *data;
+	int rc;
+
+	md->gdt = malloc(len);
+	if (unlikely(!md->gdt))
+		return ENOMEM;
+
+	for (off = 0; off < len; off += n, blk++) {
+		rc = ext2fs_bread(md, blk, &data);
+		if (unlikely(rc))
+			return rc;
+
+		n = MIN(len - off, md->bsize);
+		memcpy((char *)md->gdt + off, data, n);
+	}
+	return 0;
+}
+
+int ext2fs_read_inode(struct ext2fs_mount_data *md, __u32 ino,
+		      struct ext2_inode *inode)
+{
+	struct ext2_group_desc *gd;
+	__u32 group, index;
+	__u64 table, off;
+	void *data;
+	int rc;
+
+	if (unlikely(ino == 0 || ino > md->sb.s_inodes_count)) {
+		uk_pr_err("Invalid inode number %"PRIu32"\n", ino);
+		return EIO;
+	}
+
+	group = (ino - 1) / md->sb.s_inodes_per_group;
+	index = (ino - 1) % md->sb.s_inodes_per_group;
+	gd = (struct ext2_group_desc *)((char *)md->gdt
+					+ (size_t)group * md->desc_size);
+
+	table = gd->bg_inode_table_lo;
+	if (md->desc_size >= sizeof(*gd))
+		table |= (__u64)gd->bg_inode_table_hi << 32;
+
+	off = (__u64)index * md->inode_size;
+	rc = ext2fs_bread(md, table + (off >> md->bshift), &data);
+	if (unlikely(rc))
+		return rc;
+
+	memcpy(inode, (char *)data + (off & (md->bsize - 1)), sizeof(*inode));
+	return 0;
+}
+
+static int ext2fs_mount(struct mount *mp, const char *dev,
+			int flags __unused, const void *data __unused)
+{
+	struct ext2fs_mount_data *md;
+	unsigned int id;
+	int rc;
+
+	/* Set data as null, vnop_inactive() checks this for the root node. */
+	mp->m_root->d_vnode->v_data = NULL;
+
+	rc = ext2fs_parse_dev(dev, &id);
+	if (rc) {
+		uk_pr_err("Invalid device \"%s\", expected blkdev<id>\n", dev);
+		return rc;
+	}
+
+	md = calloc(1, sizeof(*md));
+	if (!md)
+		return ENOMEM;
+
+	uk_mutex_init(&md->lock);
+	rc = ext2fs_dev_open(md, id);
+	if (rc)
+		goto out_free_mdata;
+
+	rc = ext2fs_read_super(md);
+	if (rc)
+		goto out_close;
+
+	rc = ext2fs_bcache_init(md);
+	if (rc)
+		goto out_close;
+
+	rc = ext2fs_read_gdt(md);
+	if (rc)
+		goto out_free_bcache;
+
+	mp->m_data = md;
+	rc = ext2fs_node_init(mp->m_root->d_vnode, EXT2_ROOT_INO);
+	if (rc)
+		goto out_free_bcache;
+
+	/* Writing is not supported */
+	mp->m_flags |= MNT_RDONLY;
+
+	uk_pr_info("blkdev%u: Mounted ext2fs, %"PRIu64" blocks of %"__PRIsz" bytes\n",
+		   id, md->blocks_count, md->bsize);
+	return 0;
+
+out_free_bcache:
+	mp->m_data = NULL;
+	free(md->gdt);
+	ext2fs_bcache_free(md);
+out_close:
+	ext2fs_dev_close(md);
+out_free_mdata:
+	free(md);
+	return rc;
+}
+
+static int ext2fs_unmount(struct mount *mp, int flags __unused)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(mp);
+
+	vfscore_release_mp_dentries(mp);
+	ext2fs_dev_close(md);
+	ext2fs_bcache_free(md);
+	free(md->gdt);
+	free(md);
+
+	return 0;
+}
+
+static int ext2fs_statfs(struct mount *mp, struct statfs *statp)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(mp);
+	struct ext2_super_block *sb = &md->sb;
+	__u64 bfree, rblocks;
+
+	bfree = sb->s_free_blocks_count_lo;
+	rblocks = sb->s_r_blocks_count_lo;
+	if (md->incompat & EXT4_FEATURE_INCOMPAT_64BIT) {
+		bfree |= (__u64)sb->s_free_blocks_count_hi << 32;
+		rblocks |= (__u64)sb->s_r_blocks_count_hi << 32;
+	}
+
+	statp->f_type = EXT2_SUPER_MAGIC;
+	statp->f_bsize = md->bsize;
+	statp->f_frsize = md->bsize;
+	statp->f_blocks = md->blocks_count;
+	statp->f_bfree = bfree;
+	statp->f_bavail = (bfree > rblocks) ? bfree - rblocks : 0;
+	statp->f_files = sb->s_inodes_count;
+	statp->f_ffree = sb->s_free_inodes_count;
+	statp->f_namelen = 255;
+
+	return 0;
+}
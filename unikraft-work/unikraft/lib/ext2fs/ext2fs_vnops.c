@@ -0,0 +1,696 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uk/config.h>
+#include <uk/print.h>
+#include <vfscore/dentry.h>
+#include <vfscore/file.h>
+#include <vfscore/fs.h>
+#include <vfscore/mount.h>
+#include <vfscore/uio.h>
+#include <vfscore/vnode.h>
+#ifdef CONFIG_LIBEXT2FS_PAGECACHE
+#include <vfscore/pagecache.h>
+#endif /* CONFIG_LIBEXT2FS_PAGECACHE */
+
+#include "ext2fs.h"
+
+static const unsigned char ext2fs_dtype_tab[] = {
+	[EXT2_FT_UNKNOWN]	= DT_UNKNOWN,
+	[EXT2_FT_REG_FILE]	= DT_REG,
+	[EXT2_FT_DIR]		= DT_DIR,
+	[EXT2_FT_CHRDEV]	= DT_CHR,
+	[EXT2_FT_BLKDEV]	= DT_BLK,
+	[EXT2_FT_FIFO]		= DT_FIFO,
+	[EXT2_FT_SOCK]		= DT_SOCK,
+	[EXT2_FT_SYMLINK]	= DT_LNK,
+};
+
+int ext2fs_node_init(struct vnode *vp, __u32 ino)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2fs_node *np;
+	int rc;
+
+	np = calloc(1, sizeof(*np));
+	if (!np)
+		return ENOMEM;
+
+	uk_mutex_lock(&md->lock);
+	rc = ext2fs_read_inode(md, ino, &np->inode);
+	uk_mutex_unlock(&md->lock);
+	if (rc) {
+		free(np);
+		return rc;
+	}
+
+	np->ino = ino;
+	vp->v_data = np;
+	vp->v_type = IFTOVT(np->inode.i_mode);
+	vp->v_mode = np->inode.i_mode;
+	vp->v_size = ext2fs_inode_size(&np->inode);
+
+	return 0;
+}
+
+/*
+ * Indirect block map: 12 direct blocks, followed by a single, double, and
+ * triple indirect tree. Returns physical block 0 for holes.
+ */
+static int ext2fs_bmap_ind(struct ext2fs_mount_data *md,
+			   struct ext2fs_node *np, __u64 lblk, __u64 *pblk)
+{
+	unsigned int pshift = md->bshift - 2;
+	__u64 nptrs = 1ULL << pshift;
+	__u32 blk;
+	void *data;
+	int level;
+	int rc;
+
+	if (lblk < EXT2_NDIR_BLOCKS) {
+		*pblk = np->inode.i_block[lblk];
+		return 0;
+	}
+
+	lblk -= EXT2_NDIR_BLOCKS;
+	for (level = 1; level <= 3; level++) {
+		if (lblk < 1ULL << (pshift * level))
+			break;
+		lblk -= 1ULL << (pshift * level);
+	}
+	if (unlikely(level > 3))
+		return EFBIG;
+
+	blk = np->inode.i_block[EXT2_IND_BLOCK + level - 1];
+	while (blk && level--) {
+		rc = ext2fs_bread(md, blk, &data);
+		if (unlikely(rc))
+			return rc;
+		blk = ((__u32 *)data)[(lblk >> (pshift * level)) & (nptrs - 1)];
+	}
+
+	*pblk = blk;
+	return 0;
+}
+
+static int ext2fs_ext_check(struct ext4_extent_header *eh, size_t size,
+			    int depth)
+{
+	if (eh->eh_magic != EXT4_EXT_MAGIC
+	    || eh->eh_entries > eh->eh_max
+	    || sizeof(*eh) + eh->eh_max * sizeof(struct ext4_extent) > size
+	    || (depth >= 0 && eh->eh_depth != depth)) {
+		uk_pr_err("Corrupted extent tree\n");
+		return EIO;
+	}
+	return 0;
+}
+
+/*
+ * Extent tree lookup. Returns the physical block of `lblk` and the number
+ * of blocks that follow contiguously in the same extent, or, for a hole,
+ * physical block 0 and the number of blocks up to the next extent in the
+ * leaf. The extent found last is remembered, so that sequential accesses
+ * rarely walk the tree.
+ */
+static int ext2fs_bmap_ext(struct ext2fs_mount_data *md,
+			   struct ext2fs_node *np, __u64 lblk, __u64 *pblk,
+			   __u64 *count)
+{
+	struct ext4_extent_header *eh;
+	struct ext4_extent_idx *ei;
+	struct ext4_extent *ex;
+	unsigned int lo, hi, mid;
+	__u64 child;
+	__u32 len;
+	void *data;
+	int rc;
+
+	if (np->ext_len && lblk >= np->ext_lblk
+	    && lblk < np->ext_lblk + np->ext_len) {
+		*pblk = np->ext_pblk + (lblk - np->ext_lblk);
+		*count = np->ext_len - (lblk - np->ext_lblk);
+		return 0;
+	}
+
+	eh = (struct ext4_extent_header *)np->inode.i_block;
+	rc = ext2fs_ext_check(eh, sizeof(np->inode.i_block), -1);
+	if (unlikely(rc))
+		return rc;
+
+	while (eh->eh_depth > 0) {
+		ei = (struct ext4_extent_idx *)(eh + 1);
+		if (unlikely(!eh->eh_entries))
+			goto hole;
+
+		/* Last index starting at or before lblk */
+		lo = 1;
+		hi = eh->eh_entries;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			if (ei[mid].ei_block <= lblk)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		child = (__u64)ei[lo - 1].ei_leaf_hi << 32 | ei[lo - 1].ei_leaf_lo;
+
+		rc = ext2fs_bread(md, child, &data);
+		if (unlikely(rc))
+			return rc;
+		rc = ext2fs_ext_check(data, md->bsize, eh->eh_depth - 1);
+		if (unlikely(rc))
+			return rc;
+		eh = (struct ext4_extent_header *)data;
+	}
+
+	/* First extent starting after lblk */
+	ex = (struct ext4_extent *)(eh + 1);
+	lo = 0;
+	hi = eh->eh_entries;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (ex[mid].ee_block <= lblk)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo > 0) {
+		len = ex[lo - 1].ee_len;
+		if (len > EXT4_EXT_INIT_MAX_LEN)
+			len -= EXT4_EXT_INIT_MAX_LEN;
+		if (lblk < (__u64)ex[lo - 1].ee_block + len) {
+			*count = ex[lo - 1].ee_block + len - lblk;
+			if (ex[lo - 1].ee_len > EXT4_EXT_INIT_MAX_LEN) {
+				/* Unwritten extents read as zeros */
+				*pblk = 0;
+				return 0;
+			}
+
+			np->ext_lblk = ex[lo - 1].ee_block;
+			np->ext_pblk = (__u64)ex[lo - 1].ee_start_hi << 32
+				       | ex[lo - 1].ee_start_lo;
+			np->ext_len = len;
+			*pblk = np->ext_pblk + (lblk - np->ext_lblk);
+			return 0;
+		}
+	}
+
+	if (lo < eh->eh_entries) {
+		*pblk = 0;
+		*count = ex[lo].ee_block - lblk;
+		return 0;
+	}
+
+hole:
+	*pblk = 0;
+	*count = 1;
+	return 0;
+}
+
+/*
+ * Maps logical block `lblk` of a file to its physical block, 0 for a hole.
+ * `count` returns how many blocks, at most `max`, follow contiguously on
+ * disk (or as hole), so that they can be read with a single request.
+ */
+static int ext2fs_bmap(struct ext2fs_mount_data *md, struct ext2fs_node *np,
+		       __u64 lblk, __u64 max, __u64 *pblk, __u64 *count)
+{
+	__u64 next;
+	int rc;
+
+	UK_ASSERT(max > 0);
+
+	if (np->inode.i_flags & EXT4_EXTENTS_FL) {
+		rc = ext2fs_bmap_ext(md, np, lblk, pblk, count);
+		if (unlikely(rc))
+			return rc;
+		*count = MIN(*count, max);
+	} else {
+		rc = ext2fs_bmap_ind(md, np, lblk, pblk);
+		if (unlikely(rc))
+			return rc;
+		for (*count = 1; *count < max; (*count)++) {
+			rc = ext2fs_bmap_ind(md, np, lblk + *count, &next);
+			if (unlikely(rc))
+				return rc;
+			if (next != (*pblk ? *pblk + *count : 0))
+				break;
+		}
+	}
+
+	if (unlikely(*pblk && (*pblk >= md->blocks_count
+			       || *count > md->blocks_count - *pblk))) {
+		uk_pr_err("Inode %"PRIu32": Block %"PRIu64" out of range\n",
+			  np->ino, *pblk);
+		return EIO;
+	}
+	return 0;
+}
+
+static inline size_t ext2fs_dirent_namelen(struct ext2fs_mount_data *md,
+					   struct ext2_dir_entry *de)
+{
+	if (md->incompat & EXT2_FEATURE_INCOMPAT_FILETYPE)
+		return de->name_len;
+	return de->name_len | (size_t)de->file_type << 8;
+}
+
+/*
+ * Returns the next used directory entry at or after byte offset `off`, and
+ * advances `off` past it. The entry points into the block cache and stays
+ * valid until the next block is read. Returns ENOENT at the end.
+ */
+static int ext2fs_dir_next(struct ext2fs_mount_data *md,
+			   struct ext2fs_node *np, off_t *off,
+			   struct ext2_dir_entry **dep)
+{
+	__u64 size = ext2fs_inode_size(&np->inode);
+	struct ext2_dir_entry *de;
+	__u64 lblk, pblk, count;
+	size_t boff, reclen;
+	void *data;
+	int rc;
+
+	while ((__u64)*off < size) {
+		lblk = *off >> md->bshift;
+		boff = *off & (md->bsize - 1);
+
+		rc = ext2fs_bmap(md, np, lblk, 1, &pblk, &count);
+		if (unlikely(rc))
+			return rc;
+		if (!pblk) {
+			*off = (off_t)(lblk + 1) << md->bshift;
+			continue;
+		}
+
+		rc = ext2fs_bread(md, pblk, &data);
+		if (unlikely(rc))
+			return rc;
+
+		de = (struct ext2_dir_entry *)((char *)data + boff);
+		reclen = de->rec_len;
+		/* 64 KiB blocks encode a full-block entry specially */
+		if (md->bsize == 65536 && (reclen == 0 || reclen == 65535))
+			reclen = 65536;
+		if (unlikely(boff + EXT2_DIR_ENTRY_HDR > md->bsize
+			     || reclen < EXT2_DIR_ENTRY_HDR || reclen & 3
+			     || boff + reclen > md->bsize
+			     || EXT2_DIR_ENTRY_HDR
+				+ ext2fs_dirent_namelen(md, de) > reclen)) {
+			uk_pr_err("Inode %"PRIu32": Corrupted directory entry at %"PRIu64"\n",
+				  np->ino, (__u64)*off);
+			return EIO;
+		}
+
+		*off += reclen;
+		if (de->inode) {
+			*dep = de;
+			return 0;
+		}
+	}
+	return ENOENT;
+}
+
+static int ext2fs_read(struct vnode *vp, struct vfscore_file *fp __unused,
+		       struct uio *uio, int ioflag __unused)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2fs_node *np = EXT2FS_NODE(vp);
+	__u64 lblk, pblk, count;
+	size_t len, boff, bytes;
+	struct iovec *iov;
+	void *data;
+	int rc = 0;
+
+	if (vp->v_type == VDIR)
+		return EISDIR;
+	if (vp->v_type != VREG)
+		return EINVAL;
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (uio->uio_offset >= (off_t) vp->v_size)
+		return 0;
+	if (!uio->uio_resid)
+		return 0;
+
+	uk_mutex_lock(&md->lock);
+	while (uio->uio_resid > 0 && uio->uio_offset < (off_t) vp->v_size) {
+		iov = uio->uio_iov;
+		if (!iov->iov_len) {
+			uio->uio_iov++;
+			uio->uio_iovcnt--;
+			continue;
+		}
+
+		len = MIN(iov->iov_len,
+			  (size_t)(vp->v_size - uio->uio_offset));
+		lblk = uio->uio_offset >> md->bshift;
+		boff = uio->uio_offset & (md->bsize - 1);
+		rc = ext2fs_bmap(md, np, lblk,
+				 DIV_ROUND_UP(boff + len, md->bsize),
+				 &pblk, &count);
+		if (unlikely(rc))
+			break;
+
+		if (pblk && !boff && len >= md->bsize
+		    && !((uintptr_t)iov->iov_base & (md->ioalign - 1))) {
+			/* Whole blocks go straight to the caller's buffer,
+			 * without waiting for the previous requests
+			 */
+			count = MIN(count, len >> md->bshift);
+			rc = ext2fs_io_read(md, pblk * md->sec_per_blk,
+					    count * md->sec_per_blk,
+					    iov->iov_base);
+			if (unlikely(rc))
+				break;
+			bytes = count << md->bshift;
+		} else if (pblk) {
+			rc = ext2fs_bread(md, pblk, &data);
+			if (unlikely(rc))
+				break;
+			bytes = MIN(len, md->bsize - boff);
+			memcpy(iov->iov_base, (char *)data + boff, bytes);
+		} else {
+			bytes = MIN(len, (count << md->bshift) - boff);
+			memset(iov->iov_base, 0, bytes);
+		}
+
+		iov->iov_base = (char *)iov->iov_base + bytes;
+		iov->iov_len -= bytes;
+		uio->uio_resid -= bytes;
+		uio->uio_offset += bytes;
+	}
+	rc = ext2fs_io_wait(md) ?: rc;
+	uk_mutex_unlock(&md->lock);
+
+	return rc;
+}
+
+#ifndef CONFIG_LIBEXT2FS_PAGECACHE
+/*
+ * Reads whole sectors straight into the caller's buffers and returns as
+ * soon as the requests are submitted. Metadata needed to map the file is
+ * still read synchronously. Reads that start within a sector, into buffers
+ * that do not satisfy the device's I/O alignment, or that need more than
+ * EXT2FS_AIO_REQS requests are left to ext2fs_read().
+ */
+static int ext2fs_aread(struct vnode *vp, struct vfscore_file *fp __unused,
+			struct vfscore_aio *aio)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2fs_node *np = EXT2FS_NODE(vp);
+	struct ext2fs_aio *eaio;
+	__u64 lblk, pblk, count;
+	size_t len, boff, bytes;
+	off_t off = aio->aio_offset;
+	char *buf;
+	int i, rc = 0;
+
+	if (md->polling || vp->v_type != VREG || off < 0
+	    || (off & (md->ssize - 1)))
+		return ENOTSUP;
+
+	uk_mutex_lock(&md->lock);
+	eaio = ext2fs_aio_get(md);
+	if (unlikely(!eaio)) {
+		uk_mutex_unlock(&md->lock);
+		return ENOMEM;
+	}
+
+	for (i = 0; i < aio->aio_iovcnt && off < (off_t) vp->v_size; i++) {
+		buf = aio->aio_iov[i].iov_base;
+		len = MIN(aio->aio_iov[i].iov_len,
+			  (size_t)(vp->v_size - off));
+		if (!len)
+			continue;
+
+		/* The last sector of the file may be read past its end */
+		if (((uintptr_t)buf & (md->ioalign - 1))
+		    || ALIGN_UP(len, md->ssize) > aio->aio_iov[i].iov_len) {
+			rc = ENOTSUP;
+			goto err_put;
+		}
+
+		while (len) {
+			lblk = off >> md->bshift;
+			boff = off & (md->bsize - 1);
+			rc = ext2fs_bmap(md, np, lblk,
+					 DIV_ROUND_UP(boff + len, md->bsize),
+					 &pblk, &count);
+			if (unlikely(rc))
+				goto err_put;
+
+			bytes = MIN(len, (count << md->bshift) - boff);
+			if (pblk) {
+				rc = ext2fs_aio_read(eaio,
+						     pblk * md->sec_per_blk
+						     + boff / md->ssize,
+						     DIV_ROUND_UP(bytes,
+								  md->ssize),
+						     buf);
+				if (rc)
+					goto err_put;
+			} else {
+				memset(buf, 0, bytes);
+			}
+
+			buf += bytes;
+			len -= bytes;
+			off += bytes;
+			eaio->bytes += bytes;
+		}
+	}
+
+	eaio->aio = aio;
+	ext2fs_aio_submit(eaio);
+	uk_mutex_unlock(&md->lock);
+	return 0;
+
+err_put:
+	ext2fs_aio_put(eaio);
+	uk_mutex_unlock(&md->lock);
+	return rc;
+}
+#endif /* !CONFIG_LIBEXT2FS_PAGECACHE */
+
+static int ext2fs_readdir(struct vnode *vp, struct vfscore_file *fp,
+			  struct dirent *dir)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2_dir_entry *de;
+	size_t namelen;
+	off_t off;
+	int rc;
+
+	if (vp->v_type != VDIR)
+		return ENOTDIR;
+
+	uk_mutex_lock(&md->lock);
+	off = fp->f_offset;
+	rc = ext2fs_dir_next(md, EXT2FS_NODE(vp), &off, &de);
+	if (!rc) {
+		namelen = MIN(ext2fs_dirent_namelen(md, de),
+			      sizeof(dir->d_name) - 1);
+		dir->d_ino = de->inode;
+		dir->d_off = off;
+		dir->d_type = DT_UNKNOWN;
+		if ((md->incompat & EXT2_FEATURE_INCOMPAT_FILETYPE)
+		    && de->file_type < ARRAY_SIZE(ext2fs_dtype_tab))
+			dir->d_type = ext2fs_dtype_tab[de->file_type];
+		memcpy(dir->d_name, de->name, namelen);
+		dir->d_name[namelen] = '\0';
+		fp->f_offset = off;
+	}
+	uk_mutex_unlock(&md->lock);
+
+	return rc;
+}
+
+static int ext2fs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(dvp->v_mount);
+	struct ext2_dir_entry *de;
+	struct vnode *vp;
+	size_t namelen;
+	off_t off = 0;
+	__u32 ino;
+	int rc;
+
+	if (dvp->v_type != VDIR)
+		return ENOTDIR;
+
+	namelen = strlen(name);
+	if (namelen > NAME_MAX)
+		return ENAMETOOLONG;
+
+	uk_mutex_lock(&md->lock);
+	while (!(rc = ext2fs_dir_next(md, EXT2FS_NODE(dvp), &off, &de))) {
+		if (ext2fs_dirent_namelen(md, de) == namelen
+		    && !memcmp(de->name, name, namelen))
+			break;
+	}
+	ino = rc ? 0 : de->inode;
+	uk_mutex_unlock(&md->lock);
+	if (rc)
+		return rc;
+
+	if (vfscore_vget(dvp->v_mount, ino, &vp)) {
+		/* Already in cache. */
+		*vpp = vp;
+		return 0;
+	}
+	if (!vp)
+		return ENOMEM;
+
+	rc = ext2fs_node_init(vp, ino);
+	if (rc) {
+		vput(vp);
+		return rc;
+	}
+
+	*vpp = vp;
+	return 0;
+}
+
+static int ext2fs_getattr(struct vnode *vp, struct vattr *attr)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2_inode *inode = &EXT2FS_NODE(vp)->inode;
+	__u64 nblocks;
+
+	nblocks = (__u64)inode->i_blocks_high << 32 | inode->i_blocks_lo;
+	if (inode->i_flags & EXT4_HUGE_FILE_FL)
+		nblocks <<= md->bshift - 9;
+
+	attr->va_type = vp->v_type;
+	attr->va_mode = inode->i_mode & UK_ALLPERMS;
+	attr->va_nlink = inode->i_links_count;
+	attr->va_uid = (uid_t)inode->i_uid_high << 16 | inode->i_uid;
+	attr->va_gid = (gid_t)inode->i_gid_high << 16 | inode->i_gid;
+	attr->va_nodeid = EXT2FS_NODE(vp)->ino;
+	attr->va_atime.tv_sec = inode->i_atime;
+	attr->va_mtime.tv_sec = inode->i_mtime;
+	attr->va_ctime.tv_sec = inode->i_ctime;
+	attr->va_nblocks = nblocks;
+	attr->va_size = vp->v_size;
+
+	return 0;
+}
+
+static int ext2fs_readlink(struct vnode *vp, struct uio *uio)
+{
+	struct ext2fs_mount_data *md = EXT2FS_MD(vp->v_mount);
+	struct ext2fs_node *np = EXT2FS_NODE(vp);
+	__u64 pblk, count, xattr_blocks;
+	const char *target;
+	void *data;
+	size_t len;
+	int rc;
+
+	if (vp->v_type != VLNK)
+		return EINVAL;
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (uio->uio_offset >= (off_t) vp->v_size || !uio->uio_resid)
+		return 0;
+
+	len = MIN((size_t)(vp->v_size - uio->uio_offset),
+		  (size_t)uio->uio_resid);
+
+	/* Short targets are stored in place of the block map */
+	xattr_blocks = np->inode.i_file_acl_lo ? md->bsize >> 9 : 0;
+	if ((size_t)vp->v_size < sizeof(np->inode.i_block)
+	    && np->inode.i_blocks_lo == xattr_blocks) {
+		target = (const char *)np->inode.i_block;
+		return vfscore_uiomove((void *)(target + uio->uio_offset),
+				       len, uio);
+	}
+
+	if ((size_t)vp->v_size > md->bsize)
+		return EIO;
+
+	uk_mutex_lock(&md->lock);
+	rc = ext2fs_bmap(md, np, 0, 1, &pblk, &count);
+	if (!rc && !pblk)
+		rc = EIO;
+	if (!rc)
+		rc = ext2fs_bread(md, pblk, &data);
+	if (!rc)
+		rc = vfscore_uiomove((char *)data + uio->uio_offset, len, uio);
+	uk_mutex_unlock(&md->lock);
+
+	return rc;
+}
+
+static int ext2fs_inactive(struct vnode *vp)
+{
+	free(vp->v_data);
+	vp->v_data = NULL;
+
+	return 0;
+}
+
+#define ext2fs_open		((vnop_open_t)vfscore_vop_nullop)
+#define ext2fs_close		((vnop_close_t)vfscore_vop_nullop)
+#define ext2fs_write		((vnop_write_t)vfscore_vop_erofs)
+#define ext2fs_seek		((vnop_seek_t)vfscore_vop_nullop)
+#define ext2fs_ioctl		((vnop_ioctl_t)vfscore_vop_einval)
+#define ext2fs_fsync		((vnop_fsync_t)vfscore_vop_nullop)
+#define ext2fs_create		((vnop_create_t)vfscore_vop_erofs)
+#define ext2fs_remove		((vnop_remove_t)vfscore_vop_erofs)
+#define ext2fs_rename		((vnop_rename_t)vfscore_vop_erofs)
+#define ext2fs_mkdir		((vnop_mkdir_t)vfscore_vop_erofs)
+#define ext2fs_rmdir		((vnop_rmdir_t)vfscore_vop_erofs)
+#define ext2fs_setattr		((vnop_setattr_t)vfscore_vop_erofs)
+#define ext2fs_truncate		((vnop_truncate_t)vfscore_vop_erofs)
+#define ext2fs_link		((vnop_link_t)vfscore_vop_erofs)
+#ifdef CONFIG_LIBEXT2FS_PAGECACHE
+#define ext2fs_cache		vfscore_pagecache_vop
+/* Asynchronous reads would bypass the page cache */
+#define ext2fs_aread		((vnop_aread_t)NULL)
+#else /* !CONFIG_LIBEXT2FS_PAGECACHE */
+#define ext2fs_cache		((vnop_cache_t)NULL)
+#endif /* !CONFIG_LIBEXT2FS_PAGECACHE */
+#define ext2fs_fallocate	((vnop_fallocate_t)vfscore_vop_erofs)
+#define ext2fs_symlink		((vnop_symlink_t)vfscore_vop_erofs)
+#define ext2fs_poll		((vnop_poll_t)vfscore_vop_einval)
+
+struct vnops ext2fs_vnops = {
+	.vop_open	= ext2fs_open,
+	.vop_close	= ext2fs_close,
+	.vop_read	= ext2fs_read,
+	.vop_write	= ext2fs_write,
+	.vop_seek	= ext2fs_seek,
+	.vop_ioctl	= ext2fs_ioctl,
+	.vop_fsync	= ext2fs_fsync,
+	.vop_readdir	= ext2fs_readdir,
+	.vop_lookup	= ext2fs_lookup,
+	.vop_create	= ext2fs_create,
+	.vop_remove	= ext2fs_remove,
+	.vop_rename	= ext2fs_rename,
+	.vop_mkdir	= ext2fs_mkdir,
+	.vop_rmdir	= ext2fs_rmdir,
+	.vop_getattr	= ext2fs_getattr,
+	.vop_setattr	= ext2fs_setattr,
+	.vop_inactive	= ext2fs_inactive,
+	.vop_truncate	= ext2fs_truncate,
+	.vop_link	= ext2fs_link,
+	.vop_cache	= ext2fs_cache,
+	.vop_fallocate	= ext2fs_fallocate,
+	.vop_readlink	= ext2fs_readlink,
+	.vop_symlink	= ext2fs_symlink,
+	.vop_poll	= ext2fs_poll,
+	.vop_aread	= ext2fs_aread,
+};
@@ -673,4 +673,5 @@ struct vnops ramfs_vnops = {
 		ramfs_readlink,         /* read link */
 		ramfs_symlink,          /* symbolic link */
 		ramfs_poll,             /* poll */
+		(vnop_aread_t) NULL,    /* asynchronous read */
 };
@@ -46,6 +46,9 @@
 #include <uk/alloc_impl.h>
 #include <uk/arch/limits.h>
 #include <uk/arch/atomic.h>
+#include <uk/arch/spinlock.h>
+#include <uk/arch/lcpu.h>
+#include <uk/plat/lcpu.h>
 #include <uk/print.h>
 #include <uk/assert.h>
 #include <uk/page.h>
@@ -76,13 +79,58 @@ struct uk_bbpalloc_memr {
 	unsigned long *mm_alloc_bitmap;
 };
 
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+#define PCACHE_ORDERS	(CONFIG_LIBUKALLOCBBUDDY_PCACHE_MAXORDER + 1)
+#define PCACHE_HIGH	CONFIG_LIBUKALLOCBBUDDY_PCACHE_HIGH
+#define PCACHE_BATCH	CONFIG_LIBUKALLOCBBUDDY_PCACHE_BATCH
+
+UK_CTASSERT(PCACHE_BATCH <= PCACHE_HIGH);
+
+/* Hot chunks of one order, linked through chunk_head_t.next. The chunks stay
+ * marked as allocated in the bitmap, so the buddy never merges them.
+ */
+struct pcache_list {
+	chunk_head_t *head;
+	unsigned long count;
+};
+
+/* Per-lcpu cache of low-order chunks, used by its own lcpu with interrupts
+ * disabled. Its lock is only contended when another lcpu runs out of memory
+ * and drains all caches. Chunks move between a cache and the free lists in
+ * batches under the allocator lock, which nests inside the cache lock.
+ */
+struct uk_bbpalloc_pcache {
+	__spinlock lock;
+	struct pcache_list list[PCACHE_ORDERS];
+};
+
+#define PCACHE_STRIDE \
+	ALIGN_UP(sizeof(struct uk_bbpalloc_pcache), CACHE_LINE_SIZE)
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
 struct uk_bbpalloc {
+	__spinlock lock; /* protects free lists, bitmaps and nr_free_pages */
 	unsigned long nr_free_pages;
 	chunk_head_t *free_head[FREELIST_SIZE];
 	chunk_head_t free_tail[FREELIST_SIZE];
 	struct uk_bbpalloc_memr *memr_head;
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	void *pcache; /* CONFIG_UKPLAT_LCPU_MAXCOUNT caches, PCACHE_STRIDE apart */
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
 };
 
+/* Interrupts are only disabled on SMP, where the allocator lock and the
+ * per-lcpu caches must not be reentered from an interrupt handler. On
+ * uniprocessor builds the allocator keeps its previous behavior.
+ */
+#if CONFIG_HAVE_SMP
+#define bbuddy_irq_save(flags)	  ((flags) = ukplat_lcpu_save_irqf())
+#define bbuddy_irq_restore(flags) ukplat_lcpu_restore_irqf(flags)
+#else /* !CONFIG_HAVE_SMP */
+#define bbuddy_irq_save(flags)	  ((flags) = 0)
+#define bbuddy_irq_restore(flags) ((void) (flags))
+#endif /* !CONFIG_HAVE_SMP */
+
 /*********************
  * ALLOCATION BITMAP
  *  One bit per page of memory. Bit set => page is allocated.
@@ -235,25 +283,21 @@ static inline unsigned long num_pages_to_order(unsigned long num_pages)
 /*********************
  * BINARY BUDDY PAGE ALLOCATOR
  */
-static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
+
+/* Takes a chunk of 2^order pages from the free lists. Needs b->lock. */
+static chunk_head_t *bbuddy_alloc_chunk(struct uk_bbpalloc *b, size_t order)
 {
-	struct uk_bbpalloc *b;
 	size_t i;
 	chunk_head_t *alloc_ch, *spare_ch;
 	chunk_tail_t *spare_ct;
 
-	UK_ASSERT(a != NULL);
-	b = (struct uk_bbpalloc *)&a->priv;
-
-	size_t order = (size_t)num_pages_to_order(num_pages);
-
 	/* Find smallest order which can satisfy the request. */
 	for (i = order; i < FREELIST_SIZE; i++) {
 		if (!FREELIST_EMPTY(b->free_head[i]))
 			break;
 	}
 	if (i == FREELIST_SIZE)
-		goto no_memory;
+		return NULL;
 
 	/* Unlink a chunk. */
 	alloc_ch = b->free_head[i];
@@ -281,35 +325,16 @@ static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 	}
 	map_alloc(b, (uintptr_t)alloc_ch, 1UL << order);
 
-	uk_alloc_stats_count_palloc(a, (void *) alloc_ch, num_pages);
-	return ((void *)alloc_ch);
-
-no_memory:
-	uk_pr_warn("%"__PRIuptr": Cannot handle palloc request of order %"__PRIsz": Out of memory\n",
-		   (uintptr_t)a, order);
-
-	uk_alloc_stats_count_penomem(a, num_pages);
-	errno = ENOMEM;
-	return NULL;
+	return alloc_ch;
 }
 
-static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
+/* Returns a chunk of 2^order pages to the free lists. Needs b->lock. */
+static void bbuddy_free_chunk(struct uk_bbpalloc *b, void *obj, size_t order)
 {
-	struct uk_bbpalloc *b;
 	chunk_head_t *freed_ch, *to_merge_ch;
 	chunk_tail_t *freed_ct;
 	unsigned long mask;
 
-	UK_ASSERT(a != NULL);
-
-	uk_alloc_stats_count_pfree(a, obj, num_pages);
-	b = (struct uk_bbpalloc *)&a->priv;
-
-	size_t order = (size_t)num_pages_to_order(num_pages);
-
-	/* if the object is not page aligned it was clearly not from us */
-	UK_ASSERT((((uintptr_t)obj) & (__PAGE_SIZE - 1)) == 0);
-
 	/* First free the chunk */
 	map_free(b, (uintptr_t)obj, 1UL << order);
 
@@ -357,6 +382,188 @@ static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
 	b->free_head[order] = freed_ch;
 }
 
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+static inline struct uk_bbpalloc_pcache *pcache_get(struct uk_bbpalloc *b,
+						     __lcpuidx idx)
+{
+	UK_ASSERT(idx < CONFIG_UKPLAT_LCPU_MAXCOUNT);
+	return (struct uk_bbpalloc_pcache *)
+		((uintptr_t)b->pcache + idx * PCACHE_STRIDE);
+}
+
+/* Moves up to PCACHE_BATCH chunks from the free lists into a cache */
+static void pcache_refill(struct uk_bbpalloc *b, struct pcache_list *l,
+			  size_t order)
+{
+	chunk_head_t *ch;
+	unsigned int i;
+
+	ukarch_spin_lock(&b->lock);
+	for (i = 0; i < PCACHE_BATCH; i++) {
+		ch = bbuddy_alloc_chunk(b, order);
+		if (!ch)
+			break;
+		ch->next = l->head;
+		l->head = ch;
+		l->count++;
+	}
+	ukarch_spin_unlock(&b->lock);
+}
+
+/* Returns up to `count` chunks of a cache to the free lists. Needs b->lock. */
+static void pcache_flush(struct uk_bbpalloc *b, struct pcache_list *l,
+			 size_t order, unsigned long count)
+{
+	chunk_head_t *ch;
+
+	while (count-- && l->head) {
+		ch = l->head;
+		l->head = ch->next;
+		l->count--;
+		bbuddy_free_chunk(b, ch, order);
+	}
+}
+
+/* Returns all chunks of a cache to the free lists. Needs b->lock. */
+static void pcache_drain(struct uk_bbpalloc *b, struct uk_bbpalloc_pcache *pc)
+{
+	size_t order;
+
+	for (order = 0; order < PCACHE_ORDERS; order++)
+		pcache_flush(b, &pc->list[order], order,
+			     pc->list[order].count);
+}
+
+/* Returns the chunks of all caches to the free lists, so that buddies held
+ * by other lcpus can merge again. Called before an allocation fails.
+ */
+static void pcache_drain_all(struct uk_bbpalloc *b)
+{
+	struct uk_bbpalloc_pcache *pc;
+	__lcpuidx idx;
+
+	for (idx = 0; idx < CONFIG_UKPLAT_LCPU_MAXCOUNT; idx++) {
+		pc = pcache_get(b, idx);
+		ukarch_spin_lock(&pc->lock);
+		ukarch_spin_lock(&b->lock);
+		pcache_drain(b, pc);
+		ukarch_spin_unlock(&b->lock);
+		ukarch_spin_unlock(&pc->lock);
+	}
+}
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	struct uk_bbpalloc *b;
+	chunk_head_t *ch = NULL;
+	unsigned long flags;
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	struct uk_bbpalloc_pcache *pc;
+	struct pcache_list *l;
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+	UK_ASSERT(a != NULL);
+	b = (struct uk_bbpalloc *)&a->priv;
+
+	size_t order = (size_t)num_pages_to_order(num_pages);
+
+	bbuddy_irq_save(flags);
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	pc = pcache_get(b, ukplat_lcpu_idx());
+	if (order < PCACHE_ORDERS) {
+		l = &pc->list[order];
+		ukarch_spin_lock(&pc->lock);
+		if (!l->head)
+			pcache_refill(b, l, order);
+		ch = l->head;
+		if (ch) {
+			l->head = ch->next;
+			l->count--;
+		}
+		ukarch_spin_unlock(&pc->lock);
+		if (ch)
+			goto out;
+	}
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+	ukarch_spin_lock(&b->lock);
+	ch = bbuddy_alloc_chunk(b, order);
+	ukarch_spin_unlock(&b->lock);
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	if (!ch) {
+		/* The cached chunks of any lcpu may be the missing buddies */
+		pcache_drain_all(b);
+		ukarch_spin_lock(&b->lock);
+		ch = bbuddy_alloc_chunk(b, order);
+		ukarch_spin_unlock(&b->lock);
+	}
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+out:
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+	bbuddy_irq_restore(flags);
+	if (!ch)
+		goto no_memory;
+
+	uk_alloc_stats_count_palloc(a, (void *) ch, num_pages);
+	return ((void *)ch);
+
+no_memory:
+	uk_pr_warn("%"__PRIuptr": Cannot handle palloc request of order %"__PRIsz": Out of memory\n",
+		   (uintptr_t)a, order);
+
+	uk_alloc_stats_count_penomem(a, num_pages);
+	errno = ENOMEM;
+	return NULL;
+}
+
+static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
+{
+	struct uk_bbpalloc *b;
+	unsigned long flags;
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	struct uk_bbpalloc_pcache *pc;
+	struct pcache_list *l;
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+	UK_ASSERT(a != NULL);
+
+	uk_alloc_stats_count_pfree(a, obj, num_pages);
+	b = (struct uk_bbpalloc *)&a->priv;
+
+	size_t order = (size_t)num_pages_to_order(num_pages);
+
+	/* if the object is not page aligned it was clearly not from us */
+	UK_ASSERT((((uintptr_t)obj) & (__PAGE_SIZE - 1)) == 0);
+
+	bbuddy_irq_save(flags);
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	if (order < PCACHE_ORDERS) {
+		pc = pcache_get(b, ukplat_lcpu_idx());
+		l = &pc->list[order];
+		ukarch_spin_lock(&pc->lock);
+		if (l->count >= PCACHE_HIGH) {
+			ukarch_spin_lock(&b->lock);
+			pcache_flush(b, l, order, PCACHE_BATCH);
+			ukarch_spin_unlock(&b->lock);
+		}
+		((chunk_head_t *)obj)->next = l->head;
+		l->head = (chunk_head_t *)obj;
+		l->count++;
+		ukarch_spin_unlock(&pc->lock);
+		bbuddy_irq_restore(flags);
+		return;
+	}
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+	ukarch_spin_lock(&b->lock);
+	bbuddy_free_chunk(b, obj, order);
+	ukarch_spin_unlock(&b->lock);
+	bbuddy_irq_restore(flags);
+}
+
 static long bbuddy_pmaxalloc(struct uk_alloc *a)
 {
 	struct uk_bbpalloc *b;
@@ -380,11 +587,31 @@ static long bbuddy_pmaxalloc(struct uk_alloc *a)
 static long bbuddy_pavailmem(struct uk_alloc *a)
 {
 	struct uk_bbpalloc *b;
+	long nr_pages;
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	struct uk_bbpalloc_pcache *pc;
+	__lcpuidx idx;
+	size_t order;
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
 
 	UK_ASSERT(a != NULL);
 	b = (struct uk_bbpalloc *)&a->priv;
 
-	return (long) b->nr_free_pages;
+	nr_pages = (long) b->nr_free_pages;
+
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	/* Cached chunks are free as well. The caches of other lcpus are read
+	 * without synchronization, so the result is only a snapshot.
+	 */
+	for (idx = 0; idx < CONFIG_UKPLAT_LCPU_MAXCOUNT; idx++) {
+		pc = pcache_get(b, idx);
+		for (order = 0; order < PCACHE_ORDERS; order++)
+			nr_pages += (long) (UK_READ_ONCE(pc->list[order].count)
+					    << order);
+	}
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
+
+	return nr_pages;
 }
 
 static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
@@ -396,6 +623,7 @@ static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 	chunk_head_t *ch;
 	chunk_tail_t *ct;
 	uintptr_t min, max, range;
+	unsigned long flags;
 
 	UK_ASSERT(a != NULL);
 	UK_ASSERT(base != NULL);
@@ -447,6 +675,10 @@ static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 	 * Initialize region's bitmap
 	 */
 	memr->first_page = min;
+
+	bbuddy_irq_save(flags);
+	ukarch_spin_lock(&b->lock);
+
 	/* add to list */
 	memr->next = b->memr_head;
 	b->memr_head = memr;
@@ -486,6 +718,8 @@ static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 		count++;
 	}
 
+	ukarch_spin_unlock(&b->lock);
+	bbuddy_irq_restore(flags);
 	return 0;
 }
 
@@ -502,7 +736,12 @@ struct uk_alloc *uk_allocbbuddy_init(void *base, size_t len)
 	UK_ASSERT(max > min);
 
 	/* Allocate space for allocator descriptor */
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	metalen = round_pgup(ALIGN_UP(sizeof(*a) + sizeof(*b), CACHE_LINE_SIZE)
+			     + CONFIG_UKPLAT_LCPU_MAXCOUNT * PCACHE_STRIDE);
+#else /* !CONFIG_LIBUKALLOCBBUDDY_PCACHE */
 	metalen = round_pgup(sizeof(*a) + sizeof(*b));
+#endif /* !CONFIG_LIBUKALLOCBBUDDY_PCACHE */
 
 	/* enough space for allocator available? */
 	if (min + metalen > max) {
@@ -524,6 +763,14 @@ struct uk_alloc *uk_allocbbuddy_init(void *base, size_t len)
 		b->free_tail[i].next = NULL;
 	}
 	b->memr_head = NULL;
+	ukarch_spin_init(&b->lock);
+#if CONFIG_LIBUKALLOCBBUDDY_PCACHE
+	/* memset() above left all caches empty */
+	b->pcache = (void *)ALIGN_UP((uintptr_t)a + sizeof(*a) + sizeof(*b),
+				     CACHE_LINE_SIZE);
+	for (i = 0; i < CONFIG_UKPLAT_LCPU_MAXCOUNT; i++)
+		ukarch_spin_init(&pcache_get(b, i)->lock);
+#endif /* CONFIG_LIBUKALLOCBBUDDY_PCACHE */
 
 	/* initialize and register allocator interface */
 	uk_alloc_init_palloc(a, bbuddy_palloc, bbuddy_pfree,
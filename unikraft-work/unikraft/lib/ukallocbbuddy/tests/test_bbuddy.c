@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/allocbbuddy.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+#include <uk/arch/atomic.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/time.h>
+
+/* The tests run on a private buddy allocator so that the page counts are not
+ * disturbed by other users. It stays registered afterwards, there is no way
+ * to unregister from ukalloc.
+ */
+#define TEST_PAGES		256
+#define BENCH_LIVE		8	/* pages held per lcpu and round */
+#define BENCH_ROUNDS		4096
+#define BENCH_MAX_LCPUS		4
+#define BENCH_STACK_PAGES	4
+
+static struct uk_alloc *pa;
+
+struct bench_result {
+	__nsec ns;
+} __align(CACHE_LINE_SIZE);
+
+static struct bench_result results[CONFIG_UKPLAT_LCPU_MAXCOUNT];
+static int bench_go;
+static __u32 bench_lcpus = 1;
+
+#if CONFIG_HAVE_SMP
+static void *bench_sp[CONFIG_UKPLAT_LCPU_MAXCOUNT];
+
+/* Secondary lcpus wait in idle state for the benchmark function */
+static void bench_start_lcpus(void)
+{
+	__u32 i, count = ukplat_lcpu_count();
+	void *stack;
+
+	for (i = 0; i < count - 1; i++) {
+		stack = uk_palloc(uk_alloc_get_default(), BENCH_STACK_PAGES);
+		if (!stack)
+			return;
+		bench_sp[i] = (void *)((__uptr) stack
+				       + (BENCH_STACK_PAGES << __PAGE_SHIFT));
+	}
+
+	/* Fails for lcpus that someone else started already, which is fine */
+	ukplat_lcpu_start(NULL, NULL, bench_sp, NULL, 0);
+	bench_lcpus = MIN(count, (__u32) BENCH_MAX_LCPUS);
+}
+#endif /* CONFIG_HAVE_SMP */
+
+static int bbuddy_test_init(struct uk_testsuite *suite __unused)
+{
+	void *mem;
+
+	mem = uk_palloc(uk_alloc_get_default(), TEST_PAGES);
+	if (!mem)
+		return -ENOMEM;
+
+	pa = uk_allocbbuddy_init(mem, TEST_PAGES << __PAGE_SHIFT);
+	if (!pa)
+		return -ENOMEM;
+
+#if CONFIG_HAVE_SMP
+	bench_start_lcpus();
+#endif /* CONFIG_HAVE_SMP */
+	return 0;
+}
+
+UK_TESTCASE(ukallocbbuddy, palloc_orders)
+{
+	void *pages[5];
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(pages); i++) {
+		pages[i] = uk_palloc(pa, 1UL << i);
+		UK_TEST_EXPECT_NOT_NULL(pages[i]);
+		UK_TEST_EXPECT_ZERO((__uptr) pages[i] & (__PAGE_SIZE - 1));
+		memset(pages[i], (int) i, (1UL << i) << __PAGE_SHIFT);
+	}
+
+	/* chunks must not overlap */
+	for (i = 0; i < ARRAY_SIZE(pages); i++) {
+		UK_TEST_EXPECT_SNUM_EQ(((__u8 *) pages[i])[0], i);
+		UK_TEST_EXPECT_SNUM_EQ(((__u8 *) pages[i])
+				       [((1UL << i) << __PAGE_SHIFT) - 1], i);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pages); i++)
+		uk_pfree(pa, pages[i], 1UL << i);
+}
+
+UK_TESTCASE(ukallocbbuddy, pavailmem_counts_cached)
+{
+	void *pages[BENCH_LIVE];
+	long before;
+	unsigned int i;
+
+	before = uk_alloc_pavailmem(pa);
+	for (i = 0; i < ARRAY_SIZE(pages); i++) {
+		pages[i] = uk_palloc(pa, 1);
+		UK_TEST_EXPECT_NOT_NULL(pages[i]);
+	}
+	UK_TEST_EXPECT_SNUM_EQ(uk_alloc_pavailmem(pa),
+			       before - (long) ARRAY_SIZE(pages));
+
+	for (i = 0; i < ARRAY_SIZE(pages); i++)
+		uk_pfree(pa, pages[i], 1);
+	UK_TEST_EXPECT_SNUM_EQ(uk_alloc_pavailmem(pa), before);
+}
+
+/* After single pages were spread over the caches, a large allocation must
+ * still find its buddies.
+ */
+UK_TESTCASE(ukallocbbuddy, exhaust_and_merge)
+{
+	static void *pages[TEST_PAGES];
+	long maxalloc, avail;
+	unsigned int i, n;
+	void *big;
+
+	maxalloc = uk_alloc_pmaxalloc(pa);
+	avail = uk_alloc_pavailmem(pa);
+
+	for (n = 0; n < ARRAY_SIZE(pages); n++) {
+		pages[n] = uk_palloc(pa, 1);
+		if (!pages[n])
+			break;
+	}
+	UK_TEST_EXPECT_SNUM_EQ(n, avail);
+	UK_TEST_EXPECT_ZERO(uk_alloc_pavailmem(pa));
+
+	for (i = 0; i < n; i++)
+		uk_pfree(pa, pages[i], 1);
+	UK_TEST_EXPECT_SNUM_EQ(uk_alloc_pavailmem(pa), avail);
+
+	big = uk_palloc(pa, maxalloc);
+	UK_TEST_EXPECT_NOT_NULL(big);
+	uk_pfree(pa, big, maxalloc);
+}
+
+static void bench_loop(void)
+{
+	void *pages[BENCH_LIVE];
+	unsigned int r, i;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	for (r = 0; r < BENCH_ROUNDS; r++) {
+		for (i = 0; i < BENCH_LIVE; i++)
+			pages[i] = uk_palloc(pa, 1);
+		for (i = 0; i < BENCH_LIVE; i++)
+			uk_pfree(pa, pages[i], 1);
+	}
+	results[ukplat_lcpu_idx()].ns = ukplat_monotonic_clock() - start;
+}
+
+#if CONFIG_HAVE_SMP
+static void bench_lcpu_fn(struct __regs *regs __unused, void *arg __unused)
+{
+	while (!UK_READ_ONCE(bench_go))
+		;
+	bench_loop();
+}
+#endif /* CONFIG_HAVE_SMP */
+
+/* Runs the same alloc/free loop on 1..bench_lcpus lcpus concurrently and
+ * reports the aggregated throughput.
+ */
+UK_TESTCASE(ukallocbbuddy, bench_scaling)
+{
+	__u64 ops;
+	__nsec ns;
+	__u32 n, i;
+#if CONFIG_HAVE_SMP
+	const struct ukplat_lcpu_func fn = { .fn = bench_lcpu_fn };
+	__lcpuidx idx[BENCH_MAX_LCPUS];
+	unsigned int num;
+	__u32 self = ukplat_lcpu_idx();
+	int rc;
+#endif /* CONFIG_HAVE_SMP */
+
+	for (n = 1; n <= bench_lcpus; n++) {
+		UK_WRITE_ONCE(bench_go, 0);
+		memset(results, 0, sizeof(results));
+
+#if CONFIG_HAVE_SMP
+		for (i = 0, num = 0; num < n - 1; i++)
+			if (i != self)
+				idx[num++] = i;
+		if (num) {
+			rc = ukplat_lcpu_run(idx, &num, &fn, 0);
+			UK_TEST_EXPECT_ZERO(rc);
+		}
+#endif /* CONFIG_HAVE_SMP */
+
+		UK_WRITE_ONCE(bench_go, 1);
+		bench_loop();
+
+#if CONFIG_HAVE_SMP
+		if (num)
+			ukplat_lcpu_wait(idx, &num, 0);
+#endif /* CONFIG_HAVE_SMP */
+
+		ns = 0;
+		for (i = 0; i < ARRAY_SIZE(results); i++)
+			ns = MAX(ns, results[i].ns);
+		ops = (__u64) n * BENCH_ROUNDS * BENCH_LIVE * 2;
+
+		uk_pr_info("%"__PRIu32" lcpu(s): %"__PRIu64" ops in %"__PRInsec" ns, %"__PRIu64" ops/ms\n",
+			   n, ops, ns, (ns) ? ops * 1000000 / ns : 0);
+		UK_TEST_EXPECT_SNUM_GT(ns, 0);
+	}
+}
+
+uk_testsuite_register(ukallocbbuddy, bbuddy_test_init);
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UKALLOCSLAB_H__
+#define __UKALLOCSLAB_H__
+
+#include <uk/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes a slab allocator on a given memory range. A binary buddy
+ * allocator is set up on the range as parent page allocator. The slab
+ * allocator is registered before its parent so that it becomes the default
+ * allocator when it is the first one being initialized. With
+ * CONFIG_LIBUKALLOCSLAB_TCACHE, the first slab allocator initialized with
+ * this function additionally serves small allocations from thread caches.
+ *
+ * @param base
+ *  Base address of memory range.
+ * @param len
+ *  Length of memory range (bytes).
+ * @return
+ *  - (NULL): Not enough memory for the allocator.
+ *  - pointer to the uk_alloc interface of the slab allocator.
+ */
+struct uk_alloc *uk_allocslab_init(void *base, __sz len);
+
+/**
+ * Creates a slab allocator on top of an existing page allocator. The
+ * descriptor of the slab allocator is allocated from the parent.
+ *
+ * @param parent
+ *  Allocator that provides pages with uk_palloc() and uk_pfree().
+ * @return
+ *  - (NULL): If allocation failed (e.g., ENOMEM).
+ *  - pointer to the uk_alloc interface of the slab allocator.
+ */
+struct uk_alloc *uk_allocslab_create(struct uk_alloc *parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UKALLOCSLAB_H__ */
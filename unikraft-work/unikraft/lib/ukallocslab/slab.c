@@ -0,0 +1,722 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/* ukallocslab serves small allocations from per-size-class slabs.
+ *
+ * Every slab is a single page obtained from a parent page allocator. The
+ * page starts with a `struct slab` header, followed by equally sized objects
+ * of one size class. Because objects never start at a page boundary, the
+ * header of any object is found by rounding the object address minus one
+ * down to the page boundary, so free() needs no per-object metadata.
+ * Requests larger than the biggest size class are served with whole pages
+ * from the parent, using the same header layout with class SLAB_CLASS_LARGE.
+ *
+ * Free objects of a slab are kept in a LIFO list threaded through the
+ * objects themselves. A fresh slab is not carved up front: objects that were
+ * never handed out are taken from a bump pointer instead. Slabs that have
+ * free objects are linked on the partial list of their class, so allocation
+ * and free are O(1). Each class keeps at most one completely free slab
+ * cached; further empty slabs are returned to the parent right away.
+ *
+ * The slabs and free lists are shared and protected by a spinlock. With
+ * CONFIG_LIBUKALLOCSLAB_TCACHE, every thread additionally keeps a small
+ * stack of free objects per size class for the allocator that serves the
+ * heap. Allocations and frees are served from it without touching shared
+ * state; it is refilled from and flushed to the slabs in batches, and
+ * returned completely when the thread exits.
+ *
+ *          ++----------------++  <- page boundary
+ *          ||  struct slab   ||
+ *          ++----------------++  <- SLAB_HDR_SIZE
+ *          |     object 0     |
+ *          +------------------+
+ *          |     object 1     |
+ *          +------------------+
+ *          |       ...        |
+ *          v                  v
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <uk/allocslab.h>
+#include <uk/allocbbuddy.h>
+#include <uk/alloc_impl.h>
+#include <uk/arch/spinlock.h>
+#include <uk/plat/lcpu.h>
+#include <uk/essentials.h>
+#include <uk/list.h>
+#include <uk/print.h>
+#include <uk/page.h>
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+#include <uk/thread.h>
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+#define SLAB_HDR_SIZE		64
+#define SLAB_MIN_ALIGN		16
+#define SLAB_MAX_ALIGN		SLAB_HDR_SIZE
+#define SLAB_MAX_SIZE		1024
+#define SLAB_MAGIC		0x51ab
+#define SLAB_CLASS_LARGE	0xffff
+
+#define size_to_num_pages(size) \
+	(ALIGN_UP((unsigned long)(size), __PAGE_SIZE) / __PAGE_SIZE)
+
+/* Power-of-two classes with one intermediate class in between, so that the
+ * internal fragmentation of an object stays below 50% (33% above 32 B).
+ * All sizes are multiples of SLAB_MIN_ALIGN.
+ */
+static const __u16 slab_class_size[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+#define SLAB_NUM_CLASSES	ARRAY_SIZE(slab_class_size)
+#define SLAB_LUT_SIZE		((SLAB_MAX_SIZE / SLAB_MIN_ALIGN) + 1)
+
+struct slab {
+	__u16 magic;
+	__u16 cls;	/* size class index or SLAB_CLASS_LARGE */
+	__u16 inuse;	/* objects handed out */
+	__u16 left;	/* objects that were never handed out */
+	union {
+		struct {
+			struct uk_list_head list; /* partial list of class */
+			void *free;	/* released objects */
+			void *unused;	/* next never handed out object */
+		};
+		struct {
+			__sz size;
+			unsigned long num_pages;
+			void *base;
+		};
+	};
+};
+
+UK_CTASSERT(sizeof(struct slab) <= SLAB_HDR_SIZE);
+
+struct slab_class {
+	struct uk_list_head partial;	/* slabs with free objects */
+	struct slab *empty;		/* cached completely free slab */
+	__sz size;
+	__u16 cap;			/* objects per slab */
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	__u16 tcap;			/* objects per thread cache */
+	__u16 tbatch;			/* objects per refill or flush */
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+};
+
+struct uk_allocslab {
+	struct uk_alloc self;
+
+	struct uk_alloc *parent;
+	__spinlock lock;		/* protects classes and free_bytes */
+	struct slab_class classes[SLAB_NUM_CLASSES];
+	__u8 lut[SLAB_LUT_SIZE];	/* size / SLAB_MIN_ALIGN -> class */
+	__sz free_bytes;		/* free object space in slabs */
+};
+
+#if CONFIG_HAVE_SMP
+#define slab_irq_save(flags)	((flags) = ukplat_lcpu_save_irqf())
+#define slab_irq_restore(flags)	ukplat_lcpu_restore_irqf(flags)
+#else /* !CONFIG_HAVE_SMP */
+#define slab_irq_save(flags)	((flags) = 0)
+#define slab_irq_restore(flags)	((void) (flags))
+#endif /* !CONFIG_HAVE_SMP */
+
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+struct slab_tcache {
+	unsigned int nr[SLAB_NUM_CLASSES];
+	void *objs[SLAB_NUM_CLASSES][CONFIG_LIBUKALLOCSLAB_TCACHE_SIZE];
+};
+
+/* Set after the thread cache was returned on thread exit, so that frees
+ * by later termination callbacks do not create a new one that leaks.
+ */
+#define SLAB_TCACHE_DEAD	((struct slab_tcache *) 1)
+
+/* Only the allocator that serves the heap has thread caches */
+static struct uk_allocslab *slab_tcache_owner;
+static __uk_tls struct slab_tcache *slab_tcache;
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+static inline struct uk_allocslab *ukalloc2slab(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return __containerof(a, struct uk_allocslab, self);
+}
+
+static inline struct slab *slab_of(const void *ptr)
+{
+	struct slab *slab;
+
+	slab = (struct slab *) ALIGN_DOWN((__uptr) ptr - 1,
+					  (__uptr) __PAGE_SIZE);
+	UK_ASSERT(slab->magic == SLAB_MAGIC);
+	return slab;
+}
+
+static inline unsigned int slab_size2class(struct uk_allocslab *s, __sz size)
+{
+	UK_ASSERT(size <= SLAB_MAX_SIZE);
+	return s->lut[DIV_ROUND_UP(size, SLAB_MIN_ALIGN)];
+}
+
+static struct slab *slab_new(struct uk_allocslab *s, unsigned int cls)
+{
+	struct slab_class *c = &s->classes[cls];
+	struct slab *slab;
+
+	slab = uk_palloc(s->parent, 1);
+	if (unlikely(!slab))
+		return NULL;
+
+	slab->magic  = SLAB_MAGIC;
+	slab->cls    = cls;
+	slab->inuse  = 0;
+	slab->left   = c->cap;
+	slab->free   = NULL;
+	slab->unused = (void *)((__uptr) slab + SLAB_HDR_SIZE);
+
+	s->free_bytes += c->cap * c->size;
+	return slab;
+}
+
+static void slab_release(struct uk_allocslab *s, struct slab *slab)
+{
+	struct slab_class *c = &s->classes[slab->cls];
+
+	UK_ASSERT(slab->inuse == 0);
+
+	s->free_bytes -= c->cap * c->size;
+	slab->magic = 0;
+	uk_pfree(s->parent, slab, 1);
+}
+
+static void *slab_take(struct uk_allocslab *s, unsigned int cls)
+{
+	struct slab_class *c = &s->classes[cls];
+	struct slab *slab;
+	void *obj;
+
+	if (unlikely(uk_list_empty(&c->partial))) {
+		slab = slab_new(s, cls);
+		if (unlikely(!slab))
+			return NULL;
+		uk_list_add(&slab->list, &c->partial);
+	}
+
+	slab = uk_list_first_entry(&c->partial, struct slab, list);
+	if (slab == c->empty)
+		c->empty = NULL;
+
+	if (slab->free) {
+		obj = slab->free;
+		slab->free = *((void **) obj);
+	} else {
+		UK_ASSERT(slab->left > 0);
+		obj = slab->unused;
+		slab->unused = (void *)((__uptr) obj + c->size);
+		slab->left--;
+	}
+
+	/* full slabs are not tracked until an object is returned */
+	if (++slab->inuse == c->cap)
+		uk_list_del(&slab->list);
+
+	s->free_bytes -= c->size;
+	return obj;
+}
+
+static void slab_put(struct uk_allocslab *s, struct slab *slab, void *obj)
+{
+	struct slab_class *c = &s->classes[slab->cls];
+
+	UK_ASSERT(slab->inuse > 0);
+
+	*((void **) obj) = slab->free;
+	slab->free = obj;
+	s->free_bytes += c->size;
+
+	if (slab->inuse-- == c->cap)
+		uk_list_add(&slab->list, &c->partial);
+
+	if (slab->inuse > 0)
+		return;
+
+	/* keep one empty slab per class to absorb alloc/free ping-pong */
+	if (!c->empty) {
+		c->empty = slab;
+		return;
+	}
+	uk_list_del(&slab->list);
+	slab_release(s, slab);
+}
+
+static void *slab_large_alloc(struct uk_allocslab *s, __sz align, __sz size)
+{
+	struct slab *hdr;
+	unsigned long num_pages;
+	__uptr base, intptr;
+	__sz realsize;
+
+	/* Room for the header in front of the object, plus `align` more
+	 * bytes in order to find an aligned pointer preceding `size` bytes.
+	 */
+	realsize = size + SLAB_HDR_SIZE + ((align > SLAB_HDR_SIZE) ? align : 0);
+	if (unlikely(realsize < size))
+		return NULL;
+
+	num_pages = size_to_num_pages(realsize);
+	base = (__uptr) uk_palloc(s->parent, num_pages);
+	if (unlikely(!base))
+		return NULL;
+
+	intptr = ALIGN_UP(base + SLAB_HDR_SIZE, (__uptr) align);
+	hdr = (struct slab *) ALIGN_DOWN(intptr - 1, (__uptr) __PAGE_SIZE);
+	UK_ASSERT((__uptr) hdr >= base);
+
+	hdr->magic     = SLAB_MAGIC;
+	hdr->cls       = SLAB_CLASS_LARGE;
+	hdr->size      = size;
+	hdr->num_pages = num_pages;
+	hdr->base      = (void *) base;
+	return (void *) intptr;
+}
+
+static void slab_large_free(struct uk_allocslab *s, struct slab *hdr)
+{
+	UK_ASSERT(hdr->cls == SLAB_CLASS_LARGE);
+
+	hdr->magic = 0;
+	uk_pfree(s->parent, hdr->base, hdr->num_pages);
+}
+
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+static struct slab_tcache *slab_tcache_get(struct uk_allocslab *s)
+{
+	struct uk_thread *t = uk_thread_current();
+	struct slab_tcache *tc;
+
+	/* Early boot allocations happen before any UKTLS is set up */
+	if (s != slab_tcache_owner || !t || !(t->flags & UK_THREADF_UKTLS))
+		return NULL;
+
+	tc = slab_tcache;
+	if (likely(tc))
+		return (tc == SLAB_TCACHE_DEAD) ? NULL : tc;
+
+	/* Page allocations do not touch the shared slab state */
+	tc = slab_large_alloc(s, SLAB_MIN_ALIGN, sizeof(*tc));
+	if (unlikely(!tc))
+		return NULL;
+	memset(tc->nr, 0, sizeof(tc->nr));
+	slab_tcache = tc;
+	return tc;
+}
+
+/* Must be called with the allocator lock held */
+static void slab_tcache_put(struct uk_allocslab *s, void **objs,
+			    unsigned int num)
+{
+	unsigned int i;
+
+	for (i = 0; i < num; ++i)
+		slab_put(s, slab_of(objs[i]), objs[i]);
+}
+
+static void slab_tcache_term(struct uk_thread *child __unused)
+{
+	struct uk_allocslab *s = slab_tcache_owner;
+	struct slab_tcache *tc = slab_tcache;
+	unsigned long flags;
+	unsigned int cls;
+
+	/* NOTE: Termination callbacks run with the TLS of the child */
+	slab_tcache = SLAB_TCACHE_DEAD;
+	if (!tc || tc == SLAB_TCACHE_DEAD)
+		return;
+
+	slab_irq_save(flags);
+	ukarch_spin_lock(&s->lock);
+	for (cls = 0; cls < SLAB_NUM_CLASSES; ++cls)
+		slab_tcache_put(s, tc->objs[cls], tc->nr[cls]);
+	ukarch_spin_unlock(&s->lock);
+	slab_irq_restore(flags);
+
+	slab_large_free(s, slab_of(tc));
+}
+
+UK_THREAD_INIT_PRIO_FLAGS(0x0, slab_tcache_term, UK_PRIO_EARLIEST,
+			  UK_THREAD_INITF_UKTLS);
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+static void *slab_alloc_obj(struct uk_allocslab *s, unsigned int cls)
+{
+	unsigned long flags;
+	void *obj;
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	struct slab_class *c = &s->classes[cls];
+	struct slab_tcache *tc;
+
+	tc = slab_tcache_get(s);
+	if (tc) {
+		/* An interrupt on this CPU may run on the same thread cache */
+		slab_irq_save(flags);
+		if (unlikely(!tc->nr[cls])) {
+			ukarch_spin_lock(&s->lock);
+			while (tc->nr[cls] < c->tbatch) {
+				obj = slab_take(s, cls);
+				if (unlikely(!obj))
+					break;
+				tc->objs[cls][tc->nr[cls]++] = obj;
+			}
+			ukarch_spin_unlock(&s->lock);
+		}
+		obj = likely(tc->nr[cls]) ? tc->objs[cls][--tc->nr[cls]]
+					  : NULL;
+		slab_irq_restore(flags);
+		return obj;
+	}
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+	slab_irq_save(flags);
+	ukarch_spin_lock(&s->lock);
+	obj = slab_take(s, cls);
+	ukarch_spin_unlock(&s->lock);
+	slab_irq_restore(flags);
+	return obj;
+}
+
+static void slab_free_obj(struct uk_allocslab *s, struct slab *slab,
+			  void *obj)
+{
+	unsigned long flags;
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	struct slab_class *c = &s->classes[slab->cls];
+	unsigned int cls = slab->cls;
+	struct slab_tcache *tc;
+
+	tc = slab_tcache_get(s);
+	if (tc) {
+		slab_irq_save(flags);
+		if (unlikely(tc->nr[cls] == c->tcap)) {
+			/* Return the least recently freed objects */
+			ukarch_spin_lock(&s->lock);
+			slab_tcache_put(s, tc->objs[cls], c->tbatch);
+			ukarch_spin_unlock(&s->lock);
+
+			tc->nr[cls] -= c->tbatch;
+			memmove(&tc->objs[cls][0], &tc->objs[cls][c->tbatch],
+				tc->nr[cls] * sizeof(void *));
+		}
+		tc->objs[cls][tc->nr[cls]++] = obj;
+		slab_irq_restore(flags);
+		return;
+	}
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+	slab_irq_save(flags);
+	ukarch_spin_lock(&s->lock);
+	slab_put(s, slab, obj);
+	ukarch_spin_unlock(&s->lock);
+	slab_irq_restore(flags);
+}
+
+static __sz slab_usable_size(struct uk_allocslab *s, const void *ptr)
+{
+	struct slab *slab = slab_of(ptr);
+
+	if (slab->cls == SLAB_CLASS_LARGE)
+		return (__uptr) slab->base + (slab->num_pages << __PAGE_SHIFT)
+		       - (__uptr) ptr;
+	return s->classes[slab->cls].size;
+}
+
+static void *slab_malloc(struct uk_alloc *a, __sz size)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	unsigned int cls;
+	void *ptr;
+
+	if (unlikely(!size))
+		return NULL;
+
+	if (likely(size <= SLAB_MAX_SIZE)) {
+		cls = slab_size2class(s, size);
+		ptr = slab_alloc_obj(s, cls);
+		uk_alloc_stats_count_alloc(a, ptr, s->classes[cls].size);
+		return ptr;
+	}
+
+	ptr = slab_large_alloc(s, SLAB_MIN_ALIGN, size);
+	uk_alloc_stats_count_alloc(a, ptr, size);
+	return ptr;
+}
+
+static void slab_free(struct uk_alloc *a, void *ptr)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	struct slab *slab;
+
+	if (unlikely(!ptr))
+		return;
+
+	slab = slab_of(ptr);
+	if (slab->cls == SLAB_CLASS_LARGE) {
+		uk_alloc_stats_count_free(a, ptr, slab->size);
+		slab_large_free(s, slab);
+		return;
+	}
+
+	UK_ASSERT(slab->cls < SLAB_NUM_CLASSES);
+	UK_ASSERT(((__uptr) ptr - (__uptr) slab - SLAB_HDR_SIZE)
+		  % s->classes[slab->cls].size == 0);
+
+	uk_alloc_stats_count_free(a, ptr, s->classes[slab->cls].size);
+	slab_free_obj(s, slab, ptr);
+}
+
+static int slab_posix_memalign(struct uk_alloc *a, void **memptr,
+			       __sz align, __sz size)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	unsigned int cls;
+	void *ptr = NULL;
+
+	if (((align - 1) & align) != 0
+	    || (align % sizeof(void *)) != 0)
+		return EINVAL;
+
+	/* Same as ifpages: leave memptr untouched for a size of zero */
+	if (!size)
+		return EINVAL;
+
+	/* Objects start SLAB_HDR_SIZE-aligned in their slab, so every class
+	 * whose size is a multiple of `align` yields aligned objects.
+	 */
+	if (size <= SLAB_MAX_SIZE && align <= SLAB_MAX_ALIGN) {
+		cls = slab_size2class(s, size);
+		while (slab_class_size[cls] % align)
+			cls++;
+		UK_ASSERT(cls < SLAB_NUM_CLASSES);
+
+		ptr = slab_alloc_obj(s, cls);
+		uk_alloc_stats_count_alloc(a, ptr, s->classes[cls].size);
+	} else {
+		ptr = slab_large_alloc(s, MAX(align, (__sz) SLAB_MIN_ALIGN),
+				       size);
+		uk_alloc_stats_count_alloc(a, ptr, size);
+	}
+
+	if (unlikely(!ptr))
+		return ENOMEM;
+
+	*memptr = ptr;
+	return 0;
+}
+
+static void *slab_realloc(struct uk_alloc *a, void *ptr, __sz size)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	struct slab *slab;
+	void *retptr;
+	__sz usable;
+
+	if (!ptr)
+		return slab_malloc(a, size);
+
+	if (!size) {
+		slab_free(a, ptr);
+		return NULL;
+	}
+
+	/* Keep the object if it is in the class that would be chosen anyway
+	 * or, for page allocations, if no page would be released.
+	 */
+	slab = slab_of(ptr);
+	usable = slab_usable_size(s, ptr);
+	if (slab->cls == SLAB_CLASS_LARGE) {
+		if (size > SLAB_MAX_SIZE && size <= usable
+		    && usable - size < __PAGE_SIZE)
+			return ptr;
+	} else if (size <= SLAB_MAX_SIZE
+		   && slab_size2class(s, size) == slab->cls) {
+		return ptr;
+	}
+
+	retptr = slab_malloc(a, size);
+	if (unlikely(!retptr))
+		return NULL;
+
+	memcpy(retptr, ptr, MIN(size, usable));
+	slab_free(a, ptr);
+	return retptr;
+}
+
+static void *slab_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	void *ptr;
+
+	ptr = uk_palloc(s->parent, num_pages);
+	uk_alloc_stats_count_palloc(a, ptr, num_pages);
+	return ptr;
+}
+
+static void slab_pfree(struct uk_alloc *a, void *ptr, unsigned long num_pages)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+
+	uk_alloc_stats_count_pfree(a, ptr, num_pages);
+	uk_pfree(s->parent, ptr, num_pages);
+}
+
+/* NOTE: Memory that is still free in the parent is reported by the parent
+ *       itself. We only report what is cached in our slabs so that
+ *       uk_alloc_availmem_total() does not count the parent twice.
+ *       Objects held in thread caches count as allocated.
+ */
+static __ssz slab_availmem(struct uk_alloc *a)
+{
+	return (__ssz) ukalloc2slab(a)->free_bytes;
+}
+
+static long slab_pavailmem(struct uk_alloc *a)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	long count = 0;
+	unsigned int i;
+
+	for (i = 0; i < SLAB_NUM_CLASSES; ++i)
+		if (s->classes[i].empty)
+			count++;
+	return count;
+}
+
+static long slab_pmaxalloc(struct uk_alloc *a)
+{
+	return uk_alloc_pmaxalloc(ukalloc2slab(a)->parent);
+}
+
+static __ssz slab_maxalloc(struct uk_alloc *a)
+{
+	long num_pages;
+
+	num_pages = slab_pmaxalloc(a);
+	if (num_pages < 0)
+		return (__ssz) num_pages;
+	if (num_pages == 0)
+		return 0;
+	return (((__ssz) num_pages) << __PAGE_SHIFT) - SLAB_HDR_SIZE;
+}
+
+static int slab_addmem(struct uk_alloc *a, void *base, __sz len)
+{
+	return uk_alloc_addmem(ukalloc2slab(a)->parent, base, len);
+}
+
+static struct uk_alloc *allocslab_setup(struct uk_allocslab *s,
+					struct uk_alloc *parent)
+{
+	struct uk_alloc *a = &s->self;
+	unsigned int i, cls;
+
+	s->parent = parent;
+	s->free_bytes = 0;
+	ukarch_spin_init(&s->lock);
+
+	for (i = 0; i < SLAB_NUM_CLASSES; ++i) {
+		UK_INIT_LIST_HEAD(&s->classes[i].partial);
+		s->classes[i].empty = NULL;
+		s->classes[i].size  = slab_class_size[i];
+		s->classes[i].cap   = (__PAGE_SIZE - SLAB_HDR_SIZE)
+				      / slab_class_size[i];
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+		/* Do not hold more than a slab worth of objects per class */
+		s->classes[i].tcap  = MIN(s->classes[i].cap,
+					  CONFIG_LIBUKALLOCSLAB_TCACHE_SIZE);
+		s->classes[i].tbatch = (s->classes[i].tcap + 1) / 2;
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+	}
+
+	for (i = 0, cls = 0; i < SLAB_LUT_SIZE; ++i) {
+		while (slab_class_size[cls] < i * SLAB_MIN_ALIGN)
+			cls++;
+		s->lut[i] = cls;
+	}
+
+	a->malloc         = slab_malloc;
+	a->calloc         = uk_calloc_compat;
+	a->realloc        = slab_realloc;
+	a->posix_memalign = slab_posix_memalign;
+	a->memalign       = uk_memalign_compat;
+	a->free           = slab_free;
+	a->palloc         = slab_palloc;
+	a->pfree          = slab_pfree;
+	a->availmem       = slab_availmem;
+	a->pavailmem      = slab_pavailmem;
+	a->maxalloc       = slab_maxalloc;
+	a->pmaxalloc      = slab_pmaxalloc;
+	a->addmem         = slab_addmem;
+
+	uk_alloc_stats_reset(a);
+	uk_alloc_register(a);
+	return a;
+}
+
+struct uk_alloc *uk_allocslab_create(struct uk_alloc *parent)
+{
+	struct uk_allocslab *s;
+
+	UK_ASSERT(parent);
+
+	s = uk_palloc(parent, size_to_num_pages(sizeof(*s)));
+	if (unlikely(!s))
+		return NULL;
+
+	uk_pr_debug("%p: Slab allocator created on parent %p\n", s, parent);
+	return allocslab_setup(s, parent);
+}
+
+struct uk_alloc *uk_allocslab_init(void *base, __sz len)
+{
+	struct uk_allocslab *s;
+	struct uk_alloc *a, *parent;
+	__uptr min, max;
+	__sz metalen;
+
+	min = round_pgup((__uptr) base);
+	max = round_pgdown((__uptr) base + len);
+	metalen = round_pgup(sizeof(*s));
+
+	/* The parent needs at least a page for its own descriptor and one
+	 * page to hand out. Because of the multiboot layout, the first region
+	 * might be a single page, so we simply ignore it.
+	 */
+	if (max <= min || max - min < metalen + 2 * __PAGE_SIZE) {
+		uk_pr_debug("Not enough space for allocator: %"__PRIsz" B\n",
+			    len);
+		return NULL;
+	}
+
+	s = (struct uk_allocslab *) min;
+	uk_pr_info("Initialize slab allocator @ 0x%"__PRIuptr", len %"__PRIsz
+		   "\n", min, len);
+
+	/* Register before the parent so that we are the default allocator */
+	a = allocslab_setup(s, NULL);
+
+	parent = uk_allocbbuddy_init((void *)(min + metalen),
+				     max - min - metalen);
+	if (unlikely(!parent))
+		UK_CRASH("Failed to initialize parent page allocator\n");
+	s->parent = parent;
+
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	if (!slab_tcache_owner)
+		slab_tcache_owner = s;
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+	return a;
+}
@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/allocslab.h>
+#include <uk/allocbbuddy.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+#include <uk/plat/time.h>
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+#include <uk/sched.h>
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+/* Memory handed to a private binary buddy allocator. It acts as parent of
+ * the slab allocator under test and as reference for the page-based malloc
+ * path (uk_malloc_ifpages()). Both allocators stay registered afterwards,
+ * there is no way to unregister from ukalloc.
+ */
+#define TEST_PAGES		256
+#define BENCH_OBJS		128
+#define BENCH_ROUNDS		16
+
+static struct uk_alloc *pa;	/* parent page allocator */
+static struct uk_alloc *sa;	/* slab allocator */
+
+static int allocslab_test_init(struct uk_testsuite *suite __unused)
+{
+	void *mem;
+
+	mem = uk_palloc(uk_alloc_get_default(), TEST_PAGES);
+	if (!mem)
+		return -ENOMEM;
+
+	pa = uk_allocbbuddy_init(mem, TEST_PAGES << __PAGE_SHIFT);
+	if (!pa)
+		return -ENOMEM;
+
+	sa = uk_allocslab_create(pa);
+	if (!sa)
+		return -ENOMEM;
+	return 0;
+}
+
+UK_TESTCASE(ukallocslab, alloc_sizes)
+{
+	static void *objs[64];
+	unsigned int i;
+	__sz size;
+
+	for (i = 0; i < ARRAY_SIZE(objs); ++i) {
+		size = (i + 1) * 16 - (i % 16);
+		objs[i] = uk_malloc(sa, size);
+		UK_TEST_EXPECT_NOT_NULL(objs[i]);
+		UK_TEST_EXPECT_ZERO((__uptr) objs[i] % 16);
+		memset(objs[i], (int) i, size);
+	}
+
+	/* objects must not overlap */
+	for (i = 0; i < ARRAY_SIZE(objs); ++i) {
+		size = (i + 1) * 16 - (i % 16);
+		UK_TEST_EXPECT_SNUM_EQ(((__u8 *) objs[i])[0], (__u8) i);
+		UK_TEST_EXPECT_SNUM_EQ(((__u8 *) objs[i])[size - 1], (__u8) i);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(objs); ++i)
+		uk_free(sa, objs[i]);
+
+	UK_TEST_EXPECT_NULL(uk_malloc(sa, 0));
+}
+
+UK_TESTCASE(ukallocslab, free_reuses_object)
+{
+	void *a, *b;
+
+	a = uk_malloc(sa, 40);
+	UK_TEST_EXPECT_NOT_NULL(a);
+	uk_free(sa, a);
+
+	b = uk_malloc(sa, 33);
+	UK_TEST_EXPECT_PTR_EQ(b, a);
+	uk_free(sa, b);
+}
+
+UK_TESTCASE(ukallocslab, large_and_aligned)
+{
+	void *ptr;
+	int rc;
+
+	ptr = uk_malloc(sa, 3 * __PAGE_SIZE);
+	UK_TEST_EXPECT_NOT_NULL(ptr);
+	memset(ptr, 0xa5, 3 * __PAGE_SIZE);
+	uk_free(sa, ptr);
+
+	rc = uk_posix_memalign(sa, &ptr, 64, 100);
+	UK_TEST_EXPECT_ZERO(rc);
+	UK_TEST_EXPECT_ZERO((__uptr) ptr % 64);
+	uk_free(sa, ptr);
+
+	rc = uk_posix_memalign(sa, &ptr, __PAGE_SIZE, 100);
+	UK_TEST_EXPECT_ZERO(rc);
+	UK_TEST_EXPECT_ZERO((__uptr) ptr % __PAGE_SIZE);
+	memset(ptr, 0x5a, 100);
+	uk_free(sa, ptr);
+
+	rc = uk_posix_memalign(sa, &ptr, 3, 100);
+	UK_TEST_EXPECT_SNUM_EQ(rc, EINVAL);
+}
+
+UK_TESTCASE(ukallocslab, realloc)
+{
+	char *a, *b;
+
+	a = uk_malloc(sa, 100);
+	UK_TEST_EXPECT_NOT_NULL(a);
+	memset(a, 'x', 100);
+
+	/* same size class: object stays in place */
+	b = uk_realloc(sa, a, 120);
+	UK_TEST_EXPECT_PTR_EQ(b, a);
+
+	b = uk_realloc(sa, a, 2 * __PAGE_SIZE);
+	UK_TEST_EXPECT_NOT_NULL(b);
+	UK_TEST_EXPECT_SNUM_EQ(b[0], 'x');
+	UK_TEST_EXPECT_SNUM_EQ(b[99], 'x');
+
+	a = uk_realloc(sa, b, 8);
+	UK_TEST_EXPECT_NOT_NULL(a);
+	UK_TEST_EXPECT_SNUM_EQ(a[7], 'x');
+	uk_free(sa, a);
+}
+
+UK_TESTCASE(ukallocslab, pages_returned)
+{
+	static void *objs[BENCH_OBJS];
+	long before, after;
+	unsigned int i;
+
+	before = uk_alloc_pavailmem(pa);
+	for (i = 0; i < ARRAY_SIZE(objs); ++i) {
+		objs[i] = uk_malloc(sa, 256);
+		UK_TEST_EXPECT_NOT_NULL(objs[i]);
+	}
+	UK_TEST_EXPECT_SNUM_LT(uk_alloc_pavailmem(pa), before);
+
+	for (i = 0; i < ARRAY_SIZE(objs); ++i)
+		uk_free(sa, objs[i]);
+	after = uk_alloc_pavailmem(pa);
+
+	/* at most one empty slab stays cached per size class */
+	UK_TEST_EXPECT_SNUM_LE(before - after, 1);
+}
+
+/* Allocates and frees BENCH_OBJS objects of `size` bytes BENCH_ROUNDS times
+ * and reports the time per operation and the peak number of parent pages.
+ */
+static long bench(struct uk_alloc *a, __sz size, __nsec *ns)
+{
+	static void *objs[BENCH_OBJS];
+	long before, peak = 0;
+	unsigned int r, i;
+	__nsec start;
+
+	before = uk_alloc_pavailmem(pa);
+	start = ukplat_monotonic_clock();
+	for (r = 0; r < BENCH_ROUNDS; ++r) {
+		for (i = 0; i < BENCH_OBJS; ++i)
+			objs[i] = uk_malloc(a, size);
+		if (r == 0)
+			peak = before - uk_alloc_pavailmem(pa);
+		for (i = 0; i < BENCH_OBJS; ++i)
+			uk_free(a, objs[i]);
+	}
+	*ns = (ukplat_monotonic_clock() - start)
+	      / (2 * BENCH_ROUNDS * BENCH_OBJS);
+	return peak;
+}
+
+UK_TESTCASE(ukallocslab, bench_vs_ifpages)
+{
+	static const __sz sizes[] = { 16, 32, 100, 256, 1000 };
+	long pages_slab, pages_ifpages;
+	__nsec ns_slab, ns_ifpages;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		pages_ifpages = bench(pa, sizes[i], &ns_ifpages);
+		pages_slab = bench(sa, sizes[i], &ns_slab);
+
+		uk_pr_info("%4"__PRIsz" B x %d: ifpages %"__PRInsec" ns/op %ld pages, slab %"__PRInsec" ns/op %ld pages\n",
+			   sizes[i], BENCH_OBJS, ns_ifpages, pages_ifpages,
+			   ns_slab, pages_slab);
+		UK_TEST_EXPECT_SNUM_LT(pages_slab, pages_ifpages);
+	}
+}
+
+/* Thread caches only exist for the slab allocator that serves the heap */
+#if CONFIG_LIBUKALLOCSLAB_TCACHE && CONFIG_LIBUKBOOT_INITSLAB
+#define TCACHE_OBJ_SIZE		768
+
+static void *volatile tcache_obj;
+static volatile __ssz tcache_avail;
+static volatile int tcache_state;
+
+static __noreturn void tcache_thread(void *arg __unused)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	void *ptr;
+
+	ptr = uk_malloc(a, TCACHE_OBJ_SIZE);
+	uk_free(a, ptr);
+	tcache_obj = ptr;
+	tcache_avail = uk_alloc_availmem(a);
+
+	/* Keep the object cached until the main thread checked for it */
+	tcache_state = 1;
+	while (tcache_state != 2)
+		uk_sched_yield();
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(ukallocslab, tcache_returned_on_exit)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct uk_thread *t;
+	void *ptr;
+
+	tcache_state = 0;
+	t = uk_sched_thread_create(uk_sched_current(), tcache_thread, NULL,
+				   "tcache");
+	UK_TEST_ASSERT(t != NULL);
+	while (tcache_state != 1)
+		uk_sched_yield();
+
+	/* A freed object stays in the cache of the thread that freed it */
+	ptr = uk_malloc(a, TCACHE_OBJ_SIZE);
+	UK_TEST_EXPECT_NOT_NULL(ptr);
+	UK_TEST_EXPECT(ptr != tcache_obj);
+
+	/* The thread exits as soon as it runs again */
+	tcache_state = 2;
+	uk_sched_yield();
+	UK_TEST_EXPECT_SNUM_GT(uk_alloc_availmem(a), tcache_avail);
+	uk_free(a, ptr);
+}
+
+UK_TESTCASE(ukallocslab, bench_tcache)
+{
+	static const __sz sizes[] = { 16, 100, 1000 };
+	__nsec ns_shared, ns_tcache;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		bench(sa, sizes[i], &ns_shared);
+		bench(uk_alloc_get_default(), sizes[i], &ns_tcache);
+
+		uk_pr_info("%4"__PRIsz" B x %d: shared %"__PRInsec" ns/op, thread cache %"__PRInsec" ns/op\n",
+			   sizes[i], BENCH_OBJS, ns_shared, ns_tcache);
+	}
+}
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE && CONFIG_LIBUKBOOT_INITSLAB */
+
+uk_testsuite_register(ukallocslab, allocslab_test_init);
@@ -53,6 +53,9 @@
 #elif CONFIG_LIBUKBOOT_INITREGION
 #include <uk/allocregion.h>
 #define uk_alloc_init uk_allocregion_init
+#elif CONFIG_LIBUKBOOT_INITSLAB
+#include <uk/allocslab.h>
+#define uk_alloc_init uk_allocslab_init
 #elif CONFIG_LIBUKBOOT_INITMIMALLOC
 #include <uk/mimalloc.h>
 #define uk_alloc_init uk_mimalloc_init
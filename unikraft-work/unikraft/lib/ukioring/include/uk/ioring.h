@@ -0,0 +1,271 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UK_IORING_H__
+#define __UK_IORING_H__
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/arch/lcpu.h>
+#include <uk/alloc.h>
+#include <uk/essentials.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous I/O through a pair of rings in memory shared between the
+ * application and the library: the application queues operations as
+ * submission queue entries (SQEs) and publishes them with
+ * uk_ioring_submit(), the library executes them in the background and
+ * posts a completion queue entry (CQE) for each. Queuing, submitting, and
+ * reaping are plain memory accesses; only waking idle workers and waiting
+ * for completions involve the scheduler.
+ *
+ * Operations on regular files are executed by a pool of worker threads, so
+ * up to one block device request or 9P request per worker is in flight.
+ * Reads at an explicit offset from file systems that implement
+ * asynchronous reads (ext2fs without page cache) are the exception: the
+ * worker only submits the block device requests, and the completion is
+ * posted when the device finished them. Operations on streams that can be
+ * polled, such as pipes, wait for readiness on the ring's eventpoll and do
+ * not occupy a worker while doing so.
+ *
+ * A ring must only be used by one application thread at a time.
+ */
+
+#define UK_IORING_OP_NOP	0
+#define UK_IORING_OP_READ	1
+#define UK_IORING_OP_WRITE	2
+#define UK_IORING_OP_READV	3
+#define UK_IORING_OP_WRITEV	4
+#define UK_IORING_OP_FSYNC	5
+#define UK_IORING_OP_MAX	6
+
+/* File offset for read and write: use and advance the file position */
+#define UK_IORING_OFF_CUR	((__u64)-1)
+
+/* Flags for UK_IORING_OP_FSYNC. Other flags fail with -EINVAL.
+ * vfscore has no fdatasync(), so DATASYNC performs a full fsync().
+ */
+#define UK_IORING_FSYNC_DATASYNC	0x1
+
+/* Flags in uk_ioring::sq_flags */
+#define UK_IORING_SQ_NEED_WAKEUP	0x1
+
+struct uk_ioring_sqe {
+	__u8	opcode;		/* UK_IORING_OP_* */
+	__u8	__reserved0;
+	__u16	__reserved1;
+	__s32	fd;
+	__u64	off;		/* offset or UK_IORING_OFF_CUR */
+	__u64	addr;		/* buffer or iovec array */
+	__u32	len;		/* buffer length or number of iovecs */
+	__u32	op_flags;	/* FSYNC_* */
+	__u64	user_data;	/* copied to the CQE */
+};
+
+struct uk_ioring_cqe {
+	__u64	user_data;
+	__s32	res;		/* result of the operation or -errno */
+	__u32	flags;
+};
+
+struct uk_ioring_ctx;
+
+struct uk_ioring {
+	/* Written by the application */
+	__u32			sq_tail;
+	__u32			cq_head;
+	/* Next SQE to hand out, published as sq_tail on submit */
+	__u32			sqe_tail;
+
+	/* Written by the library */
+	__u32			sq_head __align(CACHE_LINE_SIZE);
+	__u32			cq_tail;
+	__u32			sq_flags;
+
+	/* Read-only after creation */
+	__u32			sq_mask __align(CACHE_LINE_SIZE);
+	__u32			cq_mask;
+	struct uk_ioring_sqe	*sqes;
+	struct uk_ioring_cqe	*cqes;
+	struct uk_ioring_ctx	*ctx;
+};
+
+struct uk_ioring_params {
+	/* Submission queue size, rounded up to a power of two */
+	__u32		sq_entries;
+	/* Completion queue size, rounded up to a power of two and to at
+	 * least sq_entries. Defaults to 2 * sq_entries if 0. It bounds the
+	 * number of operations in flight.
+	 */
+	__u32		cq_entries;
+	/* Defaults to CONFIG_LIBUKIORING_WORKERS if 0 */
+	unsigned int	nr_workers;
+};
+
+/**
+ * Creates a ring and starts its workers on the current scheduler.
+ *
+ * @param a
+ *   Allocator for the rings and the ring state
+ * @param params
+ *   Ring sizes and number of workers
+ * @return
+ *   - (>=0): Pointer to the ring
+ *   - (<0): Negative error code, use PTRISERR() and PTR2ERR()
+ *     - (-EINVAL): Invalid ring size
+ *     - (-ENOMEM): Out of memory
+ */
+struct uk_ioring *uk_ioring_create(struct uk_alloc *a,
+				   const struct uk_ioring_params *params);
+
+/**
+ * Stops the workers and frees the ring. Waits for operations that are
+ * being executed, including asynchronous reads; operations waiting for
+ * readiness are canceled without completion.
+ *
+ * @param r
+ *   Ring to destroy
+ */
+void uk_ioring_destroy(struct uk_ioring *r);
+
+/**
+ * Wakes up the workers of a ring. Called by uk_ioring_submit() when all
+ * workers are idle.
+ */
+void uk_ioring_wakeup(struct uk_ioring *r);
+
+/**
+ * Blocks until a completion is available.
+ *
+ * @return
+ *   - The oldest unseen CQE; mark it seen with uk_ioring_cqe_seen()
+ *   - NULL if no operation is in flight
+ */
+struct uk_ioring_cqe *uk_ioring_wait_cqe(struct uk_ioring *r);
+
+/**
+ * Returns the next free SQE, initialized to a NOP, or NULL if the
+ * submission queue is full or as many operations as fit into the
+ * completion queue are in flight.
+ */
+static inline struct uk_ioring_sqe *uk_ioring_get_sqe(struct uk_ioring *r)
+{
+	__u32 tail = r->sqe_tail;
+	struct uk_ioring_sqe *sqe;
+
+	if (tail - __atomic_load_n(&r->sq_head, __ATOMIC_ACQUIRE) > r->sq_mask)
+		return NULL;
+	if (tail - r->cq_head > r->cq_mask)
+		return NULL;
+
+	sqe = &r->sqes[tail & r->sq_mask];
+	*sqe = (struct uk_ioring_sqe){ .opcode = UK_IORING_OP_NOP };
+	r->sqe_tail = tail + 1;
+	return sqe;
+}
+
+/**
+ * Publishes all SQEs obtained since the last submit and wakes up the
+ * workers if they are idle.
+ *
+ * @return
+ *   Number of submitted SQEs
+ */
+static inline unsigned int uk_ioring_submit(struct uk_ioring *r)
+{
+	__u32 n = r->sqe_tail - r->sq_tail;
+
+	if (n) {
+		/* Pairs with the workers setting NEED_WAKEUP before they
+		 * check for new SQEs a last time
+		 */
+		__atomic_store_n(&r->sq_tail, r->sqe_tail, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&r->sq_flags, __ATOMIC_SEQ_CST)
+		    & UK_IORING_SQ_NEED_WAKEUP)
+			uk_ioring_wakeup(r);
+	}
+	return n;
+}
+
+/**
+ * Returns the oldest unseen CQE without blocking, or NULL if there is none.
+ */
+static inline struct uk_ioring_cqe *uk_ioring_peek_cqe(struct uk_ioring *r)
+{
+	if (r->cq_head == __atomic_load_n(&r->cq_tail, __ATOMIC_ACQUIRE))
+		return NULL;
+	return &r->cqes[r->cq_head & r->cq_mask];
+}
+
+/**
+ * Releases the CQE returned by the last peek or wait.
+ */
+static inline void uk_ioring_cqe_seen(struct uk_ioring *r)
+{
+	__atomic_store_n(&r->cq_head, r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+static inline void uk_ioring_sqe_set_data(struct uk_ioring_sqe *sqe,
+					  __u64 user_data)
+{
+	sqe->user_data = user_data;
+}
+
+static inline void uk_ioring_prep_rw(struct uk_ioring_sqe *sqe, __u8 opcode,
+				     int fd, const void *addr, __u32 len,
+				     __u64 off)
+{
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (__u64)(__uptr)addr;
+	sqe->len = len;
+	sqe->off = off;
+}
+
+static inline void uk_ioring_prep_read(struct uk_ioring_sqe *sqe, int fd,
+				       void *buf, __u32 len, __u64 off)
+{
+	uk_ioring_prep_rw(sqe, UK_IORING_OP_READ, fd, buf, len, off);
+}
+
+static inline void uk_ioring_prep_write(struct uk_ioring_sqe *sqe, int fd,
+					const void *buf, __u32 len, __u64 off)
+{
+	uk_ioring_prep_rw(sqe, UK_IORING_OP_WRITE, fd, buf, len, off);
+}
+
+/* The iovec array must stay valid until the operation completes */
+static inline void uk_ioring_prep_readv(struct uk_ioring_sqe *sqe, int fd,
+					const struct iovec *iov,
+					unsigned int iovcnt, __u64 off)
+{
+	uk_ioring_prep_rw(sqe, UK_IORING_OP_READV, fd, iov, iovcnt, off);
+}
+
+static inline void uk_ioring_prep_writev(struct uk_ioring_sqe *sqe, int fd,
+					 const struct iovec *iov,
+					 unsigned int iovcnt, __u64 off)
+{
+	uk_ioring_prep_rw(sqe, UK_IORING_OP_WRITEV, fd, iov, iovcnt, off);
+}
+
+static inline void uk_ioring_prep_fsync(struct uk_ioring_sqe *sqe, int fd,
+					unsigned int flags)
+{
+	uk_ioring_prep_rw(sqe, UK_IORING_OP_FSYNC, fd, NULL, 0, 0);
+	sqe->op_flags = flags;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_IORING_H__ */
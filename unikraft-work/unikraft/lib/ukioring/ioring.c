@@ -0,0 +1,642 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/assert.h>
+#include <uk/errptr.h>
+#include <uk/ioring.h>
+#include <uk/list.h>
+#include <uk/mutex.h>
+#include <uk/plat/lcpu.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <uk/syscall.h>
+#include <uk/wait.h>
+#include <vfscore/dentry.h>
+#include <vfscore/eventpoll.h>
+#include <vfscore/file.h>
+#include <vfscore/fs.h>
+#include <vfscore/vnode.h>
+
+/*
+ * When the syscall_shim library is not part of the build, the raw system
+ * call functions are not declared by <uk/syscall.h>.
+ */
+#if !CONFIG_LIBSYSCALL_SHIM
+long uk_syscall_r_readv(long fd, long iov, long iovcnt);
+long uk_syscall_r_preadv(long fd, long iov, long iovcnt, long offset);
+long uk_syscall_r_writev(long fd, long iov, long iovcnt);
+long uk_syscall_r_pwritev(long fd, long iov, long iovcnt, long offset);
+long uk_syscall_r_fsync(long fd);
+#endif /* !CONFIG_LIBSYSCALL_SHIM */
+
+#define IORING_MAX_ENTRIES	32768
+
+/* An operation from the time a worker takes it from the submission queue
+ * until its completion is posted.
+ */
+struct uk_ioring_op {
+	struct uk_ioring_sqe	sqe;
+	/* Reference to the file, taken when the operation has to wait */
+	struct vfscore_file	*fp;
+	/* Parks the operation on the ring's eventpoll until the file is
+	 * ready. Only linked into the eventpoll while parked.
+	 */
+	struct eventpoll_fd	efd;
+	struct uk_list_head	free_link;
+	/* Read started with VOP_AREAD(). Linked into the ring's aio_done
+	 * list when the file system completed it.
+	 */
+	struct uk_ioring_ctx	*ctx;
+	struct vfscore_aio	aio;
+	struct iovec		iov;
+	struct uk_ioring_op	*aio_next;
+};
+
+struct uk_ioring_ctx {
+	struct uk_alloc		*a;
+	/* Drivers signal readiness of parked operations to the eventpoll,
+	 * which puts them on its triggered list and wakes up its wait queue.
+	 * Idle workers sleep on that wait queue, too. The eventpoll's lock
+	 * protects the ring state below, the consumer side of the submission
+	 * queue, and the producer side of the completion queue.
+	 */
+	struct eventpoll	ep;
+	/* Application waiting for completions */
+	struct uk_waitq		cq_wq;
+	/* Destroy waiting for the workers to exit */
+	struct uk_waitq		exit_wq;
+	struct uk_ioring_op	*ops;
+	struct uk_list_head	free_ops;
+	unsigned int		nr_running;
+	unsigned int		nr_idle;
+	int			stop;
+	/* Asynchronous reads started and not yet posted */
+	unsigned int		nr_aio;
+	/* Asynchronous reads completed by the file system, pushed from
+	 * interrupt context: protected by disabling interrupts
+	 */
+	struct uk_ioring_op	*aio_done;
+};
+
+#define IORING_LOCK(ctx)	(&(ctx)->ep.fd_lock)
+
+static void ioring_op_done(struct uk_ioring *r, struct uk_ioring_op *op,
+			   long res)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_ioring_cqe *cqe;
+	__u32 tail;
+
+	if (op->fp) {
+		vfscore_put_file(op->fp);
+		op->fp = NULL;
+	}
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+	tail = r->cq_tail;
+	/* uk_ioring_get_sqe() limits the operations in flight to the size
+	 * of the completion queue, so it cannot overflow
+	 */
+	UK_ASSERT(tail - __atomic_load_n(&r->cq_head, __ATOMIC_ACQUIRE)
+		  <= r->cq_mask);
+	cqe = &r->cqes[tail & r->cq_mask];
+	cqe->user_data = op->sqe.user_data;
+	cqe->res = (__s32)res;
+	cqe->flags = 0;
+	__atomic_store_n(&r->cq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	uk_list_add(&op->free_link, &ctx->free_ops);
+	uk_waitq_wake_up(&ctx->cq_wq);
+	uk_mutex_unlock(IORING_LOCK(ctx));
+}
+
+/*
+ * Parks an operation until the file signals one of `events`. Returns 1 if
+ * the operation was parked, 0 if the file is ready already, or a negative
+ * error code.
+ */
+static int ioring_op_park(struct uk_ioring *r, struct uk_ioring_op *op,
+			  unsigned int events)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct epoll_event ev = { .events = events };
+	unsigned int revents = 0;
+	struct vnode *vp;
+	int rc;
+
+	UK_ASSERT(op->fp);
+	vp = op->fp->f_dentry->d_vnode;
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+
+	/* The fd of an eventpoll file description is only used to look it
+	 * up for epoll_ctl(). Use the operation index instead, so that
+	 * several operations can wait on the same file.
+	 */
+	eventpoll_fd_init(&op->efd, op->fp, (int)(op - ctx->ops), &ev);
+	eventpoll_add_unsafe(&ctx->ep, &op->efd);
+
+	/* Registers the eventpoll with the driver on the first poll */
+	rc = VOP_POLL(vp, &revents, &op->efd.cb);
+	if (rc || (revents & (events | EPOLLERR | EPOLLHUP))) {
+		eventpoll_del_unsafe(&op->efd);
+		uk_mutex_unlock(IORING_LOCK(ctx));
+		return -rc;
+	}
+
+	uk_mutex_unlock(IORING_LOCK(ctx));
+	return 1;
+}
+
+static int ioring_op_get_file(struct uk_ioring_op *op)
+{
+	if (!op->fp) {
+		op->fp = vfscore_get_file(op->sqe.fd);
+		if (unlikely(!op->fp))
+			return -EBADF;
+	}
+	return 0;
+}
+
+/*
+ * Operations on streams wait for readiness before they run, so that they
+ * do not block a worker. Regular files are always ready.
+ */
+static int ioring_op_poll(struct uk_ioring *r, struct uk_ioring_op *op,
+			  unsigned int events)
+{
+	int rc;
+
+	rc = ioring_op_get_file(op);
+	if (unlikely(rc))
+		return rc;
+
+	if (!(op->fp->f_vfs_flags & UK_VFSCORE_NOPOS) || !op->fp->f_dentry
+	    || !op->fp->f_dentry->d_vnode->v_op->vop_poll)
+		return 0;
+
+	return ioring_op_park(r, op, events);
+}
+
+/* Called by the file system, possibly from interrupt context */
+static void ioring_aio_done(struct vfscore_aio *aio)
+{
+	struct uk_ioring_op *op = __containerof(aio, struct uk_ioring_op, aio);
+	struct uk_ioring_ctx *ctx = op->ctx;
+	unsigned long flags;
+
+	flags = ukplat_lcpu_save_irqf();
+	op->aio_next = ctx->aio_done;
+	ctx->aio_done = op;
+	ukplat_lcpu_restore_irqf(flags);
+
+	uk_waitq_wake_up(&ctx->ep.wq);
+}
+
+/*
+ * Starts a positioned read on a file system that can read asynchronously,
+ * so that the worker does not wait for the device. Returns 1 if the read
+ * was started, 0 if it has to be done synchronously, or a negative error
+ * code.
+ */
+static int ioring_op_aread(struct uk_ioring *r, struct uk_ioring_op *op)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_ioring_sqe *sqe = &op->sqe;
+	struct vfscore_file *fp = op->fp;
+	struct vnode *vp;
+	int rc;
+
+	/* Anything preadv() would reject goes the synchronous way */
+	if (sqe->off == UK_IORING_OFF_CUR || (__s64)sqe->off < 0
+	    || !(fp->f_flags & UK_FREAD) || fp->f_offset < 0
+	    || (fp->f_vfs_flags & UK_VFSCORE_NOPOS) || !fp->f_dentry
+	    || (sqe->opcode == UK_IORING_OP_READV && sqe->len > IOV_MAX))
+		return 0;
+
+	vp = fp->f_dentry->d_vnode;
+	if (!vp->v_op->vop_aread)
+		return 0;
+
+	if (sqe->opcode == UK_IORING_OP_READ) {
+		op->iov.iov_base = (void *)(__uptr)sqe->addr;
+		op->iov.iov_len = sqe->len;
+		op->aio.aio_iov = &op->iov;
+		op->aio.aio_iovcnt = 1;
+	} else {
+		op->aio.aio_iov = (const struct iovec *)(__uptr)sqe->addr;
+		op->aio.aio_iovcnt = (int)sqe->len;
+	}
+	op->aio.aio_offset = (off_t)sqe->off;
+	op->aio.aio_done = ioring_aio_done;
+	op->ctx = ctx;
+
+	/* Count the read before it can complete */
+	uk_mutex_lock(IORING_LOCK(ctx));
+	ctx->nr_aio++;
+	uk_mutex_unlock(IORING_LOCK(ctx));
+
+	/* The read may be posted, and the operation's file reference
+	 * dropped, before VOP_AREAD() returns
+	 */
+	fhold(fp);
+	vn_lock(vp);
+	rc = VOP_AREAD(vp, fp, &op->aio);
+	vn_unlock(vp);
+	vfscore_put_file(fp);
+	if (!rc)
+		return 1;
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+	ctx->nr_aio--;
+	uk_mutex_unlock(IORING_LOCK(ctx));
+	return (rc == ENOTSUP) ? 0 : -rc;
+}
+
+static long ioring_op_rw(struct uk_ioring_op *op)
+{
+	struct uk_ioring_sqe *sqe = &op->sqe;
+	struct iovec iov;
+	long iovp, iovcnt;
+	int write;
+
+	switch (sqe->opcode) {
+	case UK_IORING_OP_READ:
+	case UK_IORING_OP_WRITE:
+		iov.iov_base = (void *)(__uptr)sqe->addr;
+		iov.iov_len = sqe->len;
+		iovp = (long)&iov;
+		iovcnt = 1;
+		break;
+	default:
+		iovp = (long)sqe->addr;
+		iovcnt = (long)sqe->len;
+		break;
+	}
+
+	write = (sqe->opcode == UK_IORING_OP_WRITE ||
+		 sqe->opcode == UK_IORING_OP_WRITEV);
+	if (sqe->off == UK_IORING_OFF_CUR)
+		return write ? uk_syscall_r_writev(sqe->fd, iovp, iovcnt)
+			     : uk_syscall_r_readv(sqe->fd, iovp, iovcnt);
+	return write ? uk_syscall_r_pwritev(sqe->fd, iovp, iovcnt,
+					    (long)sqe->off)
+		     : uk_syscall_r_preadv(sqe->fd, iovp, iovcnt,
+					   (long)sqe->off);
+}
+
+/*
+ * Runs an operation on a worker, either freshly taken from the submission
+ * queue or after its file signaled readiness. Posts the completion unless
+ * the operation was parked (again).
+ */
+static void ioring_op_run(struct uk_ioring *r, struct uk_ioring_op *op)
+{
+	struct uk_ioring_sqe *sqe = &op->sqe;
+	long res;
+	int rc;
+
+	switch (sqe->opcode) {
+	case UK_IORING_OP_NOP:
+		res = 0;
+		break;
+	case UK_IORING_OP_READ:
+	case UK_IORING_OP_READV:
+		rc = ioring_op_poll(r, op, EPOLLIN);
+		if (rc)
+			goto out_rc;
+		rc = ioring_op_aread(r, op);
+		if (rc)
+			goto out_rc;
+		res = ioring_op_rw(op);
+		break;
+	case UK_IORING_OP_WRITE:
+	case UK_IORING_OP_WRITEV:
+		rc = ioring_op_poll(r, op, EPOLLOUT);
+		if (rc)
+			goto out_rc;
+		res = ioring_op_rw(op);
+		break;
+	case UK_IORING_OP_FSYNC:
+		/* vfscore implements fdatasync() as fsync() */
+		if (unlikely(sqe->op_flags & ~UK_IORING_FSYNC_DATASYNC))
+			res = -EINVAL;
+		else
+			res = uk_syscall_r_fsync(sqe->fd);
+		break;
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	ioring_op_done(r, op, res);
+	return;
+
+out_rc:
+	/* A parked operation is resumed by a worker once the file is ready,
+	 * the completion of an asynchronous read is posted by a worker once
+	 * the file system finished it
+	 */
+	if (rc < 0)
+		ioring_op_done(r, op, rc);
+}
+
+static inline int ioring_sq_pending(struct uk_ioring *r)
+{
+	return r->sq_head != __atomic_load_n(&r->sq_tail, __ATOMIC_ACQUIRE);
+}
+
+/* Locking: IORING_LOCK held */
+static inline int ioring_has_work(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+
+	return (ctx->stop && !ctx->nr_aio)
+	       || __atomic_load_n(&ctx->aio_done, __ATOMIC_RELAXED)
+	       || !uk_list_empty(&ctx->ep.tr_list)
+	       || (ioring_sq_pending(r) && !uk_list_empty(&ctx->free_ops));
+}
+
+/* Takes a completed asynchronous read. Locking: IORING_LOCK held */
+static struct uk_ioring_op *ioring_next_aio(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_ioring_op *op;
+	unsigned long flags;
+
+	flags = ukplat_lcpu_save_irqf();
+	op = ctx->aio_done;
+	if (op)
+		ctx->aio_done = op->aio_next;
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (op)
+		ctx->nr_aio--;
+	return op;
+}
+
+/*
+ * Returns the next operation to run: parked operations whose file became
+ * ready first, then new submissions. Locking: IORING_LOCK held
+ */
+static struct uk_ioring_op *ioring_next_op(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct eventpoll_fd *efd;
+	struct uk_ioring_op *op;
+	__u32 head;
+
+	if (ctx->stop)
+		return NULL;
+
+	if (!uk_list_empty(&ctx->ep.tr_list)) {
+		efd = uk_list_first_entry(&ctx->ep.tr_list,
+					  struct eventpoll_fd, tr_link);
+		eventpoll_del_unsafe(efd);
+		return __containerof(efd, struct uk_ioring_op, efd);
+	}
+
+	if (!ioring_sq_pending(r) || uk_list_empty(&ctx->free_ops))
+		return NULL;
+
+	op = uk_list_first_entry(&ctx->free_ops, struct uk_ioring_op,
+				 free_link);
+	uk_list_del(&op->free_link);
+
+	/* Copy the SQE, the application may reuse its slot from now on */
+	head = r->sq_head;
+	op->sqe = r->sqes[head & r->sq_mask];
+	op->fp = NULL;
+	__atomic_store_n(&r->sq_head, head + 1, __ATOMIC_RELEASE);
+	return op;
+}
+
+static __noreturn void ioring_worker(void *arg)
+{
+	struct uk_ioring *r = (struct uk_ioring *)arg;
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_ioring_op *op;
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+	for (;;) {
+		op = ioring_next_aio(r);
+		if (op) {
+			uk_mutex_unlock(IORING_LOCK(ctx));
+			ioring_op_done(r, op, op->aio.aio_res);
+			uk_mutex_lock(IORING_LOCK(ctx));
+			continue;
+		}
+		op = ioring_next_op(r);
+		if (op) {
+			uk_mutex_unlock(IORING_LOCK(ctx));
+			ioring_op_run(r, op);
+			uk_mutex_lock(IORING_LOCK(ctx));
+			continue;
+		}
+		/* Asynchronous reads still need a worker to post them */
+		if (ctx->stop && !ctx->nr_aio)
+			break;
+
+		/* Ask the application to wake us up on submit, then check a
+		 * last time for submissions before going to sleep
+		 */
+		if (ctx->nr_idle++ == 0)
+			__atomic_or_fetch(&r->sq_flags,
+					  UK_IORING_SQ_NEED_WAKEUP,
+					  __ATOMIC_SEQ_CST);
+		uk_waitq_wait_event_mutex(&ctx->ep.wq, ioring_has_work(r),
+					  IORING_LOCK(ctx));
+		if (--ctx->nr_idle == 0)
+			__atomic_and_fetch(&r->sq_flags,
+					   ~UK_IORING_SQ_NEED_WAKEUP,
+					   __ATOMIC_SEQ_CST);
+	}
+
+	ctx->nr_running--;
+	uk_waitq_wake_up(&ctx->exit_wq);
+	uk_mutex_unlock(IORING_LOCK(ctx));
+	uk_sched_thread_exit();
+}
+
+void uk_ioring_wakeup(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+
+	/* Taking the lock orders the wake-up after a worker that is about
+	 * to sleep has added itself to the wait queue
+	 */
+	uk_mutex_lock(IORING_LOCK(ctx));
+	uk_waitq_wake_up(&ctx->ep.wq);
+	uk_mutex_unlock(IORING_LOCK(ctx));
+}
+
+struct uk_ioring_cqe *uk_ioring_wait_cqe(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_ioring_cqe *cqe;
+
+	cqe = uk_ioring_peek_cqe(r);
+	if (cqe)
+		return cqe;
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+	uk_waitq_wait_event_mutex(&ctx->cq_wq,
+				  uk_ioring_peek_cqe(r)
+				  || r->sq_tail == r->cq_head,
+				  IORING_LOCK(ctx));
+	uk_mutex_unlock(IORING_LOCK(ctx));
+
+	return uk_ioring_peek_cqe(r);
+}
+
+static __u32 ioring_roundup_pow2(__u32 v)
+{
+	__u32 n = 1;
+
+	while (n < v)
+		n <<= 1;
+	return n;
+}
+
+/*
+ * Stops the workers after they finished the operations they are running
+ * and posted the asynchronous reads in flight
+ */
+static void ioring_stop(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+
+	uk_mutex_lock(IORING_LOCK(ctx));
+	ctx->stop = 1;
+	uk_waitq_wake_up(&ctx->ep.wq);
+	uk_waitq_wait_event_mutex(&ctx->exit_wq, ctx->nr_running == 0,
+				  IORING_LOCK(ctx));
+	uk_mutex_unlock(IORING_LOCK(ctx));
+}
+
+static void ioring_free(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx = r->ctx;
+	struct uk_alloc *a = ctx->a;
+
+	uk_free(a, ctx->ops);
+	uk_free(a, ctx);
+	uk_free(a, r);
+}
+
+struct uk_ioring *uk_ioring_create(struct uk_alloc *a,
+				   const struct uk_ioring_params *params)
+{
+	struct uk_ioring_ctx *ctx;
+	struct uk_ioring *r;
+	struct uk_thread *t;
+	struct uk_sched *s;
+	__u32 sq_entries, cq_entries, i;
+	unsigned int nr_workers;
+	__sz hdr_len, len;
+
+	UK_ASSERT(a);
+	UK_ASSERT(params);
+
+	if (unlikely(!params->sq_entries ||
+		     params->sq_entries > IORING_MAX_ENTRIES ||
+		     params->cq_entries > 2 * IORING_MAX_ENTRIES))
+		return ERR2PTR(-EINVAL);
+
+	sq_entries = ioring_roundup_pow2(params->sq_entries);
+	cq_entries = params->cq_entries ?: 2 * sq_entries;
+	cq_entries = ioring_roundup_pow2(MAX(cq_entries, sq_entries));
+	nr_workers = params->nr_workers ?: CONFIG_LIBUKIORING_WORKERS;
+
+	s = uk_sched_current();
+	if (unlikely(!s))
+		return ERR2PTR(-ENOTSUP);
+
+	/* The rings follow the control structure in one allocation */
+	hdr_len = ALIGN_UP(sizeof(*r), CACHE_LINE_SIZE);
+	len = hdr_len + sq_entries * sizeof(struct uk_ioring_sqe)
+	      + cq_entries * sizeof(struct uk_ioring_cqe);
+	r = uk_memalign(a, CACHE_LINE_SIZE, len);
+	if (unlikely(!r))
+		return ERR2PTR(-ENOMEM);
+	memset(r, 0, len);
+	r->sq_mask = sq_entries - 1;
+	r->cq_mask = cq_entries - 1;
+	r->sqes = (struct uk_ioring_sqe *)((__uptr)r + hdr_len);
+	r->cqes = (struct uk_ioring_cqe *)(r->sqes + sq_entries);
+
+	ctx = uk_calloc(a, 1, sizeof(*ctx));
+	if (unlikely(!ctx))
+		goto err_free_ring;
+	r->ctx = ctx;
+	ctx->a = a;
+
+	/* At most cq_entries operations are in flight */
+	ctx->ops = uk_calloc(a, cq_entries, sizeof(*ctx->ops));
+	if (unlikely(!ctx->ops))
+		goto err_free_ctx;
+	UK_INIT_LIST_HEAD(&ctx->free_ops);
+	for (i = 0; i < cq_entries; i++)
+		uk_list_add_tail(&ctx->ops[i].free_link, &ctx->free_ops);
+
+	eventpoll_init(&ctx->ep, NULL);
+	uk_waitq_init(&ctx->cq_wq);
+	uk_waitq_init(&ctx->exit_wq);
+
+	for (i = 0; i < nr_workers; i++) {
+		t = uk_sched_thread_create(s, ioring_worker, r, "ioring");
+		if (unlikely(!t)) {
+			uk_pr_err("Failed to create I/O ring worker\n");
+			ioring_stop(r);
+			ioring_free(r);
+			return ERR2PTR(-ENOMEM);
+		}
+		uk_mutex_lock(IORING_LOCK(ctx));
+		ctx->nr_running++;
+		uk_mutex_unlock(IORING_LOCK(ctx));
+	}
+
+	uk_pr_debug("ioring %p: %"PRIu32" SQEs, %"PRIu32" CQEs, %u workers\n",
+		    r, sq_entries, cq_entries, nr_workers);
+	return r;
+
+err_free_ctx:
+	uk_free(a, ctx);
+err_free_ring:
+	uk_free(a, r);
+	return ERR2PTR(-ENOMEM);
+}
+
+void uk_ioring_destroy(struct uk_ioring *r)
+{
+	struct uk_ioring_ctx *ctx;
+	struct eventpoll_fd *efd, *tmp;
+	struct uk_ioring_op *op;
+
+	UK_ASSERT(r);
+	ctx = r->ctx;
+
+	ioring_stop(r);
+
+	/* Cancel parked operations */
+	uk_mutex_lock(IORING_LOCK(ctx));
+	uk_list_for_each_entry_safe(efd, tmp, &ctx->ep.fd_list, fd_link)
+		eventpoll_del_unsafe(efd);
+	uk_mutex_unlock(IORING_LOCK(ctx));
+
+	/* Only parked operations still hold a file reference */
+	for (op = ctx->ops; op <= &ctx->ops[r->cq_mask]; op++) {
+		if (op->fp)
+			vfscore_put_file(op->fp);
+	}
+
+	ioring_free(r);
+}
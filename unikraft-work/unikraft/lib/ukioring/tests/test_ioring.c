@@ -0,0 +1,872 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#if CONFIG_LIBEXT2FS
+#include <stdio.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <uk/blkdev.h>
+#include <uk/blkdev_driver.h>
+#include <uk/wait.h>
+#endif /* CONFIG_LIBEXT2FS */
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/errptr.h>
+#include <uk/essentials.h>
+#include <uk/ioring.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <uk/sched_impl.h>
+#include <uk/syscall.h>
+#include <uk/plat/time.h>
+
+#if !CONFIG_LIBSYSCALL_SHIM
+long uk_syscall_r_pipe(long pipefd);
+long uk_syscall_r_preadv(long fd, long iov, long iovcnt, long offset);
+#endif /* !CONFIG_LIBSYSCALL_SHIM */
+
+/* Pipes that are read from with requests still waiting for their data is
+ * where thread-per-request needs one blocked thread per request.
+ */
+#define BENCH_PIPES		32
+#define BENCH_ROUNDS		16
+
+static struct uk_ioring *ring_create(__u32 entries, unsigned int workers)
+{
+	struct uk_ioring_params p = {
+		.sq_entries = entries,
+		.nr_workers = workers,
+	};
+
+	return uk_ioring_create(uk_alloc_get_default(), &p);
+}
+
+/* Reaps one completion. Returns its result, or 1 << 30 if there is none. */
+static int reap(struct uk_ioring *r, __u64 *user_data)
+{
+	struct uk_ioring_cqe *cqe;
+	int res;
+
+	cqe = uk_ioring_wait_cqe(r);
+	if (!cqe)
+		return 1 << 30;
+	*user_data = cqe->user_data;
+	res = cqe->res;
+	uk_ioring_cqe_seen(r);
+	return res;
+}
+
+/* Expects the next completion to have user data `data` and result `res` */
+#define EXPECT_CQE(r, data, res)					\
+	do {								\
+		__u64 _data = ~0ULL;					\
+		int _res = reap(r, &_data);				\
+									\
+		UK_TEST_EXPECT_SNUM_EQ(_res, res);			\
+		UK_TEST_EXPECT_SNUM_EQ(_data, data);			\
+	} while (0)
+
+UK_TESTCASE(ukioring, create_invalid)
+{
+	struct uk_ioring_params p = { .sq_entries = 0 };
+
+	UK_TEST_EXPECT_SNUM_EQ(PTR2ERR(uk_ioring_create(uk_alloc_get_default(),
+							&p)), -EINVAL);
+}
+
+UK_TESTCASE(ukioring, nop_batch)
+{
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	unsigned int i, n;
+	__u64 seen = 0;
+
+	r = ring_create(6, 2);
+	UK_TEST_ASSERT(!PTRISERR(r));
+	UK_TEST_EXPECT_SNUM_EQ(r->sq_mask + 1, 8);
+	UK_TEST_EXPECT_SNUM_EQ(r->cq_mask + 1, 16);
+
+	/* The submission queue holds 8 entries */
+	for (n = 0; (sqe = uk_ioring_get_sqe(r)); n++)
+		uk_ioring_sqe_set_data(sqe, 1UL << n);
+	UK_TEST_EXPECT_SNUM_EQ(n, 8);
+	UK_TEST_EXPECT_SNUM_EQ(uk_ioring_submit(r), 8);
+
+	for (i = 0; i < n; i++) {
+		struct uk_ioring_cqe *cqe = uk_ioring_wait_cqe(r);
+
+		UK_TEST_ASSERT(cqe != NULL);
+		UK_TEST_EXPECT_ZERO(cqe->res);
+		seen |= cqe->user_data;
+		uk_ioring_cqe_seen(r);
+	}
+	UK_TEST_EXPECT_SNUM_EQ(seen, 0xff);
+
+	/* Nothing in flight */
+	UK_TEST_EXPECT_NULL(uk_ioring_peek_cqe(r));
+	UK_TEST_EXPECT_NULL(uk_ioring_wait_cqe(r));
+
+	uk_ioring_destroy(r);
+}
+
+UK_TESTCASE(ukioring, inflight_bounded_by_cq)
+{
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	unsigned int i;
+
+	r = ring_create(4, 1);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	/* 8 CQEs: two full submission queues without reaping */
+	for (i = 0; i < 8; i++) {
+		sqe = uk_ioring_get_sqe(r);
+		UK_TEST_ASSERT(sqe != NULL);
+		if (i % 4 == 3) {
+			uk_ioring_submit(r);
+			uk_sched_yield();
+		}
+	}
+	UK_TEST_EXPECT_NULL(uk_ioring_get_sqe(r));
+
+	EXPECT_CQE(r, 0, 0);
+	UK_TEST_EXPECT_NOT_NULL(uk_ioring_get_sqe(r));
+	uk_ioring_submit(r);
+	for (i = 0; i < 8; i++)
+		EXPECT_CQE(r, 0, 0);
+
+	uk_ioring_destroy(r);
+}
+
+UK_TESTCASE(ukioring, errors)
+{
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	char buf[4];
+
+	r = ring_create(4, 1);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, -1, buf, sizeof(buf), 0);
+	uk_ioring_sqe_set_data(sqe, 1);
+	sqe = uk_ioring_get_sqe(r);
+	sqe->opcode = UK_IORING_OP_MAX;
+	uk_ioring_sqe_set_data(sqe, 2);
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_fsync(sqe, -1, UK_IORING_FSYNC_DATASYNC << 1);
+	uk_ioring_sqe_set_data(sqe, 3);
+	uk_ioring_submit(r);
+
+	EXPECT_CQE(r, 1, -EBADF);
+	EXPECT_CQE(r, 2, -EINVAL);
+	EXPECT_CQE(r, 3, -EINVAL);
+
+	uk_ioring_destroy(r);
+}
+
+UK_TESTCASE(ukioring, pipe_read_waits_without_worker)
+{
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	char buf[8] = { 0 };
+	int fds[2];
+	int i;
+
+	UK_TEST_ASSERT(uk_syscall_r_pipe((long)fds) == 0);
+
+	/* With a single worker, a read on an empty pipe must not hold it */
+	r = ring_create(4, 1);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fds[0], buf, sizeof(buf), UK_IORING_OFF_CUR);
+	uk_ioring_sqe_set_data(sqe, 1);
+	uk_ioring_submit(r);
+	for (i = 0; i < 4; i++)
+		uk_sched_yield();
+	UK_TEST_EXPECT_NULL(uk_ioring_peek_cqe(r));
+
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_sqe_set_data(sqe, 2);
+	uk_ioring_submit(r);
+	EXPECT_CQE(r, 2, 0);
+
+	/* The write makes the pipe readable and resumes the read */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_write(sqe, fds[1], "ioring", 6, UK_IORING_OFF_CUR);
+	uk_ioring_sqe_set_data(sqe, 3);
+	uk_ioring_submit(r);
+	EXPECT_CQE(r, 3, 6);
+	EXPECT_CQE(r, 1, 6);
+	UK_TEST_EXPECT_ZERO(memcmp(buf, "ioring", 6));
+
+	/* Destroying cancels parked operations */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fds[0], buf, sizeof(buf), UK_IORING_OFF_CUR);
+	uk_ioring_submit(r);
+	uk_sched_yield();
+	uk_ioring_destroy(r);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+#if CONFIG_LIBVFSCORE_AUTOMOUNT_ROOTFS
+#define TEST_FILE	"/ukioring-test"
+
+UK_TESTCASE(ukioring, file_rw)
+{
+	static char wbuf[4][512], rbuf[4][512];
+	struct iovec iov[2];
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	int fd, i;
+
+	fd = open(TEST_FILE, O_CREAT | O_RDWR | O_TRUNC, 0644);
+	UK_TEST_ASSERT(fd >= 0);
+
+	r = ring_create(8, 4);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	/* Writes at explicit offsets, in any order */
+	for (i = 0; i < 4; i++) {
+		memset(wbuf[i], 'a' + i, sizeof(wbuf[i]));
+		sqe = uk_ioring_get_sqe(r);
+		uk_ioring_prep_write(sqe, fd, wbuf[i], sizeof(wbuf[i]),
+				     (__u64)(3 - i) * sizeof(wbuf[i]));
+	}
+	uk_ioring_submit(r);
+	for (i = 0; i < 4; i++)
+		EXPECT_CQE(r, 0, sizeof(wbuf[i]));
+
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_fsync(sqe, fd, UK_IORING_FSYNC_DATASYNC);
+	uk_ioring_submit(r);
+	EXPECT_CQE(r, 0, 0);
+
+	/* Vectored read of the first two blocks, plain reads of the rest */
+	iov[0].iov_base = rbuf[0];
+	iov[0].iov_len = sizeof(rbuf[0]);
+	iov[1].iov_base = rbuf[1];
+	iov[1].iov_len = sizeof(rbuf[1]);
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_readv(sqe, fd, iov, 2, 0);
+	for (i = 2; i < 4; i++) {
+		sqe = uk_ioring_get_sqe(r);
+		uk_ioring_prep_read(sqe, fd, rbuf[i], sizeof(rbuf[i]),
+				    (__u64)i * sizeof(rbuf[i]));
+		uk_ioring_sqe_set_data(sqe, i);
+	}
+	uk_ioring_submit(r);
+	for (i = 0; i < 3; i++) {
+		struct uk_ioring_cqe *cqe = uk_ioring_wait_cqe(r);
+
+		UK_TEST_ASSERT(cqe != NULL);
+		UK_TEST_EXPECT_SNUM_EQ(cqe->res, cqe->user_data ? 512 : 1024);
+		uk_ioring_cqe_seen(r);
+	}
+	for (i = 0; i < 4; i++)
+		UK_TEST_EXPECT_ZERO(memcmp(rbuf[i], wbuf[3 - i],
+					   sizeof(rbuf[i])));
+
+	uk_ioring_destroy(r);
+	close(fd);
+	unlink(TEST_FILE);
+}
+#endif /* CONFIG_LIBVFSCORE_AUTOMOUNT_ROOTFS */
+
+static int bench_fds[BENCH_PIPES][2];
+static char bench_buf[BENCH_PIPES];
+static volatile unsigned int bench_done;
+
+static __noreturn void bench_thread(void *arg)
+{
+	int i = (int)(__uptr)arg;
+
+	if (read(bench_fds[i][0], &bench_buf[i], 1) == 1)
+		bench_done++;
+	uk_sched_thread_exit();
+}
+
+/* One thread per request blocks in read() until its pipe has data */
+static __nsec bench_threads(void)
+{
+	struct uk_sched *s = uk_sched_current();
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	bench_done = 0;
+	for (i = 0; i < BENCH_PIPES; i++) {
+		if (!uk_sched_thread_create(s, bench_thread, (__uptr)i,
+					    "bench"))
+			return 0;
+	}
+	uk_sched_yield();
+	for (i = 0; i < BENCH_PIPES; i++)
+		write(bench_fds[i][1], "x", 1);
+	while (bench_done < BENCH_PIPES)
+		uk_sched_yield();
+	/* The idle thread does not get to release the exited threads */
+	uk_sched_thread_gc(s);
+	return ukplat_monotonic_clock() - start;
+}
+
+/* All requests go through one ring and wait for their pipe while parked */
+static __nsec bench_ring(struct uk_ioring *r)
+{
+	struct uk_ioring_sqe *sqe;
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < BENCH_PIPES; i++) {
+		sqe = uk_ioring_get_sqe(r);
+		uk_ioring_prep_read(sqe, bench_fds[i][0], &bench_buf[i], 1,
+				    UK_IORING_OFF_CUR);
+	}
+	uk_ioring_submit(r);
+	uk_sched_yield();
+	for (i = 0; i < BENCH_PIPES; i++)
+		write(bench_fds[i][1], "x", 1);
+	for (i = 0; i < BENCH_PIPES; i++) {
+		if (!uk_ioring_wait_cqe(r) || uk_ioring_peek_cqe(r)->res != 1)
+			return 0;
+		uk_ioring_cqe_seen(r);
+	}
+	return ukplat_monotonic_clock() - start;
+}
+
+UK_TESTCASE(ukioring, bench_vs_thread_per_request)
+{
+	__nsec ns_threads = 0, ns_ring = 0, ns;
+	struct uk_ioring *r;
+	int i;
+
+	for (i = 0; i < BENCH_PIPES; i++)
+		UK_TEST_ASSERT(uk_syscall_r_pipe((long)bench_fds[i]) == 0);
+
+	r = ring_create(BENCH_PIPES, 0);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		ns = bench_threads();
+		UK_TEST_ASSERT(ns != 0);
+		ns_threads += ns;
+
+		ns = bench_ring(r);
+		UK_TEST_ASSERT(ns != 0);
+		ns_ring += ns;
+	}
+
+	uk_pr_info("%d blocking pipe reads: thread per request %"__PRInsec" ns/op, ring %"__PRInsec" ns/op\n",
+		   BENCH_PIPES, ns_threads / (BENCH_ROUNDS * BENCH_PIPES),
+		   ns_ring / (BENCH_ROUNDS * BENCH_PIPES));
+
+	uk_ioring_destroy(r);
+	for (i = 0; i < BENCH_PIPES; i++) {
+		close(bench_fds[i][0]);
+		close(bench_fds[i][1]);
+	}
+}
+
+#if CONFIG_LIBEXT2FS && !CONFIG_LIBEXT2FS_PAGECACHE \
+	&& CONFIG_LIBVFSCORE_AUTOMOUNT_ROOTFS
+/* ext2fs reads ring operations asynchronously. The test device keeps an
+ * ext2 image in memory and completes each request a fixed time after its
+ * submission, from a thread that stands in for the interrupt.
+ */
+#define EXT2_BSIZE		4096
+#define EXT2_FILE_INO		12
+/* 12 direct blocks, the rest through the indirect block */
+#define EXT2_FILE_BLOCKS	256
+#define EXT2_FILE_SIZE		(EXT2_FILE_BLOCKS * EXT2_BSIZE)
+#define EXT2_DATA_BLK		5
+#define EXT2_IMG_SIZE		((EXT2_DATA_BLK + EXT2_FILE_BLOCKS) * EXT2_BSIZE)
+#define EXT2_MNT		"/ukioring-ext2"
+#define EXT2_FILE		EXT2_MNT "/data"
+
+#define RAMBLK_SSIZE		512
+#define RAMBLK_DEPTH		64
+#define RAMBLK_LATENCY		ukarch_time_usec_to_nsec(100)
+
+#define BENCH_EXT2_READS	64
+
+static struct {
+	struct uk_blkdev	dev;
+	char			*img;
+	struct uk_blkreq	*reqs[RAMBLK_DEPTH];
+	__nsec			due[RAMBLK_DEPTH];
+	unsigned int		nb_reqs;
+	/* Most requests in flight since the last reset */
+	unsigned int		max_reqs;
+	int			intr;
+	struct uk_waitq		wq;
+} ramblk;
+
+static inline void put16(__u64 off, __u16 v)
+{
+	memcpy(ramblk.img + off, &v, sizeof(v));
+}
+
+static inline void put32(__u64 off, __u32 v)
+{
+	memcpy(ramblk.img + off, &v, sizeof(v));
+}
+
+static void put_dirent(__u64 off, __u32 ino, __u16 reclen, const char *name)
+{
+	put32(off, ino);
+	put16(off + 4, reclen);
+	ramblk.img[off + 6] = (char)strlen(name);
+	memcpy(ramblk.img + off + 8, name, strlen(name));
+}
+
+/*
+ * Revision 0 file system with a single block group: superblock in block 0,
+ * group descriptor in block 1, 32 inodes in block 2, the root directory in
+ * block 3, and the indirect block of /data in block 4. Every 32-bit word
+ * of /data holds its own file offset.
+ */
+static void ext2_img_build(void)
+{
+	__u64 itab = 2 * EXT2_BSIZE;
+	__u64 ino;
+	__u32 i;
+
+	put32(1024 + 0x00, 32);				/* s_inodes_count */
+	put32(1024 + 0x04, EXT2_IMG_SIZE / EXT2_BSIZE);	/* s_blocks_count */
+	put32(1024 + 0x18, 2);				/* s_log_block_size */
+	put32(1024 + 0x20, 32768);			/* s_blocks_per_group */
+	put32(1024 + 0x28, 32);				/* s_inodes_per_group */
+	put16(1024 + 0x38, 0xEF53);			/* s_magic */
+
+	put32(EXT2_BSIZE + 0x08, 2);			/* bg_inode_table */
+
+	ino = itab + (2 - 1) * 128;
+	put16(ino + 0x00, 0040755);			/* i_mode */
+	put32(ino + 0x04, EXT2_BSIZE);			/* i_size */
+	put16(ino + 0x1A, 2);				/* i_links_count */
+	put32(ino + 0x28, 3);				/* i_block[0] */
+	put_dirent(3 * EXT2_BSIZE, 2, 12, ".");
+	put_dirent(3 * EXT2_BSIZE + 12, 2, 12, "..");
+	put_dirent(3 * EXT2_BSIZE + 24, EXT2_FILE_INO, EXT2_BSIZE - 24, "data");
+
+	ino = itab + (EXT2_FILE_INO - 1) * 128;
+	put16(ino + 0x00, 0100644);
+	put32(ino + 0x04, EXT2_FILE_SIZE);
+	put16(ino + 0x1A, 1);
+	for (i = 0; i < 12; i++)
+		put32(ino + 0x28 + i * 4, EXT2_DATA_BLK + i);
+	put32(ino + 0x28 + 12 * 4, 4);
+	for (i = 12; i < EXT2_FILE_BLOCKS; i++)
+		put32(4 * EXT2_BSIZE + (i - 12) * 4, EXT2_DATA_BLK + i);
+
+	for (i = 0; i < EXT2_FILE_SIZE; i += 4)
+		put32(EXT2_DATA_BLK * EXT2_BSIZE + i, i);
+}
+
+static int ramblk_submit_one(struct uk_blkdev *dev __unused,
+			     struct uk_blkdev_queue *queue __unused,
+			     struct uk_blkreq *req)
+{
+	__u64 off = req->start_sector * RAMBLK_SSIZE;
+	__u64 len = req->nb_sectors * RAMBLK_SSIZE;
+
+	if (ramblk.nb_reqs == RAMBLK_DEPTH)
+		return 0;
+
+	if (req->operation != UK_BLKREQ_READ || off + len > EXT2_IMG_SIZE)
+		req->result = -EIO;
+	else {
+		memcpy(req->aio_buf, ramblk.img + off, len);
+		req->result = 0;
+	}
+	ramblk.due[ramblk.nb_reqs] = ukplat_monotonic_clock() + RAMBLK_LATENCY;
+	ramblk.reqs[ramblk.nb_reqs++] = req;
+	ramblk.max_reqs = MAX(ramblk.max_reqs, ramblk.nb_reqs);
+	uk_waitq_wake_up(&ramblk.wq);
+
+	return UK_BLKDEV_STATUS_SUCCESS
+	       | ((ramblk.nb_reqs < RAMBLK_DEPTH) ? UK_BLKDEV_STATUS_MORE : 0);
+}
+
+static int ramblk_finish_reqs(struct uk_blkdev *dev __unused,
+			      struct uk_blkdev_queue *queue __unused)
+{
+	__nsec now = ukplat_monotonic_clock();
+	struct uk_blkreq *req;
+	unsigned int i = 0;
+
+	while (i < ramblk.nb_reqs) {
+		if (ramblk.due[i] > now) {
+			i++;
+			continue;
+		}
+		req = ramblk.reqs[i];
+		ramblk.nb_reqs--;
+		ramblk.reqs[i] = ramblk.reqs[ramblk.nb_reqs];
+		ramblk.due[i] = ramblk.due[ramblk.nb_reqs];
+
+		ukarch_store_n(&req->state.counter, UK_BLKREQ_FINISHED);
+		if (req->cb)
+			req->cb(req, req->cb_cookie);
+	}
+	return 0;
+}
+
+/* Raises the queue interrupt whenever the oldest request is due */
+static __noreturn void ramblk_irq_thread(void *arg __unused)
+{
+	__nsec due;
+	unsigned int i;
+
+	for (;;) {
+		uk_waitq_wait_event(&ramblk.wq, ramblk.nb_reqs > 0);
+
+		due = ramblk.due[0];
+		for (i = 1; i < ramblk.nb_reqs; i++)
+			due = MIN(due, ramblk.due[i]);
+		while (ukplat_monotonic_clock() < due)
+			uk_sched_yield();
+
+		if (ramblk.intr)
+			uk_blkdev_drv_queue_event(&ramblk.dev, 0);
+		else
+			uk_sched_yield();
+	}
+}
+
+static void ramblk_get_info(struct uk_blkdev *dev __unused,
+			    struct uk_blkdev_info *info)
+{
+	info->max_queues = 1;
+}
+
+static int ramblk_configure(struct uk_blkdev *dev __unused,
+			    const struct uk_blkdev_conf *conf __unused)
+{
+	return 0;
+}
+
+static int ramblk_queue_get_info(struct uk_blkdev *dev __unused,
+				 uint16_t queue_id __unused,
+				 struct uk_blkdev_queue_info *q_info)
+{
+	memset(q_info, 0, sizeof(*q_info));
+	q_info->nb_max = RAMBLK_DEPTH;
+	q_info->nb_min = 1;
+	q_info->nb_align = 1;
+	return 0;
+}
+
+static struct uk_blkdev_queue *
+ramblk_queue_configure(struct uk_blkdev *dev __unused,
+		       uint16_t queue_id __unused, uint16_t nb_desc __unused,
+		       const struct uk_blkdev_queue_conf *conf __unused)
+{
+	/* The API only checks the queue pointer, it is never dereferenced */
+	return (struct uk_blkdev_queue *)&ramblk;
+}
+
+static int ramblk_intr_enable(struct uk_blkdev *dev __unused,
+			      struct uk_blkdev_queue *queue __unused)
+{
+	ramblk.intr = 1;
+	return 0;
+}
+
+static int ramblk_intr_disable(struct uk_blkdev *dev __unused,
+			       struct uk_blkdev_queue *queue __unused)
+{
+	ramblk.intr = 0;
+	return 0;
+}
+
+static int ramblk_nop(struct uk_blkdev *dev __unused)
+{
+	return 0;
+}
+
+static int ramblk_queue_unconfigure(struct uk_blkdev *dev __unused,
+				    struct uk_blkdev_queue *queue __unused)
+{
+	return 0;
+}
+
+static const struct uk_blkdev_ops ramblk_ops = {
+	.get_info = ramblk_get_info,
+	.dev_configure = ramblk_configure,
+	.queue_get_info = ramblk_queue_get_info,
+	.queue_configure = ramblk_queue_configure,
+	.dev_start = ramblk_nop,
+	.dev_stop = ramblk_nop,
+	.queue_intr_enable = ramblk_intr_enable,
+	.queue_intr_disable = ramblk_intr_disable,
+	.queue_unconfigure = ramblk_queue_unconfigure,
+	.dev_unconfigure = ramblk_nop,
+};
+
+/* Registers the device on first use and mounts it. Returns the file. */
+static int ext2_mount_file(void)
+{
+	static int id = -1;
+	char dev[16];
+
+	if (id < 0) {
+		ramblk.img = uk_calloc(uk_alloc_get_default(), 1,
+				       EXT2_IMG_SIZE);
+		if (!ramblk.img)
+			return -ENOMEM;
+		ext2_img_build();
+		uk_waitq_init(&ramblk.wq);
+
+		ramblk.dev.submit_one = ramblk_submit_one;
+		ramblk.dev.finish_reqs = ramblk_finish_reqs;
+		ramblk.dev.dev_ops = &ramblk_ops;
+		ramblk.dev._data = ERR2PTR(-EINVAL);
+		ramblk.dev.capabilities.sectors = EXT2_IMG_SIZE / RAMBLK_SSIZE;
+		ramblk.dev.capabilities.ssize = RAMBLK_SSIZE;
+		ramblk.dev.capabilities.mode = O_RDONLY;
+		ramblk.dev.capabilities.max_sectors_per_req = 64;
+		ramblk.dev.capabilities.ioalign = RAMBLK_SSIZE;
+		id = uk_blkdev_drv_register(&ramblk.dev,
+					    uk_alloc_get_default(), "ramblk");
+		if (id < 0)
+			return id;
+
+		if (!uk_sched_thread_create(uk_sched_current(),
+					    ramblk_irq_thread, NULL, "ramblk"))
+			return -ENOMEM;
+		mkdir(EXT2_MNT, 0755);
+	}
+
+	snprintf(dev, sizeof(dev), "blkdev%d", id);
+	if (mount(dev, EXT2_MNT, "ext2fs", MS_RDONLY, NULL))
+		return -errno;
+	return open(EXT2_FILE, O_RDONLY);
+}
+
+static void ext2_unmount_file(int fd)
+{
+	close(fd);
+	umount(EXT2_MNT);
+}
+
+/* Checks that `buf` holds `len` bytes of /data from offset `off` */
+static int ext2_data_ok(const char *buf, __u32 off, __u32 len)
+{
+	__u32 i, v;
+
+	for (i = 0; i < len; i += 4) {
+		memcpy(&v, buf + i, sizeof(v));
+		if (v != off + i)
+			return 0;
+	}
+	return 1;
+}
+
+UK_TESTCASE(ukioring, ext2fs_reads_async)
+{
+	static char buf[18][EXT2_BSIZE] __align(RAMBLK_SSIZE);
+	struct iovec iov[2];
+	struct uk_ioring_sqe *sqe;
+	struct uk_ioring *r;
+	int fd, i, res, results[4];
+	__u64 data = ~0ULL;
+
+	fd = ext2_mount_file();
+	UK_TEST_ASSERT(fd >= 0);
+
+	/* A single worker keeps all reads in flight at the device */
+	r = ring_create(32, 1);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	/* Load the indirect block, so that no read waits for metadata */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fd, buf[0], EXT2_BSIZE, 12 * EXT2_BSIZE);
+	uk_ioring_submit(r);
+	EXPECT_CQE(r, 0, EXT2_BSIZE);
+
+	ramblk.max_reqs = 0;
+	for (i = 0; i < 16; i++) {
+		sqe = uk_ioring_get_sqe(r);
+		uk_ioring_prep_read(sqe, fd, buf[i], EXT2_BSIZE,
+				    (__u64)((i * 37) % EXT2_FILE_BLOCKS)
+				    * EXT2_BSIZE);
+		uk_ioring_sqe_set_data(sqe, i);
+	}
+	uk_ioring_submit(r);
+	for (i = 0; i < 16; i++) {
+		res = reap(r, &data);
+		UK_TEST_EXPECT_SNUM_EQ(res, EXT2_BSIZE);
+		UK_TEST_EXPECT(data < 16
+			       && ext2_data_ok(buf[data],
+					       ((data * 37) % EXT2_FILE_BLOCKS)
+					       * EXT2_BSIZE, EXT2_BSIZE));
+	}
+	UK_TEST_EXPECT_SNUM_EQ(ramblk.max_reqs, 16);
+
+	/* Vectored read across a block boundary, up to the end of file */
+	iov[0].iov_base = buf[16];
+	iov[0].iov_len = 1024;
+	iov[1].iov_base = buf[17];
+	iov[1].iov_len = EXT2_BSIZE;
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_readv(sqe, fd, iov, 2, EXT2_FILE_SIZE - 2048);
+	uk_ioring_sqe_set_data(sqe, 1);
+	/* Misaligned buffer: read synchronously */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fd, buf[0] + 4, 1000, 512);
+	uk_ioring_sqe_set_data(sqe, 2);
+	/* At end of file */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fd, buf[1], EXT2_BSIZE, EXT2_FILE_SIZE);
+	uk_ioring_sqe_set_data(sqe, 3);
+	uk_ioring_submit(r);
+
+	/* Asynchronous reads may complete in any order */
+	for (i = 0; i < 3; i++) {
+		res = reap(r, &data);
+		UK_TEST_ASSERT(data >= 1 && data <= 3);
+		results[data] = res;
+	}
+	UK_TEST_EXPECT_SNUM_EQ(results[1], 2048);
+	UK_TEST_EXPECT_SNUM_EQ(results[2], 1000);
+	UK_TEST_EXPECT_SNUM_EQ(results[3], 0);
+	UK_TEST_EXPECT(ext2_data_ok(buf[0] + 4, 512, 1000));
+	UK_TEST_EXPECT(ext2_data_ok(buf[16], EXT2_FILE_SIZE - 2048, 1024));
+	UK_TEST_EXPECT(ext2_data_ok(buf[17], EXT2_FILE_SIZE - 1024, 1024));
+
+	/* Destroying waits for reads in flight */
+	sqe = uk_ioring_get_sqe(r);
+	uk_ioring_prep_read(sqe, fd, buf[0], EXT2_BSIZE, 0);
+	uk_ioring_submit(r);
+	uk_sched_yield();
+	uk_ioring_destroy(r);
+	UK_TEST_EXPECT_ZERO(ramblk.nb_reqs);
+	UK_TEST_EXPECT(ext2_data_ok(buf[0], 0, EXT2_BSIZE));
+
+	ext2_unmount_file(fd);
+}
+
+static char bench_ext2_buf[BENCH_EXT2_READS][EXT2_BSIZE]
+	__align(RAMBLK_SSIZE);
+static int bench_ext2_fd;
+
+static __u64 bench_ext2_off(int i)
+{
+	return (__u64)((i * 37) % EXT2_FILE_BLOCKS) * EXT2_BSIZE;
+}
+
+static __noreturn void bench_ext2_thread(void *arg)
+{
+	int i = (int)(__uptr)arg;
+	struct iovec iov = {
+		.iov_base = bench_ext2_buf[i],
+		.iov_len = EXT2_BSIZE,
+	};
+
+	if (uk_syscall_r_preadv(bench_ext2_fd, (long)&iov, 1,
+				(long)bench_ext2_off(i)) == EXT2_BSIZE)
+		bench_done++;
+	uk_sched_thread_exit();
+}
+
+/* One thread per read, each blocked in preadv() */
+static __nsec bench_ext2_threads(void)
+{
+	struct uk_sched *s = uk_sched_current();
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	bench_done = 0;
+	for (i = 0; i < BENCH_EXT2_READS; i++) {
+		if (!uk_sched_thread_create(s, bench_ext2_thread, (__uptr)i,
+					    "bench"))
+			return 0;
+	}
+	while (bench_done < BENCH_EXT2_READS)
+		uk_sched_yield();
+	uk_sched_thread_gc(s);
+	return ukplat_monotonic_clock() - start;
+}
+
+/* All reads submitted through one ring */
+static __nsec bench_ext2_ring(struct uk_ioring *r)
+{
+	struct uk_ioring_sqe *sqe;
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < BENCH_EXT2_READS; i++) {
+		sqe = uk_ioring_get_sqe(r);
+		uk_ioring_prep_read(sqe, bench_ext2_fd, bench_ext2_buf[i],
+				    EXT2_BSIZE, bench_ext2_off(i));
+	}
+	uk_ioring_submit(r);
+	for (i = 0; i < BENCH_EXT2_READS; i++) {
+		if (!uk_ioring_wait_cqe(r)
+		    || uk_ioring_peek_cqe(r)->res != EXT2_BSIZE)
+			return 0;
+		uk_ioring_cqe_seen(r);
+	}
+	return ukplat_monotonic_clock() - start;
+}
+
+UK_TESTCASE(ukioring, bench_ext2fs_vs_thread_per_request)
+{
+	__nsec ns_threads = 0, ns_ring = 0, ns;
+	unsigned int depth_threads, depth_ring;
+	struct uk_ioring *r;
+	int i;
+
+	bench_ext2_fd = ext2_mount_file();
+	UK_TEST_ASSERT(bench_ext2_fd >= 0);
+
+	r = ring_create(BENCH_EXT2_READS, 0);
+	UK_TEST_ASSERT(!PTRISERR(r));
+
+	ramblk.max_reqs = 0;
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		ns = bench_ext2_threads();
+		UK_TEST_ASSERT(ns != 0);
+		ns_threads += ns;
+	}
+	depth_threads = ramblk.max_reqs;
+
+	ramblk.max_reqs = 0;
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		ns = bench_ext2_ring(r);
+		UK_TEST_ASSERT(ns != 0);
+		ns_ring += ns;
+	}
+	depth_ring = ramblk.max_reqs;
+
+	for (i = 0; i < BENCH_EXT2_READS; i++)
+		UK_TEST_EXPECT(ext2_data_ok(bench_ext2_buf[i],
+					    bench_ext2_off(i), EXT2_BSIZE));
+
+	uk_pr_info("%d ext2fs block reads, %"__PRInsec" ns device latency: thread per request %"__PRInsec" ns/op (%u in flight), ring %"__PRInsec" ns/op (%u in flight)\n",
+		   BENCH_EXT2_READS, RAMBLK_LATENCY,
+		   ns_threads / (BENCH_ROUNDS * BENCH_EXT2_READS),
+		   depth_threads,
+		   ns_ring / (BENCH_ROUNDS * BENCH_EXT2_READS), depth_ring);
+	UK_TEST_EXPECT_SNUM_GT(depth_ring, depth_threads);
+
+	uk_ioring_destroy(r);
+	ext2_unmount_file(bench_ext2_fd);
+}
+#endif /* CONFIG_LIBEXT2FS && !CONFIG_LIBEXT2FS_PAGECACHE && ... */
+
+uk_testsuite_register(ukioring, NULL);
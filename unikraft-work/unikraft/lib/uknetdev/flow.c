@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <string.h>
+#include <uk/netdev.h>
+#include <uk/essentials.h>
+
+#define FLOW_ETH_TYPE_OFF	(2 * UK_ETH_ADDR_LEN)
+#define FLOW_ETH_P_IPV4		0x0800
+#define FLOW_ETH_P_IPV6		0x86dd
+#define FLOW_ETH_P_8021Q	0x8100
+
+#define FLOW_IPV4_HDR_MINLEN	20
+#define FLOW_IPV4_FRAG_MASK	0x3fff /* MF flag and fragment offset */
+#define FLOW_IPV6_HDR_LEN	40
+
+#define FLOW_IPPROTO_TCP	6
+#define FLOW_IPPROTO_UDP	17
+
+/* Source and destination address of IPv6 plus both ports */
+#define FLOW_TUPLE_MAXLEN	(2 * 16 + 2 * 2)
+
+/**
+ * Default RSS key of the Microsoft RSS specification. Most NICs use it as
+ * well, so software steering agrees with hardware steering.
+ */
+static const __u8 flow_key[40] = {
+	0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+	0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+	0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+	0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+	0x6a, 0x42, 0xb3, 0x8b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+UK_CTASSERT(sizeof(flow_key) >= FLOW_TUPLE_MAXLEN + sizeof(__u32));
+
+static inline __u16 flow_get16(const __u8 *p)
+{
+	return ((__u16) p[0] << 8) | p[1];
+}
+
+__u32 uk_netdev_flow_hash_toeplitz(const __u8 *tuple, size_t len)
+{
+	__u32 window, hash = 0;
+	size_t i;
+	int bit;
+
+	UK_ASSERT(len <= FLOW_TUPLE_MAXLEN);
+
+	window = ((__u32) flow_key[0] << 24) | ((__u32) flow_key[1] << 16)
+		 | ((__u32) flow_key[2] << 8) | flow_key[3];
+	for (i = 0; i < len; i++) {
+		for (bit = 7; bit >= 0; bit--) {
+			if (tuple[i] & (1 << bit))
+				hash ^= window;
+			window = (window << 1)
+				 | ((flow_key[i + 4] >> bit) & 1);
+		}
+	}
+	return hash;
+}
+
+__u32 uk_netdev_flow_hash(const struct uk_netbuf *nb)
+{
+	__u8 tuple[FLOW_TUPLE_MAXLEN];
+	const __u8 *frame, *l3, *l4 = NULL;
+	size_t len, alen, off;
+	__u16 type;
+	__u8 proto;
+
+	UK_ASSERT(nb);
+
+	frame = nb->data;
+	len = nb->len;
+	off = FLOW_ETH_TYPE_OFF;
+	if (unlikely(len < UK_ETH_HDR_UNTAGGED_LEN))
+		return 0;
+	type = flow_get16(frame + off);
+	if (type == FLOW_ETH_P_8021Q) {
+		off += UK_ETH_8021Q_LEN;
+		if (unlikely(len < off + UK_ETH_TYPE_LEN))
+			return 0;
+		type = flow_get16(frame + off);
+	}
+	off += UK_ETH_TYPE_LEN;
+	l3 = frame + off;
+	len -= off;
+
+	switch (type) {
+	case FLOW_ETH_P_IPV4:
+		if (unlikely(len < FLOW_IPV4_HDR_MINLEN))
+			return 0;
+		alen = 4;
+		memcpy(tuple, l3 + 12, 2 * alen);
+		proto = l3[9];
+		/* Only the first fragment carries the ports */
+		off = (l3[0] & 0x0f) * 4;
+		if (!(flow_get16(l3 + 6) & FLOW_IPV4_FRAG_MASK)
+		    && off >= FLOW_IPV4_HDR_MINLEN)
+			l4 = l3 + off;
+		break;
+	case FLOW_ETH_P_IPV6:
+		if (unlikely(len < FLOW_IPV6_HDR_LEN))
+			return 0;
+		alen = 16;
+		memcpy(tuple, l3 + 8, 2 * alen);
+		proto = l3[6];
+		off = FLOW_IPV6_HDR_LEN;
+		l4 = l3 + off;
+		break;
+	default:
+		return 0;
+	}
+
+	if (l4 && (proto == FLOW_IPPROTO_TCP || proto == FLOW_IPPROTO_UDP)
+	    && len >= off + 4) {
+		memcpy(tuple + 2 * alen, l4, 4);
+		return uk_netdev_flow_hash_toeplitz(tuple, 2 * alen + 4);
+	}
+	return uk_netdev_flow_hash_toeplitz(tuple, 2 * alen);
+}
@@ -37,6 +37,7 @@
 #include <stddef.h>
 #include <limits.h>
 #include <errno.h>
+#include <uk/config.h>
 #include <uk/assert.h>
 #include <uk/refcount.h>
 #include <uk/alloc.h>
@@ -47,6 +48,10 @@ extern "C" {
 #endif
 
 struct uk_netbuf;
+#if CONFIG_LIBUKNETDEV_POOL
+struct uk_netbuf_pool;
+struct uk_netbuf_cache;
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 
 typedef void (*uk_netbuf_dtor_t)(struct uk_netbuf *);
 
@@ -99,7 +104,8 @@ typedef void (*uk_netbuf_dtor_t)(struct uk_netbuf *);
  * The netbuf structure, private meta data area, and buffer area can be backed
  * by independent memory allocations. uk_netbuf_alloc_buf() and
  * uk_netbuf_prepare_buf() are placing all these three regions into a single
- * allocation.
+ * allocation. Netbufs taken from a netbuf pool (uk_netbuf_pool_alloc()) use
+ * the same layout, but are prepared only once when the pool is created.
  */
 
 /* Packet is validated (non-corrupted, checksum okay)
@@ -123,6 +129,24 @@ typedef void (*uk_netbuf_dtor_t)(struct uk_netbuf *);
 #define UK_NETBUF_F_PARTIAL_CSUM_BIT 1
 #define UK_NETBUF_F_PARTIAL_CSUM     (1 << UK_NETBUF_F_PARTIAL_CSUM_BIT)
 
+/* Indicates that the packet is larger than the MTU and consists of segments
+ * of `gso_size` payload bytes each, of the protocol given by `gso_type`.
+ * On transmit, the device splits the packet into these segments (TSO, UFO).
+ * On receive, the device coalesced these segments into a single packet.
+ * UK_NETBUF_F_PARTIAL_CSUM has to be set as well: the checksum is completed
+ * for every segment.
+ */
+#define UK_NETBUF_F_GSO_BIT          2
+#define UK_NETBUF_F_GSO              (1 << UK_NETBUF_F_GSO_BIT)
+
+/* Segmentation types for `gso_type` */
+#define UK_NETBUF_GSO_NONE           0
+#define UK_NETBUF_GSO_TCPV4          1 /**< TCP over IPv4 (TSO) */
+#define UK_NETBUF_GSO_TCPV6          2 /**< TCP over IPv6 (TSO) */
+#define UK_NETBUF_GSO_UDP            3 /**< UDP over IPv4 (UFO) */
+#define UK_NETBUF_GSO_TYPE_MASK      0x7f
+#define UK_NETBUF_GSO_ECN            0x80 /**< TCP segments have ECN set */
+
 struct uk_netbuf {
 	struct uk_netbuf *next;
 	struct uk_netbuf *prev;
@@ -146,10 +170,19 @@ struct uk_netbuf {
 				 * Number of bytes starting from `csum_start`
 				 * pointing to the checksum field
 				 */
+	uint16_t gso_size;     /**< Used if UK_NETBUF_F_GSO is set;
+				 * Payload bytes per segment (e.g., TCP MSS)
+				 */
+	uint8_t gso_type;      /**< Used if UK_NETBUF_F_GSO is set;
+				 * UK_NETBUF_GSO_* segmentation type
+				 */
 
 	uk_netbuf_dtor_t dtor; /**< Destructor callback */
 	struct uk_alloc *_a;   /**< @internal Allocator for free'ing */
 	void *_b;              /**< @internal Base address for free'ing */
+#if CONFIG_LIBUKNETDEV_POOL
+	struct uk_netbuf_cache *_c; /**< @internal Pool cache for recycling */
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 };
 
 /*
@@ -328,6 +361,117 @@ struct uk_netbuf *uk_netbuf_prepare_buf(void *mem, size_t size,
 					uint16_t headroom,
 					size_t privlen, uk_netbuf_dtor_t dtor);
 
+#if CONFIG_LIBUKNETDEV_POOL
+/**
+ * Allocate a pool of netbufs with data buffer area, backed by ukallocpool.
+ * Every netbuf is laid out like with uk_netbuf_alloc_buf() and is prepared
+ * once on pool creation, so that taking a netbuf from the pool only resets
+ * the data pointer, length, flags, and reference count.
+ * Netbufs are taken through per-queue caches (uk_netbuf_pool_cache_get()).
+ * On the last uk_netbuf_free(), a netbuf is returned to the cache it was
+ * taken from. Caches exchange netbufs with the shared pool in batches.
+ * Note: A pool cannot be released again (see uk_allocpool_free()).
+ * @param a
+ *   Allocator for the pool memory
+ * @param count
+ *   Number of netbufs in the pool
+ * @param buflen
+ *   Size of the buffer area of each netbuf
+ * @param bufalign
+ *   Alignment for the buffer area (`m->buf` will be aligned to it)
+ * @param headroom
+ *   Number of bytes reserved as headroom from the buffer area.
+ *   `headroom` has to be smaller or equal to `buflen`.
+ * @param privlen
+ *   Length for reserved memory to store private data of each netbuf.
+ * @param nb_caches
+ *   Number of caches, typically one per receive-transmit queue pair
+ * @param dtor
+ *   Destructor that is called when a netbuf is free'd (optional). The
+ *   destructor must not release the netbuf memory.
+ * @returns
+ *   - (NULL): Allocation failed
+ *   - Reference to the netbuf pool
+ */
+struct uk_netbuf_pool *uk_netbuf_pool_alloc(struct uk_alloc *a,
+					    unsigned int count,
+					    size_t buflen, size_t bufalign,
+					    uint16_t headroom, size_t privlen,
+					    uint16_t nb_caches,
+					    uk_netbuf_dtor_t dtor);
+
+/**
+ * Returns a cache of a netbuf pool.
+ * A cache is meant to be used by a single context, e.g., the one serving a
+ * netdev queue. Netbufs may still be free'd from any other thread or
+ * interrupt handler; every cache has a lock that is only contended then.
+ * @param p
+ *   Reference to the netbuf pool
+ * @param idx
+ *   Index of the cache, has to be smaller than `nb_caches` of the pool
+ * @returns
+ *   Reference to the cache
+ */
+struct uk_netbuf_cache *uk_netbuf_pool_cache_get(struct uk_netbuf_pool *p,
+						 uint16_t idx);
+
+/**
+ * Returns the number of netbufs available in the shared part of a netbuf
+ * pool. Netbufs held by caches are not counted.
+ * @param p
+ *   Reference to the netbuf pool
+ */
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p);
+
+/**
+ * Takes multiple netbufs from a pool cache. The cache is refilled from the
+ * shared pool when it runs empty.
+ * m->len is initialized with 0.
+ * @param c
+ *   Reference to the pool cache
+ * @param m
+ *   Array that is filled with references to the taken netbufs
+ * @param count
+ *   Number of netbufs requested (equal to the length of `m`)
+ * @returns
+ *   Number of netbufs placed to m[0]...m[count - 1]
+ */
+uint16_t uk_netbuf_cache_take_batch(struct uk_netbuf_cache *c,
+				    struct uk_netbuf *m[], uint16_t count);
+
+/**
+ * Takes a single netbuf from a pool cache.
+ * m->len is initialized with 0.
+ * @param c
+ *   Reference to the pool cache
+ * @returns
+ *   - (NULL): Pool is exhausted
+ *   - initialized uk_netbuf
+ */
+static inline struct uk_netbuf *uk_netbuf_cache_take(struct uk_netbuf_cache *c)
+{
+	struct uk_netbuf *m;
+
+	return (uk_netbuf_cache_take_batch(c, &m, 1) == 1) ? m : NULL;
+}
+
+/**
+ * Receive buffer allocator for netdev receive queues
+ * (see `uk_netdev_alloc_rxpkts`). Takes netbufs from a pool cache and sets
+ * their length to the available tailroom.
+ * @param argp
+ *   Reference to the pool cache (`struct uk_netbuf_cache *`)
+ * @param pkts
+ *   Array that is filled with references to the taken netbufs
+ * @param count
+ *   Number of netbufs requested (equal to the length of `pkts`)
+ * @returns
+ *   Number of netbufs placed to pkts[0]...pkts[count - 1]
+ */
+uint16_t uk_netbuf_cache_alloc_rxpkts(void *argp, struct uk_netbuf *pkts[],
+				      uint16_t count);
+#endif /* CONFIG_LIBUKNETDEV_POOL */
+
 /**
  * Retrieves the last element of a netbuf chain
  * @param m
@@ -38,6 +38,7 @@
 #include <uk/netdev_core.h>
 #include <uk/assert.h>
 #include <uk/errptr.h>
+#include <uk/plat/lcpu.h>
 
 /**
  * Unikraft Network API
@@ -523,6 +524,246 @@ static inline int uk_netdev_tx_one(struct uk_netdev *dev, uint16_t queue_id,
 	return dev->tx_one(dev, dev->_tx_queue[queue_id], pkt);
 }
 
+/**
+ * Generic burst receive for drivers that do not implement `rx_burst`.
+ * Calls `rx_one` for each packet. Use uk_netdev_rx_burst() instead.
+ */
+int uk_netdev_rx_burst_compat(struct uk_netdev *dev,
+			      struct uk_netdev_rx_queue *queue,
+			      struct uk_netbuf **pkts, uint16_t *cnt);
+
+/**
+ * Generic burst transmit for drivers that do not implement `tx_burst`.
+ * Calls `tx_one` for each packet. Use uk_netdev_tx_burst() instead.
+ */
+int uk_netdev_tx_burst_compat(struct uk_netdev *dev,
+			      struct uk_netdev_tx_queue *queue,
+			      struct uk_netbuf **pkts, uint16_t *cnt);
+
+/**
+ * Receive up to `*cnt` packets and re-program used receive descriptors once
+ * for the whole burst. The same rules about queue interrupts as for
+ * uk_netdev_rx_one() apply. Drivers without native burst support fall back
+ * to calling uk_netdev_rx_one() for each packet.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue to receive from.
+ *   The value must be in the range [0, nb_rx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array with at least `*cnt` entries that is filled with references to
+ *   the received packets.
+ * @param cnt
+ *   On input, the maximum number of packets to receive. On return, the number
+ *   of packets stored to `pkts`.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was received.
+ *     - UK_NETDEV_STATUS_MORE: Indicates that more received packets are
+ *        available on the receive queue. When interrupts are used, they are
+ *        disabled until this flag is unset by a subsequent call.
+ *     - UK_NETDEV_STATUS_UNDERRUN: Informs that some available slots of the
+ *        receive queue could not be programmed with a receive buffer.
+ *   - (<0): Negative value with error code from driver, no packet is returned.
+ */
+static inline int uk_netdev_rx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->rx_one);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+	UK_ASSERT(pkts && cnt);
+
+	if (unlikely(!dev->rx_burst))
+		return uk_netdev_rx_burst_compat(dev, dev->_rx_queue[queue_id],
+						 pkts, cnt);
+	return dev->rx_burst(dev, dev->_rx_queue[queue_id], pkts, cnt);
+}
+
+/**
+ * Transmit up to `*cnt` packets. The device is notified once for the whole
+ * burst. Packets are taken in order; transmission stops at the first packet
+ * that does not fit on the transmit queue. Drivers without native burst
+ * support fall back to calling uk_netdev_tx_one() for each packet.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the transmit queue to send with.
+ *   The value must be in the range [0, nb_tx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array of `*cnt` netbufs to send. Sent packets are free'd by the driver
+ *   after the device finished sending them. Packets that were not taken stay
+ *   owned by the caller.
+ * @param cnt
+ *   On input, the number of packets in `pkts`. On return, the number of
+ *   packets that were put to the transmit queue.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was put to the
+ *        transmit queue.
+ *     - UK_NETDEV_STATUS_MORE: All packets were taken and there is still at
+ *        least one descriptor available for a subsequent transmission.
+ *   - (<0): Negative value with error code from driver, no packet was sent.
+ */
+static inline int uk_netdev_tx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->tx_one);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_tx_queue[queue_id]));
+	UK_ASSERT(pkts && cnt);
+
+	if (unlikely(!dev->tx_burst))
+		return uk_netdev_tx_burst_compat(dev, dev->_tx_queue[queue_id],
+						 pkts, cnt);
+	return dev->tx_burst(dev, dev->_tx_queue[queue_id], pkts, cnt);
+}
+
+#if CONFIG_LIBUKNETDEV_POLL
+/**
+ * Configure adaptive polling of a RX queue. The queue is busy-polled with
+ * uk_netdev_poll_rx() while traffic arrives and falls back to interrupts when
+ * it becomes idle (see `struct uk_netdev_poll_conf`). Polling starts in busy
+ * mode and resets the statistics.
+ * A typical receive loop, with the queue event callback waking up the thread:
+ *
+ *   for (;;) {
+ *           cnt = BURST;
+ *           rc = uk_netdev_poll_rx(dev, qid, pkts, &cnt);
+ *           process(pkts, cnt);
+ *           if (rc >= 0 && !uk_netdev_status_more(rc))
+ *                   wait_for_rx_event();
+ *   }
+ *
+ * @param dev
+ *   The Unikraft Network Device in running state.
+ * @param queue_id
+ *   The index of the receive queue.
+ *   The value must be in the range [0, nb_rx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param conf
+ *   Idle budget and interrupt moderation of the queue.
+ * @return
+ *   - (0): Success.
+ *   - (<0): Negative error code.
+ */
+int uk_netdev_rxq_poll_configure(struct uk_netdev *dev, uint16_t queue_id,
+				 const struct uk_netdev_poll_conf *conf);
+
+/**
+ * Poll an adaptively polled RX queue for up to `*cnt` packets. Once the idle
+ * budget is spent, interrupts of the queue are enabled; the function then
+ * returns without UK_NETDEV_STATUS_MORE and the caller should wait for the
+ * queue event. Polling resumes with the next call after the event. Calls
+ * while waiting for the event return without packets. Drivers without queue
+ * interrupts are busy-polled permanently.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue to receive from.
+ * @param pkts
+ *   Array with at least `*cnt` entries that is filled with references to
+ *   the received packets.
+ * @param cnt
+ *   On input, the maximum number of packets to receive. On return, the number
+ *   of packets stored to `pkts`.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was received.
+ *     - UK_NETDEV_STATUS_MORE: The queue is in busy mode, poll again.
+ *        If unset, interrupts are enabled: wait for the queue event.
+ *     - UK_NETDEV_STATUS_UNDERRUN: Some slots of the receive queue could not
+ *        be programmed with a receive buffer.
+ *   - (<0): Negative value with error code from driver, no packet is returned.
+ */
+int uk_netdev_poll_rx(struct uk_netdev *dev, uint16_t queue_id,
+		      struct uk_netbuf **pkts, uint16_t *cnt);
+
+/**
+ * Read the counters of an adaptively polled RX queue.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @param stats
+ *   Reference to the structure filled with the counters.
+ */
+void uk_netdev_poll_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			      struct uk_netdev_poll_stats *stats);
+#endif /* CONFIG_LIBUKNETDEV_POLL */
+
+/**
+ * Compute the Toeplitz hash of a flow tuple with the default RSS key, as
+ * NICs do for receive side scaling.
+ *
+ * @param tuple
+ *   Source and destination address followed by source and destination port,
+ *   all in network byte order. The ports are omitted for flows without them.
+ * @param len
+ *   Length of `tuple` in bytes, at most 36.
+ * @return
+ *   32-bit hash value.
+ */
+__u32 uk_netdev_flow_hash_toeplitz(const __u8 *tuple, size_t len);
+
+/**
+ * Compute the flow hash of an Ethernet frame. TCP and UDP over IPv4 and
+ * IPv6 are hashed over addresses and ports, other IP packets and IPv4
+ * fragments over the addresses only. An optional 802.1Q tag is skipped.
+ * Only the first netbuf of a chain is inspected.
+ *
+ * @param nb
+ *   Netbuf whose data points to the Ethernet header.
+ * @return
+ *   - (0): The frame is not IP or is truncated.
+ *   - 32-bit hash value, equal for all packets of the same flow direction.
+ */
+__u32 uk_netdev_flow_hash(const struct uk_netbuf *nb);
+
+/**
+ * Map a flow hash to a queue, so that all packets of a flow are processed
+ * by the same queue.
+ *
+ * @param hash
+ *   Hash value returned by uk_netdev_flow_hash().
+ * @param nb_queues
+ *   Number of queues configured with uk_netdev_configure().
+ * @return
+ *   Queue index in the range [0, nb_queues - 1].
+ */
+static inline uint16_t uk_netdev_flow_queue(__u32 hash, uint16_t nb_queues)
+{
+	UK_ASSERT(nb_queues > 0);
+
+	return (uint16_t) (((__u64) hash * nb_queues) >> 32);
+}
+
+/**
+ * Queue owned by the current logical CPU. When every lcpu transmits on,
+ * and polls, its own queue pair, the queues need no locking.
+ *
+ * @param nb_queues
+ *   Number of queues configured with uk_netdev_configure().
+ * @return
+ *   Queue index in the range [0, nb_queues - 1].
+ */
+static inline uint16_t uk_netdev_lcpu_queue(uint16_t nb_queues)
+{
+	UK_ASSERT(nb_queues > 0);
+
+	return (uint16_t) (ukplat_lcpu_idx() % nb_queues);
+}
+
 /**
  * Tests for status flags returned by `uk_netdev_rx_one` or `uk_netdev_tx_one`.
  * When the functions returned an error code or one of the selected flags is
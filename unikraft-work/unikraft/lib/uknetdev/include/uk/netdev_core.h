@@ -43,6 +43,9 @@
 #include <uk/list.h>
 #include <uk/alloc.h>
 #include <uk/essentials.h>
+#if CONFIG_LIBUKNETDEV_POLL
+#include <uk/arch/time.h>
+#endif /* CONFIG_LIBUKNETDEV_POLL */
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
 #include <uk/sched.h>
 #include <uk/semaphore.h>
@@ -138,12 +141,38 @@ struct uk_hwaddr {
 #define UK_NETDEV_F_PARTIAL_CSUM_BIT	2
 #define UK_NETDEV_F_PARTIAL_CSUM	(1UL << UK_NETDEV_F_PARTIAL_CSUM_BIT)
 
+/* Indicates that the device segments packets marked with UK_NETBUF_F_GSO
+ * on transmit: TCP over IPv4 (TSO4), TCP over IPv6 (TSO6), UDP over
+ * IPv4 (UFO).
+ */
+#define UK_NETDEV_F_TSO4_BIT		3
+#define UK_NETDEV_F_TSO4		(1UL << UK_NETDEV_F_TSO4_BIT)
+#define UK_NETDEV_F_TSO6_BIT		4
+#define UK_NETDEV_F_TSO6		(1UL << UK_NETDEV_F_TSO6_BIT)
+#define UK_NETDEV_F_UFO_BIT		5
+#define UK_NETDEV_F_UFO			(1UL << UK_NETDEV_F_UFO_BIT)
+
+/* Indicates that received packets can be larger than the MTU, because the
+ * device coalesced segments (marked with UK_NETBUF_F_GSO), and that they can
+ * be spread over a chain of receive netbufs.
+ */
+#define UK_NETDEV_F_LRO_BIT		6
+#define UK_NETDEV_F_LRO			(1UL << UK_NETDEV_F_LRO_BIT)
+
 #define uk_netdev_rxintr_supported(feature)	\
 	(feature & (UK_NETDEV_F_RXQ_INTR))
 #define uk_netdev_txintr_supported(feature)	\
 	(feature & (UK_NETDEV_F_TXQ_INTR))
 #define uk_netdev_partial_csum_supported(feature)	\
 	(feature & (UK_NETDEV_F_PARTIAL_CSUM))
+#define uk_netdev_tso4_supported(feature)	\
+	(feature & (UK_NETDEV_F_TSO4))
+#define uk_netdev_tso6_supported(feature)	\
+	(feature & (UK_NETDEV_F_TSO6))
+#define uk_netdev_ufo_supported(feature)	\
+	(feature & (UK_NETDEV_F_UFO))
+#define uk_netdev_lro_supported(feature)	\
+	(feature & (UK_NETDEV_F_LRO))
 
 /**
  * A structure used to describe network device capabilities.
@@ -283,6 +312,39 @@ struct uk_netdev_rxqueue_conf {
 #endif
 };
 
+#if CONFIG_LIBUKNETDEV_POLL
+/**
+ * A structure used to configure adaptive polling of a RX queue
+ * (see uk_netdev_rxq_poll_configure()).
+ *
+ * Interrupts are re-enabled on an empty poll when the idle budget is spent:
+ * at least `idle_polls` consecutive polls found no packet and the last packet
+ * is at least `idle_time` old. Interrupt moderation additionally keeps
+ * interrupts off after an interrupt until `intr_pkts` packets were received
+ * or `intr_time` has passed, whichever comes first. This bounds the interrupt
+ * rate to one per `intr_time` under light load; `intr_time` = 0 disables it.
+ */
+struct uk_netdev_poll_conf {
+	uint32_t idle_polls; /**< Empty polls before interrupts are enabled */
+	__nsec idle_time;    /**< Time without packets before enabling them */
+	uint32_t intr_pkts;  /**< Moderation: packets per interrupt */
+	__nsec intr_time;    /**< Moderation: time from interrupt to enabling */
+};
+
+/**
+ * Counters of an adaptively polled RX queue. The busy time relative to the
+ * elapsed time tells the CPU share spent on polling the queue.
+ */
+struct uk_netdev_poll_stats {
+	uint64_t polls;       /**< Calls to uk_netdev_poll_rx() */
+	uint64_t empty_polls; /**< Polls that found no packet */
+	uint64_t pkts;        /**< Packets received */
+	uint64_t intr_arm;    /**< Switches from polling to interrupts */
+	uint64_t intr;        /**< Interrupts that resumed polling */
+	__nsec busy_time;     /**< Time spent polling */
+};
+#endif /* CONFIG_LIBUKNETDEV_POLL */
+
 /**
  * A structure used to configure an Unikraft network device TX queue.
  */
@@ -385,6 +447,22 @@ typedef int (*uk_netdev_tx_one_t)(struct uk_netdev *dev,
 				  struct uk_netdev_tx_queue *queue,
 				  struct uk_netbuf *pkt);
 
+/**
+ * Driver callback type to retrieve up to `*cnt` packets from a RX queue.
+ * On return, `*cnt` holds the number of packets stored to `pkts`.
+ */
+typedef int (*uk_netdev_rx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, uint16_t *cnt);
+
+/**
+ * Driver callback type to submit up to `*cnt` packets to a TX queue.
+ * On return, `*cnt` holds the number of packets taken from `pkts`.
+ */
+typedef int (*uk_netdev_tx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, uint16_t *cnt);
+
 /**
  * A structure containing the functions exported by a driver.
  */
@@ -437,6 +515,25 @@ struct uk_netdev_event_handler {
 #endif
 };
 
+#if CONFIG_LIBUKNETDEV_POLL
+/**
+ * @internal
+ * Adaptive polling state of a RX queue (internal to libuknetdev)
+ */
+struct uk_netdev_poll {
+	struct uk_netdev_poll_conf conf;
+	struct uk_netdev_poll_stats stats;
+
+	int armed;              /**< Interrupts enabled, cleared by event */
+	int busy;               /**< Polling since `busy_start` */
+	int can_arm;            /**< Driver supports queue interrupts */
+	uint32_t idle;          /**< Consecutive empty polls */
+	uint32_t resumed_pkts;  /**< Packets received since polling resumed */
+	__nsec busy_start;
+	__nsec last_pkt;
+};
+#endif /* CONFIG_LIBUKNETDEV_POLL */
+
 /**
  * @internal
  * libuknetdev internal data associated with each network device.
@@ -446,6 +543,9 @@ struct uk_netdev_data {
 
 	struct uk_netdev_event_handler
 			     rxq_handler[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+#if CONFIG_LIBUKNETDEV_POLL
+	struct uk_netdev_poll rxq_poll[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+#endif /* CONFIG_LIBUKNETDEV_POLL */
 
 	const uint16_t       id;    /**< ID is assigned during registration */
 	const char           *drv_name;
@@ -461,10 +561,10 @@ struct uk_netdev_einfo {
  * NETDEV
  * A structure used to interact with a network device.
  *
- * Function callbacks (tx_one, rx_one, ops) are registered by the driver before
- * registering the netdev. They change during device life time. Packet RX/TX
- * functions are added directly to this structure for performance reasons.
- * It prevents another indirection to ops.
+ * Function callbacks (tx_one, rx_one, tx_burst, rx_burst, ops) are registered
+ * by the driver before registering the netdev. They change during device life
+ * time. Packet RX/TX functions are added directly to this structure for
+ * performance reasons. It prevents another indirection to ops.
  */
 struct uk_netdev {
 	/** Packet transmission. */
@@ -473,6 +573,10 @@ struct uk_netdev {
 	/** Packet reception. */
 	uk_netdev_rx_one_t          rx_one; /* by driver */
 
+	/** Burst transmission and reception. */
+	uk_netdev_tx_burst_t        tx_burst; /* by driver, optional */
+	uk_netdev_rx_burst_t        rx_burst; /* by driver, optional */
+
 	/** Pointer to API-internal state data. */
 	struct uk_netdev_data       *_data;
 
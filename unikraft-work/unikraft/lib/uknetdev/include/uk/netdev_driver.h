@@ -34,6 +34,9 @@
 
 #include <uk/netdev_core.h>
 #include <uk/assert.h>
+#if CONFIG_LIBUKNETDEV_POLL
+#include <uk/arch/atomic.h>
+#endif /* CONFIG_LIBUKNETDEV_POLL */
 
 /**
  * Unikraft network driver API.
@@ -85,6 +88,14 @@ static inline void uk_netdev_drv_rx_event(struct uk_netdev *dev,
 
 	rxq_handler = &dev->_data->rxq_handler[queue_id];
 
+#if CONFIG_LIBUKNETDEV_POLL
+	/* The interrupt ends waiting of an adaptively polled queue */
+	if (ukarch_load_n(&dev->_data->rxq_poll[queue_id].armed)) {
+		ukarch_store_n(&dev->_data->rxq_poll[queue_id].armed, 0);
+		dev->_data->rxq_poll[queue_id].stats.intr++;
+	}
+#endif /* CONFIG_LIBUKNETDEV_POLL */
+
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
 	uk_semaphore_up(&rxq_handler->events);
 #else
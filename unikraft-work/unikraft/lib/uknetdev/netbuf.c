@@ -32,6 +32,11 @@
 #include <uk/netbuf.h>
 #include <uk/essentials.h>
 #include <uk/print.h>
+#if CONFIG_LIBUKNETDEV_POOL
+#include <string.h>
+#include <uk/allocpool.h>
+#include <uk/plat/spinlock.h>
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 
 /* Used to align netbuf's priv and data areas to `long long` data type */
 #define NETBUF_ADDR_ALIGNMENT (sizeof(long long))
@@ -161,6 +166,201 @@ struct uk_netbuf *uk_netbuf_prepare_buf(void *mem, size_t size,
 	return m;
 }
 
+#if CONFIG_LIBUKNETDEV_POOL
+#define NETBUF_CACHE_LEN   CONFIG_LIBUKNETDEV_POOL_CACHESIZE
+/* Number of netbufs a cache exchanges with the shared pool at once */
+#define NETBUF_CACHE_BATCH (NETBUF_CACHE_LEN / 2)
+
+/* A netbuf may be free'd from another thread or an interrupt handler than
+ * the one serving the queue, so every cache has a lock. It is normally only
+ * taken by the owner of the cache and thus uncontended. The pool lock
+ * nests inside the cache lock.
+ */
+struct uk_netbuf_cache {
+	struct uk_netbuf_pool *p;
+	__spinlock lock;
+	unsigned int count;
+	/* Allocations of the cached netbufs, the last one is taken first */
+	void *obj[NETBUF_CACHE_LEN];
+};
+
+struct uk_netbuf_pool {
+	__spinlock lock;   /* protects ap */
+	struct uk_allocpool *ap;
+	size_t meta_off;   /* Offset of `struct uk_netbuf` in an allocation */
+	uint16_t headroom;
+	uint16_t nb_caches;
+	struct uk_netbuf_cache caches[];
+};
+
+static inline struct uk_netbuf *netbuf_pool_obj2nb(struct uk_netbuf_pool *p,
+						   void *obj)
+{
+	return (struct uk_netbuf *) ((__uptr) obj + p->meta_off);
+}
+
+struct uk_netbuf_pool *uk_netbuf_pool_alloc(struct uk_alloc *a,
+					    unsigned int count,
+					    size_t buflen, size_t bufalign,
+					    uint16_t headroom, size_t privlen,
+					    uint16_t nb_caches,
+					    uk_netbuf_dtor_t dtor)
+{
+	struct uk_netbuf_pool *p;
+	struct uk_netbuf *m, *prepared = NULL;
+	unsigned int i;
+	size_t obj_len;
+	void *obj;
+
+	UK_ASSERT(a);
+	UK_ASSERT(count > 0);
+	UK_ASSERT(buflen > 0);
+	UK_ASSERT(headroom <= buflen);
+	UK_ASSERT(nb_caches > 0);
+
+	p = uk_malloc(a, sizeof(*p) + nb_caches * sizeof(p->caches[0]));
+	if (!p)
+		return NULL;
+
+	obj_len = NETBUF_ADDR_ALIGN_UP(buflen)
+		  + NETBUF_ADDR_ALIGN_UP(sizeof(*m) + privlen);
+	p->ap = uk_allocpool_alloc(a, count, obj_len,
+				   MAX(bufalign, NETBUF_ADDR_ALIGNMENT));
+	if (!p->ap) {
+		uk_free(a, p);
+		return NULL;
+	}
+	p->headroom  = headroom;
+	p->nb_caches = nb_caches;
+	ukarch_spin_init(&p->lock);
+	for (i = 0; i < nb_caches; i++) {
+		p->caches[i].p = p;
+		ukarch_spin_init(&p->caches[i].lock);
+		p->caches[i].count = 0;
+	}
+
+	/* Prepare every netbuf once. Objects are handed out again in LIFO
+	 * order, so we keep all of them until the last one is prepared.
+	 * The free-list entry of a free object overlaps with the headroom,
+	 * the metadata at the end of the object stays intact.
+	 */
+	for (i = uk_allocpool_availcount(p->ap); i > 0; i--) {
+		obj = uk_allocpool_take(p->ap);
+		m = uk_netbuf_prepare_buf(obj, uk_allocpool_objlen(p->ap),
+					  headroom, privlen, dtor);
+		UK_ASSERT(m);
+		if (!prepared)
+			p->meta_off = (size_t) ((__uptr) m - (__uptr) obj);
+		UK_ASSERT(netbuf_pool_obj2nb(p, obj) == m);
+
+		m->_b = obj;
+		m->next = prepared;
+		prepared = m;
+	}
+	while (prepared) {
+		m = prepared;
+		prepared = m->next;
+		m->next = NULL;
+		uk_allocpool_return(p->ap, m->_b);
+	}
+
+	uk_pr_debug("%p: Netbuf pool created: %u netbufs, %u caches\n",
+		    p, uk_allocpool_availcount(p->ap), nb_caches);
+	return p;
+}
+
+struct uk_netbuf_cache *uk_netbuf_pool_cache_get(struct uk_netbuf_pool *p,
+						 uint16_t idx)
+{
+	UK_ASSERT(p);
+	UK_ASSERT(idx < p->nb_caches);
+
+	return &p->caches[idx];
+}
+
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p)
+{
+	unsigned long flags;
+	unsigned int count;
+
+	UK_ASSERT(p);
+
+	ukplat_spin_lock_irqsave(&p->lock, flags);
+	count = uk_allocpool_availcount(p->ap);
+	ukplat_spin_unlock_irqrestore(&p->lock, flags);
+	return count;
+}
+
+uint16_t uk_netbuf_cache_take_batch(struct uk_netbuf_cache *c,
+				    struct uk_netbuf *m[], uint16_t count)
+{
+	struct uk_netbuf_pool *p;
+	unsigned long flags;
+	uint16_t i;
+
+	UK_ASSERT(c);
+	UK_ASSERT(m);
+
+	p = c->p;
+	ukplat_spin_lock_irqsave(&c->lock, flags);
+	for (i = 0; i < count; i++) {
+		if (unlikely(c->count == 0)) {
+			ukarch_spin_lock(&p->lock);
+			c->count = uk_allocpool_take_batch(p->ap, c->obj,
+							   NETBUF_CACHE_BATCH);
+			ukarch_spin_unlock(&p->lock);
+			if (unlikely(c->count == 0))
+				break;
+		}
+
+		/* Only the fields a user may have changed need a reset */
+		m[i] = netbuf_pool_obj2nb(p, c->obj[--c->count]);
+		UK_ASSERT(!m[i]->next && !m[i]->prev);
+		m[i]->data  = (void *) ((__uptr) m[i]->buf + p->headroom);
+		m[i]->len   = 0;
+		m[i]->flags = 0;
+		m[i]->_c    = c;
+		uk_refcount_init(&m[i]->refcount, 1);
+	}
+	ukplat_spin_unlock_irqrestore(&c->lock, flags);
+	return i;
+}
+
+uint16_t uk_netbuf_cache_alloc_rxpkts(void *argp, struct uk_netbuf *pkts[],
+				      uint16_t count)
+{
+	struct uk_netbuf_cache *c = (struct uk_netbuf_cache *) argp;
+	uint16_t i, cnt;
+
+	cnt = uk_netbuf_cache_take_batch(c, pkts, count);
+	for (i = 0; i < cnt; i++)
+		pkts[i]->len = pkts[i]->buflen - c->p->headroom;
+	return cnt;
+}
+
+static void netbuf_cache_return(struct uk_netbuf_cache *c, void *obj)
+{
+	unsigned long flags;
+
+	UK_ASSERT(c);
+	UK_ASSERT(obj);
+
+	ukplat_spin_lock_irqsave(&c->lock, flags);
+	/* Hand the least recently used half back to the shared pool */
+	if (unlikely(c->count == NETBUF_CACHE_LEN)) {
+		ukarch_spin_lock(&c->p->lock);
+		uk_allocpool_return_batch(c->p->ap, c->obj,
+					  NETBUF_CACHE_BATCH);
+		ukarch_spin_unlock(&c->p->lock);
+		c->count -= NETBUF_CACHE_BATCH;
+		memmove(c->obj, &c->obj[NETBUF_CACHE_BATCH],
+			c->count * sizeof(c->obj[0]));
+	}
+	c->obj[c->count++] = obj;
+	ukplat_spin_unlock_irqrestore(&c->lock, flags);
+}
+#endif /* CONFIG_LIBUKNETDEV_POOL */
+
 struct uk_netbuf *uk_netbuf_disconnect(struct uk_netbuf *m)
 {
 	struct uk_netbuf *remhead = NULL;
@@ -218,6 +418,9 @@ void uk_netbuf_free_single(struct uk_netbuf *m)
 {
 	struct uk_alloc *a;
 	void *b;
+#if CONFIG_LIBUKNETDEV_POOL
+	struct uk_netbuf_cache *c;
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 
 	UK_ASSERT(m);
 
@@ -239,9 +442,18 @@ void uk_netbuf_free_single(struct uk_netbuf *m)
 		 */
 		a = m->_a;
 		b = m->_b;
+#if CONFIG_LIBUKNETDEV_POOL
+		c = m->_c;
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 
 		if (m->dtor)
 			m->dtor(m);
+#if CONFIG_LIBUKNETDEV_POOL
+		if (c) {
+			netbuf_cache_return(c, b);
+			return;
+		}
+#endif /* CONFIG_LIBUKNETDEV_POOL */
 		if (a && b)
 			uk_free(a, b);
 	} else {
@@ -643,3 +643,76 @@ int uk_netdev_mtu_set(struct uk_netdev *dev, uint16_t mtu)
 
 	return dev->ops->mtu_set(dev, mtu);
 }
+
+int uk_netdev_rx_burst_compat(struct uk_netdev *dev,
+			      struct uk_netdev_rx_queue *queue,
+			      struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	int status = 0x0;
+	uint16_t i = 0;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->rx_one);
+	UK_ASSERT(pkts && cnt);
+
+	while (i < *cnt) {
+		rc = dev->rx_one(dev, queue, &pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (!i) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		status = (status & UK_NETDEV_STATUS_UNDERRUN) | rc;
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS))
+			break;
+		i++;
+		if (!(rc & UK_NETDEV_STATUS_MORE))
+			break;
+	}
+
+	status &= ~UK_NETDEV_STATUS_SUCCESS;
+	if (i)
+		status |= UK_NETDEV_STATUS_SUCCESS;
+	*cnt = i;
+	return status;
+}
+
+int uk_netdev_tx_burst_compat(struct uk_netdev *dev,
+			      struct uk_netdev_tx_queue *queue,
+			      struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	int status = 0x0;
+	uint16_t i = 0;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->tx_one);
+	UK_ASSERT(pkts && cnt);
+
+	while (i < *cnt) {
+		rc = dev->tx_one(dev, queue, pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (!i) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		status = rc;
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS))
+			break;
+		i++;
+	}
+
+	/* MORE is only reported when the queue took all packets */
+	if (i < *cnt)
+		status &= ~UK_NETDEV_STATUS_MORE;
+	status &= ~UK_NETDEV_STATUS_SUCCESS;
+	if (i)
+		status |= UK_NETDEV_STATUS_SUCCESS;
+	*cnt = i;
+	return status;
+}
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/netdev.h>
+#include <uk/arch/atomic.h>
+#include <uk/plat/time.h>
+#include <uk/print.h>
+
+static inline struct uk_netdev_poll *poll_get(struct uk_netdev *dev,
+					      uint16_t queue_id)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+
+	return &dev->_data->rxq_poll[queue_id];
+}
+
+int uk_netdev_rxq_poll_configure(struct uk_netdev *dev, uint16_t queue_id,
+				 const struct uk_netdev_poll_conf *conf)
+{
+	struct uk_netdev_poll *p;
+
+	UK_ASSERT(conf);
+
+	p = poll_get(dev, queue_id);
+	if (dev->_data->state != UK_NETDEV_RUNNING)
+		return -EINVAL;
+
+	/* Start in busy mode, with interrupts off */
+	ukarch_store_n(&p->armed, 0);
+	if (dev->ops->rxq_intr_disable)
+		uk_netdev_rxq_intr_disable(dev, queue_id);
+
+	memset(&p->stats, 0, sizeof(p->stats));
+	p->conf    = *conf;
+	p->busy    = 0;
+	p->can_arm = (dev->ops->rxq_intr_enable != NULL);
+
+	uk_pr_info("netdev%"PRIu16": Adaptive polling on receive queue %"PRIu16"\n",
+		   dev->_data->id, queue_id);
+	return 0;
+}
+
+int uk_netdev_poll_rx(struct uk_netdev *dev, uint16_t queue_id,
+		      struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	struct uk_netdev_poll *p;
+	__nsec now;
+	int status;
+	int rc;
+
+	UK_ASSERT(pkts && cnt);
+
+	p = poll_get(dev, queue_id);
+	if (ukarch_load_n(&p->armed)) {
+		/* Still waiting for the queue event */
+		*cnt = 0;
+		return 0x0;
+	}
+
+	now = ukplat_monotonic_clock();
+	if (!p->busy) {
+		/* Resuming after an interrupt: The driver disabled the queue
+		 * interrupt, but would enable it again as soon as the queue
+		 * runs empty. We decide ourselves when to do that.
+		 */
+		if (p->can_arm)
+			uk_netdev_rxq_intr_disable(dev, queue_id);
+		p->busy         = 1;
+		p->busy_start   = now;
+		p->last_pkt     = now;
+		p->idle         = 0;
+		p->resumed_pkts = 0;
+	}
+
+	p->stats.polls++;
+	status = uk_netdev_rx_burst(dev, queue_id, pkts, cnt);
+	if (unlikely(status < 0))
+		return status;
+
+	if (*cnt) {
+		p->stats.pkts   += *cnt;
+		p->resumed_pkts += *cnt;
+		p->idle          = 0;
+		p->last_pkt      = now;
+		return status | UK_NETDEV_STATUS_MORE;
+	}
+
+	p->stats.empty_polls++;
+	p->idle++;
+	if (!p->can_arm
+	    || p->idle < p->conf.idle_polls
+	    || now - p->last_pkt < p->conf.idle_time)
+		return status | UK_NETDEV_STATUS_MORE;
+
+	/* Interrupt moderation: hold interrupts off after an interrupt */
+	if (p->resumed_pkts < p->conf.intr_pkts
+	    && now - p->busy_start < p->conf.intr_time)
+		return status | UK_NETDEV_STATUS_MORE;
+
+	/* Set before enabling, so that an immediate interrupt clears it */
+	ukarch_store_n(&p->armed, 1);
+	rc = uk_netdev_rxq_intr_enable(dev, queue_id);
+	if (rc != 0) {
+		/* Packets arrived meanwhile (1) or no interrupt support */
+		ukarch_store_n(&p->armed, 0);
+		if (rc < 0)
+			p->can_arm = 0;
+		else
+			uk_netdev_rxq_intr_disable(dev, queue_id);
+		p->idle = 0;
+		return status | UK_NETDEV_STATUS_MORE;
+	}
+
+	p->busy = 0;
+	p->stats.intr_arm++;
+	p->stats.busy_time += now - p->busy_start;
+	return status;
+}
+
+void uk_netdev_poll_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			      struct uk_netdev_poll_stats *stats)
+{
+	struct uk_netdev_poll *p;
+
+	UK_ASSERT(stats);
+
+	p = poll_get(dev, queue_id);
+	*stats = p->stats;
+
+	/* Account the ongoing busy period */
+	if (p->busy)
+		stats->busy_time += ukplat_monotonic_clock() - p->busy_start;
+}
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/netbuf.h>
+#include <uk/essentials.h>
+#if CONFIG_LIBUKSCHED
+#include <uk/sched.h>
+#endif /* CONFIG_LIBUKSCHED */
+
+/* More netbufs than a cache holds, so that frees also reach the pool */
+#define TEST_NETBUFS	(2 * CONFIG_LIBUKNETDEV_POOL_CACHESIZE)
+#define TEST_BUFLEN	256
+#define TEST_HEADROOM	64
+
+static struct uk_netbuf_pool *pool;
+static struct uk_netbuf *nbs[TEST_NETBUFS];
+
+static int netbuf_test_init(struct uk_testsuite *suite __unused)
+{
+	pool = uk_netbuf_pool_alloc(uk_alloc_get_default(), TEST_NETBUFS,
+				    TEST_BUFLEN, 1, TEST_HEADROOM, 0, 1, NULL);
+	return pool ? 0 : -ENOMEM;
+}
+
+/* Takes every netbuf of the pool through its cache */
+static unsigned int take_all(void)
+{
+	struct uk_netbuf_cache *c = uk_netbuf_pool_cache_get(pool, 0);
+
+	return uk_netbuf_cache_take_batch(c, nbs, TEST_NETBUFS);
+}
+
+UK_TESTCASE(uknetdev_netbuf, pool_take_free)
+{
+	struct uk_netbuf_cache *c = uk_netbuf_pool_cache_get(pool, 0);
+	unsigned int i;
+
+	UK_TEST_EXPECT_SNUM_EQ(take_all(), TEST_NETBUFS);
+	UK_TEST_EXPECT_NULL(uk_netbuf_cache_take(c));
+	UK_TEST_EXPECT_SNUM_EQ(uk_netbuf_pool_availcount(pool), 0);
+	UK_TEST_EXPECT_SNUM_EQ(uk_netbuf_headroom(nbs[0]), TEST_HEADROOM);
+
+	for (i = 0; i < TEST_NETBUFS; i++)
+		uk_netbuf_free(nbs[i]);
+	UK_TEST_EXPECT_SNUM_EQ(take_all(), TEST_NETBUFS);
+	for (i = 0; i < TEST_NETBUFS; i++)
+		uk_netbuf_free(nbs[i]);
+}
+
+#if CONFIG_LIBUKSCHED
+static volatile int free_done;
+
+/* Frees every other netbuf while the test thread frees the rest */
+static __noreturn void free_thread(void *arg __unused)
+{
+	unsigned int i;
+
+	for (i = 1; i < TEST_NETBUFS; i += 2) {
+		uk_netbuf_free(nbs[i]);
+		if ((i % 16) == 1)
+			uk_sched_yield();
+	}
+	free_done = 1;
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(uknetdev_netbuf, free_from_thread)
+{
+	unsigned int i, j, dups = 0;
+	struct uk_thread *t;
+
+	UK_TEST_EXPECT_SNUM_EQ(take_all(), TEST_NETBUFS);
+
+	free_done = 0;
+	t = uk_sched_thread_create(uk_sched_current(), free_thread, NULL,
+				   "netbuf-free");
+	UK_TEST_ASSERT(t != NULL);
+	for (i = 0; i < TEST_NETBUFS; i += 2) {
+		uk_netbuf_free(nbs[i]);
+		if ((i % 16) == 0)
+			uk_sched_yield();
+	}
+	while (!free_done)
+		uk_sched_yield();
+
+	/* No netbuf got lost or handed out twice */
+	UK_TEST_EXPECT_SNUM_EQ(take_all(), TEST_NETBUFS);
+	for (i = 0; i < TEST_NETBUFS; i++)
+		for (j = i + 1; j < TEST_NETBUFS; j++)
+			dups += (nbs[i] == nbs[j]);
+	UK_TEST_EXPECT_SNUM_EQ(dups, 0);
+	for (i = 0; i < TEST_NETBUFS; i++)
+		uk_netbuf_free(nbs[i]);
+}
+#endif /* CONFIG_LIBUKSCHED */
+
+uk_testsuite_register(uknetdev_netbuf, netbuf_test_init);
@@ -102,8 +102,16 @@ static int vma_file_read(struct vfscore_file *fp, __vaddr_t buf, __sz len,
 	};
 	int rc;
 
+	/* Go through the page cache of the file system if there is one, so
+	 * that faults on the same file data do not hit the file system again.
+	 * The data is still copied: mapping cached pages directly needs
+	 * reference counted frames, since unmapping frees the frames.
+	 */
 	vn_lock(vp);
-	rc = VOP_READ(vp, fp, &uio, 0);
+	if (vp->v_op->vop_cache)
+		rc = VOP_CACHE(vp, fp, &uio);
+	else
+		rc = VOP_READ(vp, fp, &uio, 0);
 	vn_unlock(vp);
 
 	if (unlikely(rc))
@@ -71,7 +71,10 @@ int vfs_read(struct vfscore_file *fp, struct uio *uio, int flags)
 	if ((flags & FOF_OFFSET) == 0)
 		uio->uio_offset = fp->f_offset;
 
-	error = VOP_READ(vp, fp, uio, 0);
+	if (vp->v_op->vop_cache)
+		error = VOP_CACHE(vp, fp, uio);
+	else
+		error = VOP_READ(vp, fp, uio, 0);
 	if (!error) {
 		count = bytes - uio->uio_resid;
 		if (((flags & FOF_OFFSET) == 0) &&
@@ -104,7 +107,10 @@ int vfs_write(struct vfscore_file *fp, struct uio *uio, int flags)
 	if ((flags & FOF_OFFSET) == 0)
 		uio->uio_offset = fp->f_offset;
 
-	error = VOP_WRITE(vp, uio, ioflags);
+	if (vp->v_op->vop_cache)
+		error = VOP_CACHE(vp, fp, uio);
+	else
+		error = VOP_WRITE(vp, uio, ioflags);
 	if (!error) {
 		count = bytes - uio->uio_resid;
 		if (!(flags & FOF_OFFSET) &&
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef _VFSCORE_PAGECACHE_H_
+#define _VFSCORE_PAGECACHE_H_
+
+#include <uk/config.h>
+#include <vfscore/vnode.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+
+/*
+ * The page cache keeps file data in page-sized buffers keyed by vnode and
+ * page index. A file system opts in by setting `vop_cache` to
+ * vfscore_pagecache_vop: vfscore then routes read() and write() on regular
+ * files through the cache, which calls VOP_READ to fill pages and VOP_WRITE
+ * to write dirty pages back. The file system must keep `v_size` up to date,
+ * and VOP_WRITE must not depend on an open file since write-back also runs
+ * from the flusher thread and on vnode release.
+ */
+
+struct vfscore_pagecache_stats {
+	__u64 hits;		/* lookups served from the cache */
+	__u64 misses;		/* pages read on demand */
+	__u64 readahead;	/* pages read ahead of a sequential reader */
+	__u64 writeback;	/* dirty pages written back */
+	__u64 evictions;	/* clean pages dropped */
+	unsigned long pages;	/* pages cached right now */
+	unsigned long dirty;	/* of which are dirty */
+};
+
+/**
+ * Generic `vop_cache` operation. Performs the read or write described by
+ * `uio` on the cached pages of `vp`. Must be called with `vp` locked.
+ *
+ * @return
+ *   0 on success, a positive errno value otherwise
+ */
+int vfscore_pagecache_vop(struct vnode *vp, struct vfscore_file *fp,
+			  struct uio *uio);
+
+/* Returns 1 if the vnode uses the page cache */
+static inline int vfscore_pagecache_enabled(struct vnode *vp)
+{
+	return vp->v_op->vop_cache == vfscore_pagecache_vop;
+}
+
+/**
+ * Writes back all dirty pages of `vp`. Must be called with `vp` locked.
+ *
+ * @return
+ *   0 on success, a positive errno value otherwise
+ */
+int vfscore_pagecache_flush(struct vnode *vp);
+
+/**
+ * Drops cached pages beyond `length` after the file system truncated `vp`,
+ * and sets `v_size` accordingly. Must be called with `vp` locked.
+ */
+void vfscore_pagecache_truncate(struct vnode *vp, off_t length);
+
+/**
+ * Writes back and drops all pages of `vp`. Called when the last reference
+ * to `vp` is gone, before VOP_INACTIVE.
+ */
+void vfscore_pagecache_release(struct vnode *vp);
+
+/**
+ * Writes back the dirty pages of all vnodes that are not locked by other
+ * threads.
+ */
+void vfscore_pagecache_sync(void);
+
+/**
+ * Drops up to `count` clean pages, least recently used first. Can be called
+ * to give memory back under pressure.
+ *
+ * @return
+ *   Number of pages dropped
+ */
+unsigned long vfscore_pagecache_shrink(unsigned long count);
+
+void vfscore_pagecache_stats_get(struct vfscore_pagecache_stats *stats);
+
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VFSCORE_PAGECACHE_H_ */
@@ -86,6 +86,14 @@ struct vnode {
 	struct uk_mutex	v_lock;		/* lock for this vnode */
 	struct uk_list_head v_names;	/* directory entries pointing at this */
 	void		*v_data;	/* private data for fs */
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	struct uk_list_head v_pages;	/* pages in the page cache */
+	struct uk_list_head v_dirty;	/* dirty pages, oldest first */
+	struct uk_list_head v_dirty_link; /* link in list of dirty vnodes */
+	unsigned long	v_ndirty;	/* number of dirty pages */
+	unsigned long	v_ra_next;	/* page a sequential read continues at */
+	unsigned long	v_ra_pages;	/* current read-ahead window */
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 };
 
 /* flags for vnode */
@@ -183,6 +191,28 @@ typedef int (*vnop_symlink_t)   (struct vnode *, char *, char *);
 typedef int (*vnop_poll_t)	(struct vnode *, unsigned int *,
 				 struct eventpoll_cb *);
 
+/*
+ * Asynchronous read of `aio_iov` at `aio_offset`. The file system starts
+ * the device I/O and returns 0; once it finished, it sets `aio_res` to the
+ * number of bytes read or a negative error code and calls `aio_done`,
+ * possibly from interrupt context. The iovec array and the buffers must
+ * stay valid until then. Returns ENOTSUP if the read cannot be done
+ * asynchronously, in which case the caller falls back to VOP_READ.
+ */
+struct vfscore_aio;
+typedef void (*vfscore_aio_done_t)(struct vfscore_aio *);
+
+struct vfscore_aio {
+	const struct iovec	*aio_iov;
+	int			aio_iovcnt;
+	off_t			aio_offset;
+	long			aio_res;
+	vfscore_aio_done_t	aio_done;
+};
+
+typedef int (*vnop_aread_t)	(struct vnode *, struct vfscore_file *,
+				 struct vfscore_aio *);
+
 /*
  * vnode operations
  */
@@ -211,6 +241,7 @@ struct vnops {
 	vnop_readlink_t		vop_readlink;
 	vnop_symlink_t		vop_symlink;
 	vnop_poll_t		vop_poll;
+	vnop_aread_t		vop_aread;
 };
 
 /*
@@ -241,6 +272,7 @@ struct vnops {
 #define VOP_READLINK(VP, U)        ((VP)->v_op->vop_readlink)(VP, U)
 #define VOP_SYMLINK(DVP, NP, OP)   ((DVP)->v_op->vop_symlink)(DVP, NP, OP)
 #define VOP_POLL(VP, EP, ECP)	   ((VP)->v_op->vop_poll)(VP, EP, ECP)
+#define VOP_AREAD(VP, FP, AIO)	   ((VP)->v_op->vop_aread)(VP, FP, AIO)
 
 int vfscore_vop_nullop();
 int vfscore_vop_einval();
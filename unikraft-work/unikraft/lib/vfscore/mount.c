@@ -52,6 +52,7 @@
 #include <vfscore/prex.h>
 #include <vfscore/dentry.h>
 #include <vfscore/vnode.h>
+#include <vfscore/pagecache.h>
 #include <uk/syscall.h>
 
 /*
@@ -369,6 +370,10 @@ sys_pivot_root(const char *new_root, const char *put_old)
 UK_LLSYSCALL_R_DEFINE(int, sync)
 {
 	struct mount *mp;
+
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	vfscore_pagecache_sync();
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	uk_mutex_lock(&mount_lock);
 
 	/* Call each mounted file system. */
@@ -0,0 +1,675 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/arch/limits.h>
+#include <uk/arch/time.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/list.h>
+#include <uk/mutex.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <vfscore/file.h>
+#include <vfscore/pagecache.h>
+
+#define PC_PAGE_SHIFT		__PAGE_SHIFT
+#define PC_PAGE_SIZE		((size_t)__PAGE_SIZE)
+
+#define PC_HASH_BUCKETS		1024
+#define PC_EVICT_BATCH		8
+/* Evict before allocating when the allocator has fewer free pages */
+#define PC_LOWMEM_PAGES		256
+/* Read-ahead window of a sequential reader */
+#define PC_RA_MAX		((unsigned long)CONFIG_LIBVFSCORE_PAGECACHE_READAHEAD)
+#define PC_RA_MIN		MIN(4UL, PC_RA_MAX)
+
+#define PG_DIRTY		0x1
+
+/*
+ * A cached page. Pages hold file data up to the end of the file; everything
+ * beyond, as well as holes, reads as zeros. Clean pages are on the global LRU
+ * list, dirty pages on the dirty list of their vnode, oldest first.
+ */
+struct pc_page {
+	struct uk_hlist_node	hash_link;
+	struct uk_list_head	vnode_link;	/* vnode's page list */
+	struct uk_list_head	lru_link;	/* LRU or vnode's dirty list */
+	struct vnode		*vp;
+	unsigned long		index;
+	unsigned int		flags;
+	unsigned int		busy;		/* not evictable while > 0 */
+	void			*data;
+};
+
+/*
+ * Locking: pc_lock protects the hash table, all page lists and counters.
+ * The pages of a vnode are only added, filled, written, and dropped with
+ * the vnode locked. Other vnodes can only evict its clean, non-busy pages.
+ * pc_lock is never held while calling into the file system.
+ */
+static struct uk_mutex pc_lock = UK_MUTEX_INITIALIZER(pc_lock);
+static struct uk_hlist_head pc_hash_table[PC_HASH_BUCKETS];
+static UK_LIST_HEAD(pc_lru);
+static UK_LIST_HEAD(pc_dirty_vnodes);
+static unsigned long pc_ndirty_vnodes;
+static struct vfscore_pagecache_stats pc_stats;
+
+#if CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK
+static struct uk_thread *pc_flusher;
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK */
+
+static inline unsigned int pc_hash(struct vnode *vp, unsigned long index)
+{
+	unsigned long h = ((unsigned long)vp >> 6) + index;
+
+	return (h ^ (h >> 10)) & (PC_HASH_BUCKETS - 1);
+}
+
+static inline off_t pc_page_offset(struct pc_page *pg)
+{
+	return (off_t)pg->index << PC_PAGE_SHIFT;
+}
+
+/* Locking: pc_lock must be held */
+static struct pc_page *pc_lookup(struct vnode *vp, unsigned long index)
+{
+	struct pc_page *pg;
+
+	uk_hlist_for_each_entry(pg, &pc_hash_table[pc_hash(vp, index)],
+				hash_link) {
+		if (pg->vp == vp && pg->index == index)
+			return pg;
+	}
+	return NULL;
+}
+
+/* Locking: pc_lock must be held */
+static void pc_page_insert(struct vnode *vp, struct pc_page *pg,
+			   unsigned long index)
+{
+	pg->vp = vp;
+	pg->index = index;
+	uk_hlist_add_head(&pg->hash_link, &pc_hash_table[pc_hash(vp, index)]);
+	uk_list_add_tail(&pg->vnode_link, &vp->v_pages);
+	uk_list_add_tail(&pg->lru_link, &pc_lru);
+	pc_stats.pages++;
+}
+
+/* Locking: pc_lock must be held */
+static void pc_page_dirty(struct pc_page *pg)
+{
+	struct vnode *vp = pg->vp;
+
+	if (pg->flags & PG_DIRTY)
+		return;
+
+	pg->flags |= PG_DIRTY;
+	uk_list_move_tail(&pg->lru_link, &vp->v_dirty);
+	if (vp->v_ndirty++ == 0) {
+		uk_list_add_tail(&vp->v_dirty_link, &pc_dirty_vnodes);
+		pc_ndirty_vnodes++;
+	}
+	pc_stats.dirty++;
+}
+
+/* Locking: pc_lock must be held */
+static void pc_page_clean(struct pc_page *pg)
+{
+	struct vnode *vp = pg->vp;
+
+	UK_ASSERT(pg->flags & PG_DIRTY);
+	UK_ASSERT(vp->v_ndirty > 0);
+
+	pg->flags &= ~PG_DIRTY;
+	uk_list_move_tail(&pg->lru_link, &pc_lru);
+	if (--vp->v_ndirty == 0) {
+		uk_list_del(&vp->v_dirty_link);
+		pc_ndirty_vnodes--;
+	}
+	pc_stats.dirty--;
+}
+
+/* Locking: pc_lock must be held */
+static void pc_page_remove(struct pc_page *pg)
+{
+	UK_ASSERT(!pg->busy);
+
+	if (pg->flags & PG_DIRTY)
+		pc_page_clean(pg);
+
+	uk_hlist_del(&pg->hash_link);
+	uk_list_del(&pg->vnode_link);
+	uk_list_del(&pg->lru_link);
+	pc_stats.pages--;
+}
+
+static void pc_page_free(struct pc_page *pg)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+
+	uk_pfree(a, pg->data, 1);
+	uk_free(a, pg);
+}
+
+/* Locking: pc_lock must be held */
+static unsigned long pc_evict(unsigned long count)
+{
+	struct pc_page *pg, *tmp;
+	unsigned long n = 0;
+
+	uk_list_for_each_entry_safe(pg, tmp, &pc_lru, lru_link) {
+		if (n == count)
+			break;
+		if (pg->busy)
+			continue;
+
+		pc_page_remove(pg);
+		pc_page_free(pg);
+		n++;
+	}
+	pc_stats.evictions += n;
+	return n;
+}
+
+/*
+ * Allocates a zeroed page, evicting clean pages to stay within the size
+ * limit and when memory runs low. Returns NULL if no page can be had; the
+ * caller then bypasses the cache.
+ */
+static struct pc_page *pc_page_alloc(void)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct pc_page *pg;
+	long avail;
+	int retry = 0;
+	int full;
+
+	uk_mutex_lock(&pc_lock);
+	full = (pc_stats.pages >= CONFIG_LIBVFSCORE_PAGECACHE_MAXPAGES);
+	if (!full) {
+		avail = uk_alloc_pavailmem(a);
+		full = (avail >= 0 && avail < PC_LOWMEM_PAGES);
+	}
+	if (full && !pc_evict(PC_EVICT_BATCH)
+	    && pc_stats.pages >= CONFIG_LIBVFSCORE_PAGECACHE_MAXPAGES) {
+		uk_mutex_unlock(&pc_lock);
+		return NULL;
+	}
+	uk_mutex_unlock(&pc_lock);
+
+	for (;;) {
+		pg = uk_malloc(a, sizeof(*pg));
+		if (likely(pg)) {
+			pg->data = uk_palloc(a, 1);
+			if (likely(pg->data))
+				break;
+			uk_free(a, pg);
+		}
+
+		/* Out of memory: Give back clean pages and try once more */
+		if (retry++)
+			return NULL;
+		uk_mutex_lock(&pc_lock);
+		full = !pc_evict(PC_EVICT_BATCH);
+		uk_mutex_unlock(&pc_lock);
+		if (full)
+			return NULL;
+	}
+
+	memset(pg->data, 0, PC_PAGE_SIZE);
+	pg->flags = 0;
+	pg->busy = 0;
+	return pg;
+}
+
+/* Looks up a page and marks it busy */
+static struct pc_page *pc_get(struct vnode *vp, unsigned long index)
+{
+	struct pc_page *pg;
+
+	uk_mutex_lock(&pc_lock);
+	pg = pc_lookup(vp, index);
+	if (pg) {
+		pg->busy++;
+		if (!(pg->flags & PG_DIRTY))
+			uk_list_move_tail(&pg->lru_link, &pc_lru);
+		pc_stats.hits++;
+	}
+	uk_mutex_unlock(&pc_lock);
+	return pg;
+}
+
+static void pc_put(struct pc_page *pg, int dirty)
+{
+	uk_mutex_lock(&pc_lock);
+	UK_ASSERT(pg->busy > 0);
+	pg->busy--;
+	if (dirty)
+		pc_page_dirty(pg);
+	uk_mutex_unlock(&pc_lock);
+}
+
+/*
+ * Reads up to `count` pages starting at `index` from the file system with a
+ * single VOP_READ. Stops early at pages that are already cached. Returns the
+ * page at `index` marked busy.
+ */
+static int pc_fill(struct vnode *vp, struct vfscore_file *fp,
+		   unsigned long index, unsigned long count,
+		   struct pc_page **pgp)
+{
+	struct pc_page *pages[PC_RA_MAX];
+	struct iovec iov[PC_RA_MAX];
+	struct uio uio;
+	unsigned long i, n;
+	int rc;
+
+	UK_ASSERT(count > 0 && count <= ARRAY_SIZE(pages));
+
+	uk_mutex_lock(&pc_lock);
+	for (n = 1; n < count; n++) {
+		if (pc_lookup(vp, index + n))
+			break;
+	}
+	uk_mutex_unlock(&pc_lock);
+
+	for (i = 0; i < n; i++) {
+		pages[i] = pc_page_alloc();
+		if (unlikely(!pages[i]))
+			break;
+		iov[i].iov_base = pages[i]->data;
+		iov[i].iov_len = PC_PAGE_SIZE;
+	}
+	if (unlikely(!i))
+		return ENOMEM;
+	n = i;
+
+	uio.uio_iov = iov;
+	uio.uio_iovcnt = (int)n;
+	uio.uio_offset = (off_t)index << PC_PAGE_SHIFT;
+	uio.uio_resid = n * PC_PAGE_SIZE;
+	uio.uio_rw = UIO_READ;
+
+	/* Short reads leave the rest of the pages zeroed */
+	rc = VOP_READ(vp, fp, &uio, 0);
+	if (unlikely(rc)) {
+		for (i = 0; i < n; i++)
+			pc_page_free(pages[i]);
+		return rc;
+	}
+
+	uk_mutex_lock(&pc_lock);
+	for (i = 0; i < n; i++)
+		pc_page_insert(vp, pages[i], index + i);
+	pages[0]->busy++;
+	pc_stats.misses++;
+	pc_stats.readahead += n - 1;
+	uk_mutex_unlock(&pc_lock);
+
+	*pgp = pages[0];
+	return 0;
+}
+
+/*
+ * Returns the number of pages to read on a miss at `index`. A miss right
+ * where the last read stopped is sequential and doubles the read-ahead
+ * window, any other miss only reads the page itself.
+ */
+static unsigned long pc_readahead(struct vnode *vp, unsigned long index)
+{
+	unsigned long end = ((unsigned long)vp->v_size + PC_PAGE_SIZE - 1)
+			    >> PC_PAGE_SHIFT;
+
+	if (index != vp->v_ra_next) {
+		vp->v_ra_pages = 0;
+		return 1;
+	}
+
+	if (!vp->v_ra_pages)
+		vp->v_ra_pages = PC_RA_MIN;
+	else
+		vp->v_ra_pages = MIN(vp->v_ra_pages * 2, PC_RA_MAX);
+
+	UK_ASSERT(end > index);
+	return MIN(vp->v_ra_pages, end - index);
+}
+
+/* Writes back dirty pages, oldest first. Locking: vp must be locked. */
+static int pc_writeback(struct vnode *vp)
+{
+	struct pc_page *pg;
+	struct iovec iov;
+	struct uio uio;
+	off_t start;
+	int rc = 0;
+
+	uk_mutex_lock(&pc_lock);
+	while (vp->v_ndirty) {
+		pg = uk_list_first_entry(&vp->v_dirty, struct pc_page,
+					 lru_link);
+		pc_page_clean(pg);
+		pg->busy++;
+		uk_mutex_unlock(&pc_lock);
+
+		start = pc_page_offset(pg);
+		if (start < vp->v_size) {
+			iov.iov_base = pg->data;
+			iov.iov_len = MIN((off_t)PC_PAGE_SIZE, vp->v_size - start);
+			uio.uio_iov = &iov;
+			uio.uio_iovcnt = 1;
+			uio.uio_offset = start;
+			uio.uio_resid = iov.iov_len;
+			uio.uio_rw = UIO_WRITE;
+
+			rc = VOP_WRITE(vp, &uio, 0);
+			if (!rc && uio.uio_resid)
+				rc = EIO;
+		}
+
+		uk_mutex_lock(&pc_lock);
+		pg->busy--;
+		if (unlikely(rc)) {
+			pc_page_dirty(pg);
+			break;
+		}
+		pc_stats.writeback++;
+	}
+	uk_mutex_unlock(&pc_lock);
+	return rc;
+}
+
+/* Drops all pages of a vnode, including dirty ones. Locking: vp locked. */
+static void pc_drop(struct vnode *vp)
+{
+	struct pc_page *pg, *tmp;
+
+	uk_mutex_lock(&pc_lock);
+	uk_list_for_each_entry_safe(pg, tmp, &vp->v_pages, vnode_link) {
+		pc_page_remove(pg);
+		pc_page_free(pg);
+	}
+	uk_mutex_unlock(&pc_lock);
+}
+
+#if CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK
+static __noreturn void pc_flusher_fn(void *arg __unused)
+{
+	for (;;) {
+		uk_sched_thread_sleep(ukarch_time_msec_to_nsec(
+				CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK));
+		vfscore_pagecache_sync();
+	}
+}
+
+/*
+ * Starts the flusher with the first dirty page and wakes it up early when
+ * half of the cache is dirty.
+ */
+static void pc_kick_flusher(void)
+{
+	struct uk_sched *s;
+
+	if (unlikely(!pc_flusher)) {
+		s = uk_sched_current();
+		if (!s)
+			return;
+		pc_flusher = uk_sched_thread_create(s, pc_flusher_fn, NULL,
+						    "vfscore-flush");
+		if (unlikely(!pc_flusher))
+			uk_pr_warn("vfscore: Failed to start page cache flusher\n");
+		return;
+	}
+
+	if (pc_stats.dirty > CONFIG_LIBVFSCORE_PAGECACHE_MAXPAGES / 2)
+		uk_thread_wake(pc_flusher);
+}
+#else /* !CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK */
+static inline void pc_kick_flusher(void)
+{
+}
+#endif /* !CONFIG_LIBVFSCORE_PAGECACHE_WRITEBACK */
+
+static int pc_read(struct vnode *vp, struct vfscore_file *fp,
+		   struct uio *uio)
+{
+	struct pc_page *pg;
+	unsigned long index;
+	size_t off, n;
+	int rc = 0;
+
+	if (uio->uio_offset < 0)
+		return EINVAL;
+
+	while (uio->uio_resid > 0 && uio->uio_offset < vp->v_size) {
+		index = (unsigned long)uio->uio_offset >> PC_PAGE_SHIFT;
+		off = uio->uio_offset & (PC_PAGE_SIZE - 1);
+
+		pg = pc_get(vp, index);
+		if (!pg) {
+			rc = pc_fill(vp, fp, index, pc_readahead(vp, index),
+				     &pg);
+			if (unlikely(rc == ENOMEM))
+				goto direct;
+			if (unlikely(rc))
+				break;
+		}
+
+		n = MIN((size_t)uio->uio_resid, PC_PAGE_SIZE - off);
+		n = MIN(n, (size_t)(vp->v_size - uio->uio_offset));
+		rc = vfscore_uiomove((char *)pg->data + off, n, uio);
+		pc_put(pg, 0);
+		vp->v_ra_next = index + 1;
+		if (unlikely(rc))
+			break;
+	}
+	return rc;
+
+direct:
+	/* No memory for the cache: Read the rest from the file system */
+	rc = pc_writeback(vp);
+	if (unlikely(rc))
+		return rc;
+	return VOP_READ(vp, fp, uio, 0);
+}
+
+static int pc_write(struct vnode *vp, struct vfscore_file *fp,
+		    struct uio *uio)
+{
+	struct pc_page *pg;
+	unsigned long index;
+	off_t start;
+	size_t off, n;
+	int rc = 0;
+
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (fp->f_flags & O_APPEND)
+		uio->uio_offset = vp->v_size;
+	if (uio->uio_offset >= LONG_MAX)
+		return EFBIG;
+
+	while (uio->uio_resid > 0) {
+		index = (unsigned long)uio->uio_offset >> PC_PAGE_SHIFT;
+		start = (off_t)index << PC_PAGE_SHIFT;
+		off = uio->uio_offset & (PC_PAGE_SIZE - 1);
+		n = MIN((size_t)uio->uio_resid, PC_PAGE_SIZE - off);
+
+		pg = pc_get(vp, index);
+		if (!pg && start < vp->v_size
+		    && (off || (off_t)n < MIN((off_t)PC_PAGE_SIZE,
+					      vp->v_size - start))) {
+			/* Existing data that the write does not replace
+			 * has to be read first. If that fails, e.g., because
+			 * the file is write-only, write through instead.
+			 */
+			rc = pc_fill(vp, fp, index, 1, &pg);
+			if (unlikely(rc))
+				goto direct;
+		} else if (!pg) {
+			pg = pc_page_alloc();
+			if (unlikely(!pg))
+				goto direct;
+
+			uk_mutex_lock(&pc_lock);
+			pc_page_insert(vp, pg, index);
+			pg->busy++;
+			uk_mutex_unlock(&pc_lock);
+		}
+
+		rc = vfscore_uiomove((char *)pg->data + off, n, uio);
+		pc_put(pg, 1);
+		if (uio->uio_offset > vp->v_size)
+			vp->v_size = uio->uio_offset;
+		if (unlikely(rc))
+			break;
+	}
+
+	if (!rc && (fp->f_flags & (O_DSYNC | O_SYNC)))
+		rc = pc_writeback(vp);
+	pc_kick_flusher();
+	return rc;
+
+direct:
+	/* Write the rest to the file system, without leaving stale pages
+	 * behind
+	 */
+	rc = pc_writeback(vp);
+	if (unlikely(rc))
+		return rc;
+	pc_drop(vp);
+	return VOP_WRITE(vp, uio,
+			 (fp->f_flags & (O_DSYNC | O_SYNC)) ? IO_SYNC : 0);
+}
+
+int vfscore_pagecache_vop(struct vnode *vp, struct vfscore_file *fp,
+			  struct uio *uio)
+{
+	UK_ASSERT(vp && fp && uio);
+
+	if (vp->v_type != VREG) {
+		if (uio->uio_rw == UIO_READ)
+			return VOP_READ(vp, fp, uio, 0);
+		return VOP_WRITE(vp, uio, 0);
+	}
+
+	if (uio->uio_rw == UIO_READ)
+		return pc_read(vp, fp, uio);
+	return pc_write(vp, fp, uio);
+}
+
+int vfscore_pagecache_flush(struct vnode *vp)
+{
+	UK_ASSERT(vp);
+
+	if (!vfscore_pagecache_enabled(vp))
+		return 0;
+	return pc_writeback(vp);
+}
+
+void vfscore_pagecache_truncate(struct vnode *vp, off_t length)
+{
+	struct pc_page *pg, *tmp;
+	unsigned long index;
+	size_t off;
+
+	UK_ASSERT(vp);
+	UK_ASSERT(length >= 0);
+
+	if (!vfscore_pagecache_enabled(vp))
+		return;
+
+	index = (unsigned long)length >> PC_PAGE_SHIFT;
+	off = length & (PC_PAGE_SIZE - 1);
+
+	uk_mutex_lock(&pc_lock);
+	uk_list_for_each_entry_safe(pg, tmp, &vp->v_pages, vnode_link) {
+		if (pg->index > index || (pg->index == index && !off)) {
+			pc_page_remove(pg);
+			pc_page_free(pg);
+		} else if (pg->index == index) {
+			/* The tail reads as zeros if the file grows again */
+			memset((char *)pg->data + off, 0, PC_PAGE_SIZE - off);
+		}
+	}
+	uk_mutex_unlock(&pc_lock);
+
+	vp->v_size = length;
+}
+
+void vfscore_pagecache_release(struct vnode *vp)
+{
+	int rc;
+
+	UK_ASSERT(vp);
+	UK_ASSERT(vp->v_refcnt == 0);
+
+	if (!vfscore_pagecache_enabled(vp))
+		return;
+
+	/* The flusher may still be writing back pages of the vnode */
+	uk_mutex_lock(&vp->v_lock);
+	rc = pc_writeback(vp);
+	if (unlikely(rc))
+		uk_pr_warn("vfscore: Failed to write back inode %"PRIu64": %d\n",
+			   vp->v_ino, rc);
+	pc_drop(vp);
+	uk_mutex_unlock(&vp->v_lock);
+}
+
+void vfscore_pagecache_sync(void)
+{
+	struct vnode *vp;
+	unsigned long n;
+	int rc;
+
+	uk_mutex_lock(&pc_lock);
+	for (n = pc_ndirty_vnodes; n > 0 && pc_ndirty_vnodes; n--) {
+		vp = uk_list_first_entry(&pc_dirty_vnodes, struct vnode,
+					 v_dirty_link);
+		uk_list_move_tail(&vp->v_dirty_link, &pc_dirty_vnodes);
+
+		/* Vnodes locked by other threads are written back later. As
+		 * long as we hold the lock, the vnode cannot be released.
+		 */
+		if (!uk_mutex_trylock(&vp->v_lock))
+			continue;
+		uk_mutex_unlock(&pc_lock);
+
+		rc = pc_writeback(vp);
+		if (unlikely(rc))
+			uk_pr_warn("vfscore: Failed to write back inode %"PRIu64": %d\n",
+				   vp->v_ino, rc);
+		uk_mutex_unlock(&vp->v_lock);
+
+		uk_mutex_lock(&pc_lock);
+	}
+	uk_mutex_unlock(&pc_lock);
+}
+
+unsigned long vfscore_pagecache_shrink(unsigned long count)
+{
+	unsigned long n;
+
+	uk_mutex_lock(&pc_lock);
+	n = pc_evict(count);
+	uk_mutex_unlock(&pc_lock);
+	return n;
+}
+
+void vfscore_pagecache_stats_get(struct vfscore_pagecache_stats *stats)
+{
+	UK_ASSERT(stats);
+
+	uk_mutex_lock(&pc_lock);
+	*stats = pc_stats;
+	uk_mutex_unlock(&pc_lock);
+}
@@ -197,6 +197,7 @@ static struct vnops stdio_vnops = {
 	stdio_readlink,		/* read link */
 	stdio_symlink,		/* symbolic link */
 	stdio_poll,		/* poll */
+	(vnop_aread_t) NULL,	/* asynchronous read */
 };
 
 static struct vnode stdio_vnode = {
@@ -54,6 +54,7 @@
 #include <vfscore/prex.h>
 #include <vfscore/vnode.h>
 #include <vfscore/file.h>
+#include <vfscore/pagecache.h>
 
 #include "vfs.h"
 #include <vfscore/fs.h>
@@ -216,6 +217,9 @@ sys_open(char *path, int flags, mode_t mode, struct vfscore_file **fpp)
 		error = VOP_TRUNCATE(vp, 0);
 		if (error)
 			goto out_fp_free_unlock;
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+		vfscore_pagecache_truncate(vp, 0);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	}
 
 	error = VOP_OPEN(vp, fp);
@@ -417,7 +421,11 @@ sys_fsync(struct vfscore_file *fp)
 
 	vp = fp->f_dentry->d_vnode;
 	vn_lock(vp);
-	error = VOP_FSYNC(vp, fp);
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	error = vfscore_pagecache_flush(vp);
+	if (!error)
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
+		error = VOP_FSYNC(vp, fp);
 	vn_unlock(vp);
 	return error;
 }
@@ -1164,6 +1172,10 @@ sys_truncate(char *path, off_t length)
 
 	vn_lock(dp->d_vnode);
 	error = VOP_TRUNCATE(dp->d_vnode, length);
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	if (!error)
+		vfscore_pagecache_truncate(dp->d_vnode, length);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	vn_unlock(dp->d_vnode);
 
 	drele(dp);
@@ -1182,6 +1194,10 @@ sys_ftruncate(struct vfscore_file *fp, off_t length)
 	vp = fp->f_dentry->d_vnode;
 	vn_lock(vp);
 	error = VOP_TRUNCATE(vp, length);
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	if (!error)
+		vfscore_pagecache_truncate(vp, length);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	vn_unlock(vp);
 
 	return error;
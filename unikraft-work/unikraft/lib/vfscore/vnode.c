@@ -47,6 +47,7 @@
 #include <vfscore/prex.h>
 #include <vfscore/dentry.h>
 #include <vfscore/vnode.h>
+#include <vfscore/pagecache.h>
 #include "vfs.h"
 
 #define __UK_S_BLKSIZE 512
@@ -198,6 +199,10 @@ vfscore_vget(struct mount *mp, uint64_t ino, struct vnode **vpp)
 	}
 
 	UK_INIT_LIST_HEAD(&vp->v_names);
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	UK_INIT_LIST_HEAD(&vp->v_pages);
+	UK_INIT_LIST_HEAD(&vp->v_dirty);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	vp->v_ino = ino;
 	vp->v_mount = mp;
 	vp->v_refcnt = 1;
@@ -242,6 +247,10 @@ vput(struct vnode *vp)
 	uk_list_del(&vp->v_link);
 	VNODE_UNLOCK();
 
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	vfscore_pagecache_release(vp);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
+
 	/*
 	 * Deallocate fs specific vnode data
 	 */
@@ -289,6 +298,10 @@ vrele(struct vnode *vp)
 	uk_list_del(&vp->v_link);
 	VNODE_UNLOCK();
 
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	vfscore_pagecache_release(vp);
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
+
 	/*
 	 * Deallocate fs specific vnode data
 	 */
@@ -325,6 +338,11 @@ vn_stat(struct vnode *vp, struct stat *st)
 
 	st->st_ino = (ino_t)vap->va_nodeid;
 	st->st_size = vap->va_size;
+#ifdef CONFIG_LIBVFSCORE_PAGECACHE
+	/* Dirty pages may have grown the file beyond what the fs knows */
+	if (vfscore_pagecache_enabled(vp) && vp->v_ndirty)
+		st->st_size = vp->v_size;
+#endif /* CONFIG_LIBVFSCORE_PAGECACHE */
 	mode = vap->va_mode;
 	switch (vp->v_type) {
 	case VREG:
@@ -101,7 +101,7 @@ struct virtio_config_ops {
 	/** Get the feature */
 	__u64 (*features_get)(struct virtio_dev *vdev);
 	/** Set the feature */
-	void (*features_set)(struct virtio_dev *vdev, __u64 features);
+	int (*features_set)(struct virtio_dev *vdev, __u64 features);
 	/** Get and Set Status */
 	__u8 (*status_get)(struct virtio_dev *vdev);
 	void (*status_set)(struct virtio_dev *vdev, __u8 status);
@@ -226,13 +226,18 @@ static inline __u64 virtio_feature_get(struct virtio_dev *vdev)
  *	Reference to the virtio device.
  * @param feature
  *	A bit map of the feature negotiated.
+ * @return int
+ *	0 on success, < 0 if the device rejected the features.
  */
-static inline void virtio_feature_set(struct virtio_dev *vdev, __u32 feature)
+static inline int virtio_feature_set(struct virtio_dev *vdev, __u64 feature)
 {
+	int rc = -ENOTSUP;
+
 	UK_ASSERT(vdev);
 
 	if (likely(vdev->cops->features_set))
-		vdev->cops->features_set(vdev, feature);
+		rc = vdev->cops->features_set(vdev, feature);
+	return rc;
 }
 
 /**
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __PLAT_DRV_VIRTIO_CONSOLE_H
+#define __PLAT_DRV_VIRTIO_CONSOLE_H
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+
+/* Virtqueues of port 0; multiport devices have more */
+#define VIRTIO_CONSOLE_RX_QUEUE		0
+#define VIRTIO_CONSOLE_TX_QUEUE		1
+
+/**
+ * Writes console output to the first virtio console device. Newlines are
+ * sent as "\r\n", like on the serial console.
+ *
+ * Used by ukplat_coutk() and ukplat_coutd(), which fall back to the
+ * serial console if this fails, for instance before the virtio bus has
+ * been probed.
+ *
+ * @param buf
+ *   Characters to write
+ * @param len
+ *   Number of characters
+ * @return
+ *   - (>0): Number of characters of buf queued; less than len only if
+ *     the transmit queue broke
+ *   - (<0): Negative error code, nothing was written
+ *     - (-ENODEV): No virtio console device is up
+ *     - (-EBUSY): Called from within the driver on the same CPU
+ *     - (-EIO): The transmit queue is broken
+ */
+int virtio_console_out(const char *buf, unsigned int len);
+
+#endif /* __PLAT_DRV_VIRTIO_CONSOLE_H */
@@ -81,6 +81,25 @@ extern "C" {
 /* Arbitrary descriptor layouts. */
 #define VIRTIO_F_ANY_LAYOUT       27
 
+/* Support for the packed virtqueue layout */
+#define VIRTIO_F_RING_PACKED      34
+
+/*
+ * Packed descriptors mark their availability with these two flags. The
+ * driver sets AVAIL to its wrap counter and USED to the inverse, the device
+ * sets both to its own wrap counter once it used the buffer.
+ */
+#define VRING_PACKED_DESC_F_AVAIL       (1 << 7)
+#define VRING_PACKED_DESC_F_USED        (1 << 15)
+
+/* Flags of the packed ring event suppression structures */
+#define VRING_PACKED_EVENT_FLAG_ENABLE  0x0
+#define VRING_PACKED_EVENT_FLAG_DISABLE 0x1
+/* Only if VIRTIO_F_EVENT_IDX: notify at the descriptor in off_wrap */
+#define VRING_PACKED_EVENT_FLAG_DESC    0x2
+/* Position of the wrap counter in off_wrap */
+#define VRING_PACKED_EVENT_F_WRAP_CTR   15
+
 /**
  * Virtqueue descriptors: 16 bytes.
  * These can chain together via "next".
@@ -157,7 +176,9 @@ struct vring {
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr) ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(__virtio16 *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr)						\
+	(*(__virtio_le16 *)((char *)(vr)->used->ring +			\
+			    (vr)->num * sizeof(struct vring_used_elem)))
 
 static inline void vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 			      unsigned long align)
@@ -183,10 +204,63 @@ static inline unsigned int vring_size(unsigned int num, unsigned long align)
 	return size;
 }
 
+/**
+ * Packed virtqueue descriptors: 16 bytes.
+ * The same ring carries available and used descriptors.
+ */
+struct vring_packed_desc {
+	/* Address (guest-physical). */
+	__virtio_le64 addr;
+	/* Length. */
+	__virtio_le32 len;
+	/* Buffer ID. */
+	__virtio_le16 id;
+	/* The flags as indicated above. */
+	__virtio_le16 flags;
+};
+
+struct vring_packed_desc_event {
+	/* Descriptor ring offset and wrap counter */
+	__virtio_le16 off_wrap;
+	/* One of VRING_PACKED_EVENT_FLAG_* */
+	__virtio_le16 flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+
+	struct vring_packed_desc *desc;
+	/* Event suppression written by the driver */
+	struct vring_packed_desc_event *driver;
+	/* Event suppression written by the device */
+	struct vring_packed_desc_event *device;
+};
+
+/* The packed layout is the descriptor ring followed by the driver and the
+ * device event suppression structures. Unlike the split layout, num does not
+ * need to be a power of 2.
+ */
+static inline void vring_packed_init(struct vring_packed *vr, unsigned int num,
+				     uint8_t *p)
+{
+	vr->num = num;
+	vr->desc = (struct vring_packed_desc *) p;
+	vr->driver = (struct vring_packed_desc_event *) (p +
+			num * sizeof(struct vring_packed_desc));
+	vr->device = vr->driver + 1;
+}
+
+static inline unsigned int vring_packed_size(unsigned int num)
+{
+	return num * sizeof(struct vring_packed_desc) +
+		2 * sizeof(struct vring_packed_desc_event);
+}
+
 static inline int vring_need_event(__u16 event_idx, __u16 new_idx,
 				   __u16 old_idx)
 {
-	return (new_idx - event_idx - 1) < (new_idx - old_idx);
+	/* Indices are free running, compare them modulo 2^16 */
+	return (__u16)(new_idx - event_idx - 1) < (__u16)(new_idx - old_idx);
 }
 
 #ifdef __cplusplus
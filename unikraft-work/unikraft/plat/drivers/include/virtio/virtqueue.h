@@ -44,6 +44,29 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/**
+ * Ring features implemented by the virtqueue. Drivers add the ones offered
+ * by the device to the feature set they negotiate.
+ */
+#if CONFIG_VIRTIO_RING_INDIRECT
+#define VIRTQUEUE_F_INDIRECT_DESC	(1ULL << VIRTIO_F_INDIRECT_DESC)
+#else /* !CONFIG_VIRTIO_RING_INDIRECT */
+#define VIRTQUEUE_F_INDIRECT_DESC	0
+#endif /* !CONFIG_VIRTIO_RING_INDIRECT */
+#if CONFIG_VIRTIO_RING_EVENT_IDX
+#define VIRTQUEUE_F_EVENT_IDX		(1ULL << VIRTIO_F_EVENT_IDX)
+#else /* !CONFIG_VIRTIO_RING_EVENT_IDX */
+#define VIRTQUEUE_F_EVENT_IDX		0
+#endif /* !CONFIG_VIRTIO_RING_EVENT_IDX */
+#if CONFIG_VIRTIO_RING_PACKED
+#define VIRTQUEUE_F_RING_PACKED		(1ULL << VIRTIO_F_RING_PACKED)
+#else /* !CONFIG_VIRTIO_RING_PACKED */
+#define VIRTQUEUE_F_RING_PACKED		0
+#endif /* !CONFIG_VIRTIO_RING_PACKED */
+#define VIRTQUEUE_FEATURES					\
+	(VIRTQUEUE_F_INDIRECT_DESC | VIRTQUEUE_F_RING_PACKED |	\
+	 VIRTQUEUE_F_EVENT_IDX)
+
 /**
  * Type declarations
  */
@@ -70,6 +93,19 @@ struct virtqueue {
 	void *priv;
 };
 
+/**
+ * Notification and interrupt counters of a virtqueue. Every host
+ * notification and every interrupt costs a VM exit.
+ */
+struct virtqueue_stats {
+	/* Host notifications sent */
+	__u64 notify;
+	/* Host notifications skipped because the device did not ask for one */
+	__u64 notify_suppressed;
+	/* Interrupts that found used buffers on the ring */
+	__u64 intr;
+};
+
 /**
  * Fetch the physical address of the descriptor ring.
  * @param vq
@@ -137,7 +173,10 @@ int virtqueue_ring_interrupt(void *obj);
 __u64 virtqueue_feature_negotiate(__u64 feature_set);
 
 /**
- * Check if host notification is enabled.
+ * Check if the host needs a notification for the buffers made available
+ * since the last call. With VIRTIO_F_EVENT_IDX, this compares the avail
+ * event index published by the device against the new buffers, otherwise
+ * it checks the VRING_USED_F_NO_NOTIFY flag.
  *
  * @param vq
  *	Reference to the virtqueue.
@@ -147,6 +186,16 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set);
  */
 int virtqueue_notify_enabled(struct virtqueue *vq);
 
+/**
+ * Read the notification and interrupt counters of the virtqueue.
+ *
+ * @param vq
+ *	Reference to the virtqueue.
+ * @param stats
+ *	Reference to the structure filled with the counters.
+ */
+void virtqueue_stats_get(struct virtqueue *vq, struct virtqueue_stats *stats);
+
 /**
  * Remove the user buffer from the virtqueue.
  *
@@ -168,7 +217,8 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len);
 
 /**
  * Create a descriptor chain starting at index head,
- * using vq->bufs also starting at index head.
+ * using vq->bufs also starting at index head. With VIRTIO_F_INDIRECT_DESC,
+ * a buffer of several segments takes a single ring slot instead.
  * @param vq
  *	Reference to the virtual queue
  * @param cookie
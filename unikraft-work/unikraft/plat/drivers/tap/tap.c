@@ -35,6 +35,7 @@
 #include <string.h>
 #include <uk/alloc.h>
 #include <uk/arch/types.h>
+#include <uk/essentials.h>
 #include <uk/netdev_core.h>
 #include <uk/netdev_driver.h>
 #include <uk/netbuf.h>
@@ -58,6 +59,9 @@
 
 #define ETH_PKT_PAYLOAD_LEN       1500
 
+/* Maximum number of receive buffers allocated at once for burst receive */
+#define TAP_RX_SPARE_MAX          64
+
 /**
  * TODO: Find a better way of forwarding the command line argument to the
  * driver. For now they are defined as macros from this driver.
@@ -92,6 +96,9 @@ struct uk_netdev_rx_queue {
 	uk_netdev_alloc_rxpkts alloc_rxpkts;
 	/* Reference to a user data */
 	void *alloc_rxpkts_argp;
+	/* Receive buffers allocated but not yet used by burst receive */
+	__u16 nb_spare;
+	struct uk_netbuf *spare[TAP_RX_SPARE_MAX];
 };
 
 struct tap_net_dev {
@@ -169,6 +176,12 @@ static int tap_netdev_xmit(struct uk_netdev *dev,
 static int tap_netdev_recv(struct uk_netdev *dev,
 			   struct uk_netdev_rx_queue *queue,
 			   struct uk_netbuf **pkt);
+static int tap_netdev_xmit_burst(struct uk_netdev *dev,
+				 struct uk_netdev_tx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt);
+static int tap_netdev_recv_burst(struct uk_netdev *dev,
+				 struct uk_netdev_rx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt);
 static struct uk_netdev_rx_queue *tap_netdev_rxq_setup(struct uk_netdev *dev,
 					__u16 queue_id, __u16 nb_desc,
 					struct uk_netdev_rxqueue_conf *conf);
@@ -331,6 +344,108 @@ static int tap_netdev_xmit(struct uk_netdev *dev,
 	return rc;
 }
 
+/**
+ * The tap device hands out one packet per read(), so a burst still costs one
+ * system call per packet. Receive buffers are allocated in batches instead
+ * and buffers that were not needed are kept for the next call.
+ */
+static int tap_netdev_recv_burst(struct uk_netdev *dev,
+				 struct uk_netdev_rx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt)
+{
+	struct tap_net_dev *tdev __maybe_unused;
+	struct uk_netbuf *pkt;
+	int status = 0x0;
+	__u16 i = 0;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	tdev = to_tapnetdev(dev);
+
+	if (!queue->alloc_rxpkts)
+		return -EINVAL;
+
+	while (i < *cnt) {
+		if (!queue->nb_spare) {
+			queue->nb_spare = queue->alloc_rxpkts(
+						queue->alloc_rxpkts_argp,
+						queue->spare,
+						MIN(*cnt - i, TAP_RX_SPARE_MAX));
+			if (unlikely(!queue->nb_spare)) {
+				uk_pr_err(DRIVER_NAME": Failed to allocate the memory\n");
+				status |= UK_NETDEV_STATUS_UNDERRUN
+					  | UK_NETDEV_STATUS_MORE;
+				break;
+			}
+		}
+
+		pkt = queue->spare[queue->nb_spare - 1];
+		rc = tap_read(queue->fd, pkt->data, pkt->len);
+		if (rc > 0) {
+			pkt->len = rc;
+			pkts[i++] = pkt;
+			queue->nb_spare--;
+		} else if (rc == 0 || rc == -EWOULDBLOCK || rc == -EAGAIN) {
+			break;
+		} else {
+			uk_pr_err(DRIVER_NAME": Failed(%d) to read the packet\n",
+				  rc);
+			if (!i) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+	}
+	uk_pr_debug(DRIVER_NAME": Received %"__PRIu16" packets on interface %s(%d)\n",
+		    i, tdev->name, queue->fd);
+
+	if (i) {
+		status |= UK_NETDEV_STATUS_SUCCESS;
+		/* We only know that the queue is empty after a failed read */
+		status |= (i == *cnt) ? UK_NETDEV_STATUS_MORE : 0x0;
+	}
+	*cnt = i;
+	return status;
+}
+
+static int tap_netdev_xmit_burst(struct uk_netdev *dev,
+				 struct uk_netdev_tx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt)
+{
+	struct tap_net_dev *tdev __unused;
+	int status = 0x0;
+	__u16 i;
+	int rc = 0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	tdev = to_tapnetdev(dev);
+
+	for (i = 0; i < *cnt; i++) {
+		rc = tap_write(queue->fd, pkts[i]->data, pkts[i]->len);
+		if (rc <= 0)
+			break;
+		uk_netbuf_free(pkts[i]);
+	}
+	uk_pr_debug(DRIVER_NAME": Sent %"__PRIu16" packets\n", i);
+
+	if (unlikely(!i && rc < 0 && rc != -EWOULDBLOCK && rc != -EAGAIN)) {
+		*cnt = 0;
+		return rc;
+	}
+
+	if (i) {
+		status |= UK_NETDEV_STATUS_SUCCESS;
+		status |= (i == *cnt) ? UK_NETDEV_STATUS_MORE : 0x0;
+	}
+	*cnt = i;
+	return status;
+}
+
 static int tap_netdev_txq_info_get(struct uk_netdev *dev __unused,
 				   __u16 queue_id __unused,
 				   struct uk_netdev_queue_info *qinfo)
@@ -775,6 +890,8 @@ static int tap_dev_init(int id)
 	}
 	tdev->ndev.rx_one = tap_netdev_recv;
 	tdev->ndev.tx_one = tap_netdev_xmit;
+	tdev->ndev.rx_burst = tap_netdev_recv_burst;
+	tdev->ndev.tx_burst = tap_netdev_xmit_burst;
 	tdev->ndev.ops = &tap_netdev_ops;
 	tdev->tid = id;
 	/**
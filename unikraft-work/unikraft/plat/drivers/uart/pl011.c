@@ -19,9 +19,13 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 #include <libfdt.h>
+#include <uk/config.h>
 #include <uk/plat/console.h>
 #include <uk/assert.h>
 #include <arm/cpu.h>
+#if CONFIG_VIRTIO_CONSOLE
+#include <virtio/virtio_console.h>
+#endif
 
 /* PL011 UART registers and masks*/
 /* Data register */
@@ -183,7 +187,15 @@ static int pl011_getc(void)
 
 int ukplat_coutk(const char *buf, unsigned int len)
 {
-	for (unsigned int i = 0; i < len; i++)
+	unsigned int i = 0;
+
+#if CONFIG_VIRTIO_CONSOLE
+	int rc = virtio_console_out(buf, len);
+
+	if (rc > 0)
+		i = rc;
+#endif
+	for (; i < len; i++)
 		pl011_putc(buf[i]);
 	return len;
 }
@@ -368,7 +368,12 @@ static int virtio_9p_feature_negotiate(struct virtio_9p_device *d)
 	d->tag[tag_len] = '\0';
 
 	d->vdev->features &= host_features;
-	virtio_feature_set(d->vdev, d->vdev->features);
+	rc = virtio_feature_set(d->vdev, d->vdev->features);
+	if (unlikely(rc)) {
+		uk_pr_err(DRIVER_NAME": Failed to set features on the device %p\n",
+			  d);
+		goto free_mem;
+	}
 	return 0;
 
 free_mem:
@@ -381,6 +386,8 @@ static inline void virtio_9p_feature_set(struct virtio_9p_device *d)
 {
 	d->vdev->features = 0;
 	VIRTIO_FEATURE_SET(d->vdev->features, VIRTIO_9P_F_MOUNT_TAG);
+	VIRTIO_FEATURE_SET(d->vdev->features, VIRTIO_F_VERSION_1);
+	d->vdev->features |= VIRTQUEUE_FEATURES;
 }
 
 static int virtio_9p_configure(struct virtio_9p_device *d)
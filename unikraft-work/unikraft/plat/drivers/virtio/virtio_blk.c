@@ -49,7 +49,9 @@
  *	Multi-queue,
  *	Maximum size of a segment for requests,
  *	Maximum number of segments per request,
- *	Flush
+ *	Flush,
+ *	Modern device interface,
+ *	Ring features of the virtqueue
  **/
 #define VIRTIO_BLK_DRV_FEATURES(features)				\
 	do {								\
@@ -60,6 +62,8 @@
 		VIRTIO_FEATURE_SET(features, VIRTIO_BLK_F_MQ);		\
 		VIRTIO_FEATURE_SET(features, VIRTIO_BLK_F_SIZE_MAX);	\
 		VIRTIO_FEATURE_SET(features, VIRTIO_BLK_F_FLUSH);	\
+		VIRTIO_FEATURE_SET(features, VIRTIO_F_VERSION_1);	\
+		(features) |= VIRTQUEUE_FEATURES;			\
 	} while (0)
 
 static struct uk_alloc *a;
@@ -873,7 +877,9 @@ static int virtio_blkdev_feature_negotiate(struct virtio_blk_device *vbdev)
 	 * Mask out features supported by both driver and device.
 	 */
 	vbdev->vdev->features &= host_features;
-	virtio_feature_set(vbdev->vdev, vbdev->vdev->features);
+	rc = virtio_feature_set(vbdev->vdev, vbdev->vdev->features);
+	if (unlikely(rc))
+		uk_pr_err("Failed to set features\n");
 
 exit:
 	return rc;
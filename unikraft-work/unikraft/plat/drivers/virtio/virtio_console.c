@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2026, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <uk/alloc.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+#include <uk/sglist.h>
+#include <uk/arch/lcpu.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
+#include <virtio/virtio_bus.h>
+#include <virtio/virtio_console.h>
+#include <virtio/virtio_ids.h>
+#include <virtio/virtqueue.h>
+
+#define DRIVER_NAME		"virtio-console"
+
+/* Output is copied into one of these buffers per descriptor, so that the
+ * caller's buffer can be reused right away. Every call notifies the
+ * device once, unless it runs out of buffers.
+ */
+#define VIRTIO_CONSOLE_TX_BUFS		16
+#define VIRTIO_CONSOLE_TX_BUF_SIZE	256
+
+struct virtio_console_device {
+	/* Virtio device */
+	struct virtio_dev *vdev;
+	/* Transmit queue of port 0 */
+	struct virtqueue *txq;
+	/* Transmit buffers and the stack of free ones */
+	char *bufs;
+	__u16 free[VIRTIO_CONSOLE_TX_BUFS];
+	__u16 nr_free;
+	struct uk_sglist sg;
+	struct uk_sglist_seg sgsegs[1];
+	/* Protects all of the above */
+	__spinlock lock;
+	/* CPU holding the lock, to detect output from within the driver */
+	__lcpuid owner;
+};
+
+static struct uk_alloc *a;
+/* Device used for console output, set once it is up */
+static struct virtio_console_device *vcons;
+
+static inline char *virtio_console_buf(struct virtio_console_device *d,
+				       __u16 idx)
+{
+	return d->bufs + (__sz)idx * VIRTIO_CONSOLE_TX_BUF_SIZE;
+}
+
+/* Takes the buffers that the device consumed back. Locking: d->lock */
+static void virtio_console_reclaim(struct virtio_console_device *d)
+{
+	void *cookie;
+	__u32 len;
+
+	while (virtqueue_buffer_dequeue(d->txq, &cookie, &len) >= 0)
+		d->free[d->nr_free++] = (__u16)(__uptr)cookie;
+}
+
+/*
+ * Copies as much of buf as fits into one transmit buffer, expanding "\n"
+ * to "\r\n". Returns the number of characters of buf consumed.
+ */
+static unsigned int virtio_console_fill(char *dst, __sz *dlen,
+					const char *buf, unsigned int len)
+{
+	unsigned int i;
+	__sz n = 0;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] == '\n') {
+			if (n + 2 > VIRTIO_CONSOLE_TX_BUF_SIZE)
+				break;
+			dst[n++] = '\r';
+		} else if (n + 1 > VIRTIO_CONSOLE_TX_BUF_SIZE) {
+			break;
+		}
+		dst[n++] = buf[i];
+	}
+	*dlen = n;
+	return i;
+}
+
+int virtio_console_out(const char *buf, unsigned int len)
+{
+	struct virtio_console_device *d = UK_READ_ONCE(vcons);
+	unsigned int done = 0, n;
+	unsigned long flags;
+	__u16 idx;
+	__sz blen;
+	int rc;
+
+	if (!d)
+		return -ENODEV;
+
+	/* Printing from the enqueue or notify path must not deadlock */
+	if (UK_READ_ONCE(d->owner) == ukplat_lcpu_id())
+		return -EBUSY;
+
+	ukplat_spin_lock_irqsave(&d->lock, flags);
+	d->owner = ukplat_lcpu_id();
+
+	while (done < len) {
+		virtio_console_reclaim(d);
+		if (!d->nr_free) {
+			/* Let the device drain what is queued, then wait for
+			 * it like the serial console waits for its FIFO
+			 */
+			virtqueue_host_notify(d->txq);
+			while (!virtqueue_hasdata(d->txq))
+				ukarch_spinwait();
+			continue;
+		}
+
+		idx = d->free[--d->nr_free];
+		n = virtio_console_fill(virtio_console_buf(d, idx), &blen,
+					buf + done, len - done);
+
+		uk_sglist_reset(&d->sg);
+		rc = uk_sglist_append(&d->sg, virtio_console_buf(d, idx),
+				      blen);
+		if (likely(rc == 0))
+			rc = virtqueue_buffer_enqueue(d->txq, (void *)(__uptr)idx,
+						      &d->sg, 1, 0);
+		if (unlikely(rc < 0)) {
+			/* All buffers are reclaimed before the ring fills
+			 * up, so this only happens on a broken ring
+			 */
+			d->free[d->nr_free++] = idx;
+			break;
+		}
+		done += n;
+	}
+	virtqueue_host_notify(d->txq);
+
+	d->owner = -1;
+	ukplat_spin_unlock_irqrestore(&d->lock, flags);
+	return done ? (int)done : -EIO;
+}
+
+/* Output is polled; the device does not need to interrupt */
+static int virtio_console_tx_done(struct virtqueue *vq __unused,
+				  void *priv __unused)
+{
+	return 0;
+}
+
+static int virtio_console_configure(struct virtio_console_device *d)
+{
+	__u16 qdesc_size[2];
+	__u64 host_features;
+	int vq_avail;
+	int rc;
+
+	/* Single port, no emergency write or console size */
+	host_features = virtio_feature_get(d->vdev);
+	d->vdev->features = 0;
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_F_VERSION_1))
+		VIRTIO_FEATURE_SET(d->vdev->features, VIRTIO_F_VERSION_1);
+	rc = virtio_feature_set(d->vdev, d->vdev->features);
+	if (unlikely(rc)) {
+		uk_pr_err(DRIVER_NAME": Failed to set features: %d\n", rc);
+		return rc;
+	}
+
+	vq_avail = virtio_find_vqs(d->vdev, 2, qdesc_size);
+	if (unlikely(vq_avail != 2)) {
+		uk_pr_err(DRIVER_NAME": Expected: %d queues, found %d\n",
+			  2, vq_avail);
+		return -ENOMEM;
+	}
+
+	d->txq = virtio_vqueue_setup(d->vdev, VIRTIO_CONSOLE_TX_QUEUE,
+				     qdesc_size[VIRTIO_CONSOLE_TX_QUEUE],
+				     virtio_console_tx_done, a);
+	if (unlikely(PTRISERR(d->txq))) {
+		uk_pr_err(DRIVER_NAME": Failed to set up virtqueue %d\n",
+			  VIRTIO_CONSOLE_TX_QUEUE);
+		return PTR2ERR(d->txq);
+	}
+	d->txq->priv = d;
+	virtqueue_intr_disable(d->txq);
+
+	d->bufs = uk_malloc(a, VIRTIO_CONSOLE_TX_BUFS
+			       * VIRTIO_CONSOLE_TX_BUF_SIZE);
+	if (unlikely(!d->bufs)) {
+		virtio_vqueue_release(d->vdev, d->txq, a);
+		return -ENOMEM;
+	}
+	for (__u16 i = 0; i < VIRTIO_CONSOLE_TX_BUFS; i++)
+		d->free[d->nr_free++] = i;
+	uk_sglist_init(&d->sg, ARRAY_SIZE(d->sgsegs), &d->sgsegs[0]);
+
+	return 0;
+}
+
+static int virtio_console_add_dev(struct virtio_dev *vdev)
+{
+	struct virtio_console_device *d;
+	int rc;
+
+	UK_ASSERT(vdev != NULL);
+
+	if (vcons) {
+		uk_pr_info(DRIVER_NAME": Ignoring additional device %p\n",
+			   vdev);
+		return 0;
+	}
+
+	d = uk_calloc(a, 1, sizeof(*d));
+	if (!d)
+		return -ENOMEM;
+	ukarch_spin_init(&d->lock);
+	d->owner = -1;
+	d->vdev = vdev;
+
+	rc = virtio_console_configure(d);
+	if (rc) {
+		virtio_dev_status_update(vdev, VIRTIO_CONFIG_STATUS_FAIL);
+		uk_free(a, d);
+		return rc;
+	}
+	virtio_dev_drv_up(vdev);
+
+	UK_WRITE_ONCE(vcons, d);
+	uk_pr_info(DRIVER_NAME": Console output on device %p\n", vdev);
+	return 0;
+}
+
+static int virtio_console_drv_init(struct uk_alloc *drv_allocator)
+{
+	if (!drv_allocator)
+		return -EINVAL;
+
+	a = drv_allocator;
+	return 0;
+}
+
+static const struct virtio_dev_id vcons_dev_id[] = {
+	{VIRTIO_ID_CONSOLE},
+	{VIRTIO_ID_INVALID} /* List Terminator */
+};
+
+static struct virtio_driver vcons_drv = {
+	.dev_ids = vcons_dev_id,
+	.init    = virtio_console_drv_init,
+	.add_dev = virtio_console_add_dev
+};
+VIRTIO_BUS_REGISTER_DRIVER(&vcons_drv);
@@ -84,6 +84,8 @@ struct virtio_mmio_vq_info {
 typedef void vq_callback_t(struct virtqueue *);
 
 /* Configuration interface */
+static __u8 vm_get_status(struct virtio_dev *vdev);
+static void vm_set_status(struct virtio_dev *vdev, __u8 status);
 
 static __u64 vm_get_features(struct virtio_dev *vdev)
 {
@@ -100,8 +102,8 @@ static __u64 vm_get_features(struct virtio_dev *vdev)
 	return features;
 }
 
-static void vm_set_features(struct virtio_dev *vdev,
-					 __u64 features)
+static int vm_set_features(struct virtio_dev *vdev,
+			   __u64 features)
 {
 	struct virtio_mmio_device *vm_dev = to_virtio_mmio_device(vdev);
 
@@ -112,7 +114,7 @@ static void vm_set_features(struct virtio_dev *vdev,
 	if (vm_dev->version == 2 &&
 		!uk_test_bit(VIRTIO_F_VERSION_1, &vdev->features)) {
 		uk_pr_err("New virtio-mmio devices (version 2) must provide VIRTIO_F_VERSION_1 feature!\n");
-		return;
+		return -EINVAL;
 	}
 
 	virtio_cwrite32(vm_dev->base, VIRTIO_MMIO_DRIVER_FEATURES_SEL, 1);
@@ -122,6 +124,21 @@ static void vm_set_features(struct virtio_dev *vdev,
 	virtio_cwrite32(vm_dev->base, VIRTIO_MMIO_DRIVER_FEATURES_SEL, 0);
 	virtio_cwrite32(vm_dev->base, VIRTIO_MMIO_DRIVER_FEATURES,
 						(__u32)vdev->features);
+
+	/**
+	 * Version 2 devices only apply the features once we set FEATURES_OK,
+	 * and clear it again if they do not accept them.
+	 */
+	if (vm_dev->version == 2) {
+		vm_set_status(vdev, VIRTIO_CONFIG_STATUS_FEATURES_OK);
+		if (!(vm_get_status(vdev) & VIRTIO_CONFIG_STATUS_FEATURES_OK)) {
+			uk_pr_err("virtio-mmio device %p did not accept features 0x%"__PRIx64"\n",
+				  vm_dev, vdev->features);
+			vm_set_status(vdev, VIRTIO_CONFIG_STATUS_FAIL);
+			return -ENODEV;
+		}
+	}
+	return 0;
 }
 
 static int vm_get(struct virtio_dev *vdev, __u16 offset,
@@ -228,6 +245,8 @@ static void vm_set_status(struct virtio_dev *vdev, __u8 status)
 	/* We should never be setting status to 0. */
 	UK_BUGON(status == 0);
 
+	/* Status bits accumulate until the next reset */
+	status |= vm_get_status(vdev);
 	virtio_cwrite32(vm_dev->base, VIRTIO_MMIO_STATUS, status);
 }
 
@@ -33,6 +33,7 @@
 #include <uk/sglist.h>
 #include <uk/arch/types.h>
 #include <uk/arch/limits.h>
+#include <uk/arch/time.h>
 #include <uk/netbuf.h>
 #include <uk/netdev.h>
 #include <uk/netdev_core.h>
@@ -40,6 +41,7 @@
 #include <virtio/virtio_bus.h>
 #include <virtio/virtqueue.h>
 #include <virtio/virtio_net.h>
+#include <uk/plat/time.h>
 
 /**
  * VIRTIO_PKT_BUFFER_LEN = VIRTIO_NET_HDR + ETH_HDR + ETH_PKT_PAYLOAD_LEN
@@ -50,8 +52,16 @@
 #define VIRTIO_PKT_BUFFER_LEN ((UK_ETH_PAYLOAD_MAXLEN) \
 			       + (UK_ETH_HDR_UNTAGGED_LEN) \
 			       + (VIRTIO_HDR_LEN))
+/**
+ * Segmentation offload packets are limited by the IP length field.
+ */
+#define VIRTIO_GSO_PKT_BUFFER_LEN ((__U16_MAX) \
+				   + (UK_ETH_HDR_UNTAGGED_LEN) \
+				   + (VIRTIO_HDR_LEN))
 
 #define DRIVER_NAME           "virtio-net"
+/* How long to wait for the device to complete a control command */
+#define VIRTIO_NET_CTRL_TIMEOUT_MS 1000
 
 
 #define  VTNET_RX_HEADER_PAD (4)
@@ -61,9 +71,10 @@
 #define  VTNET_INTR_USR_EN_MASK   (2)
 
 /**
- * Define max possible fragments for the network packets.
+ * Define max possible fragments for the network packets, plus one for the
+ * virtio header.
  */
-#define NET_MAX_FRAGMENTS    ((__U16_MAX >> __PAGE_SHIFT) + 2)
+#define NET_MAX_FRAGMENTS    ((__U16_MAX >> __PAGE_SHIFT) + 3)
 
 #define to_virtionetdev(ndev) \
 	__containerof(ndev, struct virtio_net_device, netdev)
@@ -126,6 +137,8 @@ struct uk_netdev_rx_queue {
 	/* User-provided receive buffer allocation function */
 	uk_netdev_alloc_rxpkts alloc_rxpkts;
 	void *alloc_rxpkts_argp;
+	/* The nr. of free descriptors not yet refilled */
+	uint16_t nb_unfilled;
 	/* Reference to the uk_netdev */
 	struct uk_netdev *ndev;
 	/* The scatter list and its associated fragements */
@@ -141,6 +154,18 @@ struct virtio_net_device {
 	struct uk_netdev netdev;
 	/* Count of the number of the virtqueues */
 	__u16 max_vqueue_pairs;
+	/* The control virtqueue, if VIRTIO_NET_F_MQ was negotiated */
+	struct virtqueue *ctrlq;
+	__u16 ctrlq_hwvq_id;
+	/* The control command and its scatter list */
+	struct virtio_net_ctrl_hdr ctrl_hdr;
+	struct virtio_net_ctrl_mq ctrl_mq;
+	virtio_net_ctrl_ack ctrl_ack;
+	/* The last command timed out and is still in the control queue */
+	int ctrl_pending;
+	struct uk_sglist ctrl_sg;
+	/* A small buffer may cross a page boundary */
+	struct uk_sglist_seg ctrl_sgsegs[6];
 	/* List of the Rx/Tx queue */
 	__u16    rx_vqueue_cnt;
 	struct   uk_netdev_rx_queue *rxqs;
@@ -158,6 +183,12 @@ struct virtio_net_device {
 	__u8 state;
 	/* RX promiscuous mode. */
 	__u8 promisc : 1;
+	/* The virtio header may share a descriptor with the packet data */
+	__u8 any_layout : 1;
+	/* A received packet may span several receive buffers */
+	__u8 mrg_rxbuf : 1;
+	/* Size of the virtio header, depends on the negotiated features */
+	__u16 hdr_len;
 };
 
 /**
@@ -195,6 +226,12 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 static int virtio_netdev_recv(struct uk_netdev *dev,
 			      struct uk_netdev_rx_queue *queue,
 			      struct uk_netbuf **pkt);
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
+static int virtio_netdev_recv_burst(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
 static const struct uk_hwaddr *virtio_net_mac_get(struct uk_netdev *n);
 static __u16 virtio_net_mtu_get(struct uk_netdev *n);
 static unsigned virtio_net_promisc_get(struct uk_netdev *n);
@@ -267,24 +304,26 @@ static int virtio_netdev_rx_fillup(struct uk_netdev_rx_queue *rxq,
 				   int notify)
 {
 	struct uk_netbuf *netbuf[RX_FILLUP_BATCHLEN];
+	struct virtio_net_device *vndev = to_virtionetdev(rxq->ndev);
 	int rc = 0;
 	int status = 0x0;
 	__u16 i, j;
 	__u16 req;
 	__u16 cnt = 0;
 	__u16 filled = 0;
+	__u16 step;
 
 	/**
-	 * Fixed amount of memory is allocated to each received buffer. In
-	 * our case since we don't support jumbo frame or LRO yet we require
-	 * that the buffer feed to the ring descriptor is atleast
-	 * ethernet MTU + virtio net header.
-	 * Because we using 2 descriptor for a single netbuf, our effective
-	 * queue size is just the half.
+	 * Without mergeable receive buffers, each received buffer must hold
+	 * at least the ethernet MTU + virtio net header.
+	 * When the virtio header needs its own descriptor, we use 2
+	 * descriptors for a single netbuf, so our effective queue size is just
+	 * the half.
 	 */
-	nb_desc = ALIGN_DOWN(nb_desc, 2);
+	step = vndev->any_layout ? 1 : 2;
+	nb_desc = ALIGN_DOWN(nb_desc, step);
 	while (filled < nb_desc) {
-		req = MIN(nb_desc / 2, RX_FILLUP_BATCHLEN);
+		req = MIN((nb_desc - filled) / step, RX_FILLUP_BATCHLEN);
 		cnt = rxq->alloc_rxpkts(rxq->alloc_rxpkts_argp, netbuf, req);
 		for (i = 0; i < cnt; i++) {
 			uk_pr_debug("Enqueue netbuf %"PRIu16"/%"PRIu16" (%p) to virtqueue %p...\n",
@@ -303,7 +342,7 @@ static int virtio_netdev_rx_fillup(struct uk_netdev_rx_queue *rxq,
 				status |= UK_NETDEV_STATUS_UNDERRUN;
 				goto out;
 			}
-			filled += 2;
+			filled += step;
 		}
 
 		if (unlikely(cnt < req)) {
@@ -316,7 +355,7 @@ static int virtio_netdev_rx_fillup(struct uk_netdev_rx_queue *rxq,
 
 out:
 	uk_pr_debug("Programmed %"PRIu16" receive netbufs to receive virtqueue %p (status %x)\n",
-		    filled / 2, rxq, status);
+		    filled / step, rxq, status);
 
 	/**
 	 * Notify the host, when we submit new descriptor(s).
@@ -327,31 +366,105 @@ out:
 	return status;
 }
 
-static int virtio_netdev_xmit(struct uk_netdev *dev,
-			      struct uk_netdev_tx_queue *queue,
-			      struct uk_netbuf *pkt)
+/**
+ * Refills the free descriptors of a receive queue after a receive call.
+ * Refilling is deferred until a quarter of the queue (at most a fill-up
+ * batch) is free or the queue was drained, so that receive buffers are
+ * allocated in batches instead of one per received packet.
+ */
+static int virtio_netdev_rx_refill(struct uk_netdev_rx_queue *rxq,
+				   int drained)
 {
-	struct virtio_net_device *vndev __unused;
+	int status;
+
+	if (!drained && rxq->nb_unfilled < MIN(RX_FILLUP_BATCHLEN,
+					       rxq->nb_desc / 4))
+		return 0x0;
+
+	status = virtio_netdev_rx_fillup(rxq, rxq->nb_unfilled, 1);
+	rxq->nb_unfilled = 0;
+	return status;
+}
+
+/**
+ * Fills the segmentation fields of the virtio header for a packet marked with
+ * UK_NETBUF_F_GSO. Returns 0 on success or a negative error code if the
+ * device cannot segment the packet.
+ */
+static int virtio_netdev_xmit_gso(struct virtio_net_device *vndev,
+				  struct virtio_net_hdr *vhdr,
+				  struct uk_netbuf *pkt,
+				  const __u8 *buf_start, size_t buf_len)
+{
+	__u16 l4_start = vhdr->csum_start;
+	__u16 l4_len;
+	int feature;
+
+	/* The device completes the checksum of every segment */
+	if (unlikely(!(pkt->flags & UK_NETBUF_F_PARTIAL_CSUM)
+		     || !pkt->gso_size))
+		return -EINVAL;
+
+	switch (pkt->gso_type & UK_NETBUF_GSO_TYPE_MASK) {
+	case UK_NETBUF_GSO_TCPV4:
+		vhdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+		feature = VIRTIO_NET_F_HOST_TSO4;
+		break;
+	case UK_NETBUF_GSO_TCPV6:
+		vhdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV6;
+		feature = VIRTIO_NET_F_HOST_TSO6;
+		break;
+	case UK_NETBUF_GSO_UDP:
+		vhdr->gso_type = VIRTIO_NET_HDR_GSO_UDP;
+		feature = VIRTIO_NET_F_HOST_UFO;
+		break;
+	default:
+		return -EINVAL;
+	}
+	if (unlikely(!VIRTIO_FEATURE_HAS(vndev->vdev->features, feature)))
+		return -ENOTSUP;
+
+	if (pkt->gso_type & UK_NETBUF_GSO_ECN) {
+		if (unlikely(!VIRTIO_FEATURE_HAS(vndev->vdev->features,
+						 VIRTIO_NET_F_HOST_ECN)))
+			return -ENOTSUP;
+		vhdr->gso_type |= VIRTIO_NET_HDR_GSO_ECN;
+	}
+	vhdr->gso_size = pkt->gso_size;
+
+	/**
+	 * The header length is a hint for the device: ethernet, IP and the
+	 * TCP header with its options (data offset) or the UDP header.
+	 */
+	if (vhdr->gso_type == VIRTIO_NET_HDR_GSO_UDP)
+		l4_len = 8;
+	else if ((size_t) l4_start + 12 < buf_len)
+		l4_len = (buf_start[l4_start + 12] >> 4) * 4;
+	else
+		l4_len = 0;
+	vhdr->hdr_len = l4_start + l4_len;
+	return 0;
+}
+
+/**
+ * Puts one packet to the transmit virtqueue without notifying the host.
+ * Returns the number of free descriptors left on success, -ENOSPC when the
+ * ring is full, or a negative error code. The packet is unmodified on
+ * failure.
+ */
+static int virtio_netdev_xmit_enqueue(struct uk_netdev_tx_queue *queue,
+				      struct uk_netbuf *pkt)
+{
+	struct virtio_net_device *vndev = to_virtionetdev(queue->ndev);
 	struct virtio_net_hdr *vhdr;
 	struct virtio_net_hdr_padded *padded_hdr;
 	int16_t header_sz = sizeof(*padded_hdr);
 	int rc = 0;
-	int status = 0x0;
 	size_t total_len = 0;
+	size_t max_len;
 	__u8  *buf_start;
 	size_t buf_len;
 
-	UK_ASSERT(dev);
-	UK_ASSERT(pkt && queue);
-
-	vndev = to_virtionetdev(dev);
-	/**
-	 * We are reclaiming the free descriptors from buffers. The function is
-	 * not protected by means of locks. We need to be careful if there are
-	 * multiple context through which we free the tx descriptors.
-	 */
-	virtio_netdev_xmit_free(queue);
-
 	buf_start = pkt->data;
 	buf_len = pkt->len;
 	/**
@@ -363,7 +476,8 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 		rc = -ENOSPC;
 		goto err_exit;
 	}
-	vhdr = pkt->data;
+	/* The header goes right in front of the packet data */
+	vhdr = (struct virtio_net_hdr *) (buf_start - vndev->hdr_len);
 
 	/**
 	 * Fill the virtio-net-header with the necessary information.
@@ -378,7 +492,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 *       to `uk_sglist_append_netbuf()`. However, a netbuf
 	 *       chain can only once have set the PARTIAL_CSUM flag.
 	 */
-	memset(vhdr, 0, sizeof(*vhdr));
+	memset(vhdr, 0, vndev->hdr_len);
 	if (pkt->flags & UK_NETBUF_F_PARTIAL_CSUM) {
 		vhdr->flags       |= VIRTIO_NET_HDR_F_NEEDS_CSUM;
 		/* `csum_start` is without header size */
@@ -386,6 +500,17 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 		vhdr->csum_offset  = pkt->csum_offset;
 	}
 	vhdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
+	max_len = VIRTIO_PKT_BUFFER_LEN;
+	if (pkt->flags & UK_NETBUF_F_GSO) {
+		rc = virtio_netdev_xmit_gso(vndev, vhdr, pkt,
+					    buf_start, buf_len);
+		if (unlikely(rc < 0)) {
+			uk_pr_err("Segmentation offload not supported for packet: %d\n",
+				  rc);
+			goto err_remove_vhdr;
+		}
+		max_len = VIRTIO_GSO_PKT_BUFFER_LEN;
+	}
 
 	/**
 	 * Prepare the sglist and enqueue the buffer to the virtio-ring.
@@ -394,18 +519,19 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 
 	/**
 	 * According the specification 5.1.6.6, we need to explicitly use
-	 * 2 descriptor for each transmit and receive network packet since we
-	 * do not negotiate for the VIRTIO_F_ANY_LAYOUT.
-	 *
+	 * 2 descriptor for each transmit and receive network packet unless
+	 * VIRTIO_F_ANY_LAYOUT is negotiated:
 	 * 1 for the virtio header and the other for the actual network packet.
 	 */
 	/* Appending the data to the list. */
-	rc = uk_sglist_append(&queue->sg, vhdr, sizeof(*vhdr));
-	if (unlikely(rc != 0)) {
-		uk_pr_err("Failed to append to the sg list\n");
-		goto err_remove_vhdr;
+	if (vndev->any_layout) {
+		rc = uk_sglist_append(&queue->sg, vhdr,
+				      vndev->hdr_len + buf_len);
+	} else {
+		rc = uk_sglist_append(&queue->sg, vhdr, vndev->hdr_len);
+		if (likely(rc == 0))
+			rc = uk_sglist_append(&queue->sg, buf_start, buf_len);
 	}
-	rc = uk_sglist_append(&queue->sg, buf_start, buf_len);
 	if (unlikely(rc != 0)) {
 		uk_pr_err("Failed to append to the sg list\n");
 		goto err_remove_vhdr;
@@ -419,9 +545,9 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	}
 
 	total_len = uk_sglist_length(&queue->sg);
-	if (unlikely(total_len > VIRTIO_PKT_BUFFER_LEN)) {
-		uk_pr_err("Packet size too big: %lu, max:%u\n",
-			  total_len, VIRTIO_PKT_BUFFER_LEN);
+	if (unlikely(total_len > max_len)) {
+		uk_pr_err("Packet size too big: %lu, max:%lu\n",
+			  total_len, max_len);
 		rc = -ENOTSUP;
 		goto err_remove_vhdr;
 	}
@@ -431,6 +557,44 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 */
 	rc = virtqueue_buffer_enqueue(queue->vq, pkt, &queue->sg,
 				      queue->sg.sg_nseg, 0);
+	if (likely(rc >= 0))
+		return rc;
+	if (rc == -ENOSPC)
+		uk_pr_debug("No more descriptor available\n");
+	else
+		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
+			  rc);
+
+err_remove_vhdr:
+	/**
+	 * Remove header before exiting because we could not send
+	 */
+	uk_netbuf_header(pkt, -header_sz);
+err_exit:
+	UK_ASSERT(rc < 0);
+	return rc;
+}
+
+static int virtio_netdev_xmit(struct uk_netdev *dev,
+			      struct uk_netdev_tx_queue *queue,
+			      struct uk_netbuf *pkt)
+{
+	struct virtio_net_device *vndev __unused;
+	int status = 0x0;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(pkt && queue);
+
+	vndev = to_virtionetdev(dev);
+	/**
+	 * We are reclaiming the free descriptors from buffers. The function is
+	 * not protected by means of locks. We need to be careful if there are
+	 * multiple context through which we free the tx descriptors.
+	 */
+	virtio_netdev_xmit_free(queue);
+
+	rc = virtio_netdev_xmit_enqueue(queue, pkt);
 	if (likely(rc >= 0)) {
 		status |= UK_NETDEV_STATUS_SUCCESS;
 		/**
@@ -442,29 +606,52 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 		 * return UK_NETDEV_STATUS_MORE.
 		 */
 		status |= likely(rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0;
-	} else if (rc == -ENOSPC) {
-		uk_pr_debug("No more descriptor available\n");
+	} else if (rc != -ENOSPC) {
+		return rc;
+	}
+	return status;
+}
+
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int status = 0x0;
+	int rc = 0;
+	__u16 i;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	virtio_netdev_xmit_free(queue);
+
+	for (i = 0; i < *cnt; i++) {
+		rc = virtio_netdev_xmit_enqueue(queue, pkts[i]);
+		if (unlikely(rc < 0))
+			break;
+	}
+
+	if (unlikely(!i && rc < 0 && rc != -ENOSPC)) {
+		*cnt = 0;
+		return rc;
+	}
+
+	if (likely(i)) {
+		status |= UK_NETDEV_STATUS_SUCCESS;
 		/**
-		 * Remove header before exiting because we could not send
+		 * A single notification for the whole burst.
 		 */
-		uk_netbuf_header(pkt, -header_sz);
-	} else {
-		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
-			  rc);
-		goto err_remove_vhdr;
+		virtqueue_host_notify(queue->vq);
+		status |= (i == *cnt && rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0;
 	}
+	*cnt = i;
 	return status;
-
-err_remove_vhdr:
-	uk_netbuf_header(pkt, -header_sz);
-err_exit:
-	UK_ASSERT(rc < 0);
-	return rc;
 }
 
 static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 				     struct uk_netbuf *netbuf)
 {
+	struct virtio_net_device *vndev = to_virtionetdev(rxq->ndev);
 	int rc = 0;
 	struct virtio_net_hdr_padded *rxhdr;
 	int16_t header_sz = sizeof(*rxhdr);
@@ -482,6 +669,7 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	 */
 	buf_start = netbuf->data;
 	buf_len = netbuf->len;
+	netbuf->flags = 0x0;
 
 	/**
 	 * Retrieve the buffer header length.
@@ -491,28 +679,75 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 		uk_pr_err("Failed to allocate space to prepend virtio header\n");
 		return -EINVAL;
 	}
-	rxhdr = netbuf->data;
 
 	sg = &rxq->sg;
 	uk_sglist_reset(sg);
 
-	/* Appending the header buffer to the sglist */
-	uk_sglist_append(sg, rxhdr, sizeof(struct virtio_net_hdr));
+	/**
+	 * The header goes right in front of the data buffer. With mergeable
+	 * receive buffers, a continuation buffer receives packet data from
+	 * the header position on.
+	 */
+	if (vndev->any_layout) {
+		uk_sglist_append(sg, buf_start - vndev->hdr_len,
+				 vndev->hdr_len + buf_len);
+	} else {
+		/* Appending the header buffer to the sglist */
+		uk_sglist_append(sg, buf_start - vndev->hdr_len,
+				 vndev->hdr_len);
 
-	/* Appending the data buffer to the sglist */
-	uk_sglist_append(sg, buf_start, buf_len);
+		/* Appending the data buffer to the sglist */
+		uk_sglist_append(sg, buf_start, buf_len);
+	}
 
 	rc = virtqueue_buffer_enqueue(rxq->vq, netbuf, sg, 0, sg->sg_nseg);
 	return rc;
 }
 
+/**
+ * Takes the next buffer of a packet spread over mergeable receive buffers
+ * from the receive virtqueue and appends it to the packet.
+ */
+static int virtio_netdev_rxq_dequeue_mrg(struct uk_netdev_rx_queue *rxq,
+					 struct uk_netbuf *head)
+{
+	struct virtio_net_device *vndev = to_virtionetdev(rxq->ndev);
+	int16_t pad = sizeof(struct virtio_net_hdr_padded) - vndev->hdr_len;
+	struct uk_netbuf *buf = NULL;
+	__u32 len;
+	int ret;
+	int rc __maybe_unused;
+
+	ret = virtqueue_buffer_dequeue(rxq->vq, (void **) &buf, &len);
+	if (unlikely(ret < 0)) {
+		uk_pr_err("Missing receive buffer of merged packet\n");
+		return -EINVAL;
+	}
+	if (unlikely(!len || len > (__u32) (buf->len - pad))) {
+		uk_pr_err("Received invalid buffer size: %"__PRIu32"\n", len);
+		uk_netbuf_free(buf);
+		return -EINVAL;
+	}
+
+	/* The data starts where the header would be */
+	buf->len = len + pad;
+	rc = uk_netbuf_header(buf, -pad);
+	UK_ASSERT(rc == 1);
+	uk_netbuf_append(head, buf);
+
+	return ret;
+}
+
 static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 				     struct uk_netbuf **netbuf)
 {
+	struct virtio_net_device *vndev = to_virtionetdev(rxq->ndev);
+	int16_t header_sz = sizeof(struct virtio_net_hdr_padded);
 	int ret;
 	int rc __maybe_unused = 0;
 	struct uk_netbuf *buf = NULL;
 	struct virtio_net_hdr *vhdr;
+	__u16 num_buffers = 1;
 	__u32 len;
 
 	UK_ASSERT(netbuf);
@@ -523,16 +758,19 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 		*netbuf = NULL;
 		return rxq->nb_desc;
 	}
-	if (unlikely((len < VIRTIO_HDR_LEN + UK_ETH_HDR_UNTAGGED_LEN)
-		     || (len > VIRTIO_PKT_BUFFER_LEN))) {
+	if (unlikely((len < (__u32) vndev->hdr_len + UK_ETH_HDR_UNTAGGED_LEN)
+		     || (len > (__u32) (buf->len - header_sz
+					+ vndev->hdr_len)))) {
 		uk_pr_err("Received invalid packet size: %"__PRIu32"\n", len);
+		uk_netbuf_free(buf);
 		return -EINVAL;
 	}
 
 	/**
 	 * Copy virtio header flags to netbuf
 	 */
-	vhdr = (struct virtio_net_hdr *) buf->data;
+	vhdr = (struct virtio_net_hdr *) ((__u8 *) buf->data + header_sz
+					  - vndev->hdr_len);
 	buf->flags  = ((vhdr->flags & VIRTIO_NET_HDR_F_DATA_VALID)
 		       ? UK_NETBUF_F_DATA_VALID   : 0x0);
 	if (vhdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
@@ -541,20 +779,50 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 		/* NOTE: csum_start is without virtio header
 		 *       (uk_netbuf_header() will remove it again)
 		 */
-		buf->csum_start  = vhdr->csum_start
-			+ ((uint16_t)sizeof(struct virtio_net_hdr_padded));
+		buf->csum_start  = vhdr->csum_start + header_sz;
 	}
+	if ((vhdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN)
+	    != VIRTIO_NET_HDR_GSO_NONE) {
+		switch (vhdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN) {
+		case VIRTIO_NET_HDR_GSO_TCPV4:
+			buf->gso_type = UK_NETBUF_GSO_TCPV4;
+			break;
+		case VIRTIO_NET_HDR_GSO_TCPV6:
+			buf->gso_type = UK_NETBUF_GSO_TCPV6;
+			break;
+		default:
+			buf->gso_type = UK_NETBUF_GSO_UDP;
+			break;
+		}
+		if (vhdr->gso_type & VIRTIO_NET_HDR_GSO_ECN)
+			buf->gso_type |= UK_NETBUF_GSO_ECN;
+		buf->gso_size = vhdr->gso_size;
+		buf->flags |= UK_NETBUF_F_GSO;
+	}
+	if (vndev->mrg_rxbuf)
+		num_buffers = ((struct virtio_net_hdr_mrg_rxbuf *) vhdr)
+			->num_buffers;
 
 	/**
 	 * Removing the virtio header from the buffer and adjusting length.
-	 * We pad "VTNET_RX_HEADER_PAD" to the rx buffer while enqueuing for
-	 * alignment of the packet data. We compensate for this, by adding the
-	 *  padding to the length on dequeue.
+	 * The header is placed at the end of the reserved header space, in
+	 * front of the packet data. We compensate for the padding in front
+	 * of it, by adding the padding to the length on dequeue.
 	 */
-	buf->len = len + VTNET_RX_HEADER_PAD;
-	rc = uk_netbuf_header(buf,
-			      -((int16_t)sizeof(struct virtio_net_hdr_padded)));
+	buf->len = len + header_sz - vndev->hdr_len;
+	rc = uk_netbuf_header(buf, -header_sz);
 	UK_ASSERT(rc == 1);
+
+	/**
+	 * The rest of a merged packet is already on the used ring.
+	 */
+	while (num_buffers-- > 1) {
+		ret = virtio_netdev_rxq_dequeue_mrg(rxq, buf);
+		if (unlikely(ret < 0)) {
+			uk_netbuf_free(buf);
+			return ret;
+		}
+	}
 	*netbuf = buf;
 
 	return ret;
@@ -579,7 +847,9 @@ static int virtio_netdev_recv(struct uk_netdev *dev __unused,
 		goto err_exit;
 	}
 	status |= (*pkt) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
-	status |= virtio_netdev_rx_fillup(queue, (queue->nb_desc - rc), 1);
+	if (*pkt)
+		queue->nb_unfilled = queue->nb_desc - rc;
+	status |= virtio_netdev_rx_refill(queue, !(*pkt));
 
 	/* Enable interrupt only when user had previously enabled it */
 	if (queue->intr_enabled & VTNET_INTR_USR_EN_MASK) {
@@ -596,15 +866,15 @@ static int virtio_netdev_recv(struct uk_netdev *dev __unused,
 					  rc);
 				goto err_exit;
 			}
-			status |= UK_NETDEV_STATUS_SUCCESS;
+			status |= (*pkt) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
 
 			/*
-			 * Since we received something, we need to fillup
+			 * Since we received something, we may need to fillup
 			 * and notify
 			 */
-			status |= virtio_netdev_rx_fillup(queue,
-							  (queue->nb_desc - rc),
-							  1);
+			if (*pkt)
+				queue->nb_unfilled = queue->nb_desc - rc;
+			status |= virtio_netdev_rx_refill(queue, !(*pkt));
 
 			/* Need to enable the interrupt on the last packet */
 			rc = virtqueue_intr_enable(queue->vq);
@@ -627,6 +897,61 @@ err_exit:
 	return rc;
 }
 
+static int virtio_netdev_recv_burst(struct uk_netdev *dev __unused,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int status = 0x0;
+	int used = queue->nb_desc;
+	int rc = 0;
+	__u16 i = 0;
+
+	UK_ASSERT(dev && queue);
+	UK_ASSERT(pkts && cnt);
+
+	/* Queue interrupts have to be off when calling receive */
+	UK_ASSERT(!(queue->intr_enabled & VTNET_INTR_EN));
+
+	while (i < *cnt) {
+		rc = virtio_netdev_rxq_dequeue(queue, &pkts[i]);
+		if (unlikely(rc < 0)) {
+			uk_pr_err("Failed to dequeue the packet: %d\n", rc);
+			if (!i) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		if (!pkts[i])
+			break;
+		used = rc;
+		i++;
+	}
+
+	/* Refill and notify the host at most once for the whole burst */
+	status |= i ? UK_NETDEV_STATUS_SUCCESS : 0x0;
+	if (i)
+		queue->nb_unfilled = queue->nb_desc - used;
+	status |= virtio_netdev_rx_refill(queue, i < *cnt);
+
+	if (queue->intr_enabled & VTNET_INTR_USR_EN_MASK) {
+		/**
+		 * Interrupts stay off while packets are left on the queue,
+		 * including those that arrived while enabling them.
+		 */
+		rc = virtqueue_intr_enable(queue->vq);
+		status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
+	} else if (i == *cnt) {
+		/**
+		 * For polling case, we report further packets unless we
+		 * saw the queue empty.
+		 */
+		status |= UK_NETDEV_STATUS_MORE;
+	}
+	*cnt = i;
+	return status;
+}
+
 static struct uk_netdev_rx_queue *virtio_netdev_rx_queue_setup(
 				struct uk_netdev *n, uint16_t queue_id,
 				uint16_t nb_desc,
@@ -658,6 +983,7 @@ static struct uk_netdev_rx_queue *virtio_netdev_rx_queue_setup(
 	rxq  = &vndev->rxqs[rc];
 	rxq->alloc_rxpkts = conf->alloc_rxpkts;
 	rxq->alloc_rxpkts_argp = conf->alloc_rxpkts_argp;
+	rxq->nb_unfilled = 0;
 
 	/* Allocate receive buffers for this queue */
 	virtio_netdev_rx_fillup(rxq, rxq->nb_desc, 0);
@@ -694,12 +1020,12 @@ static int virtio_netdev_vqueue_setup(struct virtio_net_device *vndev,
 	struct virtqueue *vq;
 
 	if (queue_type == VNET_RX) {
-		id = vndev->rx_vqueue_cnt;
+		id = queue_id;
 		callback = virtio_netdev_recv_done;
 		max_desc = vndev->rxqs[id].max_nb_desc;
 		hwvq_id = vndev->rxqs[id].hwvq_id;
 	} else {
-		id = vndev->tx_vqueue_cnt;
+		id = queue_id;
 		/* We don't support the callback from the txqueue yet */
 		callback = NULL;
 		max_desc = vndev->txqs[id].max_nb_desc;
@@ -862,6 +1188,7 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 {
 	__u64 host_features = 0;
 	__u64 drv_features  = 0;
+	__u16 max_pairs = 0;
 	int rc = 0;
 	struct virtio_net_device *vndev;
 
@@ -922,11 +1249,104 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_GUEST_CSUM);
 	}
 
+	/**
+	 * Descriptor layout
+	 * NOTE: Modern devices and legacy devices with VIRTIO_F_ANY_LAYOUT
+	 *       accept the virtio header in the same descriptor as the
+	 *       packet data.
+	 */
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_F_VERSION_1))
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_F_VERSION_1);
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_F_ANY_LAYOUT))
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_F_ANY_LAYOUT);
+	vndev->any_layout =
+		VIRTIO_FEATURE_HAS(drv_features, VIRTIO_F_VERSION_1)
+		|| VIRTIO_FEATURE_HAS(drv_features, VIRTIO_F_ANY_LAYOUT);
+
+#if CONFIG_VIRTIO_NET_MRG_RXBUF
+	/**
+	 * Mergeable receive buffers
+	 * NOTE: Continuation buffers are filled from their first byte on, so
+	 *       the header has to share the descriptor with the data.
+	 */
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_MRG_RXBUF)
+	    && vndev->any_layout)
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_MRG_RXBUF);
+#endif /* CONFIG_VIRTIO_NET_MRG_RXBUF */
+	vndev->mrg_rxbuf =
+		VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_MRG_RXBUF);
+	vndev->hdr_len = (vndev->mrg_rxbuf
+			  || VIRTIO_FEATURE_HAS(drv_features,
+						VIRTIO_F_VERSION_1))
+			 ? sizeof(struct virtio_net_hdr_mrg_rxbuf)
+			 : sizeof(struct virtio_net_hdr);
+
+#if CONFIG_VIRTIO_NET_HOST_TSO
+	/**
+	 * Transmit segmentation offload
+	 * NOTE: Segmentation requires checksum offloading.
+	 */
+	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_CSUM)) {
+		drv_features |= host_features
+			& ((1ULL << VIRTIO_NET_F_HOST_TSO4)
+			   | (1ULL << VIRTIO_NET_F_HOST_TSO6)
+			   | (1ULL << VIRTIO_NET_F_HOST_UFO));
+		if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_HOST_TSO4)
+		    || VIRTIO_FEATURE_HAS(drv_features,
+					  VIRTIO_NET_F_HOST_TSO6))
+			drv_features |= host_features
+				& (1ULL << VIRTIO_NET_F_HOST_ECN);
+	}
+#endif /* CONFIG_VIRTIO_NET_HOST_TSO */
+
+#if CONFIG_VIRTIO_NET_GUEST_TSO
+	/**
+	 * Receive coalesced packets
+	 * NOTE: They are spread over mergeable receive buffers.
+	 */
+	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_GUEST_CSUM)
+	    && vndev->mrg_rxbuf) {
+		drv_features |= host_features
+			& ((1ULL << VIRTIO_NET_F_GUEST_TSO4)
+			   | (1ULL << VIRTIO_NET_F_GUEST_TSO6)
+			   | (1ULL << VIRTIO_NET_F_GUEST_UFO));
+		if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_GUEST_TSO4)
+		    || VIRTIO_FEATURE_HAS(drv_features,
+					  VIRTIO_NET_F_GUEST_TSO6))
+			drv_features |= host_features
+				& (1ULL << VIRTIO_NET_F_GUEST_ECN);
+	}
+#endif /* CONFIG_VIRTIO_NET_GUEST_TSO */
+
+	/**
+	 * Ring features
+	 * NOTE: Event indices suppress notifications and interrupts,
+	 *       indirect descriptors let a packet take a single ring slot.
+	 */
+	drv_features |= host_features & VIRTQUEUE_FEATURES;
+
+#if CONFIG_VIRTIO_NET_MQ
+	/**
+	 * Multiqueue
+	 * NOTE: The device uses a single queue pair until the driver sets
+	 *       the number of pairs over the control virtqueue.
+	 */
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_CTRL_VQ)
+	    && VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_MQ)) {
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_CTRL_VQ);
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_MQ);
+	}
+#endif /* CONFIG_VIRTIO_NET_MQ */
+
 	/**
 	 * Announce our enabled driver features back to the backend device
 	 */
 	vndev->vdev->features = drv_features;
-	virtio_feature_set(vndev->vdev, vndev->vdev->features);
+	rc = virtio_feature_set(vndev->vdev, vndev->vdev->features);
+	if (unlikely(rc)) {
+		uk_pr_err("%p: Device rejected the negotiated features\n", n);
+		goto err_negotiate_feature;
+	}
 
 	/**
 	 * According to Virtio specification, section 2.3.1. Config fields
@@ -955,6 +1375,28 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 		vndev->max_mtu = vndev->mtu = UK_ETH_PAYLOAD_MAXLEN;
 	}
 
+	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_MQ)) {
+		virtio_config_get(vndev->vdev,
+				  __offsetof(struct virtio_net_config,
+					     max_virtqueue_pairs),
+				  &max_pairs, sizeof(max_pairs), 1);
+		if (unlikely(max_pairs < VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN
+			     || max_pairs > VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX)) {
+			uk_pr_err("%p: Invalid number of queue pairs: %"__PRIu16"\n",
+				  n, max_pairs);
+			rc = -EINVAL;
+			goto err_negotiate_feature;
+		}
+		/* The control virtqueue follows all the queue pairs */
+		vndev->ctrlq_hwvq_id = 2 * max_pairs;
+		vndev->max_vqueue_pairs = MIN(max_pairs,
+					      CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	} else {
+		vndev->max_vqueue_pairs = 1;
+	}
+	uk_pr_debug("%p: %"__PRIu16" queue pairs\n", n,
+		    vndev->max_vqueue_pairs);
+
 	return 0;
 
 err_negotiate_feature:
@@ -968,16 +1410,29 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	int rc = 0;
 	int i = 0;
 	int vq_avail = 0;
-	int total_vqs = conf->nb_rx_queues + conf->nb_tx_queues;
-	__u16 qdesc_size[total_vqs];
+	int total_vqs;
+	__u16 *qdesc_size;
 
-	if (conf->nb_rx_queues != 1 || conf->nb_tx_queues != 1) {
+	if (conf->nb_rx_queues != conf->nb_tx_queues
+	    || conf->nb_rx_queues == 0
+	    || conf->nb_rx_queues > vndev->max_vqueue_pairs) {
 		uk_pr_err("Queue combination not supported: %"__PRIu16"/%"__PRIu16" rx/tx\n",
 			  conf->nb_rx_queues, conf->nb_tx_queues);
 
 		return -ENOTSUP;
 	}
 
+	/**
+	 * The size of all virtqueues up to the ones in use is read from the
+	 * device. With multiqueue, the control virtqueue comes after all the
+	 * queue pairs that the device offers.
+	 */
+	if (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_MQ))
+		total_vqs = vndev->ctrlq_hwvq_id + 1;
+	else
+		total_vqs = 2 * conf->nb_rx_queues;
+	qdesc_size = uk_malloc(a, sizeof(*qdesc_size) * total_vqs);
+
 	/**
 	 * TODO:
 	 * The virtio device management data structure are allocated using the
@@ -987,7 +1442,7 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 */
 	vndev->rxqs = uk_malloc(a, sizeof(*vndev->rxqs) * conf->nb_rx_queues);
 	vndev->txqs = uk_malloc(a, sizeof(*vndev->txqs) * conf->nb_tx_queues);
-	if (unlikely(!vndev->rxqs || !vndev->txqs)) {
+	if (unlikely(!qdesc_size || !vndev->rxqs || !vndev->txqs)) {
 		uk_pr_err("Failed to allocate memory for queue management\n");
 		rc = -ENOMEM;
 		goto err_free_txrx;
@@ -1010,7 +1465,7 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 * ...
 	 * Virtqueue-ctrlq
 	 */
-	for (i = 0; i < vndev->max_vqueue_pairs; i++) {
+	for (i = 0; i < conf->nb_rx_queues; i++) {
 		/**
 		 * Initialize the received queue with the information received
 		 * from the device.
@@ -1033,17 +1488,108 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				sizeof(vndev->txqs[i].sgsegs[0])),
 			       &vndev->txqs[i].sgsegs[0]);
 	}
+
+	if (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_MQ)) {
+		/* Commands are polled for, the control queue has no callback */
+		vndev->ctrlq = virtio_vqueue_setup(vndev->vdev,
+						   vndev->ctrlq_hwvq_id,
+						   qdesc_size[vndev->ctrlq_hwvq_id],
+						   NULL, a);
+		if (unlikely(PTRISERR(vndev->ctrlq))) {
+			uk_pr_err("Failed to set up the control virtqueue\n");
+			rc = PTR2ERR(vndev->ctrlq);
+			vndev->ctrlq = NULL;
+			goto err_free_txrx;
+		}
+		virtqueue_intr_disable(vndev->ctrlq);
+		uk_sglist_init(&vndev->ctrl_sg, ARRAY_SIZE(vndev->ctrl_sgsegs),
+			       &vndev->ctrl_sgsegs[0]);
+	}
+	uk_free(a, qdesc_size);
 exit:
 	return rc;
 
 err_free_txrx:
-	if (!vndev->rxqs)
+	if (qdesc_size)
+		uk_free(a, qdesc_size);
+	if (vndev->rxqs)
 		uk_free(a, vndev->rxqs);
-	if (!vndev->txqs)
+	if (vndev->txqs)
 		uk_free(a, vndev->txqs);
 	goto exit;
 }
 
+/**
+ * Send a command over the control virtqueue and wait for the device to
+ * acknowledge it.
+ * @param vndev
+ *	Reference to the virtio net device.
+ * @param class
+ *	The command class (VIRTIO_NET_CTRL_*).
+ * @param cmd
+ *	The command within the class.
+ * @param data
+ *	The command data, placed in the virtio net device.
+ * @param len
+ *	The length of the command data.
+ */
+static int virtio_netdev_ctrl_send(struct virtio_net_device *vndev,
+				   __u8 class, __u8 cmd, void *data, __u32 len)
+{
+	void *cookie;
+	__u32 ack_len;
+	__u16 read_segs;
+	__nsec deadline;
+	int rc;
+
+	UK_ASSERT(vndev->ctrlq);
+
+	if (unlikely(vndev->ctrl_pending)) {
+		/* Its buffers are still owned by the device */
+		if (virtqueue_buffer_dequeue(vndev->ctrlq, &cookie,
+					     &ack_len) < 0)
+			return -ETIMEDOUT;
+		vndev->ctrl_pending = 0;
+	}
+
+	vndev->ctrl_hdr.class = class;
+	vndev->ctrl_hdr.cmd = cmd;
+	vndev->ctrl_ack = VIRTIO_NET_ERR;
+
+	uk_sglist_reset(&vndev->ctrl_sg);
+	rc = uk_sglist_append(&vndev->ctrl_sg, &vndev->ctrl_hdr,
+			      sizeof(vndev->ctrl_hdr));
+	if (likely(rc == 0))
+		rc = uk_sglist_append(&vndev->ctrl_sg, data, len);
+	read_segs = vndev->ctrl_sg.sg_nseg;
+	if (likely(rc == 0))
+		rc = uk_sglist_append(&vndev->ctrl_sg, &vndev->ctrl_ack,
+				      sizeof(vndev->ctrl_ack));
+	if (unlikely(rc != 0))
+		return rc;
+
+	rc = virtqueue_buffer_enqueue(vndev->ctrlq, vndev, &vndev->ctrl_sg,
+				      read_segs,
+				      vndev->ctrl_sg.sg_nseg - read_segs);
+	if (unlikely(rc < 0))
+		return rc;
+	virtqueue_host_notify(vndev->ctrlq);
+
+	/* The device handles control commands synchronously */
+	deadline = ukplat_monotonic_clock()
+		   + ukarch_time_msec_to_nsec(VIRTIO_NET_CTRL_TIMEOUT_MS);
+	while (virtqueue_buffer_dequeue(vndev->ctrlq, &cookie, &ack_len) < 0) {
+		if (unlikely(ukplat_monotonic_clock() >= deadline)) {
+			vndev->ctrl_pending = 1;
+			return -ETIMEDOUT;
+		}
+		ukarch_spinwait();
+	}
+	UK_ASSERT(cookie == vndev);
+
+	return (vndev->ctrl_ack == VIRTIO_NET_OK) ? 0 : -EIO;
+}
+
 static int virtio_netdev_configure(struct uk_netdev *n,
 				   const struct uk_netdev_conf *conf)
 {
@@ -1120,13 +1666,28 @@ static void virtio_net_info_get(struct uk_netdev *dev,
 	dev_info->ioalign = sizeof(void *); /* word size alignment */
 	dev_info->features = UK_NETDEV_F_RXQ_INTR
 		| (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_CSUM)
-		   ? UK_NETDEV_F_PARTIAL_CSUM : 0);
+		   ? UK_NETDEV_F_PARTIAL_CSUM : 0)
+		| (VIRTIO_FEATURE_HAS(vndev->vdev->features,
+				      VIRTIO_NET_F_HOST_TSO4)
+		   ? UK_NETDEV_F_TSO4 : 0)
+		| (VIRTIO_FEATURE_HAS(vndev->vdev->features,
+				      VIRTIO_NET_F_HOST_TSO6)
+		   ? UK_NETDEV_F_TSO6 : 0)
+		| (VIRTIO_FEATURE_HAS(vndev->vdev->features,
+				      VIRTIO_NET_F_HOST_UFO)
+		   ? UK_NETDEV_F_UFO : 0)
+		| ((vndev->vdev->features
+		    & ((1ULL << VIRTIO_NET_F_GUEST_TSO4)
+		       | (1ULL << VIRTIO_NET_F_GUEST_TSO6)
+		       | (1ULL << VIRTIO_NET_F_GUEST_UFO)))
+		   ? UK_NETDEV_F_LRO : 0);
 }
 
 static int virtio_net_start(struct uk_netdev *n)
 {
 	struct virtio_net_device *d;
 	int i = 0;
+	int rc;
 
 	UK_ASSERT(n != NULL);
 	d = to_virtionetdev(n);
@@ -1150,6 +1711,22 @@ static int virtio_net_start(struct uk_netdev *n)
 	 * Set the DRIVER_OK status bit. At this point the device is "live".
 	 */
 	virtio_dev_drv_up(d->vdev);
+
+	/*
+	 * Let the device steer flows to all the queue pairs. Until then, it
+	 * uses only the first pair.
+	 */
+	if (d->ctrlq && d->rx_vqueue_cnt > 1) {
+		d->ctrl_mq.virtqueue_pairs = d->rx_vqueue_cnt;
+		rc = virtio_netdev_ctrl_send(d, VIRTIO_NET_CTRL_MQ,
+					     VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET,
+					     &d->ctrl_mq, sizeof(d->ctrl_mq));
+		if (unlikely(rc)) {
+			uk_pr_err(DRIVER_NAME": %"__PRIu16" failed to enable %"__PRIu16" queue pairs: %d\n",
+				  d->uid, d->rx_vqueue_cnt, rc);
+			return rc;
+		}
+	}
 	uk_pr_info(DRIVER_NAME": %"__PRIu16" started\n", d->uid);
 
 	for (i = 0; i < d->rx_vqueue_cnt; i++)
@@ -1190,6 +1767,8 @@ static int virtio_net_add_dev(struct virtio_dev *vdev)
 	/* register netdev */
 	vndev->netdev.rx_one = virtio_netdev_recv;
 	vndev->netdev.tx_one = virtio_netdev_xmit;
+	vndev->netdev.rx_burst = virtio_netdev_recv_burst;
+	vndev->netdev.tx_burst = virtio_netdev_xmit_burst;
 	vndev->netdev.ops = &virtio_netdev_ops;
 
 	rc = uk_netdev_drv_register(&vndev->netdev, a, drv_name);
@@ -1201,10 +1780,7 @@ static int virtio_net_add_dev(struct virtio_dev *vdev)
 	rc = 0;
 	vndev->promisc = 0;
 
-	/**
-	 * TODO:
-	 * Adding multiqueue support for the virtio net driver.
-	 */
+	/* The number of queue pairs is read from the device when probing */
 	vndev->max_vqueue_pairs = 1;
 	uk_pr_debug("virtio-net device registered with libuknet\n");
 
@@ -79,8 +79,8 @@ static int vpci_legacy_pci_config_set(struct virtio_dev *vdev, __u16 offset,
 static int vpci_legacy_pci_config_get(struct virtio_dev *vdev, __u16 offset,
 				      void *buf, __u32 len, __u8 type_len);
 static __u64 vpci_legacy_pci_features_get(struct virtio_dev *vdev);
-static void vpci_legacy_pci_features_set(struct virtio_dev *vdev,
-					 __u64 features);
+static int vpci_legacy_pci_features_set(struct virtio_dev *vdev,
+					__u64 features);
 static int vpci_legacy_pci_vq_find(struct virtio_dev *vdev, __u16 num_vq,
 				   __u16 *qdesc_size);
 static void vpci_legacy_pci_status_set(struct virtio_dev *vdev, __u8 status);
@@ -353,8 +353,8 @@ static __u64 vpci_legacy_pci_features_get(struct virtio_dev *vdev)
 	return features;
 }
 
-static void vpci_legacy_pci_features_set(struct virtio_dev *vdev,
-					 __u64 features)
+static int vpci_legacy_pci_features_set(struct virtio_dev *vdev,
+					__u64 features)
 {
 	struct virtio_pci_dev *vpdev = NULL;
 
@@ -362,8 +362,14 @@ static void vpci_legacy_pci_features_set(struct virtio_dev *vdev,
 	vpdev = to_virtiopcidev(vdev);
 	/* Mask out features not supported by the virtqueue driver */
 	features = virtqueue_feature_negotiate(features);
+	/**
+	 * The legacy interface only has 32 feature bits, so packed rings
+	 * (VIRTIO_F_RING_PACKED, bit 34) cannot be negotiated here. They
+	 * need the modern PCI capability layout, which is not implemented.
+	 */
 	virtio_cwrite32((void *) (unsigned long)vpdev->pci_base_addr,
 			VIRTIO_PCI_GUEST_FEATURES, (__u32)features);
+	return 0;
 }
 
 static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
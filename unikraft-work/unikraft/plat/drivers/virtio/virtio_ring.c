@@ -41,8 +41,10 @@
 #include <uk/sglist.h>
 #include <uk/arch/atomic.h>
 #include <uk/plat/io.h>
+#include <uk/essentials.h>
 #include <virtio/virtio_ring.h>
 #include <virtio/virtqueue.h>
+#include <virtio/virtio_bus.h>
 #ifdef CONFIG_LIBUKVMEM
 #include <uk/arch/paging.h>
 #include <uk/plat/paging.h>
@@ -51,12 +53,19 @@
 #endif /* CONFIG_LIBUKVMEM */
 
 #define VIRTQUEUE_MAX_SIZE  32768
+#if CONFIG_VIRTIO_RING_INDIRECT
+#define VIRTQUEUE_INDIRECT_MAX  CONFIG_VIRTIO_RING_INDIRECT_MAX
+#else /* !CONFIG_VIRTIO_RING_INDIRECT */
+#define VIRTQUEUE_INDIRECT_MAX  0
+#endif /* !CONFIG_VIRTIO_RING_INDIRECT */
 #define to_virtqueue_vring(vq)			\
 	__containerof(vq, struct virtqueue_vring, vq)
 
 struct virtqueue_desc_info {
 	void *cookie;
 	__u16 desc_count;
+	/* Next free buffer ID (packed ring) */
+	__u16 next;
 };
 
 struct virtqueue_vring {
@@ -71,6 +80,34 @@ struct virtqueue_vring {
 	__u16 head_free_desc;
 	/* Index of the last used descriptor by the host */
 	__u16 last_used_desc_idx;
+	/* Available index at the last host notification check */
+	__u16 last_notify_avail_idx;
+	/* VIRTIO_F_EVENT_IDX was negotiated */
+	int event_idx;
+	/* Indirect descriptor tables, one per ring slot, if negotiated */
+	struct vring_desc *indirect;
+	/* Guest physical address of the indirect descriptor tables */
+	__paddr_t indirect_paddr;
+	/* Notification and interrupt counters */
+	struct virtqueue_stats stats;
+	/**
+	 * VIRTIO_F_RING_PACKED was negotiated and vring_packed is used instead
+	 * of vring. head_free_desc is then the first free buffer ID and
+	 * last_used_desc_idx the ring position of the next used descriptor.
+	 */
+	int packed;
+	struct vring_packed vring_packed;
+	/* Ring position of the next descriptor made available */
+	__u16 next_avail_idx;
+	/* Descriptors made available since the last notification check */
+	__u16 nr_added;
+	/* AVAIL/USED flags marking a descriptor available in this lap */
+	__u16 avail_used_flags;
+	/* Shadow of the driver event suppression flags */
+	__u16 event_flags;
+	/* Wrap counters of the available and used positions */
+	__u8 avail_wrap;
+	__u8 used_wrap;
 	/* Cookie to identify driver buffer */
 	struct virtqueue_desc_info vq_info[];
 };
@@ -88,9 +125,265 @@ static inline int virtqueue_buffer_enqueue_segments(
 						    struct uk_sglist *sg,
 						    __u16 read_bufs,
 						    __u16 write_bufs);
+static inline int virtqueue_buffer_enqueue_indirect(
+						struct virtqueue_vring *vrq,
+						__u16 head,
+						struct uk_sglist *sg,
+						__u16 read_bufs,
+						__u16 write_bufs);
 static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 				 __u16 align);
 
+/**
+ * Packed ring implementation
+ */
+static inline void virtqueue_packed_next(struct virtqueue_vring *vrq,
+					 __u16 *idx)
+{
+	if (++(*idx) < vrq->vring_packed.num)
+		return;
+
+	/* Start a new lap of the ring */
+	*idx = 0;
+	vrq->avail_wrap ^= 1;
+	vrq->avail_used_flags ^= VRING_PACKED_DESC_F_AVAIL |
+				 VRING_PACKED_DESC_F_USED;
+}
+
+static inline __u16 virtqueue_packed_used_off_wrap(struct virtqueue_vring *vrq)
+{
+	return vrq->last_used_desc_idx |
+		(vrq->used_wrap << VRING_PACKED_EVENT_F_WRAP_CTR);
+}
+
+static void virtqueue_packed_intr_disable(struct virtqueue_vring *vrq)
+{
+	if (vrq->event_flags == VRING_PACKED_EVENT_FLAG_DISABLE)
+		return;
+
+	vrq->event_flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+	vrq->vring_packed.driver->flags = vrq->event_flags;
+}
+
+static int virtqueue_packed_hasdata(struct virtqueue_vring *vrq)
+{
+	__u16 flags;
+	int avail, used;
+
+	flags = vrq->vring_packed.desc[vrq->last_used_desc_idx].flags;
+	avail = !!(flags & VRING_PACKED_DESC_F_AVAIL);
+	used = !!(flags & VRING_PACKED_DESC_F_USED);
+	return (avail == used && used == vrq->used_wrap);
+}
+
+static int virtqueue_packed_intr_enable(struct virtqueue_vring *vrq)
+{
+	/**
+	 * There are more packets in the virtqueue to be processed while the
+	 * interrupt was disabled.
+	 */
+	if (virtqueue_packed_hasdata(vrq))
+		return 1;
+
+	if (vrq->event_idx)
+		vrq->vring_packed.driver->off_wrap =
+			virtqueue_packed_used_off_wrap(vrq);
+	if (vrq->event_flags == VRING_PACKED_EVENT_FLAG_DISABLE) {
+		vrq->event_flags = vrq->event_idx ?
+			VRING_PACKED_EVENT_FLAG_DESC :
+			VRING_PACKED_EVENT_FLAG_ENABLE;
+		vrq->vring_packed.driver->flags = vrq->event_flags;
+	}
+
+	/* Same as for the split ring, see virtqueue_intr_enable() */
+	mb();
+	if (virtqueue_packed_hasdata(vrq)) {
+		virtqueue_packed_intr_disable(vrq);
+		return 1;
+	}
+	return 0;
+}
+
+static int virtqueue_packed_notify_enabled(struct virtqueue_vring *vrq)
+{
+	struct vring_packed_desc_event *event = vrq->vring_packed.device;
+	__u16 old_idx, new_idx, event_idx, off_wrap;
+
+	new_idx = vrq->next_avail_idx;
+	old_idx = new_idx - vrq->nr_added;
+	vrq->nr_added = 0;
+
+	if (event->flags != VRING_PACKED_EVENT_FLAG_DESC)
+		return (event->flags != VRING_PACKED_EVENT_FLAG_DISABLE);
+
+	/**
+	 * The device asks for a notification once the descriptor at
+	 * off_wrap is available. Bring it to the lap of new_idx.
+	 */
+	off_wrap = event->off_wrap;
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	if ((off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR) != vrq->avail_wrap)
+		event_idx -= vrq->vring_packed.num;
+	return vring_need_event(event_idx, new_idx, old_idx);
+}
+
+static int virtqueue_packed_enqueue(struct virtqueue_vring *vrq, void *cookie,
+				    struct uk_sglist *sg, __u16 read_bufs,
+				    __u16 write_bufs)
+{
+	struct vring_packed_desc *desc, *table;
+	struct uk_sglist_seg *segs;
+	__u16 id, head, idx, head_flags = 0, flags;
+	__u32 total_desc, ring_desc, i;
+	__paddr_t table_off;
+	int indirect;
+
+	total_desc = read_bufs + write_bufs;
+	indirect = vrq->indirect && total_desc > 1 &&
+		   total_desc <= VIRTQUEUE_INDIRECT_MAX;
+	ring_desc = indirect ? 1 : total_desc;
+	if (unlikely(total_desc < 1 || ring_desc > vrq->vring_packed.num)) {
+		uk_pr_err("%"__PRIu32" invalid number of descriptor\n",
+			  total_desc);
+		return -EINVAL;
+	} else if (vrq->desc_avail < ring_desc) {
+		uk_pr_err("Available descriptor:%"__PRIu16", Requested descriptor:%"__PRIu32"\n",
+			  vrq->desc_avail, ring_desc);
+		return -ENOSPC;
+	}
+
+	UK_ASSERT(cookie);
+	id = vrq->head_free_desc;
+	head = idx = vrq->next_avail_idx;
+	if (indirect) {
+		/* The indirect tables are indexed by buffer ID */
+		table_off = (__paddr_t)id * VIRTQUEUE_INDIRECT_MAX;
+		table = (struct vring_packed_desc *)vrq->indirect + table_off;
+		for (i = 0; i < total_desc; i++) {
+			segs = &sg->sg_segs[i];
+			table[i].addr = segs->ss_paddr;
+			table[i].len = segs->ss_len;
+			table[i].id = 0;
+			table[i].flags = (i >= read_bufs) ?
+				VRING_DESC_F_WRITE : 0;
+		}
+
+		desc = &vrq->vring_packed.desc[idx];
+		desc->addr = vrq->indirect_paddr +
+			table_off * sizeof(struct vring_packed_desc);
+		desc->len = total_desc * sizeof(struct vring_packed_desc);
+		desc->id = id;
+		head_flags = VRING_DESC_F_INDIRECT | vrq->avail_used_flags;
+		virtqueue_packed_next(vrq, &idx);
+	} else {
+		for (i = 0; i < total_desc; i++) {
+			segs = &sg->sg_segs[i];
+			desc = &vrq->vring_packed.desc[idx];
+			desc->addr = segs->ss_paddr;
+			desc->len = segs->ss_len;
+			desc->id = id;
+
+			flags = vrq->avail_used_flags;
+			if (i >= read_bufs)
+				flags |= VRING_DESC_F_WRITE;
+			if (i < total_desc - 1)
+				flags |= VRING_DESC_F_NEXT;
+			/**
+			 * The head is published last, once the rest of the
+			 * chain is in place.
+			 */
+			if (i == 0)
+				head_flags = flags;
+			else
+				desc->flags = flags;
+			virtqueue_packed_next(vrq, &idx);
+		}
+	}
+
+	vrq->vq_info[id].cookie = cookie;
+	vrq->vq_info[id].desc_count = ring_desc;
+	vrq->head_free_desc = vrq->vq_info[id].next;
+	vrq->desc_avail -= ring_desc;
+	vrq->next_avail_idx = idx;
+	vrq->nr_added += ring_desc;
+
+	/**
+	 * Write barrier to make sure the device sees the whole chain before
+	 * the head becomes available.
+	 */
+	wmb();
+	vrq->vring_packed.desc[head].flags = head_flags;
+	return vrq->desc_avail;
+}
+
+static int virtqueue_packed_dequeue(struct virtqueue_vring *vrq, void **cookie,
+				    __u32 *len)
+{
+	struct vring_packed_desc *desc;
+	__u16 id, last;
+
+	if (!virtqueue_packed_hasdata(vrq))
+		return -ENOMSG;
+	/**
+	 * We are reading the used descriptor information updated by the host
+	 * after checking its flags.
+	 */
+	rmb();
+	desc = &vrq->vring_packed.desc[vrq->last_used_desc_idx];
+	id = desc->id;
+	UK_ASSERT(id < vrq->vring_packed.num);
+	if (len)
+		*len = desc->len;
+	*cookie = vrq->vq_info[id].cookie;
+	vrq->vq_info[id].cookie = NULL;
+
+	/* The device skips the rest of the chain */
+	last = vrq->last_used_desc_idx + vrq->vq_info[id].desc_count;
+	if (last >= vrq->vring_packed.num) {
+		last -= vrq->vring_packed.num;
+		vrq->used_wrap ^= 1;
+	}
+	vrq->last_used_desc_idx = last;
+	vrq->desc_avail += vrq->vq_info[id].desc_count;
+	vrq->vq_info[id].next = vrq->head_free_desc;
+	vrq->head_free_desc = id;
+
+	/* Ask for an interrupt on the next used buffer, see the split ring */
+	if (vrq->event_flags == VRING_PACKED_EVENT_FLAG_DESC)
+		vrq->vring_packed.driver->off_wrap =
+			virtqueue_packed_used_off_wrap(vrq);
+	return (vrq->vring_packed.num - vrq->desc_avail);
+}
+
+static void virtqueue_packed_init(struct virtqueue_vring *vrq, __u16 nr_desc)
+{
+	int i = 0;
+
+	vring_packed_init(&vrq->vring_packed, nr_desc, vrq->vring_mem);
+
+	vrq->desc_avail = nr_desc;
+	vrq->head_free_desc = 0;
+	vrq->last_used_desc_idx = 0;
+	vrq->next_avail_idx = 0;
+	vrq->nr_added = 0;
+	/* Both wrap counters start at 1 */
+	vrq->avail_wrap = 1;
+	vrq->used_wrap = 1;
+	vrq->avail_used_flags = VRING_PACKED_DESC_F_AVAIL;
+	for (i = 0; i < nr_desc; i++)
+		vrq->vq_info[i].next = i + 1;
+
+	/* Interrupts start enabled, as with the split ring */
+	if (vrq->event_idx) {
+		vrq->event_flags = VRING_PACKED_EVENT_FLAG_DESC;
+		vrq->vring_packed.driver->off_wrap =
+			virtqueue_packed_used_off_wrap(vrq);
+	} else {
+		vrq->event_flags = VRING_PACKED_EVENT_FLAG_ENABLE;
+	}
+	vrq->vring_packed.driver->flags = vrq->event_flags;
+}
+
 /**
  * Driver implementation
  */
@@ -101,7 +394,19 @@ void virtqueue_intr_disable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed) {
+		virtqueue_packed_intr_disable(vrq);
+		return;
+	}
+
 	vrq->vring.avail->flags |= (VRING_AVAIL_F_NO_INTERRUPT);
+	/**
+	 * The device ignores the flag with VIRTIO_F_EVENT_IDX. Move the used
+	 * event behind the used index, so that the next interrupt only comes
+	 * after the index wrapped around.
+	 */
+	if (vrq->event_idx)
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx - 1;
 }
 
 int virtqueue_intr_enable(struct virtqueue *vq)
@@ -112,11 +417,18 @@ int virtqueue_intr_enable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed)
+		return virtqueue_packed_intr_enable(vrq);
+
 	/* Check if there are no more packets enabled */
 	if (!virtqueue_hasdata(vq)) {
-		if (vrq->vring.avail->flags | VRING_AVAIL_F_NO_INTERRUPT) {
+		if (vrq->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT) {
 			vrq->vring.avail->flags &=
 				(~VRING_AVAIL_F_NO_INTERRUPT);
+			/* Interrupt on the next used buffer */
+			if (vrq->event_idx)
+				vring_used_event(&vrq->vring) =
+					vrq->last_used_desc_idx;
 			/**
 			 * We enabled the interrupts. We ensure it using the
 			 * memory barrier and check if there are any further
@@ -186,11 +498,41 @@ static inline void virtqueue_detach_desc(struct virtqueue_vring *vrq,
 int virtqueue_notify_enabled(struct virtqueue *vq)
 {
 	struct virtqueue_vring *vrq;
+	__u16 old_idx, new_idx;
+	int rc;
 
 	UK_ASSERT(vq);
 	vrq = to_virtqueue_vring(vq);
 
-	return ((vrq->vring.used->flags & VRING_USED_F_NO_NOTIFY) == 0);
+	if (vrq->packed) {
+		rc = virtqueue_packed_notify_enabled(vrq);
+	} else if (vrq->event_idx) {
+		/**
+		 * Notify only if the device asked for it within the buffers
+		 * made available since the previous check.
+		 */
+		old_idx = vrq->last_notify_avail_idx;
+		new_idx = vrq->vring.avail->idx;
+		vrq->last_notify_avail_idx = new_idx;
+		rc = vring_need_event(vring_avail_event(&vrq->vring),
+				      new_idx, old_idx);
+	} else {
+		rc = ((vrq->vring.used->flags & VRING_USED_F_NO_NOTIFY) == 0);
+	}
+
+	if (rc)
+		vrq->stats.notify++;
+	else
+		vrq->stats.notify_suppressed++;
+	return rc;
+}
+
+void virtqueue_stats_get(struct virtqueue *vq, struct virtqueue_stats *stats)
+{
+	UK_ASSERT(vq);
+	UK_ASSERT(stats);
+
+	*stats = to_virtqueue_vring(vq)->stats;
 }
 
 static inline int virtqueue_buffer_enqueue_segments(
@@ -219,6 +561,42 @@ static inline int virtqueue_buffer_enqueue_segments(
 	return idx;
 }
 
+static inline int virtqueue_buffer_enqueue_indirect(
+		struct virtqueue_vring *vrq,
+		__u16 head, struct uk_sglist *sg, __u16 read_bufs,
+		__u16 write_bufs)
+{
+	int i = 0, total_desc = 0;
+	struct uk_sglist_seg *segs;
+	struct vring_desc *table;
+	__paddr_t table_off;
+
+	total_desc = read_bufs + write_bufs;
+	table_off = (__paddr_t)head * VIRTQUEUE_INDIRECT_MAX;
+	table = &vrq->indirect[table_off];
+
+	for (i = 0; i < total_desc; i++) {
+		segs = &sg->sg_segs[i];
+		table[i].addr = segs->ss_paddr;
+		table[i].len = segs->ss_len;
+		table[i].flags = 0;
+		if (i >= read_bufs)
+			table[i].flags |= VRING_DESC_F_WRITE;
+
+		if (i < total_desc - 1) {
+			table[i].flags |= VRING_DESC_F_NEXT;
+			table[i].next = i + 1;
+		}
+	}
+
+	/* The buffer takes a single slot pointing to its table */
+	vrq->vring.desc[head].addr = vrq->indirect_paddr +
+		table_off * sizeof(struct vring_desc);
+	vrq->vring.desc[head].len = total_desc * sizeof(struct vring_desc);
+	vrq->vring.desc[head].flags = VRING_DESC_F_INDIRECT;
+	return vrq->vring.desc[head].next;
+}
+
 int virtqueue_hasdata(struct virtqueue *vq)
 {
 	struct virtqueue_vring *vring;
@@ -226,6 +604,9 @@ int virtqueue_hasdata(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vring = to_virtqueue_vring(vq);
+	if (vring->packed)
+		return virtqueue_packed_hasdata(vring);
+
 	return (vring->last_used_desc_idx != vring->vring.used->idx);
 }
 
@@ -234,9 +615,10 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set)
 	__u64 feature = (1ULL << VIRTIO_TRANSPORT_F_START) - 1;
 
 	/**
-	 * Currently out vring driver does not support any ring feature. We will
-	 * add support to transport feature in the future.
+	 * Besides the device specific features, the vring driver supports the
+	 * indirect descriptor and event index ring features.
 	 */
+	feature |= VIRTQUEUE_FEATURES;
 	feature &= feature_set;
 	return feature;
 }
@@ -251,6 +633,7 @@ int virtqueue_ring_interrupt(void *obj)
 	if (!virtqueue_hasdata(vq))
 		return rc;
 
+	to_virtqueue_vring(vq)->stats.intr++;
 	if (likely(vq->vq_callback))
 		rc = vq->vq_callback(vq, vq->priv);
 	return rc;
@@ -273,6 +656,12 @@ __paddr_t virtqueue_get_avail_addr(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	/* The driver event suppression area with a packed ring */
+	if (vrq->packed)
+		return virtqueue_physaddr(vq) +
+			((char *)vrq->vring_packed.driver -
+			 (char *)vrq->vring_mem);
+
 	return virtqueue_physaddr(vq) +
 		((char *)vrq->vring.avail - (char *)vrq->vring.desc);
 }
@@ -284,6 +673,12 @@ __paddr_t virtqueue_get_used_addr(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	/* The device event suppression area with a packed ring */
+	if (vrq->packed)
+		return virtqueue_physaddr(vq) +
+			((char *)vrq->vring_packed.device -
+			 (char *)vrq->vring_mem);
+
 	return virtqueue_physaddr(vq) +
 		((char *)vrq->vring.used - (char *)vrq->vring.desc);
 }
@@ -295,6 +690,9 @@ unsigned int virtqueue_vring_get_num(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed)
+		return vrq->vring_packed.num;
+
 	return vrq->vring.num;
 }
 
@@ -307,6 +705,8 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	UK_ASSERT(vq);
 	UK_ASSERT(cookie);
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed)
+		return virtqueue_packed_dequeue(vrq, cookie, len);
 
 	/* No new descriptor since last dequeue operation */
 	if (!virtqueue_hasdata(vq))
@@ -324,6 +724,15 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	*cookie = vrq->vq_info[head_idx].cookie;
 	virtqueue_detach_desc(vrq, head_idx);
 	vrq->vq_info[head_idx].cookie = NULL;
+
+	/**
+	 * With VIRTIO_F_EVENT_IDX, the device interrupts once when it passes
+	 * the used event index. Keep it one ahead of the buffers we consumed
+	 * as long as interrupts are enabled.
+	 */
+	if (vrq->event_idx &&
+	    !(vrq->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx;
 	return (vrq->vring.num - vrq->desc_avail);
 }
 
@@ -331,21 +740,33 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 			     struct uk_sglist *sg, __u16 read_bufs,
 			     __u16 write_bufs)
 {
-	__u32 total_desc = 0;
+	__u32 total_desc = 0, ring_desc = 0;
 	__u16 head_idx = 0, idx = 0;
 	struct virtqueue_vring *vrq = NULL;
+	int indirect;
 
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed)
+		return virtqueue_packed_enqueue(vrq, cookie, sg, read_bufs,
+						write_bufs);
+
 	total_desc = read_bufs + write_bufs;
-	if (unlikely(total_desc < 1 || total_desc > vrq->vring.num)) {
+	/**
+	 * Buffers with several segments go to an indirect table if it is large
+	 * enough, so that they only need a single slot of the ring.
+	 */
+	indirect = vrq->indirect && total_desc > 1 &&
+		   total_desc <= VIRTQUEUE_INDIRECT_MAX;
+	ring_desc = indirect ? 1 : total_desc;
+	if (unlikely(total_desc < 1 || ring_desc > vrq->vring.num)) {
 		uk_pr_err("%"__PRIu32" invalid number of descriptor\n",
 			  total_desc);
 		return -EINVAL;
-	} else if (vrq->desc_avail < total_desc) {
+	} else if (vrq->desc_avail < ring_desc) {
 		uk_pr_err("Available descriptor:%"__PRIu16", Requested descriptor:%"__PRIu32"\n",
-			  vrq->desc_avail, total_desc);
+			  vrq->desc_avail, ring_desc);
 		return -ENOSPC;
 	}
 	/* Get the head of free descriptor */
@@ -353,16 +774,20 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 	UK_ASSERT(cookie);
 	/* Additional information to reconstruct the data buffer */
 	vrq->vq_info[head_idx].cookie = cookie;
-	vrq->vq_info[head_idx].desc_count = total_desc;
+	vrq->vq_info[head_idx].desc_count = ring_desc;
 
 	/**
 	 * We separate the descriptor management to enqueue segment(s).
 	 */
-	idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
-			read_bufs, write_bufs);
+	if (indirect)
+		idx = virtqueue_buffer_enqueue_indirect(vrq, head_idx, sg,
+				read_bufs, write_bufs);
+	else
+		idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
+				read_bufs, write_bufs);
 	/* Metadata maintenance for the virtqueue */
 	vrq->head_free_desc = idx;
-	vrq->desc_avail -= total_desc;
+	vrq->desc_avail -= ring_desc;
 
 	uk_pr_debug("Old head:%d, new head:%d, total_desc:%d\n",
 		    head_idx, idx, total_desc);
@@ -381,6 +806,7 @@ static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 	vrq->desc_avail = vrq->vring.num;
 	vrq->head_free_desc = 0;
 	vrq->last_used_desc_idx = 0;
+	vrq->last_notify_avail_idx = 0;
 	for (i = 0; i < nr_desc - 1; i++)
 		vrq->vring.desc[i].next = i + 1;
 	/**
@@ -398,7 +824,7 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	struct virtqueue_vring *vrq;
 	struct virtqueue *vq;
 	int rc;
-	size_t ring_size = 0;
+	size_t ring_size = 0, indirect_off = 0;
 
 	UK_ASSERT(a);
 
@@ -415,8 +841,23 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	 * allocation.
 	 */
 	vrq->vring_mem = NULL;
-
-	ring_size = vring_size(nr_descs, align);
+	vrq->event_idx = vdev && VIRTIO_FEATURE_HAS(vdev->features,
+						    VIRTIO_F_EVENT_IDX);
+	vrq->packed = vdev && VIRTIO_FEATURE_HAS(vdev->features,
+						 VIRTIO_F_RING_PACKED);
+	memset(&vrq->stats, 0, sizeof(vrq->stats));
+
+	if (vrq->packed)
+		ring_size = vring_packed_size(nr_descs);
+	else
+		ring_size = vring_size(nr_descs, align);
+	/* The indirect tables follow the vring in the same DMA memory */
+	if (vdev && VIRTQUEUE_INDIRECT_MAX > 1 &&
+	    VIRTIO_FEATURE_HAS(vdev->features, VIRTIO_F_INDIRECT_DESC)) {
+		indirect_off = ALIGN_UP(ring_size, sizeof(struct vring_desc));
+		ring_size = indirect_off + (size_t)nr_descs *
+			VIRTQUEUE_INDIRECT_MAX * sizeof(struct vring_desc);
+	}
 #ifdef CONFIG_LIBUKVMEM
 	struct uk_pagetable *pt = ukplat_pt_get_active();
 	__paddr_t paddr = __PADDR_ANY;
@@ -443,7 +884,19 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	}
 #endif /* !CONFIG_LIBUKVMEM */
 	memset(vrq->vring_mem, 0, ring_size);
-	virtqueue_vring_init(vrq, nr_descs, align);
+	if (vrq->packed)
+		virtqueue_packed_init(vrq, nr_descs);
+	else
+		virtqueue_vring_init(vrq, nr_descs, align);
+	if (indirect_off) {
+		vrq->indirect = (struct vring_desc *)
+			((char *)vrq->vring_mem + indirect_off);
+		vrq->indirect_paddr = ukplat_virt_to_phys(vrq->vring_mem) +
+			indirect_off;
+	} else {
+		vrq->indirect = NULL;
+		vrq->indirect_paddr = 0;
+	}
 
 	vq = &vrq->vq;
 	vq->queue_id = queue_id;
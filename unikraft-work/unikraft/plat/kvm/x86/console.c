@@ -34,6 +34,9 @@
 #if (CONFIG_KVM_DEBUG_SERIAL_CONSOLE || CONFIG_KVM_KERNEL_SERIAL_CONSOLE)
 #include <kvm-x86/serial_console.h>
 #endif
+#if CONFIG_VIRTIO_CONSOLE
+#include <virtio/virtio_console.h>
+#endif
 
 void _libkvmplat_init_console(void)
 {
@@ -48,7 +51,15 @@ void _libkvmplat_init_console(void)
 
 int ukplat_coutd(const char *buf __maybe_unused, unsigned int len)
 {
-	for (unsigned int i = 0; i < len; i++) {
+	unsigned int i = 0;
+
+#if CONFIG_VIRTIO_CONSOLE
+	int rc = virtio_console_out(buf, len);
+
+	if (rc > 0)
+		i = rc;
+#endif
+	for (; i < len; i++) {
 #if CONFIG_KVM_DEBUG_SERIAL_CONSOLE
 		_libkvmplat_serial_putc(buf[i]);
 #endif
@@ -62,7 +73,15 @@ int ukplat_coutd(const char *buf __maybe_unused, unsigned int len)
 
 int ukplat_coutk(const char *buf __maybe_unused, unsigned int len)
 {
-	for (unsigned int i = 0; i < len; i++) {
+	unsigned int i = 0;
+
+#if CONFIG_VIRTIO_CONSOLE
+	int rc = virtio_console_out(buf, len);
+
+	if (rc > 0)
+		i = rc;
+#endif
+	for (; i < len; i++) {
 #if CONFIG_KVM_KERNEL_SERIAL_CONSOLE
 		_libkvmplat_serial_putc(buf[i]);
 #endif